@@ -0,0 +1,143 @@
+/**
+ * Latency of running small scripts through a server (main.out --serve, see runtime/vmserver.h),
+ * against running main.out for each of them, as a job runner would
+ * Build and run with: make bench_serve && ./bench_serve [RUNS]
+ *
+ * Reports the mean, median and 99th percentile latency of a run, from the request (or spawn)
+ * to the return code, for a trivial script and for a script doing a bit of work
+ */
+// clock_gettime, posix_spawn and nanosleep are POSIX
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../runtime/vmserver.h"
+
+#define DEFAULT_RUNS 500
+
+extern char **environ;
+
+typedef struct BenchScript
+{
+    const char *name;
+    const char *source;
+} BenchScript;
+
+static const BenchScript scripts[] = {
+    {"hello", "print(\"hello \" + __args__[0]);\n"},
+    {"work",
+     "func fib(x) { if(x < 2) { return x; } return fib(x - 1) + fib(x - 2); }\n"
+     "let words = map(range(200), func(i) { return str(i) + \"-\" + __args__[0]; });\n"
+     "let total = sum(map(range(200), func(x) { return x * x; }));\n"
+     "print(str(fib(12)) + \" \" + str(len(words)) + \" \" + str(total));\n"},
+};
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *script, const char *mode, double *latencies, int runs)
+{
+    double total = 0;
+    for (int i = 0; i < runs; i++)
+        total += latencies[i];
+    qsort(latencies, runs, sizeof(double), compare_doubles);
+
+    printf("%-6s %-6s mean %8.1fus  p50 %8.1fus  p99 %8.1fus\n", script, mode,
+           total / runs * 1e6, latencies[runs / 2] * 1e6, latencies[runs * 99 / 100] * 1e6);
+}
+
+static pid_t spawn(char **argv, int output)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, output, STDOUT_FILENO);
+
+    pid_t pid;
+    if (posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0)
+        pid = -1;
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+
+static int wait_exit(pid_t pid)
+{
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? atoi(argv[1]) : DEFAULT_RUNS;
+    if (runs <= 0)
+        runs = DEFAULT_RUNS;
+
+    char socket_path[64], script_path[64];
+    snprintf(socket_path, sizeof(socket_path), "/tmp/tlang_bench_%d.sock", (int)getpid());
+    snprintf(script_path, sizeof(script_path), "/tmp/tlang_bench_%d.tl", (int)getpid());
+    int null_output = open("/dev/null", O_WRONLY);
+
+    char *server_argv[] = {"./main.out", "--serve", socket_path, NULL};
+    pid_t server = spawn(server_argv, STDOUT_FILENO);
+    if (server < 0)
+    {
+        printf("Could not start ./main.out --serve, build it first\n");
+        return 1;
+    }
+
+    char *script_args[] = {"bench"};
+    double *latencies = malloc(sizeof(double) * runs);
+
+    for (size_t s = 0; s < sizeof(scripts) / sizeof(scripts[0]); s++)
+    {
+        FILE *file = fopen(script_path, "w");
+        fputs(scripts[s].source, file);
+        fclose(file);
+
+        // warms up the server, its first request also waits for it to listen
+        for (int i = 0; i < 500 && VM_serve_request(socket_path, VM_SERVER_SCRIPT_PATH, script_path, strlen(script_path),
+                                                    1, script_args, null_output, null_output) != 0; i++)
+            nanosleep(&(struct timespec){0, 10000000}, NULL);
+
+        // --no-cache, a job runner writing its scripts to a temporary directory would not reuse their .tlc
+        char *exec_argv[] = {"./main.out", script_path, "--no-cache", "--script-args", "bench", NULL};
+        for (int i = 0; i < runs; i++)
+        {
+            double start = now();
+            wait_exit(spawn(exec_argv, null_output));
+            latencies[i] = now() - start;
+        }
+        report(scripts[s].name, "exec", latencies, runs);
+
+        for (int i = 0; i < runs; i++)
+        {
+            double start = now();
+            VM_serve_request(socket_path, VM_SERVER_SCRIPT_PATH, script_path, strlen(script_path),
+                             1, script_args, null_output, null_output);
+            latencies[i] = now() - start;
+        }
+        report(scripts[s].name, "serve", latencies, runs);
+    }
+
+    kill(server, SIGTERM);
+    wait_exit(server);
+    unlink(script_path);
+    free(latencies);
+    return 0;
+}
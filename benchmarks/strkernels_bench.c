@@ -0,0 +1,94 @@
+/**
+ * Microbenchmark of the string kernels (generics/strkernels.c), for every implementation the CPU supports
+ * Build and run with: make bench_strkernels && ./bench_strkernels
+ *
+ * Reports the throughput of each kernel in GB/s on strings from 1KB to 100MB,
+ * the search kernels look for a needle placed at the very end of the string, "find" with a first byte
+ * that appears nowhere else and "find-common" with a first byte that appears every 26 bytes
+ */
+// clock_gettime and setenv are POSIX
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../generics/strkernels.h"
+
+static const char *isas[] = {"scalar", "sse2", "avx2"};
+static const size_t sizes[] = {1 << 10, 64 << 10, 1 << 20, 16 << 20, 100 << 20};
+
+static volatile size_t sink;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// every kernel processes about 256MB per measurement, whatever the string size
+static size_t rounds(size_t len)
+{
+    size_t n = (1UL << 28) / len;
+    return n ? n : 1;
+}
+
+#define BENCH(name, len, body)                                          \
+    do                                                                  \
+    {                                                                   \
+        size_t n = rounds(len);                                         \
+        double start = now();                                           \
+        for (size_t r = 0; r < n; r++)                                  \
+        {                                                               \
+            body;                                                       \
+        }                                                               \
+        double secs = now() - start;                                    \
+        printf("  %-12s %8.2f GB/s\n", name, (double)len * n / secs / 1e9); \
+    } while (0)
+
+int main()
+{
+    size_t max_len = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    char *text = malloc(max_len);
+    char *out = malloc(max_len);
+    char *spaces = malloc(max_len);
+    if (!text || !out || !spaces)
+        return 1;
+
+    // lower case letters only, so that the class checks scan the whole string
+    for (size_t i = 0; i < max_len; i++)
+        text[i] = 'a' + (i * 7) % 26;
+    memset(spaces, ' ', max_len);
+    const char *needle = "0123456789";
+    const char *common_needle = "ahovcjqx89";
+
+    for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); i++)
+    {
+        setenv(STR_KERNELS_ENV, isas[i], 1);
+        init_str_kernels();
+        if (strcmp(str_kernels_isa(), isas[i]) != 0)
+            continue;
+
+        for (size_t j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++)
+        {
+            size_t len = sizes[j];
+            memcpy(text + len - strlen(needle), needle, strlen(needle));
+            printf("%s, %zu bytes\n", isas[i], len);
+
+            BENCH("upper", len, str_to_upper(out, text, len); sink += out[r % len]);
+            BENCH("islower", len, sink += str_all_in_class(text, len - strlen(needle), STR_CLASS_LOWER));
+            BENCH("isalnum", len, sink += str_all_in_class(text, len, STR_CLASS_ALNUM));
+            BENCH("lspace", len, sink += str_leading_space(spaces, len));
+            BENCH("rspace", len, sink += str_trailing_space(spaces, len));
+            BENCH("find", len, sink += str_find(text, len, needle, strlen(needle)));
+            BENCH("find-common", len, sink += str_find(text, len, common_needle, strlen(common_needle)));
+
+            memcpy(text + len - strlen(needle), "abcdefghij", strlen(needle));
+        }
+    }
+
+    free(text);
+    free(out);
+    free(spaces);
+    return 0;
+}
@@ -0,0 +1,834 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bytecodecache.h"
+#include "../runtime/rtobjects.h"
+#include "../runtime/rtfunc.h"
+#include "../runtime/rtnumber.h"
+#include "../runtime/rtstring.h"
+#include "../generics/utilities.h"
+
+/**
+ * DESCRIPTION:
+ * This file contains the reader and writer of bytecode cache files, see bytecodecache.h for the format
+ */
+
+// seed of the hashes of the cache, they must be the same in every process
+#define CACHE_HASH_SEED 0x544c414e47ULL
+
+// nested functions deeper than this are rejected, so corrupted caches cannot overflow the native stack
+#define CACHE_MAX_NESTING 1000
+
+typedef struct CacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t compiler_version;
+    uint32_t abi;
+    uint64_t source_hash;
+    uint64_t source_length;
+    uint64_t program_length;
+    uint64_t program_hash;
+} CacheHeader;
+
+/**
+ * DESCRIPTION:
+ * Identifies the layout of the integers written by this process, caches written by another layout are ignored
+ */
+static uint32_t cache_abi()
+{
+    const uint16_t probe = 1;
+    uint8_t little_endian;
+    memcpy(&little_endian, &probe, 1);
+    return (uint32_t)sizeof(size_t) | ((uint32_t)little_endian << 8) | ((uint32_t)(LOGICAL_NOT_VARS_OP + 1) << 16);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the path of the cache of a source file, <file>.tl is cached in <file>.tlc, other files get the extension appended
+ */
+char *bytecode_cache_path(const char *source_path)
+{
+    size_t length = strlen(source_path);
+    bool has_extension = length >= 3 && strcmp(source_path + length - 3, ".tl") == 0;
+
+    char *path = malloc(length + strlen(BYTECODE_CACHE_EXTENSION) + 1);
+    if (!path)
+        MallocError();
+
+    if (has_extension)
+        sprintf(path, "%s%c", source_path, 'c');
+    else
+        sprintf(path, "%s%s", source_path, BYTECODE_CACHE_EXTENSION);
+    return path;
+}
+
+/***** Writer *****/
+
+typedef struct CacheWriter
+{
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} CacheWriter;
+
+static void write_bytes(CacheWriter *writer, const void *bytes, size_t length)
+{
+    if (writer->length + length > writer->capacity)
+    {
+        size_t capacity = writer->capacity ? writer->capacity * 2 : 4096;
+        while (capacity < writer->length + length)
+            capacity *= 2;
+
+        writer->data = realloc(writer->data, capacity);
+        if (!writer->data)
+            MallocError();
+        writer->capacity = capacity;
+    }
+
+    memcpy(writer->data + writer->length, bytes, length);
+    writer->length += length;
+}
+
+static void write_u8(CacheWriter *writer, uint8_t val) { write_bytes(writer, &val, sizeof(val)); }
+static void write_u32(CacheWriter *writer, uint32_t val) { write_bytes(writer, &val, sizeof(val)); }
+static void write_i32(CacheWriter *writer, int32_t val) { write_bytes(writer, &val, sizeof(val)); }
+static void write_u64(CacheWriter *writer, uint64_t val) { write_bytes(writer, &val, sizeof(val)); }
+
+static void write_string(CacheWriter *writer, const char *str)
+{
+    uint32_t length = strlen(str);
+    write_u32(writer, length);
+    write_bytes(writer, str, length);
+}
+
+static void write_bytecode_list(CacheWriter *writer, const ByteCodeList *list);
+
+static void write_constant(CacheWriter *writer, const RtObject *constant)
+{
+    write_u8(writer, constant->type);
+    switch (constant->type)
+    {
+    case NUMBER_TYPE:
+    {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%La", constant->data.Number->number);
+        write_string(writer, buffer);
+        break;
+    }
+    case STRING_TYPE:
+    {
+        const RtString *string = constant->data.String;
+        write_u32(writer, string->length);
+        write_bytes(writer, rtstr_data(string), string->length);
+        break;
+    }
+    case NULL_TYPE:
+    case UNDEFINED_TYPE:
+        break;
+    default:
+        // the compiler only emits the constants above
+        assert(false);
+    }
+}
+
+static void write_function(CacheWriter *writer, const RtObject *function)
+{
+    assert(function->type == FUNCTION_TYPE && function->data.Func->functype == REGULAR_FUNC);
+    const RtFunction *func = function->data.Func;
+
+    const char *name = func->func_data.user_func.func_name;
+    write_u8(writer, name != NULL);
+    if (name)
+        write_string(writer, name);
+
+    write_u32(writer, func->func_data.user_func.arg_count);
+    for (size_t i = 0; i < func->func_data.user_func.arg_count; i++)
+        write_string(writer, func->func_data.user_func.args[i]);
+
+    write_u32(writer, func->func_data.user_func.closure_count);
+    for (size_t i = 0; i < func->func_data.user_func.closure_count; i++)
+        write_string(writer, func->func_data.user_func.closures[i]);
+
+    write_bytecode_list(writer, func->func_data.user_func.body);
+}
+
+static void write_bytecode(CacheWriter *writer, const ByteCode *code)
+{
+    write_u8(writer, code->op_code);
+    write_u64(writer, code->line_nb);
+
+    switch (code->op_code)
+    {
+    case LOAD_CONST:
+        write_constant(writer, code->data.LOAD_CONST.constant);
+        break;
+    case LOAD_VAR:
+        write_string(writer, code->data.LOAD_VAR.variable);
+        break;
+    case DEREF_VAR:
+        write_string(writer, code->data.DEREF_VAR.var);
+        break;
+    case FOR_ITER:
+        write_string(writer, code->data.FOR_ITER.var);
+        write_i32(writer, code->data.FOR_ITER.offset);
+        break;
+    case CREATE_VAR:
+        write_string(writer, code->data.CREATE_VAR.new_var_name);
+        write_u8(writer, code->data.CREATE_VAR.access);
+        break;
+    case LOAD_ATTRIBUTE:
+        write_string(writer, code->data.LOAD_ATTR.attribute_name);
+        break;
+    case CREATE_EXCEPTION:
+        write_string(writer, code->data.CREATE_EXCEPTION.exception);
+        write_u8(writer, code->data.CREATE_EXCEPTION.access);
+        break;
+    case CREATE_FUNCTION:
+        write_function(writer, code->data.CREATE_FUNCTION.function);
+        break;
+    case CREATE_LIST:
+        write_u32(writer, code->data.CREATE_LIST.list_length);
+        break;
+    case CREATE_SET:
+        write_i32(writer, code->data.CREATE_SET.set_size);
+        break;
+    case CREATE_MAP:
+        write_i32(writer, code->data.CREATE_MAP.map_size);
+        break;
+    case FUNCTION_CALL:
+        write_i32(writer, code->data.FUNCTION_CALL.arg_count);
+        break;
+    case ABSOLUTE_JUMP:
+        write_u32(writer, code->data.ABSOLUTE_JUMP.offset);
+        break;
+    case OFFSET_JUMP:
+        write_i32(writer, code->data.OFFSET_JUMP.offset);
+        break;
+    case OFFSET_JUMP_IF_FALSE_POP:
+        write_i32(writer, code->data.OFFSET_JUMP_IF_FALSE_POP.offset);
+        break;
+    case OFFSET_JUMP_IF_TRUE_POP:
+        write_i32(writer, code->data.OFFSET_JUMP_IF_TRUE_POP.offset);
+        break;
+    case OFFSET_JUMP_IF_FALSE_NOPOP:
+        write_i32(writer, code->data.OFFSET_JUMP_IF_FALSE_NOPOP.offset);
+        break;
+    case OFFSET_JUMP_IF_TRUE_NOPOP:
+        write_i32(writer, code->data.OFFSET_JUMP_IF_TRUE_NOPOP.offset);
+        break;
+    case PUSH_EXCEPTION_HANDLER:
+        write_i32(writer, code->data.PUSH_EXCEPTION_HANDLER.start_of_catch_block);
+        break;
+    case OFFSET_JUMP_IF_COMPARE_EXCEPTION_FALSE:
+        write_i32(writer, code->data.OFFSET_JUMP_IF_COMPARE_EXCEPTION_FALSE.offset);
+        break;
+    default:
+        // the other instructions have no operands
+        break;
+    }
+}
+
+static void write_bytecode_list(CacheWriter *writer, const ByteCodeList *list)
+{
+    write_u32(writer, list->pg_length);
+    for (int i = 0; i < list->pg_length; i++)
+        write_bytecode(writer, list->code[i]);
+}
+
+/**
+ * DESCRIPTION:
+ * Encodes a compiled program into a cache image (header included), the returned buffer is malloced
+ *
+ * PARAMS:
+ * source: source the program was compiled from
+ * size: set to the size of the image
+ */
+void *encode_bytecode_cache(const ByteCodeList *program, const char *source, size_t *size)
+{
+    CacheWriter writer = {NULL, 0, 0};
+    CacheHeader header;
+    write_bytes(&writer, &header, sizeof(header));
+    write_bytecode_list(&writer, program);
+
+    size_t source_length = strlen(source);
+    memcpy(header.magic, BYTECODE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = BYTECODE_CACHE_VERSION;
+    header.compiler_version = TLANG_COMPILER_VERSION;
+    header.abi = cache_abi();
+    header.source_hash = hash_bytes_with_seed(source, source_length, CACHE_HASH_SEED);
+    header.source_length = source_length;
+    header.program_length = writer.length - sizeof(header);
+    header.program_hash = hash_bytes_with_seed(writer.data + sizeof(header), header.program_length, CACHE_HASH_SEED);
+    memcpy(writer.data, &header, sizeof(header));
+
+    *size = writer.length;
+    return writer.data;
+}
+
+/***** Reader *****/
+
+typedef struct CacheReader
+{
+    const uint8_t *data;
+    size_t length;
+    size_t pos;
+    const char *filename;
+    bool failed;
+} CacheReader;
+
+static bool read_bytes(CacheReader *reader, void *bytes, size_t length)
+{
+    if (reader->failed || length > reader->length - reader->pos)
+    {
+        reader->failed = true;
+        memset(bytes, 0, length);
+        return false;
+    }
+
+    memcpy(bytes, reader->data + reader->pos, length);
+    reader->pos += length;
+    return true;
+}
+
+static uint8_t read_u8(CacheReader *reader)
+{
+    uint8_t val;
+    read_bytes(reader, &val, sizeof(val));
+    return val;
+}
+
+static uint32_t read_u32(CacheReader *reader)
+{
+    uint32_t val;
+    read_bytes(reader, &val, sizeof(val));
+    return val;
+}
+
+static int32_t read_i32(CacheReader *reader)
+{
+    int32_t val;
+    read_bytes(reader, &val, sizeof(val));
+    return val;
+}
+
+static uint64_t read_u64(CacheReader *reader)
+{
+    uint64_t val;
+    read_bytes(reader, &val, sizeof(val));
+    return val;
+}
+
+/**
+ * DESCRIPTION:
+ * Reads a length prefixed string, returns NULL if the cache is truncated or the string has a null byte
+ */
+static char *read_string(CacheReader *reader)
+{
+    uint32_t length = read_u32(reader);
+    if (reader->failed || length > reader->length - reader->pos ||
+        memchr(reader->data + reader->pos, '\0', length))
+    {
+        reader->failed = true;
+        return NULL;
+    }
+
+    char *str = malloc(length + 1);
+    if (!str)
+        MallocError();
+
+    memcpy(str, reader->data + reader->pos, length);
+    str[length] = '\0';
+    reader->pos += length;
+    return str;
+}
+
+static ByteCodeList *read_bytecode_list(CacheReader *reader, unsigned int nesting);
+
+static RtObject *read_constant(CacheReader *reader)
+{
+    RtType type = read_u8(reader);
+    if (reader->failed)
+        return NULL;
+
+    switch (type)
+    {
+    case NUMBER_TYPE:
+    {
+        char *str = read_string(reader);
+        if (!str)
+            return NULL;
+
+        char *end = NULL;
+        long double number = strtold(str, &end);
+        bool valid = end != str && *end == '\0';
+        free(str);
+        if (!valid)
+        {
+            reader->failed = true;
+            return NULL;
+        }
+
+        RtObject *constant = init_RtObject(NUMBER_TYPE);
+        constant->data.Number = init_RtNumber(number);
+        return constant;
+    }
+    case STRING_TYPE:
+    {
+        // strings can have null bytes, unlike names
+        uint32_t length = read_u32(reader);
+        if (reader->failed || length > reader->length - reader->pos)
+        {
+            reader->failed = true;
+            return NULL;
+        }
+
+        RtObject *constant = init_RtObject(STRING_TYPE);
+        constant->data.String = init_RtString_len((const char *)reader->data + reader->pos, length);
+        reader->pos += length;
+        return constant;
+    }
+    case NULL_TYPE:
+    case UNDEFINED_TYPE:
+        return init_RtObject(type);
+    default:
+        reader->failed = true;
+        return NULL;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Reads a function, the struct is kept consistent at every step, so it can be freed if the cache turns out to be corrupted
+ */
+static RtObject *read_function(CacheReader *reader, unsigned int nesting)
+{
+    if (nesting >= CACHE_MAX_NESTING)
+    {
+        reader->failed = true;
+        return NULL;
+    }
+
+    RtFunction *func = init_rtfunc(REGULAR_FUNC);
+    if (!func)
+        MallocError();
+
+    func->func_data.user_func.func_name = read_u8(reader) ? read_string(reader) : NULL;
+    func->func_data.user_func.file_location = cpy_string(reader->filename);
+    func->func_data.user_func.closure_obj = NULL;
+    func->func_data.user_func.body = NULL;
+
+    // counts are bounded by the size of the cache, since every string takes at least 4 bytes
+    uint32_t arg_count = read_u32(reader);
+    if (arg_count > (reader->length - reader->pos) / 4)
+        reader->failed = true;
+    func->func_data.user_func.arg_count = reader->failed ? 0 : arg_count;
+    func->func_data.user_func.args = calloc(func->func_data.user_func.arg_count + 1, sizeof(char *));
+    for (size_t i = 0; i < func->func_data.user_func.arg_count; i++)
+        func->func_data.user_func.args[i] = read_string(reader);
+
+    uint32_t closure_count = read_u32(reader);
+    if (closure_count > (reader->length - reader->pos) / 4)
+        reader->failed = true;
+    func->func_data.user_func.closure_count = reader->failed ? 0 : closure_count;
+    func->func_data.user_func.closures = calloc(func->func_data.user_func.closure_count + 1, sizeof(char *));
+    for (size_t i = 0; i < func->func_data.user_func.closure_count; i++)
+        func->func_data.user_func.closures[i] = read_string(reader);
+
+    if (!reader->failed)
+        func->func_data.user_func.body = read_bytecode_list(reader, nesting + 1);
+
+    RtObject *function = init_RtObject(FUNCTION_TYPE);
+    function->data.Func = func;
+
+    if (reader->failed)
+    {
+        rtobj_free(function, true, false);
+        return NULL;
+    }
+    return function;
+}
+
+/**
+ * DESCRIPTION:
+ * Reads an instruction, returns NULL if the cache is corrupted
+ */
+static ByteCode *read_bytecode(CacheReader *reader, unsigned int nesting)
+{
+    OpCode op_code = read_u8(reader);
+    size_t line_nb = read_u64(reader);
+    if (reader->failed || op_code > LOGICAL_NOT_VARS_OP)
+    {
+        reader->failed = true;
+        return NULL;
+    }
+
+    ByteCode *code = init_ByteCode(op_code, line_nb);
+    void *operand = NULL;
+
+    switch (op_code)
+    {
+    case LOAD_CONST:
+        operand = code->data.LOAD_CONST.constant = read_constant(reader);
+        break;
+    case LOAD_VAR:
+        operand = code->data.LOAD_VAR.variable = read_string(reader);
+        if (operand)
+            code->data.LOAD_VAR.str_length = strlen(code->data.LOAD_VAR.variable);
+        break;
+    case DEREF_VAR:
+        operand = code->data.DEREF_VAR.var = read_string(reader);
+        break;
+    case FOR_ITER:
+        operand = code->data.FOR_ITER.var = read_string(reader);
+        code->data.FOR_ITER.offset = read_i32(reader);
+        break;
+    case CREATE_VAR:
+        operand = code->data.CREATE_VAR.new_var_name = read_string(reader);
+        code->data.CREATE_VAR.access = read_u8(reader);
+        break;
+    case LOAD_ATTRIBUTE:
+        operand = code->data.LOAD_ATTR.attribute_name = read_string(reader);
+        if (operand)
+            code->data.LOAD_ATTR.str_length = strlen(code->data.LOAD_ATTR.attribute_name);
+        break;
+    case CREATE_EXCEPTION:
+        operand = code->data.CREATE_EXCEPTION.exception = read_string(reader);
+        code->data.CREATE_EXCEPTION.access = read_u8(reader);
+        break;
+    case CREATE_FUNCTION:
+        operand = code->data.CREATE_FUNCTION.function = read_function(reader, nesting);
+        break;
+    case CREATE_LIST:
+        code->data.CREATE_LIST.list_length = read_u32(reader);
+        break;
+    case CREATE_SET:
+        code->data.CREATE_SET.set_size = read_i32(reader);
+        break;
+    case CREATE_MAP:
+        code->data.CREATE_MAP.map_size = read_i32(reader);
+        break;
+    case FUNCTION_CALL:
+        code->data.FUNCTION_CALL.arg_count = read_i32(reader);
+        break;
+    case ABSOLUTE_JUMP:
+        code->data.ABSOLUTE_JUMP.offset = read_u32(reader);
+        break;
+    case OFFSET_JUMP:
+        code->data.OFFSET_JUMP.offset = read_i32(reader);
+        break;
+    case OFFSET_JUMP_IF_FALSE_POP:
+        code->data.OFFSET_JUMP_IF_FALSE_POP.offset = read_i32(reader);
+        break;
+    case OFFSET_JUMP_IF_TRUE_POP:
+        code->data.OFFSET_JUMP_IF_TRUE_POP.offset = read_i32(reader);
+        break;
+    case OFFSET_JUMP_IF_FALSE_NOPOP:
+        code->data.OFFSET_JUMP_IF_FALSE_NOPOP.offset = read_i32(reader);
+        break;
+    case OFFSET_JUMP_IF_TRUE_NOPOP:
+        code->data.OFFSET_JUMP_IF_TRUE_NOPOP.offset = read_i32(reader);
+        break;
+    case PUSH_EXCEPTION_HANDLER:
+        code->data.PUSH_EXCEPTION_HANDLER.start_of_catch_block = read_i32(reader);
+        break;
+    case OFFSET_JUMP_IF_COMPARE_EXCEPTION_FALSE:
+        code->data.OFFSET_JUMP_IF_COMPARE_EXCEPTION_FALSE.offset = read_i32(reader);
+        break;
+    default:
+        break;
+    }
+
+    if (reader->failed)
+    {
+        // only the operand that was read is freed, the instruction is freed as if it had none
+        if (op_code == LOAD_CONST || op_code == CREATE_FUNCTION)
+            rtobj_free(operand, true, false);
+        else
+            free(operand);
+
+        code->op_code = POP_STACK;
+        free_ByteCode(code);
+        return NULL;
+    }
+    return code;
+}
+
+/**
+ * DESCRIPTION:
+ * Returns false if code does not jump, otherwise sets target to the index of the instruction it lands on,
+ * the runtime applies offsets to the index of the jump (see run_dispatch)
+ */
+static bool jump_target(const ByteCode *code, long index, long *target)
+{
+    switch (code->op_code)
+    {
+    case ABSOLUTE_JUMP:
+        *target = code->data.ABSOLUTE_JUMP.offset;
+        return true;
+    case OFFSET_JUMP:
+        *target = index + code->data.OFFSET_JUMP.offset;
+        return true;
+    case OFFSET_JUMP_IF_FALSE_POP:
+        *target = index + code->data.OFFSET_JUMP_IF_FALSE_POP.offset;
+        return true;
+    case OFFSET_JUMP_IF_TRUE_POP:
+        *target = index + code->data.OFFSET_JUMP_IF_TRUE_POP.offset;
+        return true;
+    case OFFSET_JUMP_IF_FALSE_NOPOP:
+        *target = index + code->data.OFFSET_JUMP_IF_FALSE_NOPOP.offset;
+        return true;
+    case OFFSET_JUMP_IF_TRUE_NOPOP:
+        *target = index + code->data.OFFSET_JUMP_IF_TRUE_NOPOP.offset;
+        return true;
+    case FOR_ITER:
+        *target = index + code->data.FOR_ITER.offset;
+        return true;
+    case PUSH_EXCEPTION_HANDLER:
+        *target = index + code->data.PUSH_EXCEPTION_HANDLER.start_of_catch_block;
+        return true;
+    case OFFSET_JUMP_IF_COMPARE_EXCEPTION_FALSE:
+        // the counter is still incremented after the jump
+        *target = index + code->data.OFFSET_JUMP_IF_COMPARE_EXCEPTION_FALSE.offset + 1;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Returns false for instructions without a count, otherwise sets count to the number of values they pop to build their result
+ */
+static bool popped_values(const ByteCode *code, long *count)
+{
+    switch (code->op_code)
+    {
+    case CREATE_LIST:
+        *count = code->data.CREATE_LIST.list_length;
+        return true;
+    case CREATE_SET:
+        *count = code->data.CREATE_SET.set_size;
+        return true;
+    case CREATE_MAP:
+        *count = code->data.CREATE_MAP.map_size < 0 ? -1 : 2L * code->data.CREATE_MAP.map_size;
+        return true;
+    case FUNCTION_CALL:
+        // the function is under its arguments
+        *count = code->data.FUNCTION_CALL.arg_count < 0 ? -1 : code->data.FUNCTION_CALL.arg_count + 1L;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Checks the operands of a decoded instruction list, the runtime trusts them,
+ * so an image with a wild jump or a bogus count would otherwise read outside of the program or the stack
+ *
+ * NOTE:
+ * - jumps must land on an instruction of the same list, and the last instruction cannot run past the end of it
+ * - counts cannot be negative, and the values they pop must have been pushed by instructions before them in the list,
+ *   which bounds the arrays the runtime allocates on the native stack for them by the size of the image
+ */
+static bool valid_operands(const ByteCodeList *list)
+{
+    // functions with an empty body are compiled to an empty list
+    if (list->pg_length == 0)
+        return true;
+
+    for (long i = 0; i < list->pg_length; i++)
+    {
+        const ByteCode *code = list->code[i];
+
+        long target;
+        if (jump_target(code, i, &target))
+        {
+            if (target < 0 || target >= list->pg_length)
+                return false;
+
+            // a jump to the first instruction is a long jump returning 0, which resumes the try block instead of the catch block
+            if (code->op_code == PUSH_EXCEPTION_HANDLER && target == 0)
+                return false;
+        }
+
+        long popped;
+        if (popped_values(code, &popped) && (popped < 0 || popped > i))
+            return false;
+
+        if ((code->op_code == CREATE_VAR && code->data.CREATE_VAR.access > DOES_NOT_APPLY) ||
+            (code->op_code == CREATE_EXCEPTION && code->data.CREATE_EXCEPTION.access > DOES_NOT_APPLY))
+            return false;
+    }
+
+    switch (list->code[list->pg_length - 1]->op_code)
+    {
+    case ABSOLUTE_JUMP:
+    case OFFSET_JUMP:
+    case FUNCTION_RETURN:
+    case FUNCTION_RETURN_UNDEFINED:
+    case EXIT_PROGRAM:
+    case CREATE_OBJECT_RETURN:
+    case RAISE_EXCEPTION:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static ByteCodeList *read_bytecode_list(CacheReader *reader, unsigned int nesting)
+{
+    uint32_t length = read_u32(reader);
+    if (reader->failed)
+        return NULL;
+
+    ByteCodeList *list = init_ByteCodeList();
+    for (uint32_t i = 0; i < length; i++)
+    {
+        ByteCode *code = read_bytecode(reader, nesting);
+        if (!code)
+        {
+            free_ByteCodeList(list);
+            return NULL;
+        }
+        add_bytecode(list, code);
+    }
+
+    if (!valid_operands(list))
+    {
+        reader->failed = true;
+        free_ByteCodeList(list);
+        return NULL;
+    }
+    return list;
+}
+
+/**
+ * DESCRIPTION:
+ * Decodes a cache image, returns NULL if it is invalid, was written by another version of the compiler, or does not match source
+ *
+ * PARAMS:
+ * source: source the program should have been compiled from, if NULL the image is trusted to be the program to run
+ * filename: file the functions of the program are declared in
+ */
+ByteCodeList *decode_bytecode_cache(const void *image, size_t size, const char *source, const char *filename)
+{
+    CacheHeader header;
+    if (size < sizeof(header))
+        return NULL;
+
+    memcpy(&header, image, sizeof(header));
+    if (memcmp(header.magic, BYTECODE_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BYTECODE_CACHE_VERSION ||
+        header.compiler_version != TLANG_COMPILER_VERSION ||
+        header.abi != cache_abi() ||
+        header.program_length != size - sizeof(header))
+        return NULL;
+
+    if (source)
+    {
+        size_t source_length = strlen(source);
+        if (header.source_length != source_length ||
+            header.source_hash != hash_bytes_with_seed(source, source_length, CACHE_HASH_SEED))
+            return NULL;
+    }
+
+    const uint8_t *program = (const uint8_t *)image + sizeof(header);
+    if (header.program_hash != hash_bytes_with_seed(program, header.program_length, CACHE_HASH_SEED))
+        return NULL;
+
+    CacheReader reader = {program, header.program_length, 0, filename ? filename : "", false};
+    ByteCodeList *list = read_bytecode_list(&reader, 0);
+
+    // trailing bytes mean the image is not what the writer produced
+    if (list && reader.pos != reader.length)
+    {
+        free_ByteCodeList(list);
+        return NULL;
+    }
+    return list;
+}
+
+/**
+ * DESCRIPTION:
+ * Loads the cached program of a source file, returns NULL if there is no valid cache for source
+ *
+ * PARAMS:
+ * source_path: path of the source file, it is also the file the functions of the program are declared in
+ * source: current contents of the source file
+ */
+ByteCodeList *load_bytecode_cache(const char *source_path, const char *source)
+{
+    char *path = bytecode_cache_path(source_path);
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0)
+        return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(CacheHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *image = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED)
+        return NULL;
+
+    ByteCodeList *program = decode_bytecode_cache(image, info.st_size, source, source_path);
+    munmap(image, info.st_size);
+    return program;
+}
+
+/**
+ * DESCRIPTION:
+ * Writes the cache of a source file, returns false if it could not be written (e.g read only directory)
+ *
+ * NOTE:
+ * The cache is written to a temporary file which is then renamed, so readers never see a partial cache
+ */
+bool write_bytecode_cache(const char *source_path, const char *source, const ByteCodeList *program)
+{
+    size_t size;
+    void *image = encode_bytecode_cache(program, source, &size);
+
+    char *path = bytecode_cache_path(source_path);
+    char *tmp_path = malloc(strlen(path) + 8);
+    if (!tmp_path)
+        MallocError();
+    sprintf(tmp_path, "%s.XXXXXX", path);
+
+    bool written = false;
+    int fd = mkstemp(tmp_path);
+    if (fd >= 0)
+    {
+        size_t offset = 0;
+        while (offset < size)
+        {
+            ssize_t count = write(fd, (const char *)image + offset, size - offset);
+            if (count <= 0)
+                break;
+            offset += count;
+        }
+
+        written = offset == size && fchmod(fd, 0644) == 0;
+        written = close(fd) == 0 && written;
+        written = written && rename(tmp_path, path) == 0;
+        if (!written)
+            unlink(tmp_path);
+    }
+
+    free(tmp_path);
+    free(path);
+    free(image);
+    return written;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "compiler.h"
+
+/**
+ * Bytecode cache files (.tlc), they let programs skip lexing, parsing, semantic analysis and compilation
+ *
+ * The cache of a file is written next to it (see bytecode_cache_path), it is made of a header followed by the encoded program:
+ * - header: magic, BYTECODE_CACHE_VERSION, the compiler version, the ABI of the writer (see cache_abi),
+ *           the hash and length of the source it was compiled from, and the length and hash of the program
+ * - program: the top level ByteCodeList, each instruction is its opcode, its line number and its operands.
+ *            Constants are stored by type, numbers as hexadecimal floats so they are read back exactly,
+ *            functions are stored with their arguments, closures and body, which is itself a ByteCodeList
+ *
+ * Caches are mapped in memory and fully validated before being used, a cache that does not match its source, or is corrupted, is ignored.
+ * Operands are validated too (jump targets, counts of popped values), images sent to a server are not trusted either.
+ * Integers are in the byte order of the writer, a cache is only meant for the machine that wrote it
+ */
+
+#define BYTECODE_CACHE_MAGIC "TLCB"
+#define BYTECODE_CACHE_VERSION 1
+#define BYTECODE_CACHE_EXTENSION ".tlc"
+
+// Disables reading and writing bytecode caches when set to a non empty value (same as --no-cache)
+#define BYTECODE_CACHE_DISABLE_ENV "TLANG_NO_CACHE"
+
+char *bytecode_cache_path(const char *source_path);
+void *encode_bytecode_cache(const ByteCodeList *program, const char *source, size_t *size);
+ByteCodeList *decode_bytecode_cache(const void *image, size_t size, const char *source, const char *filename);
+ByteCodeList *load_bytecode_cache(const char *source_path, const char *source);
+bool write_bytecode_cache(const char *source_path, const char *source, const ByteCodeList *program);
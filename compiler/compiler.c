@@ -161,11 +161,11 @@ static bool _are_free_vars_equal_via_name(const FreeVariable *var1, const FreeVa
 /* Hash function for free variable struct */
 static unsigned _hash_free_vars(const FreeVariable *var)
 {
-    return djb2_string_hash(var->varname);
+    return string_hash(var->varname);
 }
 
 /* Wrapper function for filtering elements with greater/equal nesting level */
-static int _nesting_lvl = 0;
+static _Thread_local int _nesting_lvl = 0;
 static bool _filter_by_nesting_lvl(const FreeVariable *var) { return var->nesting_lvl >= _nesting_lvl; }
 typedef bool (*NestingLevelFilter)(const FreeVariable *var);
 static NestingLevelFilter _filter_bge_nesting_lvl(const int nesting_lvl)
@@ -302,6 +302,13 @@ static void _collect_free_vars_from_exp_component(
             break;
         }
 
+        case LIST_SLICE:
+        {
+            _collect_free_vars_from_exp(recursion_lvl, node->meta_data.list_slice.start, free_var_set, bound_var_set);
+            _collect_free_vars_from_exp(recursion_lvl, node->meta_data.list_slice.end, free_var_set, bound_var_set);
+            break;
+        }
+
         case VARIABLE:
         {
             if (!node->sub_component)
@@ -448,6 +455,32 @@ static void _collect_free_vars_for_loop(
         bound_var_set);
 }
 
+/* Collects free vars from for (x in iterable) loops, the loop variable is bound in the loop body */
+static void _collect_free_vars_for_in_loop(
+    int recursion_lvl,
+    AST_node *node,
+    GenericSet *free_var_set,
+    GenericSet *bound_var_set)
+{
+    assert(node->type == FOR_IN_LOOP);
+
+    _collect_free_vars_from_exp(recursion_lvl, node->ast_data.exp, free_var_set, bound_var_set);
+
+    FreeVariable var = {node->identifier.declared_var, recursion_lvl + 1};
+    if (!GenericSet_has(bound_var_set, &var))
+    {
+        FreeVariable *var_ = _malloc_free_var_struct(node->identifier.declared_var, recursion_lvl + 1);
+        GenericSet_insert(bound_var_set, var_, false);
+    }
+
+    _collect_free_vars_from_body(
+        recursion_lvl + 1,
+        node->body,
+        true,
+        free_var_set,
+        bound_var_set);
+}
+
 /* Handles case for function declaration */
 static void _collect_free_vars_func_declaration(
     int recursion_lvl,
@@ -604,6 +637,9 @@ static void _collect_free_vars_from_ast_node(
     case FOR_LOOP:
         _collect_free_vars_for_loop(recursion_lvl, node, free_var_set, bound_var_set);
         break;
+    case FOR_IN_LOOP:
+        _collect_free_vars_for_in_loop(recursion_lvl, node, free_var_set, bound_var_set);
+        break;
     case FUNCTION_DECLARATION:
         _collect_free_vars_func_declaration(recursion_lvl, node, free_var_set, bound_var_set);
         break;
@@ -745,6 +781,7 @@ Compiler *init_Compiler(const char *filename)
     if (!compiler)
         return NULL;
     compiler->filename = cpy_string(filename);
+    compiler->iterators = 0;
     return compiler;
 }
 
@@ -945,6 +982,28 @@ ByteCodeList *compile_expression_component(Compiler *compiler, ExpressionCompone
         break;
     }
 
+    case LIST_SLICE:
+    {
+        // omitted bounds are loaded as null
+        ExpressionNode *bounds[] = {cm->meta_data.list_slice.start, cm->meta_data.list_slice.end};
+        for (int i = 0; i < 2; i++)
+        {
+            if (bounds[i])
+            {
+                list = concat_bytecode_lists(list, compile_expression(compiler, bounds[i]));
+            }
+            else
+            {
+                ByteCode *null_bound = init_ByteCode(LOAD_CONST, cm->line_num);
+                null_bound->data.LOAD_CONST.constant = init_RtObject(NULL_TYPE);
+                add_bytecode(list, null_bound);
+            }
+        }
+
+        instruction = init_ByteCode(LOAD_SLICE, cm->line_num);
+        break;
+    }
+
     case FUNC_CALL:
     {
         int arg_count = cm->meta_data.func_data.args_num;
@@ -1113,7 +1172,12 @@ ByteCode *compile_func_declaration(Compiler *compiler, AST_node *function)
     // Initializes function object
     // RtObject *func = init_RtObject(FUNCTION_TYPE);
     RtFunction *func = init_rtfunc(REGULAR_FUNC);
+
+    // iterators of enclosing loops belong to the stack of the caller, not the function
+    int iterators = compiler->iterators;
+    compiler->iterators = 0;
     func->func_data.user_func.body = compile_code_body(compiler, func_body, false, false);
+    compiler->iterators = iterators;
     func->func_data.user_func.func_name =
         function->type == FUNCTION_DECLARATION ? cpy_string(func_name) : NULL;
 
@@ -1494,6 +1558,68 @@ ByteCodeList *compile_for_loop(Compiler *compiler, AST_node *node, bool is_globa
     return loop_code;
 }
 
+/**
+ * DESCRIPTION:
+ * Logic for compiling for (x in iterable) loops, the iterable is never turned into a list:
+ *
+ *     <iterable>
+ *     GET_ITER
+ *     LOAD_CONST undefined, CREATE_VAR x
+ * L:  FOR_ITER x (exhausted -> E)
+ *     <body>
+ *     OFFSET_JUMP L
+ * E:  POP_STACK, POP_STACK (the iterator)
+ *     DEREF_VAR x
+ *
+ * PARAMS:
+ * node: for in loop ast node
+ * is_global_scope: wether for loop is contained within the global scope
+ */
+ByteCodeList *compile_for_in_loop(Compiler *compiler, AST_node *node, bool is_global_scope)
+{
+    assert(node->type == FOR_IN_LOOP);
+    char *varname = node->identifier.declared_var;
+
+    ByteCodeList *iterable = compile_expression(compiler, node->ast_data.exp);
+    add_bytecode(iterable, init_ByteCode(GET_ITER, node->line_nb));
+
+    // the loop variable always exists inside the loop, so that FOR_ITER can rebind it
+    ByteCode *placeholder = init_ByteCode(LOAD_CONST, node->line_nb);
+    placeholder->data.LOAD_CONST.constant = init_RtObject(UNDEFINED_TYPE);
+    ByteCode *create_var = init_ByteCode(CREATE_VAR, node->line_nb);
+    create_var->data.CREATE_VAR.new_var_name = cpy_string(varname);
+    create_var->data.CREATE_VAR.access = PUBLIC_ACCESS;
+    add_bytecode(iterable, placeholder);
+    add_bytecode(iterable, create_var);
+
+    compiler->iterators++;
+    ByteCodeList *compiled_body = compile_code_body(compiler, node->body, is_global_scope, true);
+    compiler->iterators--;
+
+    ByteCode *for_iter = init_ByteCode(FOR_ITER, node->line_nb);
+    for_iter->data.FOR_ITER.var = cpy_string(varname);
+    // +2 because we must jump over the offset jump at the end
+    for_iter->data.FOR_ITER.offset = (compiled_body ? compiled_body->pg_length : 0) + 2;
+
+    ByteCodeList *loop_code = concat_bytecode_lists(add_bytecode(init_ByteCodeList(), for_iter), compiled_body);
+
+    // break lands on the code popping the iterator, continue on FOR_ITER
+    loop_code = resolve_loop_continuation_termination(loop_code);
+
+    ByteCode *jump = init_ByteCode(OFFSET_JUMP, node->line_nb);
+    jump->data.OFFSET_JUMP.offset = loop_code->pg_length * -1;
+    add_bytecode(loop_code, jump);
+
+    add_bytecode(loop_code, init_ByteCode(POP_STACK, node->line_nb));
+    add_bytecode(loop_code, init_ByteCode(POP_STACK, node->line_nb));
+
+    ByteCode *deref = init_ByteCode(DEREF_VAR, node->line_nb);
+    deref->data.DEREF_VAR.var = cpy_string(varname);
+    add_bytecode(loop_code, deref);
+
+    return concat_bytecode_lists(iterable, loop_code);
+}
+
 /**
  * DESCRIPTION:
  * Compiles class body into a function, and adds a special bytecode at the end
@@ -1505,7 +1631,11 @@ ByteCode *compile_class_body(Compiler *compiler, AST_node *node)
     int arg_count = node->ast_data.obj_args.args_num;
 
     RtFunction *constructor = init_rtfunc(REGULAR_FUNC);
+
+    int iterators = compiler->iterators;
+    compiler->iterators = 0;
     constructor->func_data.user_func.body = compile_code_body(compiler, node->body, false, false);
+    compiler->iterators = iterators;
     constructor->func_data.user_func.func_name = cpy_string(node->identifier.obj_name);
     constructor->func_data.user_func.file_location = cpy_string(compiler->filename);
 
@@ -1666,9 +1796,19 @@ ByteCodeList *compile_code_body(Compiler *compiler, AST_List *body, bool is_glob
             ByteCodeList *compiled_rhs = compile_expression(compiler, node->ast_data.exp);
             ByteCodeList *compiled_lhs = compile_expression_component(compiler, node->identifier.expression_component);
 
+            // assigning to an index replaces the element inside the container,
+            // so the container and the index are loaded, but not the element itself
+            ByteCode *last = compiled_lhs->code[compiled_lhs->pg_length - 1];
+            bool store_index = last->op_code == LOAD_INDEX;
+            if (store_index)
+            {
+                compiled_lhs->pg_length--;
+                free_ByteCode(last);
+            }
+
             list = concat_bytecode_lists(list, concat_bytecode_lists(compiled_lhs, compiled_rhs));
 
-            ByteCode *instruction = init_ByteCode(MUTATE_VAR, node->line_nb);
+            ByteCode *instruction = init_ByteCode(store_index ? STORE_INDEX : MUTATE_VAR, node->line_nb);
 
             add_bytecode(list, instruction);
             break;
@@ -1709,6 +1849,13 @@ ByteCodeList *compile_code_body(Compiler *compiler, AST_List *body, bool is_glob
 
         case RETURN_VAL:
         {
+            // iterators of the enclosing for (x in ...) loops are left on the stack machine otherwise
+            for (int i = 0; i < compiler->iterators * 2; i++)
+            {
+                if (!list)
+                    list = init_ByteCodeList();
+                add_bytecode(list, init_ByteCode(POP_STACK, node->line_nb));
+            }
 
             ByteCodeList *return_exp = compile_expression(compiler, node->ast_data.exp);
             list = concat_bytecode_lists(list, return_exp);
@@ -1774,6 +1921,12 @@ ByteCodeList *compile_code_body(Compiler *compiler, AST_List *body, bool is_glob
             break;
         }
 
+        case FOR_IN_LOOP:
+        {
+            list = concat_bytecode_lists(list, compile_for_in_loop(compiler, node, is_global_scope));
+            break;
+        }
+
         case FUNCTION_DECLARATION:
         case INLINE_FUNCTION_DECLARATION:
         {
@@ -1899,6 +2052,10 @@ void free_ByteCode(ByteCode *bytecode)
         free(bytecode->data.DEREF_VAR.var);
         break;
 
+    case FOR_ITER:
+        free(bytecode->data.FOR_ITER.var);
+        break;
+
     case CREATE_VAR:
         free(bytecode->data.CREATE_VAR.new_var_name);
         break;
@@ -1926,6 +2083,9 @@ void free_ByteCode(ByteCode *bytecode)
     case CREATE_SET:
     case CREATE_MAP:
     case LOAD_INDEX:
+    case STORE_INDEX:
+    case LOAD_SLICE:
+    case GET_ITER:
     case FUNCTION_CALL:
     case ABSOLUTE_JUMP:
     case OFFSET_JUMP:
@@ -2039,6 +2199,18 @@ void deconstruct_bytecode(ByteCodeList *bytecode, int offset)
         case LOAD_INDEX:
             printf("LIST_INDEX\n");
             break;
+        case STORE_INDEX:
+            printf("STORE_INDEX\n");
+            break;
+        case LOAD_SLICE:
+            printf("LOAD_SLICE\n");
+            break;
+        case GET_ITER:
+            printf("GET_ITER\n");
+            break;
+        case FOR_ITER:
+            printf("FOR_ITER %s, %d offset\n", instrc->data.FOR_ITER.var, instrc->data.FOR_ITER.offset);
+            break;
         case FUNCTION_CALL:
             printf("FUNCTION_CALL %d Args \n", instrc->data.FUNCTION_CALL.arg_count);
             break;
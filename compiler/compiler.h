@@ -4,6 +4,9 @@
 #include "../parser/parser.h"
 #include "../runtime/rtobjects.h"
 
+// Version of the bytecode emitted by the compiler, bump it whenever the instructions it emits change (it invalidates bytecode caches)
+#define TLANG_COMPILER_VERSION 1
+
 typedef enum OpCode
 {
 
@@ -39,6 +42,23 @@ typedef enum OpCode
     // Uses it to fetch that index from second object on the stack
     LOAD_INDEX, // stack[n-1][stack[n]]
 
+    // Takes the 3 objects on the top of the stack as the container, the index and the new element (in that order)
+    // Pops them, and replaces the element at that index of the container by the new one
+    // The container is first given its own storage (see cow.h)
+    STORE_INDEX, // stack[n-2][stack[n-1]] = stack[n]
+
+    // Takes the 2 objects on the top of the stack as the end and start of a slice (Null when omitted),
+    // pops them along with the sliced object under them, and pushes the slice
+    LOAD_SLICE, // stack[n-2][stack[n-1] : stack[n]]
+
+    // Pops the object on top of the stack and pushes an iterator over it, made of 2 objects:
+    // the object being iterated over (containers are snapshotted, see rtobj_cow_cpy) and a cursor above it
+    GET_ITER,
+
+    // Advances the iterator on top of the stack (see GET_ITER), binding the next value to a variable,
+    // if the iterator is exhausted, jumps the program counter by the given offset instead
+    FOR_ITER,
+
     // Takes current object on the top of the stack and,
     // Jumps the program counter to a specific location (associated with that object),
     // Storing the return address on the stack
@@ -199,6 +219,12 @@ typedef struct ByteCode
             char *var;
         } DEREF_VAR;
 
+        struct
+        {
+            char *var;
+            int offset; // jump taken once the iterator is exhausted
+        } FOR_ITER;
+
         struct
         {
             RtObject *constant;
@@ -292,6 +318,10 @@ typedef struct ByteCodeList
 typedef struct Compiler
 {
     char *filename;
+
+    // number of for (x in ...) loops enclosing the code being compiled in the current function,
+    // each of them keeps its iterator (2 objects) on the stack machine
+    int iterators;
 } Compiler;
 
 #define compiler_free(compiler) free(compiler->filename); free(compiler);
@@ -303,6 +333,7 @@ GenericSet *collect_free_vars_ast_node(AST_node *node);
 Compiler *init_Compiler(const char *filename);
 ByteCodeList *init_ByteCodeList();
 ByteCode *init_ByteCode(OpCode code, size_t line_nb);
+ByteCodeList *add_bytecode(ByteCodeList *pg, ByteCode *instr);
 
 ByteCodeList *concat_bytecode_lists(ByteCodeList *lhs, ByteCodeList *rhs);
 
@@ -312,6 +343,7 @@ ByteCode *compile_func_declaration(Compiler *compiler, AST_node *function);
 ByteCodeList *compile_conditional_chain(Compiler *compiler, AST_node *node, bool is_global_scope);
 ByteCodeList *compile_try_catch_chain(Compiler *compiler, AST_node *node, bool is_global_scope, int rec_lvl);
 ByteCodeList *compiled_while_loop(Compiler *compiler, AST_node *node, bool is_global_scope);
+ByteCodeList *compile_for_in_loop(Compiler *compiler, AST_node *node, bool is_global_scope);
 ByteCodeList *compile_expression(Compiler *compiler, ExpressionNode *root);
 ByteCode *compile_class_body(Compiler *compiler, AST_node *node);
 ByteCodeList *compile_code_body(Compiler *compiler, AST_List *body, bool is_global_scope, bool add_derefs);
@@ -0,0 +1,549 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strkernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STR_KERNELS_X86
+#include <immintrin.h>
+// helpers inlined into a vectorized kernel must be compiled for the same target
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/**
+ * DESCRIPTION:
+ * Kernels are vectorized over blocks of 16 (SSE2) or 32 (AVX2) bytes, the remaining bytes are handled by the scalar kernel.
+ * The ASCII range test used everywhere is: c in [lo, hi] <=> (c - lo) as unsigned <= (hi - lo),
+ * it is done with a signed compare by biasing (c - lo) by 0x80, since there are no unsigned byte compares before AVX-512.
+ */
+
+typedef struct StrKernels
+{
+    const char *isa;
+    // flips the case of the 26 letters starting at lo ('a' for upper, 'A' for lower)
+    void (*convert_case)(char *dst, const char *src, size_t len, char lo);
+    bool (*all_in_class)(const char *str, size_t len, StrCharClass cls);
+    size_t (*leading_space)(const char *str, size_t len);
+    size_t (*trailing_space)(const char *str, size_t len);
+    long (*find)(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len);
+    size_t (*count_byte)(const char *str, size_t len, char c);
+} StrKernels;
+
+/* ----------------------------------------------- Scalar ----------------------------------------------- */
+
+#define in_range(c, lo, hi) ((unsigned char)((c) - (lo)) <= (unsigned char)((hi) - (lo)))
+
+static inline bool ascii_in_class(unsigned char c, StrCharClass cls)
+{
+    switch (cls)
+    {
+    case STR_CLASS_DIGIT:
+        return in_range(c, '0', '9');
+    case STR_CLASS_ALPHA:
+        return in_range(c | 0x20, 'a', 'z');
+    case STR_CLASS_ALNUM:
+        return in_range(c | 0x20, 'a', 'z') || in_range(c, '0', '9');
+    case STR_CLASS_SPACE:
+        return in_range(c, '\t', '\r') || c == ' ';
+    case STR_CLASS_UPPER:
+        return in_range(c, 'A', 'Z');
+    case STR_CLASS_LOWER:
+        return in_range(c, 'a', 'z');
+    }
+    return false;
+}
+
+static void scalar_convert_case(char *dst, const char *src, size_t len, char lo)
+{
+    for (size_t i = 0; i < len; i++)
+        dst[i] = in_range(src[i], lo, lo + 25) ? src[i] ^ 0x20 : src[i];
+}
+
+static bool scalar_all_in_class(const char *str, size_t len, StrCharClass cls)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!ascii_in_class((unsigned char)str[i], cls))
+            return false;
+    }
+    return true;
+}
+
+static size_t scalar_leading_space(const char *str, size_t len)
+{
+    size_t i = 0;
+    while (i < len && ascii_in_class((unsigned char)str[i], STR_CLASS_SPACE))
+        i++;
+    return i;
+}
+
+static size_t scalar_trailing_space(const char *str, size_t len)
+{
+    size_t end = len;
+    while (end > 0 && ascii_in_class((unsigned char)str[end - 1], STR_CLASS_SPACE))
+        end--;
+    return len - end;
+}
+
+static long scalar_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len)
+{
+    if (needle_len == 0)
+        return 0;
+    if (needle_len > haystack_len)
+        return -1;
+
+    // candidates are found with memchr on the first byte, then verified
+    const char *cur = haystack;
+    const char *last = haystack + (haystack_len - needle_len);
+    while (cur <= last)
+    {
+        cur = memchr(cur, needle[0], (size_t)(last - cur) + 1);
+        if (!cur)
+            return -1;
+        if (memcmp(cur + 1, needle + 1, needle_len - 1) == 0)
+            return cur - haystack;
+        cur++;
+    }
+    return -1;
+}
+
+static size_t scalar_count_byte(const char *str, size_t len, char c)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++)
+        count += str[i] == c;
+    return count;
+}
+
+static const StrKernels scalar_kernels = {
+    "scalar",
+    scalar_convert_case,
+    scalar_all_in_class,
+    scalar_leading_space,
+    scalar_trailing_space,
+    scalar_find,
+    scalar_count_byte};
+
+#ifdef STR_KERNELS_X86
+
+/* ------------------------------------------------ SSE2 ------------------------------------------------ */
+
+TARGET_SSE2 static inline __m128i sse2_in_range(__m128i x, char lo, char hi)
+{
+    __m128i biased = _mm_add_epi8(x, _mm_set1_epi8((char)(0x80 - lo)));
+    return _mm_cmplt_epi8(biased, _mm_set1_epi8((char)(0x80 + (hi - lo) + 1)));
+}
+
+TARGET_SSE2 static inline __m128i sse2_class_mask(__m128i x, StrCharClass cls)
+{
+    switch (cls)
+    {
+    case STR_CLASS_DIGIT:
+        return sse2_in_range(x, '0', '9');
+    case STR_CLASS_ALPHA:
+        return sse2_in_range(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+    case STR_CLASS_ALNUM:
+        return _mm_or_si128(sse2_in_range(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z'),
+                            sse2_in_range(x, '0', '9'));
+    case STR_CLASS_SPACE:
+        return _mm_or_si128(sse2_in_range(x, '\t', '\r'), _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+    case STR_CLASS_UPPER:
+        return sse2_in_range(x, 'A', 'Z');
+    case STR_CLASS_LOWER:
+        return sse2_in_range(x, 'a', 'z');
+    }
+    return _mm_setzero_si128();
+}
+
+TARGET_SSE2 static void sse2_convert_case(char *dst, const char *src, size_t len, char lo)
+{
+    const __m128i flip = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i letters = sse2_in_range(x, lo, lo + 25);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(x, _mm_and_si128(letters, flip)));
+    }
+    scalar_convert_case(dst + i, src + i, len - i, lo);
+}
+
+TARGET_SSE2 static bool sse2_all_in_class(const char *str, size_t len, StrCharClass cls)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(str + i));
+        if (_mm_movemask_epi8(sse2_class_mask(x, cls)) != 0xFFFF)
+            return false;
+    }
+    return scalar_all_in_class(str + i, len - i, cls);
+}
+
+TARGET_SSE2 static size_t sse2_leading_space(const char *str, size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(str + i));
+        uint32_t nonspace = ~(uint32_t)_mm_movemask_epi8(sse2_class_mask(x, STR_CLASS_SPACE)) & 0xFFFF;
+        if (nonspace)
+            return i + __builtin_ctz(nonspace);
+    }
+    return i + scalar_leading_space(str + i, len - i);
+}
+
+TARGET_SSE2 static size_t sse2_trailing_space(const char *str, size_t len)
+{
+    size_t end = len;
+    for (; end >= 16; end -= 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(str + end - 16));
+        uint32_t nonspace = ~(uint32_t)_mm_movemask_epi8(sse2_class_mask(x, STR_CLASS_SPACE)) & 0xFFFF;
+        if (nonspace)
+            return len - (end - 16 + (31 - __builtin_clz(nonspace)) + 1);
+    }
+    return (len - end) + scalar_trailing_space(str, end);
+}
+
+/**
+ * DESCRIPTION:
+ * Substring search, every position whose first AND last byte match the needle is a candidate,
+ * which filters out almost all positions 16 at a time before the remaining ones are verified with memcmp
+ */
+TARGET_SSE2 static long sse2_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len)
+{
+    if (needle_len <= 1 || needle_len > haystack_len)
+        return scalar_find(haystack, haystack_len, needle, needle_len);
+
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+    size_t i = 0;
+    for (; i + needle_len - 1 + 16 <= haystack_len; i += 16)
+    {
+        __m128i block_first = _mm_loadu_si128((const __m128i *)(haystack + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i *)(haystack + i + needle_len - 1));
+        uint32_t candidates = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+
+        while (candidates)
+        {
+            size_t pos = i + __builtin_ctz(candidates);
+            if (memcmp(haystack + pos + 1, needle + 1, needle_len - 2) == 0)
+                return (long)pos;
+            candidates &= candidates - 1;
+        }
+    }
+
+    long rest = scalar_find(haystack + i, haystack_len - i, needle, needle_len);
+    return rest < 0 ? -1 : (long)i + rest;
+}
+
+/**
+ * DESCRIPTION:
+ * Counts the matches of every byte lane in an 8 bit counter (a match is -1, so it is subtracted),
+ * the counters are summed with psadbw before any of them can overflow, i.e every 255 blocks
+ */
+TARGET_SSE2 static size_t sse2_count_byte(const char *str, size_t len, char c)
+{
+    const __m128i target = _mm_set1_epi8(c);
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 16 <= len)
+    {
+        __m128i counters = _mm_setzero_si128();
+        for (int blocks = 0; blocks < 255 && i + 16 <= len; blocks++, i += 16)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(str + i));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(x, target));
+        }
+        __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_extract_epi16(sums, 4);
+    }
+    return count + scalar_count_byte(str + i, len - i, c);
+}
+
+static const StrKernels sse2_kernels = {
+    "sse2",
+    sse2_convert_case,
+    sse2_all_in_class,
+    sse2_leading_space,
+    sse2_trailing_space,
+    sse2_find,
+    sse2_count_byte};
+
+/* ------------------------------------------------ AVX2 ------------------------------------------------ */
+
+TARGET_AVX2 static inline __m256i avx2_in_range(__m256i x, char lo, char hi)
+{
+    __m256i biased = _mm256_add_epi8(x, _mm256_set1_epi8((char)(0x80 - lo)));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + (hi - lo) + 1)), biased);
+}
+
+TARGET_AVX2 static inline __m256i avx2_class_mask(__m256i x, StrCharClass cls)
+{
+    switch (cls)
+    {
+    case STR_CLASS_DIGIT:
+        return avx2_in_range(x, '0', '9');
+    case STR_CLASS_ALPHA:
+        return avx2_in_range(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+    case STR_CLASS_ALNUM:
+        return _mm256_or_si256(avx2_in_range(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z'),
+                               avx2_in_range(x, '0', '9'));
+    case STR_CLASS_SPACE:
+        return _mm256_or_si256(avx2_in_range(x, '\t', '\r'), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+    case STR_CLASS_UPPER:
+        return avx2_in_range(x, 'A', 'Z');
+    case STR_CLASS_LOWER:
+        return avx2_in_range(x, 'a', 'z');
+    }
+    return _mm256_setzero_si256();
+}
+
+TARGET_AVX2 static void avx2_convert_case(char *dst, const char *src, size_t len, char lo)
+{
+    const __m256i flip = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i letters = avx2_in_range(x, lo, lo + 25);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(x, _mm256_and_si256(letters, flip)));
+    }
+    scalar_convert_case(dst + i, src + i, len - i, lo);
+}
+
+TARGET_AVX2 static bool avx2_all_in_class(const char *str, size_t len, StrCharClass cls)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(str + i));
+        if ((uint32_t)_mm256_movemask_epi8(avx2_class_mask(x, cls)) != UINT32_MAX)
+            return false;
+    }
+    return scalar_all_in_class(str + i, len - i, cls);
+}
+
+TARGET_AVX2 static size_t avx2_leading_space(const char *str, size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(str + i));
+        uint32_t nonspace = ~(uint32_t)_mm256_movemask_epi8(avx2_class_mask(x, STR_CLASS_SPACE));
+        if (nonspace)
+            return i + __builtin_ctz(nonspace);
+    }
+    return i + scalar_leading_space(str + i, len - i);
+}
+
+TARGET_AVX2 static size_t avx2_trailing_space(const char *str, size_t len)
+{
+    size_t end = len;
+    for (; end >= 32; end -= 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(str + end - 32));
+        uint32_t nonspace = ~(uint32_t)_mm256_movemask_epi8(avx2_class_mask(x, STR_CLASS_SPACE));
+        if (nonspace)
+            return len - (end - 32 + (31 - __builtin_clz(nonspace)) + 1);
+    }
+    return (len - end) + scalar_trailing_space(str, end);
+}
+
+TARGET_AVX2 static inline uint32_t avx2_find_candidates(const char *block, size_t needle_len, __m256i first, __m256i last)
+{
+    __m256i block_first = _mm256_loadu_si256((const __m256i *)block);
+    __m256i block_last = _mm256_loadu_si256((const __m256i *)(block + needle_len - 1));
+    return (uint32_t)_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last)));
+}
+
+TARGET_AVX2 static long avx2_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len)
+{
+    if (needle_len <= 1 || needle_len > haystack_len)
+        return scalar_find(haystack, haystack_len, needle, needle_len);
+
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needle_len - 1]);
+    size_t i = 0;
+    // two blocks per iteration, so that runs without candidates cost a single branch per 64 bytes
+    for (; i + needle_len - 1 + 64 <= haystack_len; i += 64)
+    {
+        uint64_t candidates = avx2_find_candidates(haystack + i, needle_len, first, last) |
+                              (uint64_t)avx2_find_candidates(haystack + i + 32, needle_len, first, last) << 32;
+
+        while (candidates)
+        {
+            size_t pos = i + __builtin_ctzll(candidates);
+            if (memcmp(haystack + pos + 1, needle + 1, needle_len - 2) == 0)
+                return (long)pos;
+            candidates &= candidates - 1;
+        }
+    }
+
+    long rest = sse2_find(haystack + i, haystack_len - i, needle, needle_len);
+    return rest < 0 ? -1 : (long)i + rest;
+}
+
+TARGET_AVX2 static size_t avx2_count_byte(const char *str, size_t len, char c)
+{
+    const __m256i target = _mm256_set1_epi8(c);
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 32 <= len)
+    {
+        __m256i counters = _mm256_setzero_si256();
+        for (int blocks = 0; blocks < 255 && i + 32 <= len; blocks++, i += 32)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(str + i));
+            counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(x, target));
+        }
+        __m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+        __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        count += (size_t)_mm_cvtsi128_si32(half) + (size_t)_mm_extract_epi16(half, 4);
+    }
+    return count + sse2_count_byte(str + i, len - i, c);
+}
+
+static const StrKernels avx2_kernels = {
+    "avx2",
+    avx2_convert_case,
+    avx2_all_in_class,
+    avx2_leading_space,
+    avx2_trailing_space,
+    avx2_find,
+    avx2_count_byte};
+
+#endif
+
+#if defined(STR_KERNELS_X86) && defined(__SSE2__)
+static const StrKernels *kernels = &sse2_kernels;
+#else
+static const StrKernels *kernels = &scalar_kernels;
+#endif
+
+/**
+ * DESCRIPTION:
+ * Picks the fastest kernels supported by the CPU, unless STR_KERNELS_ENV names a supported implementation
+ * Until this is called, kernels that every CPU the binary was compiled for supports are used
+ */
+void init_str_kernels()
+{
+    // candidates from fastest to slowest
+    const StrKernels *supported[3];
+    int count = 0;
+
+#ifdef STR_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        supported[count++] = &avx2_kernels;
+    if (__builtin_cpu_supports("sse2"))
+        supported[count++] = &sse2_kernels;
+#endif
+    supported[count++] = &scalar_kernels;
+
+    kernels = supported[0];
+
+    const char *forced = getenv(STR_KERNELS_ENV);
+    if (!forced)
+        return;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(supported[i]->isa, forced) == 0)
+        {
+            kernels = supported[i];
+            return;
+        }
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Name of the kernels in use ("scalar", "sse2" or "avx2")
+ */
+const char *str_kernels_isa()
+{
+    return kernels->isa;
+}
+
+/**
+ * DESCRIPTION:
+ * Writes src converted to upper case into dst, dst and src may be the same buffer
+ */
+void str_to_upper(char *dst, const char *src, size_t len)
+{
+    kernels->convert_case(dst, src, len, 'a');
+}
+
+/**
+ * DESCRIPTION:
+ * Writes src converted to lower case into dst, dst and src may be the same buffer
+ */
+void str_to_lower(char *dst, const char *src, size_t len)
+{
+    kernels->convert_case(dst, src, len, 'A');
+}
+
+/**
+ * DESCRIPTION:
+ * Returns wether every byte of str belongs to the character class, true for an empty string
+ */
+bool str_all_in_class(const char *str, size_t len, StrCharClass cls)
+{
+    return kernels->all_in_class(str, len, cls);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the number of whitespace bytes str starts with
+ */
+size_t str_leading_space(const char *str, size_t len)
+{
+    return kernels->leading_space(str, len);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the number of whitespace bytes str ends with
+ */
+size_t str_trailing_space(const char *str, size_t len)
+{
+    return kernels->trailing_space(str, len);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the index of the first occurence of needle in haystack, or -1 if there is none
+ * An empty needle is found at index 0
+ */
+long str_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len)
+{
+    return kernels->find(haystack, haystack_len, needle, needle_len);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the number of non overlapping occurences of needle in haystack, searched from left to right
+ * The needle must not be empty
+ */
+size_t str_count(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len)
+{
+    assert(needle_len > 0);
+    if (needle_len == 1)
+        return kernels->count_byte(haystack, haystack_len, needle[0]);
+
+    size_t count = 0;
+    size_t pos = 0;
+    long found;
+    while ((found = kernels->find(haystack + pos, haystack_len - pos, needle, needle_len)) >= 0)
+    {
+        count++;
+        pos += (size_t)found + needle_len;
+    }
+    return count;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Byte level string kernels used by the string builtins
+ *
+ * Every kernel has a scalar, an SSE2 and an AVX2 implementation, the best one supported by the CPU is picked
+ * once by init_str_kernels(). All kernels work on ASCII and match the "C" locale ctype functions,
+ * bytes >= 0x80 are never converted and never belong to a character class.
+ */
+
+// Forces the kernel implementation ("scalar", "sse2" or "avx2"), the best supported one is used otherwise
+#define STR_KERNELS_ENV "TLANG_STR_KERNELS"
+
+typedef enum StrCharClass
+{
+    STR_CLASS_DIGIT,
+    STR_CLASS_ALPHA,
+    STR_CLASS_ALNUM,
+    STR_CLASS_SPACE,
+    STR_CLASS_UPPER,
+    STR_CLASS_LOWER
+} StrCharClass;
+
+void init_str_kernels();
+const char *str_kernels_isa();
+
+void str_to_upper(char *dst, const char *src, size_t len);
+void str_to_lower(char *dst, const char *src, size_t len);
+bool str_all_in_class(const char *str, size_t len, StrCharClass cls);
+size_t str_leading_space(const char *str, size_t len);
+size_t str_trailing_space(const char *str, size_t len);
+long str_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len);
+size_t str_count(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len);
@@ -3,6 +3,9 @@
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
 #include "utilities.h"
 
 /**
@@ -136,23 +139,175 @@ char *surround_string(const char *str, size_t strlen, char start, char end)
     return newstr;
 }
 
+/***** Seeded hashing (wyhash) ******/
+
+// wyhash default secret
+static const uint64_t hash_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+static uint64_t hash_seed = 0;
+static bool hash_seed_initialized = false;
+
 /**
  * DESCRIPTION:
- * Hash function for strings
+ * Picks the per process hash seed, either from the HASH_SEED_ENV environment variable (for reproducible runs),
+ * or from /dev/urandom, falling back to the time, the pid and the address space layout
+ *
+ * NOTE:
+ * Called lazily by the hash functions, the seed must not change once something has been hashed
+ */
+void init_hash_seed()
+{
+    if (hash_seed_initialized)
+        return;
+
+    hash_seed_initialized = true;
+
+    const char *env = getenv(HASH_SEED_ENV);
+    if (env && env[0] != '\0')
+    {
+        hash_seed = strtoull(env, NULL, 0);
+        return;
+    }
+
+    FILE *urandom = fopen("/dev/urandom", "rb");
+    if (urandom)
+    {
+        size_t read = fread(&hash_seed, sizeof(hash_seed), 1, urandom);
+        fclose(urandom);
+        if (read == 1)
+            return;
+    }
+
+    hash_seed = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32) ^ (uint64_t)(uintptr_t)&hash_seed;
+}
+
+/**
+ * DESCRIPTION:
+ * 64x64 -> 128 bit multiplication, both halves of the product are folded together
+ */
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static inline uint64_t read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * DESCRIPTION:
+ * Seeded hash of an arbitrary buffer (wyhash), it reads 16 to 48 bytes per iteration
+ *
  * PARAMS:
- * str: string to be hashed
+ * data: buffer to hash
+ * len: length of the buffer in bytes
  */
-unsigned int djb2_string_hash(const char *str)
+uint64_t hash_bytes(const void *data, size_t len)
 {
-    assert(str);
-    unsigned int hash = 5381;
-    int c;
+    if (!hash_seed_initialized)
+        init_hash_seed();
+
+    return hash_bytes_with_seed(data, len, hash_seed);
+}
 
-    while ((c = *str++))
+/**
+ * DESCRIPTION:
+ * Same as hash_bytes with a given seed, used for hashes that must be the same in every process (e.g bytecode cache keys)
+ */
+uint64_t hash_bytes_with_seed(const void *data, size_t len, uint64_t initial_seed)
+{
+    const uint8_t *p = data;
+    uint64_t seed = initial_seed ^ hash_mix(initial_seed ^ hash_secret[0], hash_secret[1]);
+    uint64_t a, b;
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
     {
-        hash = ((hash << 5) + hash) + c; // hash * 33 + c
+        size_t i = len;
+        if (i > 48)
+        {
+            uint64_t seed1 = seed, seed2 = seed;
+            do
+            {
+                seed = hash_mix(read64(p) ^ hash_secret[1], read64(p + 8) ^ seed);
+                seed1 = hash_mix(read64(p + 16) ^ hash_secret[2], read64(p + 24) ^ seed1);
+                seed2 = hash_mix(read64(p + 32) ^ hash_secret[3], read64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+
+        while (i > 16)
+        {
+            seed = hash_mix(read64(p) ^ hash_secret[1], read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+
+        // last 16 bytes, may overlap with bytes already hashed
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
     }
-    return hash;
+
+    a ^= hash_secret[1];
+    b ^= seed;
+    __uint128_t r = (__uint128_t)a * b;
+    a = (uint64_t)r;
+    b = (uint64_t)(r >> 64);
+    return hash_mix(a ^ hash_secret[0] ^ len, b ^ hash_secret[1]);
+}
+
+/**
+ * DESCRIPTION:
+ * Seeded hash of a 64 bit integer
+ */
+uint64_t hash_u64(uint64_t val)
+{
+    if (!hash_seed_initialized)
+        init_hash_seed();
+
+    return hash_mix(val ^ hash_seed ^ hash_secret[0], hash_mix(val ^ hash_secret[1], hash_seed ^ hash_secret[2]));
+}
+
+/**
+ * DESCRIPTION:
+ * Hash function for strings
+ * PARAMS:
+ * str: string to be hashed
+ */
+unsigned int string_hash(const char *str)
+{
+    assert(str);
+    return (unsigned int)hash_bytes(str, strlen(str));
 }
 
 /**
@@ -165,8 +320,7 @@ unsigned int djb2_string_hash(const char *str)
 unsigned int hash_int(const int *integer)
 {
     assert(integer);
-    const unsigned int A = 2654435769; // A is a constant fraction close to (sqrt(5) - 1) / 2
-    return (unsigned int)(A * (*integer));
+    return (unsigned int)hash_u64((uint64_t)(int64_t)*integer);
 }
 
 /**
@@ -178,34 +332,7 @@ unsigned int hash_int(const int *integer)
  */
 unsigned int hash_pointer(const void *ptr)
 {
-    uintptr_t uintptr = (uintptr_t)ptr;
-    uintptr_t hash = uintptr;
-    hash ^= (hash >> 21);
-    hash ^= (hash << 37);
-    hash ^= (hash >> 4);
-    return (unsigned int)hash;
-}
-
-/**
- * DESCRIPTION:
- * MurmurHash3 implementation for 64-bit doubles, returning unsigned int
- */
-unsigned int murmurHashUInt(double key)
-{
-    const uint64_t seed = 0xc70f6907ULL; // Seed value for the hash function
-    const uint64_t m = 0xc6a4a7935bd1e995ULL;
-    const int r = 47;
-    uint64_t h = seed ^ (sizeof(double) * m);
-    uint64_t k = *((uint64_t *)&key);
-    k *= m;
-    k ^= k >> r;
-    k *= m;
-    h ^= k;
-    h *= m;
-    h ^= h >> r;
-    h *= m;
-    h ^= h >> r;
-    return ((unsigned int)(h & 0xFFFFFFFF));
+    return (unsigned int)hash_u64((uint64_t)(uintptr_t)ptr);
 }
 
 /**
@@ -290,7 +417,7 @@ bool ptr_equal(const void *ptr1, const void *ptr2) { return ptr1 == ptr2; }
  * PARAMS:
  * integer: int to be compared
  */
-static int _compare_val = 0;
+static _Thread_local int _compare_val = 0;
 static bool _integer_filter(const int *integer) { return (*integer) >= _compare_val; }
 
 /**
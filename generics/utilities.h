@@ -1,6 +1,8 @@
 #pragma once
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
 
 typedef enum ErrorCode
 {
@@ -16,10 +18,16 @@ void exitprogram(ErrorCode code);
 char *cpy_string(const char *str);
 char* append_char(const char *str, char c);
 char *surround_string(const char *str, size_t strlen, char start, char end);
-unsigned int djb2_string_hash(const char *str);
+// Fixes the hash seed (any integer strtoull accepts), otherwise a random seed is picked for every process
+#define HASH_SEED_ENV "TLANG_HASH_SEED"
+
+void init_hash_seed();
+uint64_t hash_bytes(const void *data, size_t len);
+uint64_t hash_bytes_with_seed(const void *data, size_t len, uint64_t seed);
+uint64_t hash_u64(uint64_t val);
+unsigned int string_hash(const char *str);
 unsigned int hash_pointer(const void* ptr);
 unsigned int hash_int(const int *integer);
-unsigned int murmurHashUInt(double key);
 bool strings_equal(const char *str1, const char *str2);
 bool integers_equal(const int *integer1, const int *integer2);
 bool ptr_equal(const void* ptr1, const void* ptr2);
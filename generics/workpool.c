@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "workpool.h"
+
+/**
+ * DESCRIPTION: This file contains the implementation of the work stealing scheduler used by parallel built in functions
+ */
+
+// each worker takes chunks of about 1/WORKPOOL_CHUNKS_PER_WORKER of its initial share, so that stealing rebalances the load
+#define WORKPOOL_CHUNKS_PER_WORKER 8
+
+/**
+ * DESCRIPTION:
+ * Creates a work pool splitting the indices [0, length) evenly between workers
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ */
+__attribute__((warn_unused_result))
+WorkPool *init_WorkPool(size_t length, unsigned int workers)
+{
+    assert(workers > 0);
+
+    WorkPool *pool = malloc(sizeof(WorkPool));
+    if (!pool)
+        return NULL;
+
+    pool->ranges = malloc(sizeof(WorkRange) * workers);
+    if (!pool->ranges)
+    {
+        free(pool);
+        return NULL;
+    }
+
+    pool->workers = workers;
+    pool->grain = length / ((size_t)workers * WORKPOOL_CHUNKS_PER_WORKER);
+    if (pool->grain == 0)
+        pool->grain = 1;
+    atomic_init(&pool->limit, length);
+
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        pthread_mutex_init(&pool->ranges[i].lock, NULL);
+        pool->ranges[i].begin = length * i / workers;
+        pool->ranges[i].end = length * (i + 1) / workers;
+    }
+
+    return pool;
+}
+
+/**
+ * DESCRIPTION:
+ * Number of indices left in a range, indices past the limit of the pool are not counted, the lock of the range must be held
+ */
+static size_t range_left(WorkPool *pool, const WorkRange *range)
+{
+    size_t limit = atomic_load(&pool->limit);
+    size_t end = range->end < limit ? range->end : limit;
+    return range->begin < end ? end - range->begin : 0;
+}
+
+/**
+ * DESCRIPTION:
+ * Takes at most grain indices from the front of a range, returns false if it is empty
+ */
+static bool take_chunk(WorkPool *pool, WorkRange *range, size_t *begin, size_t *end)
+{
+    pthread_mutex_lock(&range->lock);
+    size_t left = range_left(pool, range);
+    bool found = left > 0;
+    if (found)
+    {
+        *begin = range->begin;
+        *end = range->begin + (left > pool->grain ? pool->grain : left);
+        range->begin = *end;
+    }
+    pthread_mutex_unlock(&range->lock);
+    return found;
+}
+
+/**
+ * DESCRIPTION:
+ * Steals the back half of the largest range of the other workers and makes it the range of worker,
+ * returns false if no other worker has indices left
+ *
+ * NOTE:
+ * At most one lock is held at a time, so workers stealing from each other cannot deadlock
+ */
+static bool steal(WorkPool *pool, unsigned int worker)
+{
+    while (true)
+    {
+        unsigned int victim = worker;
+        size_t largest = 0;
+
+        for (unsigned int i = 0; i < pool->workers; i++)
+        {
+            if (i == worker)
+                continue;
+
+            pthread_mutex_lock(&pool->ranges[i].lock);
+            size_t left = range_left(pool, &pool->ranges[i]);
+            pthread_mutex_unlock(&pool->ranges[i].lock);
+
+            if (left > largest)
+            {
+                largest = left;
+                victim = i;
+            }
+        }
+
+        if (victim == worker)
+            return false;
+
+        // the victim may have taken more indices in the meantime, it is looked up again if its range is now empty
+        WorkRange *range = &pool->ranges[victim];
+        pthread_mutex_lock(&range->lock);
+        size_t left = range_left(pool, range);
+        size_t end = range->begin + left;
+        size_t begin = end - (left + 1) / 2;
+        range->end = begin;
+        pthread_mutex_unlock(&range->lock);
+
+        if (begin == end)
+            continue;
+
+        WorkRange *own = &pool->ranges[worker];
+        pthread_mutex_lock(&own->lock);
+        own->begin = begin;
+        own->end = end;
+        pthread_mutex_unlock(&own->lock);
+        return true;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Gives the next chunk of indices [begin, end) to run by a worker.
+ * Returns false once every index below the limit of the pool was given to a worker
+ *
+ * PARAMS:
+ * worker: index of the worker, in [0, workers)
+ */
+bool WorkPool_next(WorkPool *pool, unsigned int worker, size_t *begin, size_t *end)
+{
+    assert(worker < pool->workers);
+
+    while (true)
+    {
+        if (take_chunk(pool, &pool->ranges[worker], begin, end))
+            return true;
+
+        if (!steal(pool, worker))
+            return false;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Drops the indices from limit on that were not given to any worker yet, indices below it are still given out.
+ * Chunks being run are not interrupted, workers check WorkPool_limit to skip the rest of their chunk
+ *
+ * NOTE:
+ * The limit only decreases, a higher limit than the current one is ignored
+ */
+void WorkPool_truncate(WorkPool *pool, size_t limit)
+{
+    size_t current = atomic_load(&pool->limit);
+    while (limit < current && !atomic_compare_exchange_weak(&pool->limit, &current, limit))
+        ;
+}
+
+size_t WorkPool_limit(WorkPool *pool)
+{
+    return atomic_load(&pool->limit);
+}
+
+/**
+ * DESCRIPTION:
+ * Frees work pool, no worker can use it anymore
+ */
+void free_WorkPool(WorkPool *pool)
+{
+    if (!pool)
+        return;
+
+    for (unsigned int i = 0; i < pool->workers; i++)
+        pthread_mutex_destroy(&pool->ranges[i].lock);
+
+    free(pool->ranges);
+    free(pool);
+}
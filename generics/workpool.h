@@ -0,0 +1,36 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/**
+ * DESCRIPTION:
+ * Range of indices [begin, end) left to a worker of a work pool
+ */
+typedef struct WorkRange
+{
+    pthread_mutex_t lock;
+    size_t begin;
+    size_t end;
+} WorkRange;
+
+/**
+ * DESCRIPTION:
+ * Work stealing scheduler of the indices [0, length) between a fixed number of workers.
+ * Each worker starts with an equal share of the indices and takes chunks from the front of its own range,
+ * once its range is empty it steals the back half of the largest range left to the other workers
+ */
+typedef struct WorkPool
+{
+    WorkRange *ranges;      // range of each worker
+    unsigned int workers;   // number of workers
+    size_t grain;           // max number of indices a worker takes from its own range at once
+    atomic_size_t limit;    // indices from limit on are not given to workers anymore (see WorkPool_truncate)
+} WorkPool;
+
+WorkPool *init_WorkPool(size_t length, unsigned int workers);
+bool WorkPool_next(WorkPool *pool, unsigned int worker, size_t *begin, size_t *end);
+void WorkPool_truncate(WorkPool *pool, size_t limit);
+size_t WorkPool_limit(WorkPool *pool);
+void free_WorkPool(WorkPool *pool);
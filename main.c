@@ -1,25 +1,34 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <setjmp.h>
 #include <assert.h>
 #include "generics/utilities.h"
-#include "parser/keywords.h"
-#include "misc/dbgtools.h"
-#include "parser/semanalysis.h"
 #include "parser/lexer.h"
-#include "compiler/compiler.h"
-#include "generics/hashset.h"
-#include "runtime/runtime.h"
+#include "runtime/vm.h"
+#include "runtime/vmserver.h"
+#include "compiler/bytecodecache.h"
+#include "runtime/gc.h"
+#include "runtime/heapsnapshot.h"
+#include "misc/heapanalyzer.h"
 
 int return_code = 0;
 char *mainfile = NULL;
-jmp_buf global_program_interrupt;
 
 bool exec_prog_flag = true;
 bool print_lexer_flag = false;
 bool print_ast_flag = false;
 bool print_bytecode_flag = false;
 bool print_help_msg_flag = false;
+bool print_gc_stats_flag = false;
+bool bytecode_cache_flag = true;
+
+// heap snapshot given to --analyze-heap, no script is run when its set
+char *analyze_heap_path = NULL;
+
+// socket given to --serve, scripts are then run on requests (see vmserver.h)
+char *serve_socket_path = NULL;
+
+// GC pacing policy, initialized from the environment and overridden by CLI flags
+GCPolicy gc_policy;
 
 // this pointer should never be freed
 char *inline_script = NULL;
@@ -52,81 +61,63 @@ const char *help_output =
     "   --lexer: Will print lexing information of program \n"
     "   --run: Input file will be run \n"
     "   --norun: Input file will not be run \n"
+    "   --no-cache: Input file is compiled without reading or writing its bytecode cache (.tlc file next to it, env " BYTECODE_CACHE_DISABLE_ENV ") \n"
+    "   --gc-stats: Prints garbage collector statistics as JSON to stderr on exit \n"
+    "   --gc-initial-heap <N> : Number of live objects before the first collection (env " GC_INITIAL_HEAP_ENV ") \n"
+    "   --gc-growth-factor <F> : Heap growth factor (>= 1) between collections (env " GC_GROWTH_FACTOR_ENV ") \n"
+    "   --gc-tick-interval <N> : Max number of instructions between collections (env " GC_TICK_INTERVAL_ENV ") \n"
+    "   --gc-max-heap <N> : Max live objects, exceeding it raises OutOfMemoryException, 0 is unlimited (env " GC_MAX_HEAP_ENV ") \n"
+    "   --analyze-heap <SNAPSHOT> : Prints the top retainers and dominator tree of a heap snapshot, \n"
+    "       snapshots are written by heap_snapshot(path) or on SIGUSR1 (file prefix from env " HEAP_SNAPSHOT_PREFIX_ENV ") \n"
+    "   --serve <SOCKET> : Keeps a warm interpreter serving scripts over a UNIX socket until SIGINT or SIGTERM, \n"
+    "       every request is run with a fresh heap, its output is streamed back (see runtime/vmserver.h) \n"
     "   --script <CODE> : Input file will not be run, instead the code given as a argument will \n"
     "   --script-args <ARG1 ARG2 ... > : CLI Arguments given to input script \n";
 
-/* performs cleanup operations in case of parsing error */
-static void parser_error_cleanup(Parser *parser)
-{
-    // frees all memory malloced during parsing
-    clear_memtracker_pointers(parser->memtracker);
-    free_parser(parser);
-}
-
 /**
  * DESCRIPTION:
- * Parses program and performs semantic analysis. If program is valid, ast is returned. Otheriwise NULL is returned
- *
- * PARAMS:
- * file_contents: raw text of mainfile
- * tokens: mainfile tokenized
- * 
- * NOTE:
- * tokens is freed in this function
+ * Helpers for parsing the numeric value of a GC CLI flag, returns false and prints an error if value is invalid
  */
-AST_List *generate_AST(char *file_contents, TokenList *tokens)
+static bool parse_gc_size_arg(int argc, char *argv[], int *i, size_t *out)
 {
-    jmp_buf before_parsing;
-
-    Parser *parser = init_Parser();
-    parser->token_list = tokens;
-    parser->lines.lines =
-        tokenize_str_by_seperators(file_contents, '\n', &parser->lines.line_count);
-    
-    // if mainfile is NULL, then --script argument was provided
-    parser->file_name = cpy_string(mainfile? mainfile: "--script ARG");
-
-    parser->error_handler = &before_parsing;
-    int error_return = setjmp((int *)&before_parsing);
-
-    // if an error is detected, long jump is performed and if statement is called
-    if (error_return != 0)
+    char *end = NULL;
+    if (argc == *i + 1 || argv[*i + 1][0] == '-')
     {
-    parser_error:;
-        assert(parser->error_indicator);
-        parser_error_cleanup(parser);
-        return NULL;
+        printf("%s expects a non negative integer. Run --help to see arguments.\n", argv[*i]);
+        return false;
     }
 
-    // parses program
-    enum token_type end_of_program[] = {END_OF_FILE};
-    AST_List *ast = parse_code_block(parser, NULL, 0, false, end_of_program, 1);
-
-    if (parser->error_indicator)
-        goto parser_error;
-
-    // for debugging purposes
-    if (print_ast_flag)
-        print_ast_list(ast, "  ", 0);
-
-    // performs semantic anaylsis
-    SemanticAnalyzer *sem_analyser = malloc_semantic_analyser(
-        mainfile,
-        parser->lines.lines,
-        parser->lines.line_count,
-        parser->token_list);
+    unsigned long long val = strtoull(argv[*i + 1], &end, 10);
+    if (end == argv[*i + 1] || *end != '\0')
+    {
+        printf("%s expects a non negative integer, got '%s'.\n", argv[*i], argv[*i + 1]);
+        return false;
+    }
 
-    free_parser(parser);
+    *out = (size_t)val;
+    (*i)++;
+    return true;
+}
 
-    bool is_sem_valid = AST_list_has_consistent_semantics(sem_analyser, ast);
-    if (!is_sem_valid)
+static bool parse_gc_factor_arg(int argc, char *argv[], int *i, double *out)
+{
+    char *end = NULL;
+    if (argc == *i + 1)
     {
-        free_ast_list(ast);
+        printf("%s expects a number >= 1. Run --help to see arguments.\n", argv[*i]);
+        return false;
     }
 
-    free_semantic_analyser(sem_analyser);
+    double val = strtod(argv[*i + 1], &end);
+    if (end == argv[*i + 1] || *end != '\0' || val < 1.0)
+    {
+        printf("%s expects a number >= 1, got '%s'.\n", argv[*i], argv[*i + 1]);
+        return false;
+    }
 
-    return is_sem_valid ? ast : NULL;
+    *out = val;
+    (*i)++;
+    return true;
 }
 
 static bool parse_program_args(int argc, char *argv[])
@@ -173,6 +164,54 @@ static bool parse_program_args(int argc, char *argv[])
         {
             exec_prog_flag = false;
         }
+        else if (strings_equal(argv[i], "--no-cache"))
+        {
+            bytecode_cache_flag = false;
+        }
+        else if (strings_equal(argv[i], "--gc-stats"))
+        {
+            print_gc_stats_flag = true;
+        }
+        else if (strings_equal(argv[i], "--gc-initial-heap"))
+        {
+            if (!parse_gc_size_arg(argc, argv, &i, &gc_policy.initial_heap))
+                return false;
+        }
+        else if (strings_equal(argv[i], "--gc-growth-factor"))
+        {
+            if (!parse_gc_factor_arg(argc, argv, &i, &gc_policy.growth_factor))
+                return false;
+        }
+        else if (strings_equal(argv[i], "--gc-tick-interval"))
+        {
+            if (!parse_gc_size_arg(argc, argv, &i, &gc_policy.tick_interval))
+                return false;
+        }
+        else if (strings_equal(argv[i], "--gc-max-heap"))
+        {
+            if (!parse_gc_size_arg(argc, argv, &i, &gc_policy.max_heap))
+                return false;
+        }
+        else if (strings_equal(argv[i], "--analyze-heap"))
+        {
+            if (argc == i + 1)
+            {
+                printf("Must provide a heap snapshot to --analyze-heap argument. Run --help to see arguments.\n");
+                return false;
+            }
+
+            analyze_heap_path = argv[++i];
+        }
+        else if (strings_equal(argv[i], "--serve"))
+        {
+            if (argc == i + 1)
+            {
+                printf("Must provide a socket path to --serve argument. Run --help to see arguments.\n");
+                return false;
+            }
+
+            serve_socket_path = argv[++i];
+        }
         else if (strings_equal(argv[i], "--help"))
         {
             printf("%s", help_output);
@@ -208,6 +247,9 @@ static bool parse_program_args(int argc, char *argv[])
 /* MAIN PROGRAM LOGIC */
 int main(int argc, char *argv[])
 {
+    gc_policy = default_GC_policy();
+    load_GC_policy_env(&gc_policy);
+
     if (!parse_program_args(argc, argv))
         return 1;
 
@@ -217,6 +259,16 @@ int main(int argc, char *argv[])
     if (print_help_msg_flag)
         return 0;
 
+    if (analyze_heap_path)
+        return analyze_heap_snapshot(analyze_heap_path);
+
+    if (serve_socket_path)
+    {
+        return_code = VM_serve(serve_socket_path, &gc_policy, bytecode_cache_flag);
+        cleanup_VM_shared();
+        return return_code;
+    }
+
     char *file_contents = cpy_string(inline_script);
     
     if(!file_contents) {
@@ -234,64 +286,32 @@ int main(int argc, char *argv[])
 
     }
 
-    init_keyword_table();
-    init_Precedence();
-
-    TokenList *tokens = tokenize_file(file_contents);
+    VM *vm = init_VM(mainfile);
+    vm->gc_policy = gc_policy;
+    vm->print_tokens = print_lexer_flag;
+    vm->print_ast = print_ast_flag;
+    vm->print_bytecode = print_bytecode_flag;
+    vm->print_gc_stats = print_gc_stats_flag;
 
-    // prints lexing info, if user requests it
-    if (print_lexer_flag)
-        print_token_list(tokens);
+    // inline scripts have no file to cache
+    vm->bytecode_cache = bytecode_cache_flag && !inline_script;
 
-    AST_List *program_ast = generate_AST(file_contents, tokens);
+    // makes sure that program is valid
+    bool valid = VM_compile(vm, file_contents);
     free(file_contents);
 
-    // makes sure that program is valid
-    if (!program_ast)
+    if (valid && exec_prog_flag)
     {
-        free_keyword_table();
-        return 1;
+        install_heap_snapshot_signal();
+        return_code = VM_run(vm, script_args_count, script_args);
     }
-
-    // Compiles program
-    Compiler *compiler = init_Compiler(mainfile);
-    ByteCodeList *list = compile_code_body(compiler, program_ast, true, false);
-
-    // frees structs that are no longer needed
-    compiler_free(compiler);
-    free_ast_list(program_ast);
-    free_keyword_table();
-
-    // user requests to deconstruct bytecode
-    if (print_bytecode_flag)
-        deconstruct_bytecode(list, 0);
-
-    if(exec_prog_flag) {    
-        // printf("%d", script_args_count);
-        // Inits important structures used by runtime environment
-        if (!prep_runtime_env(list, mainfile, script_args_count, script_args))
-        {
-            free_ByteCodeList(list);
-            printf("Error occurred Setting up runtime environment.\n");
-            return 1;
-        }
-
-        // This is the global program interrupt
-        // if an unhandled exception occurs, a long jump is performed to this instruction
-        // with a non zero return code
-        int error_return = setjmp((int *)&global_program_interrupt);
-
-        // Runs program
-        if (error_return == 0)
-            return_code = run_program();
-        else
-            return_code = error_return;
-
-        perform_runtime_cleanup();
+    else if (!valid)
+    {
+        return_code = 1;
     }
 
+    free_VM(vm);
     free_script_args();
-    free_ByteCodeList(list);
-    free_keyword_table();
+    cleanup_VM_shared();
     return return_code;
 }
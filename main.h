@@ -1,4 +0,0 @@
-#pragma once
-#include <setjmp.h>
-
-extern jmp_buf global_program_interrupt;
\ No newline at end of file
@@ -212,6 +212,15 @@ void print_expression_component(ExpressionComponent *component, char *buffer, in
         break;
     }
 
+    case LIST_SLICE:
+    {
+        printf(" LIST_SLICE -> \n");
+        rec_lvl++;
+        print_expression_tree(component->meta_data.list_slice.start, buffer, rec_lvl);
+        print_expression_tree(component->meta_data.list_slice.end, buffer, rec_lvl);
+        break;
+    }
+
     case FUNC_CALL:
     {
         printf(" FUNC_CAL -> Arguments: %s\n", !component->meta_data.func_data.args_num ? "No Args" : "");
@@ -498,6 +507,21 @@ void print_ast_node(AST_node *node, char *buffer, int rec_lvl)
         break;
     }
 
+    case FOR_IN_LOOP:
+    {
+        printf("@ FOR_IN_LOOP: %s\n", node->identifier.declared_var);
+
+        print_repeated_string(buffer, rec_lvl + 1);
+        printf("@ ITERABLE:\n");
+        print_expression_tree(node->ast_data.exp, buffer, rec_lvl + 1);
+
+        print_repeated_string(buffer, rec_lvl + 1);
+        printf("@ BODY\n");
+        print_ast_list(node->body, buffer, rec_lvl + 1);
+
+        break;
+    }
+
     case EXCEPTION_DECLARATION:
     {
         printf("@ EXCEPTION DELCARATION: %s\n", node->identifier.exception_name);
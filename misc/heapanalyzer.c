@@ -0,0 +1,504 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "heapanalyzer.h"
+#include "../runtime/heapsnapshot.h"
+#include "../generics/utilities.h"
+
+/**
+ * DESCRIPTION:
+ * Offline analyzer for heap snapshots written by runtime/heapsnapshot.c
+ *
+ * It builds the dominator tree of the object graph (Cooper, Harvey & Kennedy iterative algorithm),
+ * rooted at a virtual node pointing to every root of the snapshot.
+ * The retained size of a node is the size of every node it dominates, i.e what would be freed if it became unreachable
+ */
+
+#define UNREACHABLE SIZE_MAX
+
+typedef struct HeapNode
+{
+    char kind[16];
+    char type[16];
+    size_t size;
+    size_t edges_start; // index of the first out edge in the graph edges array
+    size_t edge_count;
+    const char *root_name; // name of the first variable referencing this node, if its a root
+    long root_frame;
+} HeapNode;
+
+typedef struct HeapGraph
+{
+    HeapNode *nodes;
+    size_t node_count;
+
+    size_t *edges;
+    size_t edge_count;
+    size_t edge_capacity;
+
+    size_t *roots;
+    char **root_names;
+    size_t root_count;
+    size_t root_capacity;
+} HeapGraph;
+
+static void free_HeapGraph(HeapGraph *graph)
+{
+    for (size_t i = 0; i < graph->root_count; i++)
+        free(graph->root_names[i]);
+
+    free(graph->root_names);
+    free(graph->roots);
+    free(graph->edges);
+    free(graph->nodes);
+}
+
+/**
+ * DESCRIPTION:
+ * Reads a whole line of any length, buffer is grown as needed. Returns NULL at end of file
+ */
+static char *read_line(FILE *file, char **buffer, size_t *capacity)
+{
+    if (!*buffer)
+    {
+        *capacity = 256;
+        *buffer = malloc(*capacity);
+        if (!*buffer)
+            MallocError();
+    }
+
+    size_t len = 0;
+    while (fgets(*buffer + len, (int)(*capacity - len), file))
+    {
+        len += strlen(*buffer + len);
+        if ((*buffer)[len - 1] == '\n')
+            return *buffer;
+
+        *capacity *= 2;
+        *buffer = realloc(*buffer, *capacity);
+        if (!*buffer)
+            MallocError();
+    }
+
+    return len ? *buffer : NULL;
+}
+
+static void push_edge(HeapGraph *graph, size_t edge)
+{
+    if (graph->edge_count == graph->edge_capacity)
+    {
+        graph->edge_capacity = graph->edge_capacity ? graph->edge_capacity * 2 : 1024;
+        graph->edges = realloc(graph->edges, sizeof(size_t) * graph->edge_capacity);
+        if (!graph->edges)
+            MallocError();
+    }
+    graph->edges[graph->edge_count++] = edge;
+}
+
+static void push_root(HeapGraph *graph, size_t node, const char *name)
+{
+    if (graph->root_count == graph->root_capacity)
+    {
+        graph->root_capacity = graph->root_capacity ? graph->root_capacity * 2 : 64;
+        graph->roots = realloc(graph->roots, sizeof(size_t) * graph->root_capacity);
+        graph->root_names = realloc(graph->root_names, sizeof(char *) * graph->root_capacity);
+        if (!graph->roots || !graph->root_names)
+            MallocError();
+    }
+    graph->roots[graph->root_count] = node;
+    graph->root_names[graph->root_count] = cpy_string(name);
+    graph->root_count++;
+}
+
+/**
+ * DESCRIPTION:
+ * Loads a snapshot into graph, returns false (and prints why) if the file is not a valid snapshot
+ */
+static bool load_heap_snapshot(FILE *file, HeapGraph *graph)
+{
+    char *line = NULL;
+    size_t capacity = 0;
+    size_t line_nb = 0;
+    bool header_read = false;
+    bool valid = true;
+
+    while (valid && read_line(file, &line, &capacity))
+    {
+        line_nb++;
+        int version;
+        size_t objects, payloads, id, size, node;
+        long frame;
+        char kind[16], type[16], name[128];
+        int offset = 0;
+
+        if (sscanf(line, " {\"version\": %d, \"objects\": %zu, \"payloads\": %zu", &version, &objects, &payloads) == 3)
+        {
+            if (version != HEAP_SNAPSHOT_VERSION)
+            {
+                fprintf(stderr, "Unsupported heap snapshot version %d (expected %d).\n", version, HEAP_SNAPSHOT_VERSION);
+                valid = false;
+                break;
+            }
+
+            graph->node_count = objects + payloads;
+            graph->nodes = calloc(graph->node_count + 1, sizeof(HeapNode));
+            if (!graph->nodes)
+                MallocError();
+            header_read = true;
+        }
+        else if (sscanf(line, " {\"id\": %zu, \"kind\": \"%15[^\"]\", \"type\": \"%15[^\"]\", \"size\": %zu, \"edges\": [%n",
+                        &id, kind, type, &size, &offset) == 4 &&
+                 offset > 0)
+        {
+            if (!header_read || id >= graph->node_count)
+            {
+                valid = false;
+                break;
+            }
+
+            HeapNode *heapnode = &graph->nodes[id];
+            strcpy(heapnode->kind, kind);
+            strcpy(heapnode->type, type);
+            heapnode->size = size;
+            heapnode->edges_start = graph->edge_count;
+            heapnode->root_frame = -1;
+
+            char *ptr = line + offset;
+            while (*ptr != ']')
+            {
+                while (*ptr == ' ' || *ptr == ',')
+                    ptr++;
+                if (*ptr == ']')
+                    break;
+
+                char *end = NULL;
+                size_t edge = strtoull(ptr, &end, 10);
+                if (end == ptr || edge >= graph->node_count)
+                {
+                    valid = false;
+                    break;
+                }
+                push_edge(graph, edge);
+                ptr = end;
+            }
+            heapnode->edge_count = graph->edge_count - heapnode->edges_start;
+        }
+        else if (sscanf(line, " {\"node\": %zu, \"frame\": %ld, \"name\": \"%127[^\"]\"", &node, &frame, name) == 3)
+        {
+            if (!header_read || node >= graph->node_count)
+            {
+                valid = false;
+                break;
+            }
+
+            push_root(graph, node, name);
+            if (!graph->nodes[node].root_name)
+            {
+                graph->nodes[node].root_name = graph->root_names[graph->root_count - 1];
+                graph->nodes[node].root_frame = frame;
+            }
+        }
+    }
+
+    if (!valid || !header_read)
+        fprintf(stderr, "Malformed heap snapshot (line %zu).\n", line_nb);
+
+    free(line);
+    return valid && header_read;
+}
+
+/* Sorting helpers, nodes with the largest retained size come first */
+static const size_t *sort_retained = NULL;
+
+static int compare_retained(const void *n1, const void *n2)
+{
+    size_t r1 = sort_retained[*(const size_t *)n1];
+    size_t r2 = sort_retained[*(const size_t *)n2];
+    return (r1 < r2) - (r1 > r2);
+}
+
+static void print_node_label(const HeapGraph *graph, size_t node)
+{
+    const HeapNode *heapnode = &graph->nodes[node];
+    printf("#%zu %s %s", node, heapnode->kind, heapnode->type);
+    if (heapnode->root_name)
+        printf(" '%s' (frame %ld)", heapnode->root_name, heapnode->root_frame);
+}
+
+/**
+ * DESCRIPTION:
+ * Prints the dominator subtree of node, only the children retaining a significant part of the heap are printed
+ */
+static void print_dominator_tree(const HeapGraph *graph, const size_t *retained,
+                                 const size_t *children_start, const size_t *children,
+                                 size_t node, size_t total, int depth)
+{
+    for (int i = 0; i < depth; i++)
+        printf("  ");
+
+    if (node == graph->node_count)
+        printf("<roots>");
+    else
+        print_node_label(graph, node);
+    printf(": %zu bytes retained (%.1f%%)\n", retained[node], total ? 100.0 * retained[node] / total : 0.0);
+
+    if (depth == HEAP_ANALYZER_MAX_DEPTH)
+        return;
+
+    size_t count = children_start[node + 1] - children_start[node];
+    const size_t *child = children + children_start[node];
+    size_t printed = 0, hidden_bytes = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        double percent = total ? 100.0 * retained[child[i]] / total : 0.0;
+        if (printed < HEAP_ANALYZER_MAX_CHILDREN && percent >= HEAP_ANALYZER_MIN_PERCENT)
+        {
+            print_dominator_tree(graph, retained, children_start, children, child[i], total, depth + 1);
+            printed++;
+        }
+        else
+        {
+            hidden_bytes += retained[child[i]];
+        }
+    }
+
+    if (printed < count)
+    {
+        for (int i = 0; i <= depth; i++)
+            printf("  ");
+        printf("... %zu more, %zu bytes retained\n", count - printed, hidden_bytes);
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Analyzes the heap snapshot at path, prints the top retainers and the dominator tree.
+ * Returns the process exit code
+ */
+int analyze_heap_snapshot(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        printf("Could not open heap snapshot %s\n", path);
+        return 1;
+    }
+
+    HeapGraph graph = {0};
+    bool loaded = load_heap_snapshot(file, &graph);
+    fclose(file);
+
+    if (!loaded)
+    {
+        free_HeapGraph(&graph);
+        return 1;
+    }
+
+    // node_count is the virtual root, its successors are the snapshot roots
+    const size_t N = graph.node_count;
+    const size_t R = N;
+#define successor_count(v) ((v) == R ? graph.root_count : graph.nodes[v].edge_count)
+#define successor(v, k) ((v) == R ? graph.roots[k] : graph.edges[graph.nodes[v].edges_start + (k)])
+
+    size_t *rpo = malloc(sizeof(size_t) * (N + 1));
+    size_t *rpo_index = malloc(sizeof(size_t) * (N + 1));
+    size_t *stack = malloc(sizeof(size_t) * (N + 1));
+    size_t *next_edge = calloc(N + 1, sizeof(size_t));
+    size_t *idom = malloc(sizeof(size_t) * (N + 1));
+    size_t *retained = calloc(N + 1, sizeof(size_t));
+    if (!rpo || !rpo_index || !stack || !next_edge || !idom || !retained)
+        MallocError();
+
+    for (size_t v = 0; v <= N; v++)
+    {
+        rpo_index[v] = UNREACHABLE;
+        idom[v] = UNREACHABLE;
+    }
+
+    // iterative DFS from the virtual root, nodes are numbered in post order then reversed
+    size_t visited = 0, stack_size = 0;
+    stack[stack_size++] = R;
+    rpo_index[R] = 0;
+    while (stack_size)
+    {
+        size_t v = stack[stack_size - 1];
+        if (next_edge[v] < successor_count(v))
+        {
+            size_t w = successor(v, next_edge[v]);
+            next_edge[v]++;
+            if (rpo_index[w] == UNREACHABLE)
+            {
+                rpo_index[w] = 0;
+                stack[stack_size++] = w;
+            }
+            continue;
+        }
+        rpo[visited++] = v;
+        stack_size--;
+    }
+
+    for (size_t i = 0; i < visited / 2; i++)
+    {
+        size_t tmp = rpo[i];
+        rpo[i] = rpo[visited - i - 1];
+        rpo[visited - i - 1] = tmp;
+    }
+    for (size_t i = 0; i < visited; i++)
+        rpo_index[rpo[i]] = i;
+
+    // predecessors of reachable nodes, in compressed rows
+    size_t *preds_start = calloc(N + 2, sizeof(size_t));
+    if (!preds_start)
+        MallocError();
+
+    for (size_t i = 0; i < visited; i++)
+        for (size_t k = 0; k < successor_count(rpo[i]); k++)
+            preds_start[successor(rpo[i], k) + 1]++;
+
+    for (size_t v = 0; v <= N; v++)
+        preds_start[v + 1] += preds_start[v];
+
+    size_t *preds = malloc(sizeof(size_t) * (preds_start[N + 1] + 1));
+    size_t *fill = calloc(N + 1, sizeof(size_t));
+    if (!preds || !fill)
+        MallocError();
+
+    for (size_t i = 0; i < visited; i++)
+    {
+        size_t v = rpo[i];
+        for (size_t k = 0; k < successor_count(v); k++)
+        {
+            size_t w = successor(v, k);
+            preds[preds_start[w] + fill[w]++] = v;
+        }
+    }
+
+    idom[R] = R;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 1; i < visited; i++)
+        {
+            size_t v = rpo[i];
+            size_t new_idom = UNREACHABLE;
+
+            for (size_t k = preds_start[v]; k < preds_start[v + 1]; k++)
+            {
+                size_t p = preds[k];
+                if (idom[p] == UNREACHABLE)
+                    continue;
+
+                if (new_idom == UNREACHABLE)
+                {
+                    new_idom = p;
+                    continue;
+                }
+
+                // intersection of the 2 dominator chains
+                size_t f1 = p, f2 = new_idom;
+                while (f1 != f2)
+                {
+                    while (rpo_index[f1] > rpo_index[f2])
+                        f1 = idom[f1];
+                    while (rpo_index[f2] > rpo_index[f1])
+                        f2 = idom[f2];
+                }
+                new_idom = f1;
+            }
+
+            if (idom[v] != new_idom)
+            {
+                idom[v] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    // a node is always visited after its dominator, so sizes can be accumulated bottom up
+    size_t total_size = 0, reachable_size = 0;
+    for (size_t v = 0; v < N; v++)
+        total_size += graph.nodes[v].size;
+
+    for (size_t i = 0; i < visited; i++)
+    {
+        size_t v = rpo[i];
+        retained[v] = v == R ? 0 : graph.nodes[v].size;
+    }
+    for (size_t i = visited - 1; i > 0; i--)
+        retained[idom[rpo[i]]] += retained[rpo[i]];
+    reachable_size = retained[R];
+
+    printf("Heap snapshot %s: %zu nodes, %zu bytes, %zu roots\n", path, N, total_size, graph.root_count);
+    printf("Reachable: %zu nodes, %zu bytes\n", visited - 1, reachable_size);
+    printf("Unreachable (waiting for collection): %zu nodes, %zu bytes\n\n", N - (visited - 1), total_size - reachable_size);
+
+    // top retainers, only wrappers are listed since a payload is retained by its wrapper in the common case
+    size_t *order = malloc(sizeof(size_t) * (N + 1));
+    if (!order)
+        MallocError();
+
+    size_t order_len = 0;
+    for (size_t i = 1; i < visited; i++)
+    {
+        if (strcmp(graph.nodes[rpo[i]].kind, "object") == 0)
+            order[order_len++] = rpo[i];
+    }
+
+    sort_retained = retained;
+    qsort(order, order_len, sizeof(size_t), compare_retained);
+
+    printf("Top retainers:\n");
+    printf("%12s %10s  %s\n", "retained", "self", "node");
+    for (size_t i = 0; i < order_len && i < HEAP_ANALYZER_TOP_RETAINERS; i++)
+    {
+        size_t v = order[i];
+        printf("%12zu %10zu  ", retained[v], graph.nodes[v].size);
+        print_node_label(&graph, v);
+        printf("\n");
+    }
+
+    // children of every node in the dominator tree, sorted by retained size
+    size_t *children_start = calloc(N + 2, sizeof(size_t));
+    size_t *children = malloc(sizeof(size_t) * (visited + 1));
+    if (!children_start || !children)
+        MallocError();
+
+    for (size_t i = 1; i < visited; i++)
+        children_start[idom[rpo[i]] + 1]++;
+    for (size_t v = 0; v <= N; v++)
+        children_start[v + 1] += children_start[v];
+
+    memset(fill, 0, sizeof(size_t) * (N + 1));
+    for (size_t i = 1; i < visited; i++)
+    {
+        size_t parent = idom[rpo[i]];
+        children[children_start[parent] + fill[parent]++] = rpo[i];
+    }
+    for (size_t v = 0; v <= N; v++)
+        qsort(children + children_start[v], children_start[v + 1] - children_start[v], sizeof(size_t), compare_retained);
+
+    printf("\nDominator tree:\n");
+    print_dominator_tree(&graph, retained, children_start, children, R, reachable_size, 0);
+
+#undef successor_count
+#undef successor
+
+    free(children);
+    free(children_start);
+    free(order);
+    free(fill);
+    free(preds);
+    free(preds_start);
+    free(retained);
+    free(idom);
+    free(next_edge);
+    free(stack);
+    free(rpo_index);
+    free(rpo);
+    free_HeapGraph(&graph);
+    return 0;
+}
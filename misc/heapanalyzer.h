@@ -0,0 +1,11 @@
+#pragma once
+
+// Number of entries printed in the top retainers table
+#define HEAP_ANALYZER_TOP_RETAINERS 10
+
+// The dominator tree is only printed up to this depth, for children retaining at least HEAP_ANALYZER_MIN_PERCENT of the heap
+#define HEAP_ANALYZER_MAX_DEPTH 6
+#define HEAP_ANALYZER_MIN_PERCENT 1.0
+#define HEAP_ANALYZER_MAX_CHILDREN 8
+
+int analyze_heap_snapshot(const char *path);
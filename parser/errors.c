@@ -67,6 +67,8 @@ static char *_exp_component_to_string(ExpressionComponent *node)
         return "Variable Identifier";
     case LIST_INDEX:
         return "Index Expression";
+    case LIST_SLICE:
+        return "Slice Expression";
     case FUNC_CALL:
         return "Function Call";
     case INLINE_FUNC:
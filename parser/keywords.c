@@ -104,6 +104,7 @@ void init_keyword_table()
     insert_keyword_to_table("catch", CATCH_KEYWORD); 
     insert_keyword_to_table("exception", EXCEPTION_KEYWORD); 
     insert_keyword_to_table("raise", RAISE_KEYWORD); 
+    insert_keyword_to_table("in", IN_KEYWORD); 
 }
 
 
@@ -144,6 +145,8 @@ const char* get_keyword_string(enum keyword_type keyword) {
         return "map";
         case SET_KEYWORD:
         return "set";
+        case IN_KEYWORD:
+        return "in";
         default:
         return NULL;
     }
@@ -24,7 +24,8 @@ typedef enum keyword_type
     TRY_KEYWORD,
     CATCH_KEYWORD,
     EXCEPTION_KEYWORD,
-    RAISE_KEYWORD
+    RAISE_KEYWORD,
+    IN_KEYWORD
 } KeywordType;
 
 void init_keyword_table();
@@ -359,6 +359,13 @@ void free_expression_component(ExpressionComponent *component)
         free(component);
         return;
     }
+    case LIST_SLICE:
+    {
+        free_expression_tree(component->meta_data.list_slice.start);
+        free_expression_tree(component->meta_data.list_slice.end);
+        free(component);
+        return;
+    }
 
     case INLINE_FUNC:
     {
@@ -526,6 +533,7 @@ STRING_CONSTANT -> string
 LIST_CONSTANT -> list
 FUNC_CALL -> func call -> (arg1, ..., arg_n)
 LIST_INDEX -> [...]
+LIST_SLICE -> [... : ...]
 
 Note: This function does not check for a end of expression token, it knows when to end the recursion
 */
@@ -573,7 +581,16 @@ ExpressionComponent *parse_expression_component(
     ExpressionComponent *component = malloc_expression_component(parser);
     component->line_num = list[parser->token_ptr]->line_num;
 
-    if (get_keyword_type(list[parser->token_ptr]->ident) == MAP_KEYWORD)
+    // map is also the name of a built in function, map ( ... ) is a call to it rather than a map literal
+    if (rec_lvl == 0 && !parent &&
+        get_keyword_type(list[parser->token_ptr]->ident) == MAP_KEYWORD &&
+        list[parser->token_ptr + 1]->type == OPEN_PARENTHESIS)
+    {
+        component->type = VARIABLE;
+        component->meta_data.variable_reference = malloc_string_cpy(parser, list[parser->token_ptr]->ident);
+        parser->token_ptr++;
+    }
+    else if (get_keyword_type(list[parser->token_ptr]->ident) == MAP_KEYWORD)
     {
         component->type = HASHMAP_CONSTANT;
         if (list[parser->token_ptr + 1]->type != OPEN_CURLY_BRACKETS)
@@ -684,9 +701,21 @@ ExpressionComponent *parse_expression_component(
     {
         component->type = LIST_INDEX;
         parser->token_ptr++;
-        enum token_type end_of_exp[] = {CLOSING_SQUARE_BRACKETS};
-        component->meta_data.list_index = parse_expression(parser, end_of_exp, 1);
+        enum token_type end_of_exp[] = {CLOSING_SQUARE_BRACKETS, COLON};
+        ExpressionNode *index = parse_expression(parser, end_of_exp, 2);
         // component->meta_data.list_index = parse_expression(parser, NULL, NULL, end_of_exp, 1);
+
+        // the expression ended on a colon, its a slice (i.e [start : end])
+        if (list[parser->token_ptr - 1]->type == COLON)
+        {
+            component->type = LIST_SLICE;
+            component->meta_data.list_slice.start = index;
+            component->meta_data.list_slice.end = parse_expression(parser, end_of_exp, 1);
+        }
+        else
+        {
+            component->meta_data.list_index = index;
+        }
     }
     // function call
     else if (rec_lvl > 0 && !preceded_by_arrow && list[parser->token_ptr]->type == OPEN_PARENTHESIS)
@@ -1208,6 +1237,15 @@ void free_ast_node(AST_node *node)
         return;
     }
 
+    case FOR_IN_LOOP:
+    {
+        free(node->identifier.declared_var);
+        free_expression_tree(node->ast_data.exp);
+        free_ast_list(node->body);
+        free(node);
+        return;
+    }
+
     case INLINE_FUNCTION_DECLARATION:
     {
         for (int i = 0; i < node->ast_data.func_args.args_num; i++)
@@ -1461,6 +1499,47 @@ AST_node *parse_while_loop(Parser *parser, int rec_lvl)
 
 #define ReachedEndOfFor() list[parser->token_ptr]->type == CLOSING_PARENTHESIS
 
+/**
+ * DESCRIPTION:
+ * Creates AST node and parses for (x in iterable) { ... } loop block
+ * The loop variable is declared in the scope of the loop body
+ *
+ * NOTE:
+ * parser->token_ptr must point to the for keyword, and be followed by '(', an identifier and the in keyword
+ */
+static AST_node *parse_for_in_loop(Parser *parser, int rec_lvl)
+{
+    Token **list = parser->token_list->list;
+
+    AST_node *node = malloc_ast_node(parser);
+    node->type = FOR_IN_LOOP;
+    node->line_nb = list[parser->token_ptr]->line_num;
+    node->identifier.declared_var = malloc_string_cpy(parser, list[parser->token_ptr + 2]->ident);
+
+    parser->token_ptr += 4;
+
+    // parses the iterable expression
+    const enum token_type end_of_exp[] = {CLOSING_PARENTHESIS};
+    node->ast_data.exp = parse_expression(parser, end_of_exp, 1);
+
+    // checks for open curly brackets
+    if (list[parser->token_ptr]->type != OPEN_CURLY_BRACKETS)
+    {
+        print_expected_token_err(parser, "Open Curly Brackets ('{')", false,
+                                 "Proper Syntax: for (var in iterable) { ... }");
+        stop_parsing(parser);
+        return NULL;
+    }
+
+    parser->token_ptr++;
+
+    // recursively parses inner code block
+    const enum token_type end_of_for_block[] = {CLOSING_CURLY_BRACKETS};
+    node->body = parse_code_block(parser, node, rec_lvl + 1, false, end_of_for_block, 1);
+
+    return node;
+}
+
 AST_node *parse_for_loop(Parser *parser, int rec_lvl)
 {
     assert(parser);
@@ -1487,6 +1566,14 @@ AST_node *parse_for_loop(Parser *parser, int rec_lvl)
         return NULL;
     }
 
+    // for (x in iterable) { ... }
+    if (list[parser->token_ptr + 2]->type == IDENTIFIER &&
+        list[parser->token_ptr + 3]->type == KEYWORD &&
+        get_keyword_type(list[parser->token_ptr + 3]->ident) == IN_KEYWORD)
+    {
+        return parse_for_in_loop(parser, rec_lvl);
+    }
+
     AST_node *node = malloc_ast_node(parser);
     node->type = FOR_LOOP;
     node->line_nb = list[parser->token_ptr]->line_num;
@@ -70,6 +70,7 @@ typedef enum expression_component_type
 
     VARIABLE,
     LIST_INDEX,
+    LIST_SLICE,
     FUNC_CALL,
     INLINE_FUNC,
 } ExpressionComponentType;
@@ -105,6 +106,13 @@ typedef struct ExpressionComponent
         /* i.e the expression inside a list index, i.e syntax: [identifier][... exp] */
         ExpressionNode *list_index;
 
+        /* for LIST_SLICE type, i.e syntax: [identifier][start : end], both bounds can be omitted (NULL) */
+        struct list_slice
+        {
+            ExpressionNode *start;
+            ExpressionNode *end;
+        } list_slice;
+
         /* for LIST_CONSTANT type, i.e syntax: [t_1, ..., t_n] */
         struct list_data
         {
@@ -176,6 +184,7 @@ enum ast_node_type
     ELSE_IF_CONDITIONAL,
     WHILE_LOOP,
     FOR_LOOP,
+    FOR_IN_LOOP,
     RETURN_VAL,
     LOOP_TERMINATOR,
     LOOP_CONTINUATION,
@@ -235,7 +244,7 @@ typedef struct AST_node
     // union is NULL if type is a INLINE_FUNCTION_DECLARATION
     union identifier
     {
-        // used for variable declaration (let keyword)
+        // used for variable declaration (let keyword), and for the loop variable of for (x in ...) loops
         char *declared_var;
 
         // use for function declaration
@@ -390,6 +390,31 @@ bool expression_component_has_correct_semantics(SemanticAnalyzer *sem_analyzer,
             break;
         }
 
+        /*
+        Slices:
+        - Same rules as indexes, but both bounds are optional (i.e [:end], [start:], [:])
+        */
+        case LIST_SLICE:
+        {
+            if (node->sub_component &&
+                node->sub_component->type != LIST_CONSTANT &&
+                node->sub_component->type != STRING_CONSTANT &&
+                is_exp_component_terminal(node->sub_component->type))
+            {
+                print_invalid_index_err(sem_analyzer, node, node->token_num, NULL);
+                return false;
+            }
+
+            if ((node->meta_data.list_slice.start &&
+                 !exp_has_correct_semantics(sem_analyzer, node->meta_data.list_slice.start)) ||
+                (node->meta_data.list_slice.end &&
+                 !exp_has_correct_semantics(sem_analyzer, node->meta_data.list_slice.end)))
+                // function should print out an error
+                return false;
+
+            break;
+        }
+
         /*
         Function Calls:
         - Must have single standalone identifiers as arguments
@@ -519,6 +544,13 @@ bool var_assignment_has_correct_semantics(SemanticAnalyzer *sem_analyser, AST_no
         return false;
     }
 
+    // slices are new objects, assigning to them would have no effect
+    if (exp_node->type == LIST_SLICE)
+    {
+        print_invalid_var_assignment_err(sem_analyser, exp_node->token_num, "Cannot assign a Slice.");
+        return false;
+    }
+
     return expression_component_has_correct_semantics(sem_analyser, exp_node) &&
            exp_has_correct_semantics(sem_analyser, node->ast_data.exp);
 }
@@ -876,6 +908,56 @@ bool AST_list_has_consistent_semantics(SemanticAnalyzer *sem_analyzer, AST_List
             break;
         }
 
+        /*
+        for (x in iterable) block:
+        - Iterable expression must be valid
+        - Loop variable is declared for the sub block only
+        - Sub block must be valid
+        */
+        case FOR_IN_LOOP:
+        {
+            if (!node->ast_data.exp)
+            {
+                print_empty_exp_err(sem_analyzer, node->token_num,
+                                    "Proper Syntax: for (var in iterable) { ... }");
+                return false;
+            }
+
+            if (!exp_has_correct_semantics(sem_analyzer, node->ast_data.exp))
+            {
+                // function prints out error
+                return false;
+            }
+
+            add_var_to_vartable(
+                sem_analyzer->symtable,
+                node->identifier.declared_var,
+                sem_analyzer->filename,
+                sem_analyzer->nesting_lvl,
+                SYMBOL_TYPE_VARIABLE);
+
+            sem_analyzer->nesting_lvl++;
+            bool current_loop_cond = sem_analyzer->is_in_loop;
+
+            sem_analyzer->is_in_loop = true;
+
+            bool tmp = AST_list_has_consistent_semantics(sem_analyzer, node->body);
+            // if tmp false, an error would have been printed out
+
+            sem_analyzer->is_in_loop = current_loop_cond;
+            sem_analyzer->nesting_lvl--;
+
+            remove_var_from_vartable(
+                sem_analyzer->symtable,
+                node->identifier.declared_var,
+                sem_analyzer->nesting_lvl);
+
+            if (!tmp)
+                return false;
+
+            break;
+        }
+
         /*
         Function Declarations:
         - Access modifier must be semantically valid
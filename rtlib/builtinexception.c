@@ -22,11 +22,13 @@ static RtObject *builtin_Exception(RtObject **args, int arg_count);
 static RtObject *builtin_InvalidType(RtObject **args, int arg_count);
 static RtObject *builtin_InvalidNumberOfArguments(RtObject **args, int arg_count);
 static RtObject *builtin_NullPointerException(RtObject **args, int arg_count);
+static RtObject *builtin_OutOfMemoryException(RtObject **args, int arg_count);
 
 static const BuiltinFunc _builtin_Exception = {GenericExceptionString, builtin_Exception, 1};
 static const BuiltinFunc _builtin_InvalidType = {InvalidTypeExceptionString, builtin_InvalidType, 1};
 static const BuiltinFunc _builtin_InvalidNumberOfArguments = {InvalidNumberOfArgumentsExceptionString, builtin_InvalidNumberOfArguments, 1};
 static const BuiltinFunc _builtin_NullPointerException = {NullTypeExceptionString, builtin_NullPointerException, 1};
+static const BuiltinFunc _builtin_OutOfMemoryException = {OutOfMemoryExceptionString, builtin_OutOfMemoryException, 1};
 
 
 /**
@@ -42,6 +44,7 @@ int init_BuiltinException(GenericMap *BuiltinFunc_Registry) {
     InsertBuiltIn(BuiltinFunc_Registry, _builtin_InvalidType);
     InsertBuiltIn(BuiltinFunc_Registry, _builtin_InvalidNumberOfArguments);
     InsertBuiltIn(BuiltinFunc_Registry, _builtin_NullPointerException);
+    InsertBuiltIn(BuiltinFunc_Registry, _builtin_OutOfMemoryException);
 
     return 1;
 }
@@ -56,7 +59,7 @@ static RtObject *builtin_Exception(RtObject **args, int arg_count) {
     }
 
     RtObject *obj = init_RtObject(EXCEPTION_TYPE);
-    obj->data.Exception = GenericException(arg_count == 0? "": args[0]->data.String->string);
+    obj->data.Exception = GenericException(arg_count == 0? "": rtstr_chars(args[0]->data.String));
     return obj; 
 }
 
@@ -69,7 +72,7 @@ static RtObject *builtin_InvalidType(RtObject **args, int arg_count) {
     }
 
     RtObject *obj = init_RtObject(EXCEPTION_TYPE);
-    obj->data.Exception = InvalidTypeException(arg_count == 0? "": args[0]->data.String->string);
+    obj->data.Exception = InvalidTypeException(arg_count == 0? "": rtstr_chars(args[0]->data.String));
 
     return obj;
 }
@@ -83,7 +86,7 @@ static RtObject *builtin_InvalidNumberOfArguments(RtObject **args, int arg_count
     }
 
     RtObject *obj = init_RtObject(EXCEPTION_TYPE);
-    obj->data.Exception = InvalidNumberOfArgumentsException(arg_count == 0? "": args[0]->data.String->string);
+    obj->data.Exception = InvalidNumberOfArgumentsException(arg_count == 0? "": rtstr_chars(args[0]->data.String));
     return obj;
 }
 
@@ -96,9 +99,19 @@ static RtObject *builtin_NullPointerException(RtObject **args, int arg_count) {
     }
 
     RtObject *obj = init_RtObject(EXCEPTION_TYPE);
-    obj->data.Exception = NullTypeException(arg_count == 0? "": args[0]->data.String->string);
+    obj->data.Exception = NullTypeException(arg_count == 0? "": rtstr_chars(args[0]->data.String));
     return obj;
 }
 
+static RtObject *builtin_OutOfMemoryException(RtObject **args, int arg_count) {
+    if(arg_count > 1) {
+        raiseArgumentCountException()
+    }
+    if(arg_count == 1 && args[0]->type != STRING_TYPE) {
+        raiseInvalidTypeException();
+    }
 
-
+    RtObject *obj = init_RtObject(EXCEPTION_TYPE);
+    obj->data.Exception = OutOfMemoryException(arg_count == 0? "": rtstr_chars(args[0]->data.String));
+    return obj;
+}
@@ -11,11 +11,15 @@
 #include "../compiler/compiler.h"
 #include "../generics/utilities.h"
 #include "../generics/hashmap.h"
+#include "../generics/linkedlist.h"
 #include "../runtime/runtime.h"
 #include "../runtime/rtobjects.h"
 #include "../runtime/rttype.h"
 #include "../runtime/rtexchandler.h"
 #include "../runtime/filetable.h"
+#include "../runtime/gc.h"
+#include "../runtime/heapsnapshot.h"
+#include "../runtime/rtparallel.h"
 
 /**
  * This file contains the implementation of all general built in functions:
@@ -39,6 +43,18 @@
  * - fwrite
  * - freadall
  * - fclose
+ * - gc_stats
+ * - range
+ * - map
+ * - filter
+ * - reduce
+ * - any
+ * - all
+ * - zip
+ * - enumerate
+ * - sum
+ * - parallel_map
+ * - parallel_for
  */
 
 /**
@@ -71,9 +87,25 @@ static RtObject *builtin_fopen(RtObject **args, int argcount);
 static RtObject *builtin_fwrite(RtObject **args, int argcount);
 static RtObject *builtin_freadall(RtObject **args, int argcount);
 static RtObject *builtin_fclose(RtObject **args, int argcount);
+static RtObject *builtin_gc_stats(RtObject **args, int argcount);
+static RtObject *builtin_heap_snapshot(RtObject **args, int argcount);
+static RtObject *builtin_range(RtObject **args, int argcount);
+static RtObject *builtin_map(RtObject **args, int argcount);
+static RtObject *builtin_filter(RtObject **args, int argcount);
+static RtObject *builtin_reduce(RtObject **args, int argcount);
+static RtObject *builtin_any(RtObject **args, int argcount);
+static RtObject *builtin_all(RtObject **args, int argcount);
+static RtObject *builtin_zip(RtObject **args, int argcount);
+static RtObject *builtin_enumerate(RtObject **args, int argcount);
+static RtObject *builtin_sum(RtObject **args, int argcount);
+static RtObject *builtin_parallel_map(RtObject **args, int argcount);
+static RtObject *builtin_parallel_for(RtObject **args, int argcount);
 
 static GenericMap *BuiltinFunc_Registry = NULL;
 
+/* Built in functions added by programs embedding the interpreter (see register_BuiltinFunc), they are owned by this list */
+static GenericLList *Host_Builtins = NULL;
+
 static const BuiltinFunc _builtin_print = {"print", builtin_print, INT_FAST64_MAX};
 static const BuiltinFunc _builtin_println = {"println", builtin_println, INT_FAST64_MAX};
 static const BuiltinFunc _builtin_string = {"str", builtin_toString, INT_FAST64_MAX};
@@ -95,6 +127,19 @@ static const BuiltinFunc _builtin_fopen = {"fopen", builtin_fopen, 2};
 static const BuiltinFunc _builtin_fwrite = {"fwrite", builtin_fwrite, 2};
 static const BuiltinFunc _builtin_freadall = {"freadall", builtin_freadall, 1};
 static const BuiltinFunc _builtin_fclose = {"fclose", builtin_fclose, 1};
+static const BuiltinFunc _builtin_gc_stats = {"gc_stats", builtin_gc_stats, 0};
+static const BuiltinFunc _builtin_heap_snapshot = {"heap_snapshot", builtin_heap_snapshot, 1};
+static const BuiltinFunc _builtin_range = {"range", builtin_range, 3};
+static const BuiltinFunc _builtin_map = {"map", builtin_map, 2};
+static const BuiltinFunc _builtin_filter = {"filter", builtin_filter, 2};
+static const BuiltinFunc _builtin_reduce = {"reduce", builtin_reduce, 3};
+static const BuiltinFunc _builtin_any = {"any", builtin_any, 2};
+static const BuiltinFunc _builtin_all = {"all", builtin_all, 2};
+static const BuiltinFunc _builtin_zip = {"zip", builtin_zip, INT64_MAX};
+static const BuiltinFunc _builtin_enumerate = {"enumerate", builtin_enumerate, 1};
+static const BuiltinFunc _builtin_sum = {"sum", builtin_sum, 1};
+static const BuiltinFunc _builtin_parallel_map = {"parallel_map", builtin_parallel_map, 3};
+static const BuiltinFunc _builtin_parallel_for = {"parallel_for", builtin_parallel_for, 3};
 
 #define setInvalidNumberOfArgsIntermediateException(built_name, actual_args, expected_args) \
     setIntermediateException(init_InvalidNumberOfArgumentsException(built_name, actual_args, expected_args))
@@ -126,7 +171,7 @@ int init_BuiltinFuncs()
         return 1;
 
     BuiltinFunc_Registry = init_GenericMap(
-        (unsigned int (*)(const void *))djb2_string_hash,
+        (unsigned int (*)(const void *))string_hash,
         (bool (*)(const void *, const void *))strings_equal,
         (void (*)(void *))NULL,
         (void (*)(void *))NULL);
@@ -159,6 +204,19 @@ int init_BuiltinFuncs()
         InsertBuiltIn(BuiltinFunc_Registry, _builtin_fwrite) &&
         InsertBuiltIn(BuiltinFunc_Registry, _builtin_freadall) &&
         InsertBuiltIn(BuiltinFunc_Registry, _builtin_fclose) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_gc_stats) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_heap_snapshot) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_range) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_map) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_filter) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_reduce) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_any) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_all) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_zip) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_enumerate) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_sum) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_parallel_map) &&
+        InsertBuiltIn(BuiltinFunc_Registry, _builtin_parallel_for) &&
         init_BuiltinException(BuiltinFunc_Registry);
 
     if (successful_init)
@@ -216,6 +274,61 @@ void cleanup_builtin()
 {
     free_GenericMap(BuiltinFunc_Registry, false, false);
     BuiltinFunc_Registry = NULL;
+
+    if (Host_Builtins)
+        GenericLList_free(Host_Builtins, true);
+    Host_Builtins = NULL;
+}
+
+static void free_host_builtin(BuiltinFunc *builtin)
+{
+    free(builtin->builtin_name);
+    free(builtin);
+}
+
+/**
+ * DESCRIPTION:
+ * Adds a built in function implemented by a program embedding the interpreter (see tlang.h)
+ * returns 1 -> function was added
+ * return 0 -> name is already a built in identifier, or malloc failed
+ *
+ * PARAMS:
+ * name: identifier of the function, it is copied
+ * func: implementation, follows the same conventions as the built in functions of this file
+ * arg_count: expected number of arguments, INT_FAST64_MAX if any, func is responsible for checking it
+ *
+ * NOTE:
+ * The registry is shared by every VM, functions must be added before the programs using them are compiled,
+ * and never while a program is running
+ */
+int register_BuiltinFunc(const char *name, RtObject *(*func)(RtObject **, int), size_t arg_count)
+{
+    if (ident_is_builtin(name))
+        return 0;
+
+    if (!Host_Builtins)
+    {
+        Host_Builtins = init_GenericLList(NULL, (void (*)(void *))free_host_builtin);
+        if (!Host_Builtins)
+            return 0;
+    }
+
+    BuiltinFunc *builtin = malloc(sizeof(BuiltinFunc));
+    if (!builtin)
+        return 0;
+
+    builtin->builtin_name = cpy_string(name);
+    builtin->builtin_func = func;
+    builtin->arg_count = arg_count;
+
+    if (!builtin->builtin_name || !GenericLList_addLast(Host_Builtins, builtin))
+    {
+        free(builtin->builtin_name);
+        free(builtin);
+        return 0;
+    }
+
+    return GenericHashMap_insert(BuiltinFunc_Registry, builtin->builtin_name, builtin, false) ? 1 : 0;
 }
 
 /**
@@ -373,16 +486,16 @@ static RtObject *builtin_toNumber(RtObject **args, int arg_count)
     if (args[0]->type == NUMBER_TYPE)
     {
         RtObject *num = init_RtObject(NUMBER_TYPE);
-        num->data.Number = args[0]->data.Number;
+        num->data.Number = init_RtNumber(args[0]->data.Number->number);
         return num;
     }
     else if (args[0]->type == STRING_TYPE)
     {
-        char *str = args[0]->data.String->string;
+        char *str = rtstr_chars(args[0]->data.String);
         if (is_token_numeric(str))
         {
             RtObject *num = init_RtObject(NUMBER_TYPE);
-            num->data.Number->number = atof(str);
+            num->data.Number = init_RtNumber(atof(str));
             return num;
         }
         else
@@ -447,9 +560,16 @@ static RtObject *builtin_len(RtObject **args, int arg_count)
         return length;
     }
 
+    case RANGE_TYPE:
+    {
+        RtObject *length = init_RtObject(NUMBER_TYPE);
+        length->data.Number = init_RtNumber(rtrange_length(arg->data.Range));
+        return length;
+    }
+
     default:
         setIntermediateException(
-            init_InvalidTypeException_Builtin("len(obj)", "Map, List, String, or Set", arg));
+            init_InvalidTypeException_Builtin("len(obj)", "Map, List, String, Set or Range", arg));
         return NULL;
     }
 }
@@ -476,7 +596,7 @@ static RtObject *builtin_cmd(RtObject **args, int arg_count)
 
     char stdoutbuffer[MAX_STDOUT_BUFFER];
     FILE *fp = NULL;
-    const char *command = args[0]->data.String->string;
+    const char *command = rtstr_chars(args[0]->data.String);
     char *output = NULL;
     size_t output_size = 0;
     size_t bytes_read;
@@ -594,6 +714,7 @@ static RtObject *builtin_abs(RtObject **args, int argcount)
 /**
  * DESCRIPTION:
  * Built in function for creating a shallow copy of a runtime object
+ * Lists, maps and sets are copied lazily, the copy only duplicates their contents when either of them is mutated
  */
 static RtObject *builtin_copy(RtObject **args, int argcount)
 {
@@ -603,7 +724,7 @@ static RtObject *builtin_copy(RtObject **args, int argcount)
         return NULL;
     }
 
-    RtObject *obj = rtobj_shallow_cpy(args[0]);
+    RtObject *obj = rtobj_cow_cpy(args[0]);
     return obj;
 }
 
@@ -627,7 +748,7 @@ static RtObject *builtin_ord(RtObject **args, int argcount)
     }
     RtString *string = args[0]->data.String;
 
-    char c = args[0]->data.String->string[0];
+    char c = rtstr_chars(args[0]->data.String)[0];
     RtObject *ord = init_RtObject(NUMBER_TYPE);
     ord->data.Number = init_RtNumber(c);
     return ord;
@@ -777,8 +898,8 @@ static RtObject *builtin_fopen(RtObject **args, int argcount)
         return NULL;
     }
 
-    char *filename = args[0]->data.String->string;
-    char *flags = args[1]->data.String->string;
+    char *filename = rtstr_chars(args[0]->data.String);
+    char *flags = rtstr_chars(args[1]->data.String);
     FILE *file = fopen(filename, flags);
 
     // fopen fails
@@ -822,7 +943,7 @@ static RtObject *builtin_fwrite(RtObject **args, int argcount)
     }
 
     size_t fileid = (size_t)args[0]->data.Number->number;
-    char *string = args[1]->data.String->string;
+    char *string = rtstr_chars(args[1]->data.String);
 
     // gets FILE
     FILE *file = filetbl_search(fileid);
@@ -918,3 +1039,719 @@ static RtObject *builtin_fclose(RtObject **args, int argcount) {
     return init_RtObject(UNDEFINED_TYPE);
 }
 
+/**
+ * DESCRIPTION:
+ * Helpers for building the map returned by gc_stats(), inserted keys and values are added to the GC
+ */
+static RtObject *_gc_stats_number(long double n)
+{
+    RtObject *obj = init_RtObject(NUMBER_TYPE);
+    obj->data.Number = init_RtNumber(n);
+    return obj;
+}
+
+static void _gc_stats_put(RtMap *map, const char *key, RtObject *val)
+{
+    RtObject *keyobj = init_RtObject(STRING_TYPE);
+    keyobj->data.String = init_RtString(key);
+    add_to_GC_registry(keyobj);
+    add_to_GC_registry(val);
+    rtmap_insert(map, keyobj, val);
+}
+
+/**
+ * DESCRIPTION:
+ * Builtin function returning a map of the garbage collector statistics:
+ * - collections, total_pause_us, max_pause_us, last_pause_us
+ * - pause_histogram_us: list where index i counts pauses shorter than 2^i microseconds
+ * - objects_scanned, objects_freed, last_scanned, last_freed
+ * - threshold, max_threshold, threshold_history
+ * - live_objects, live_by_type: map of type name to live object count
+ */
+static RtObject *builtin_gc_stats(RtObject **args, int argcount)
+{
+    (void)args;
+    if (argcount != 0)
+    {
+        setInvalidNumberOfArgsIntermediateException("gc_stats()", argcount, 0);
+        return NULL;
+    }
+
+    const GCStats *stats = get_GC_stats();
+    RtMap *map = init_RtMap(0);
+    if (!map)
+        MallocError();
+
+    _gc_stats_put(map, "collections", _gc_stats_number(stats->collections));
+    _gc_stats_put(map, "total_pause_us", _gc_stats_number(stats->total_pause_us));
+    _gc_stats_put(map, "max_pause_us", _gc_stats_number(stats->max_pause_us));
+    _gc_stats_put(map, "last_pause_us", _gc_stats_number(stats->last_pause_us));
+    _gc_stats_put(map, "objects_scanned", _gc_stats_number(stats->total_scanned));
+    _gc_stats_put(map, "objects_freed", _gc_stats_number(stats->total_freed));
+    _gc_stats_put(map, "last_scanned", _gc_stats_number(stats->last_scanned));
+    _gc_stats_put(map, "last_freed", _gc_stats_number(stats->last_freed));
+    _gc_stats_put(map, "threshold", _gc_stats_number(stats->threshold));
+    _gc_stats_put(map, "max_threshold", _gc_stats_number(stats->max_threshold));
+    _gc_stats_put(map, "live_objects", _gc_stats_number(stats->live_objects));
+
+    RtList *histogram = init_RtList(GC_PAUSE_HISTOGRAM_BUCKETS);
+    for (size_t i = 0; i < GC_PAUSE_HISTOGRAM_BUCKETS; i++)
+        rtlist_append(histogram, add_to_GC_registry(_gc_stats_number(stats->pause_histogram[i])));
+
+    RtObject *histogramobj = init_RtObject(LIST_TYPE);
+    histogramobj->data.List = histogram;
+    _gc_stats_put(map, "pause_histogram_us", histogramobj);
+
+    size_t history_len = stats->threshold_history_len < GC_THRESHOLD_HISTORY_LEN
+                             ? stats->threshold_history_len
+                             : GC_THRESHOLD_HISTORY_LEN;
+    RtList *history = init_RtList(history_len);
+    for (size_t i = 0; i < history_len; i++)
+        rtlist_append(history, add_to_GC_registry(_gc_stats_number(GC_threshold_history_at(stats, i))));
+
+    RtObject *historyobj = init_RtObject(LIST_TYPE);
+    historyobj->data.List = history;
+    _gc_stats_put(map, "threshold_history", historyobj);
+
+    RtMap *by_type = init_RtMap(0);
+    if (!by_type)
+        MallocError();
+
+    for (int i = 0; i < NB_OF_TYPES; i++)
+        _gc_stats_put(by_type, rtobj_type_toString((RtType)i), _gc_stats_number(stats->live_by_type[i]));
+
+    RtObject *by_typeobj = init_RtObject(HASHMAP_TYPE);
+    by_typeobj->data.Map = by_type;
+    _gc_stats_put(map, "live_by_type", by_typeobj);
+
+    RtObject *statsobj = init_RtObject(HASHMAP_TYPE);
+    statsobj->data.Map = map;
+    return statsobj;
+}
+
+/**
+ * DESCRIPTION:
+ * Builtin function writing a heap snapshot of the program to a file (see runtime/heapsnapshot.h),
+ * the snapshot can be analyzed with the --analyze-heap flag
+ */
+static RtObject *builtin_heap_snapshot(RtObject **args, int argcount)
+{
+    if (argcount != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("heap_snapshot(path)", argcount, 1);
+        return NULL;
+    }
+
+    if (args[0]->type != STRING_TYPE)
+    {
+        setIntermediateException(init_InvalidTypeException_Builtin("heap_snapshot(path)", "String", args[0]));
+        return NULL;
+    }
+
+    const char *path = rtstr_chars(args[0]->data.String);
+    if (!write_heap_snapshot(path))
+    {
+        char buffer[100 + args[0]->data.String->length];
+        snprintf(buffer, sizeof(buffer), "Builtin function heap_snapshot(path) failed to write to %s.", path);
+        setIntermediateException(IOExceptionException(buffer));
+        return NULL;
+    }
+
+    return init_RtObject(UNDEFINED_TYPE);
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for creating a lazy range of numbers, values are only computed when the range is iterated over
+ * range(end) yields 0, 1, ..., end - 1
+ * range(start, end) yields start, start + 1, ..., end - 1
+ * range(start, end, step) yields start, start + step, ... up to end (exclusive), step can be negative but not 0
+ */
+static RtObject *builtin_range(RtObject **args, int argcount)
+{
+    if (argcount < 1 || argcount > 3)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin range(start, end, step)", argcount, 3);
+        return NULL;
+    }
+
+    for (int i = 0; i < argcount; i++)
+    {
+        if (args[i]->type != NUMBER_TYPE)
+        {
+            setIntermediateException(init_InvalidTypeException_Builtin("range(start, end, step)", "Number", args[i]));
+            return NULL;
+        }
+    }
+
+    long double start = argcount == 1 ? 0 : args[0]->data.Number->number;
+    long double end = argcount == 1 ? args[0]->data.Number->number : args[1]->data.Number->number;
+    long double step = argcount == 3 ? args[2]->data.Number->number : 1;
+
+    if (step == 0)
+    {
+        setIntermediateException(InvalidValueException("Builtin range(start, end, step) cannot take a step of 0"));
+        return NULL;
+    }
+
+    RtObject *range = init_RtObject(RANGE_TYPE);
+    range->data.Range = init_RtRange(start, end, step);
+    return range;
+}
+
+/**
+ * Higher order built in functions (map, filter, reduce, any, all) and helpers for iterating over iterables
+ * Functions are called through rt_call, which runs user functions without going back to the main dispatch loop
+ *
+ * NOTE:
+ * The functions that are called can run arbitrary code, including the GC, and mutate the iterable.
+ * Iterables are therefore iterated over a snapshot (see rtobj_cow_cpy), and objects kept across calls are referenced
+ */
+
+/**
+ * DESCRIPTION:
+ * Helper returning a snapshot of an iterable argument, containers are copied lazily so its done in constant time
+ * Returns NULL if the object is not iterable, in which case the intermediate exception is set
+ */
+static RtObject *_iter_snapshot(const char *builtin_name, RtObject *iterable)
+{
+    if (!rtobj_iterable(iterable))
+    {
+        setIntermediateException(init_InvalidTypeException_Builtin(builtin_name, "Iterable", iterable));
+        return NULL;
+    }
+
+    return rtobj_cow_cpy(iterable);
+}
+
+/**
+ * DESCRIPTION:
+ * Helper checking that an argument of a higher order function can be called, sets the intermediate exception if it cannot
+ */
+static bool _check_callable(const char *builtin_name, const RtObject *func)
+{
+    if (func->type != FUNCTION_TYPE)
+    {
+        setIntermediateException(init_InvalidTypeException_Builtin(builtin_name, "Function", func));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Helper creating a list object with enough room for length elements, so appending them never resizes the list
+ */
+static RtObject *_init_list_obj(size_t length)
+{
+    RtObject *list = init_RtObject(LIST_TYPE);
+    list->data.List = init_RtList(length + 1);
+    return list;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning the list of the results of func called on every element of an iterable
+ * map(iterable, func)
+ */
+static RtObject *builtin_map(RtObject **args, int argcount)
+{
+    if (argcount != 2)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin map(iterable, func)", argcount, 2);
+        return NULL;
+    }
+
+    if (!_check_callable("map(iterable, func)", args[1]))
+        return NULL;
+
+    RtObject *snapshot = _iter_snapshot("map(iterable, func)", args[0]);
+    if (!snapshot)
+        return NULL;
+
+    RtObject *result = _init_list_obj(rtobj_iter_length(snapshot));
+    size_t cursor = 0;
+    bool fresh;
+    RtObject *element;
+
+    while ((element = rtobj_iterate(snapshot, &cursor, &fresh)))
+    {
+        RtObject *mapped = rt_call(args[1], &element, 1);
+        if (!mapped)
+        {
+            rtobj_free(result, false, true);
+            result = NULL;
+            break;
+        }
+        rtlist_append(result->data.List, mapped);
+    }
+
+    rtobj_free(snapshot, false, true);
+    return result;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning the list of the elements of an iterable for which func returns a truthy value
+ * filter(iterable, func)
+ */
+static RtObject *builtin_filter(RtObject **args, int argcount)
+{
+    if (argcount != 2)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin filter(iterable, func)", argcount, 2);
+        return NULL;
+    }
+
+    if (!_check_callable("filter(iterable, func)", args[1]))
+        return NULL;
+
+    RtObject *snapshot = _iter_snapshot("filter(iterable, func)", args[0]);
+    if (!snapshot)
+        return NULL;
+
+    RtObject *result = _init_list_obj(rtobj_iter_length(snapshot));
+    size_t cursor = 0;
+    bool fresh;
+    RtObject *element;
+
+    while ((element = rtobj_iterate(snapshot, &cursor, &fresh)))
+    {
+        RtObject *keep = rt_call(args[1], &element, 1);
+        if (!keep)
+        {
+            rtobj_free(result, false, true);
+            result = NULL;
+            break;
+        }
+
+        // primitives stored in the snapshot are copied, like any element of a new list
+        if (eval_obj(keep))
+            rtlist_append(result->data.List, rtobj_rt_preprocess(element, fresh, true));
+    }
+
+    rtobj_free(snapshot, false, true);
+    return result;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function folding an iterable from left to right, func is called with the accumulated value and the next element
+ * reduce(iterable, func) starts with the first element, reduce(iterable, func, initial) starts with initial
+ */
+static RtObject *builtin_reduce(RtObject **args, int argcount)
+{
+    if (argcount != 2 && argcount != 3)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin reduce(iterable, func, initial)", argcount, 3);
+        return NULL;
+    }
+
+    if (!_check_callable("reduce(iterable, func, initial)", args[1]))
+        return NULL;
+
+    RtObject *snapshot = _iter_snapshot("reduce(iterable, func, initial)", args[0]);
+    if (!snapshot)
+        return NULL;
+
+    size_t cursor = 0;
+    bool fresh;
+    RtObject *acc = argcount == 3 ? args[2] : rtobj_iterate(snapshot, &cursor, &fresh);
+
+    if (!acc)
+    {
+        rtobj_free(snapshot, false, true);
+        setIntermediateException(InvalidValueException("Builtin reduce(iterable, func) cannot reduce an empty iterable without an initial value"));
+        return NULL;
+    }
+
+    if (argcount == 2)
+        acc = rtobj_rt_preprocess(acc, fresh, true);
+
+    // the accumulated value is only referenced by this function between calls
+    rtobj_refcount_increment1(acc);
+
+    RtObject *element;
+    while ((element = rtobj_iterate(snapshot, &cursor, &fresh)))
+    {
+        RtObject *callargs[2] = {acc, element};
+        RtObject *next = rt_call(args[1], callargs, 2);
+        rtobj_refcount_decrement1(acc);
+
+        if (!next)
+        {
+            acc = NULL;
+            break;
+        }
+
+        acc = next;
+        rtobj_refcount_increment1(acc);
+    }
+
+    if (acc)
+        rtobj_refcount_decrement1(acc);
+
+    rtobj_free(snapshot, false, true);
+    return acc;
+}
+
+/**
+ * DESCRIPTION:
+ * Helper for any and all, returns wether func (or the elements themselves without func) is truthy for any/all elements
+ * Iteration stops at the first element that decides the result
+ * Returns -1 if an exception occured
+ */
+static int _any_all(RtObject **args, int argcount, const char *builtin_name, bool any)
+{
+    if (argcount != 1 && argcount != 2)
+    {
+        setInvalidNumberOfArgsIntermediateException(builtin_name, argcount, 2);
+        return -1;
+    }
+
+    if (argcount == 2 && !_check_callable(builtin_name, args[1]))
+        return -1;
+
+    RtObject *snapshot = _iter_snapshot(builtin_name, args[0]);
+    if (!snapshot)
+        return -1;
+
+    int result = !any;
+    size_t cursor = 0;
+    bool fresh;
+    RtObject *element;
+
+    while ((element = rtobj_iterate(snapshot, &cursor, &fresh)))
+    {
+        bool truthy;
+        if (argcount == 2)
+        {
+            RtObject *ret = rt_call(args[1], &element, 1);
+            if (!ret)
+            {
+                result = -1;
+                break;
+            }
+            truthy = eval_obj(ret);
+        }
+        else
+        {
+            truthy = eval_obj(element);
+            if (fresh)
+                rtobj_free(element, false, true);
+        }
+
+        if (truthy == any)
+        {
+            result = any;
+            break;
+        }
+    }
+
+    rtobj_free(snapshot, false, true);
+    return result;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning 1 if func returns a truthy value for any element of an iterable, 0 otherwise
+ * any(iterable) checks the elements themselves
+ */
+static RtObject *builtin_any(RtObject **args, int argcount)
+{
+    int any = _any_all(args, argcount, "any(iterable, func)", true);
+    if (any == -1)
+        return NULL;
+
+    RtObject *obj = init_RtObject(NUMBER_TYPE);
+    obj->data.Number = init_RtNumber(any);
+    return obj;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning 1 if func returns a truthy value for all elements of an iterable, 0 otherwise
+ * all(iterable) checks the elements themselves
+ */
+static RtObject *builtin_all(RtObject **args, int argcount)
+{
+    int all = _any_all(args, argcount, "all(iterable, func)", false);
+    if (all == -1)
+        return NULL;
+
+    RtObject *obj = init_RtObject(NUMBER_TYPE);
+    obj->data.Number = init_RtNumber(all);
+    return obj;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning a list of lists, the ith list holds the ith element of every iterable
+ * The result is as long as the shortest iterable
+ * zip(iterable_1, iterable_2, ..., iterable_n)
+ */
+static RtObject *builtin_zip(RtObject **args, int argcount)
+{
+    if (argcount == 0)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin zip(iterable_1, iterable_2, ..., iterable_n)", argcount, INT64_MAX);
+        return NULL;
+    }
+
+    size_t length = SIZE_MAX;
+    for (int i = 0; i < argcount; i++)
+    {
+        if (!rtobj_iterable(args[i]))
+        {
+            setIntermediateException(init_InvalidTypeException_Builtin("zip(iterable_1, iterable_2, ..., iterable_n)", "Iterable", args[i]));
+            return NULL;
+        }
+
+        size_t len = rtobj_iter_length(args[i]);
+        if (len < length)
+            length = len;
+    }
+
+    // no user code runs, so the iterables can be iterated over directly
+    RtObject *result = _init_list_obj(length);
+    size_t cursors[argcount];
+    for (int i = 0; i < argcount; i++)
+        cursors[i] = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        RtObject *tuple = _init_list_obj(argcount);
+        for (int j = 0; j < argcount; j++)
+        {
+            bool fresh;
+            RtObject *element = rtobj_iterate(args[j], &cursors[j], &fresh);
+            assert(element);
+            rtlist_append(tuple->data.List, rtobj_rt_preprocess(element, fresh, true));
+        }
+
+        add_to_GC_registry(tuple);
+        rtlist_append(result->data.List, tuple);
+    }
+
+    return result;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning a list of [index, element] lists for every element of an iterable
+ * enumerate(iterable)
+ */
+static RtObject *builtin_enumerate(RtObject **args, int argcount)
+{
+    if (argcount != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin enumerate(iterable)", argcount, 1);
+        return NULL;
+    }
+
+    if (!rtobj_iterable(args[0]))
+    {
+        setIntermediateException(init_InvalidTypeException_Builtin("enumerate(iterable)", "Iterable", args[0]));
+        return NULL;
+    }
+
+    RtObject *result = _init_list_obj(rtobj_iter_length(args[0]));
+    size_t cursor = 0;
+    bool fresh;
+    RtObject *element;
+
+    for (size_t i = 0; (element = rtobj_iterate(args[0], &cursor, &fresh)); i++)
+    {
+        RtObject *index = init_RtObject(NUMBER_TYPE);
+        index->data.Number = init_RtNumber(i);
+        add_to_GC_registry(index);
+
+        RtObject *pair = _init_list_obj(2);
+        rtlist_append(pair->data.List, index);
+        rtlist_append(pair->data.List, rtobj_rt_preprocess(element, fresh, true));
+
+        add_to_GC_registry(pair);
+        rtlist_append(result->data.List, pair);
+    }
+
+    return result;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for summing the numbers of an iterable
+ * Ranges are summed in constant time, and lists of numbers directly from their unboxed storage
+ * sum(iterable)
+ */
+static RtObject *builtin_sum(RtObject **args, int argcount)
+{
+    if (argcount != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin sum(iterable)", argcount, 1);
+        return NULL;
+    }
+
+    RtObject *iterable = args[0];
+    if (!rtobj_iterable(iterable))
+    {
+        setIntermediateException(init_InvalidTypeException_Builtin("sum(iterable)", "Iterable", iterable));
+        return NULL;
+    }
+
+    long double total = 0;
+
+    if (iterable->type == RANGE_TYPE)
+    {
+        // arithmetic series
+        const RtRange *range = iterable->data.Range;
+        long double n = rtrange_length(range);
+        total = n * range->start + range->step * n * (n - 1) / 2;
+    }
+    else if (iterable->type == LIST_TYPE && iterable->data.List->strategy == RTLIST_NUMBERS)
+    {
+        const RtList *list = iterable->data.List;
+        for (size_t i = 0; i < list->length; i++)
+            total += list->numbers[i];
+    }
+    else
+    {
+        size_t cursor = 0;
+        bool fresh;
+        RtObject *element;
+
+        while ((element = rtobj_iterate(iterable, &cursor, &fresh)))
+        {
+            if (element->type != NUMBER_TYPE)
+            {
+                setIntermediateException(init_InvalidTypeException_Builtin("sum(iterable)", "Number", element));
+                if (fresh)
+                    rtobj_free(element, false, true);
+                return NULL;
+            }
+
+            total += element->data.Number->number;
+            if (fresh)
+                rtobj_free(element, false, true);
+        }
+    }
+
+    RtObject *obj = init_RtObject(NUMBER_TYPE);
+    obj->data.Number = init_RtNumber(total);
+    return obj;
+}
+
+/**
+ * DESCRIPTION:
+ * Helper reading the optional number of workers of parallel built in functions (third argument),
+ * returns 0 and sets the intermediate exception if its not a positive integer
+ */
+static unsigned int _parallel_workers(const char *builtin_name, RtObject **args, int argcount)
+{
+    if (argcount < 3)
+        return parallel_default_workers();
+
+    if (args[2]->type != NUMBER_TYPE)
+    {
+        setIntermediateException(init_InvalidTypeException_Builtin(builtin_name, "Number", args[2]));
+        return 0;
+    }
+
+    long double workers = args[2]->data.Number->number;
+    if (workers < 1 || workers != floorl(workers))
+    {
+        char buffer[strlen(builtin_name) + 80];
+        snprintf(buffer, sizeof(buffer), "Builtin %s expects a positive integer number of workers", builtin_name);
+        setIntermediateException(InvalidValueException(buffer));
+        return 0;
+    }
+
+    return workers > PARALLEL_MAX_WORKERS ? PARALLEL_MAX_WORKERS : (unsigned int)workers;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning the list of the results of func called on every element of an iterable, the calls are run by parallel workers.
+ * Workers run on copies of func and of the elements (see rtparallel.h), so func should be pure
+ * parallel_map(iterable, func) or parallel_map(iterable, func, workers)
+ */
+static RtObject *builtin_parallel_map(RtObject **args, int argcount)
+{
+    if (argcount != 2 && argcount != 3)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin parallel_map(iterable, func, workers)", argcount, 3);
+        return NULL;
+    }
+
+    if (!_check_callable("parallel_map(iterable, func, workers)", args[1]))
+        return NULL;
+
+    unsigned int workers = _parallel_workers("parallel_map(iterable, func, workers)", args, argcount);
+    if (!workers)
+        return NULL;
+
+    RtObject *snapshot = _iter_snapshot("parallel_map(iterable, func, workers)", args[0]);
+    if (!snapshot)
+        return NULL;
+
+    // elements are gathered beforehand, workers then read them at the same time
+    size_t length = rtobj_iter_length(snapshot);
+    RtObject **inputs = malloc(sizeof(RtObject *) * (length + 1));
+    bool *fresh = malloc(sizeof(bool) * (length + 1));
+    if (!inputs || !fresh)
+        MallocError();
+
+    size_t count = 0;
+    size_t cursor = 0;
+    while (count < length && (inputs[count] = rtobj_iterate(snapshot, &cursor, &fresh[count])))
+        count++;
+
+    RtObject *result = parallel_call(args[1], inputs, count, workers);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (fresh[i])
+            rtobj_free(inputs[i], false, true);
+    }
+
+    free(inputs);
+    free(fresh);
+    rtobj_free(snapshot, false, true);
+    return result;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function returning the list of the results of func called on every integer from 0 to n (exclusive), the calls are run by parallel workers.
+ * Like parallel_map(range(n), func), without creating the numbers beforehand
+ * parallel_for(n, func) or parallel_for(n, func, workers)
+ */
+static RtObject *builtin_parallel_for(RtObject **args, int argcount)
+{
+    if (argcount != 2 && argcount != 3)
+    {
+        setInvalidNumberOfArgsIntermediateException("Builtin parallel_for(n, func, workers)", argcount, 3);
+        return NULL;
+    }
+
+    if (args[0]->type != NUMBER_TYPE)
+    {
+        setIntermediateException(init_InvalidTypeException_Builtin("parallel_for(n, func, workers)", "Number", args[0]));
+        return NULL;
+    }
+
+    long double n = args[0]->data.Number->number;
+    if (n < 0 || n != floorl(n))
+    {
+        setIntermediateException(InvalidValueException("Builtin parallel_for(n, func, workers) expects a non negative integer number of calls"));
+        return NULL;
+    }
+
+    if (!_check_callable("parallel_for(n, func, workers)", args[1]))
+        return NULL;
+
+    unsigned int workers = _parallel_workers("parallel_for(n, func, workers)", args, argcount);
+    if (!workers)
+        return NULL;
+
+    return parallel_call(args[1], NULL, (size_t)n, workers);
+}
@@ -20,6 +20,7 @@ int init_BuiltinFuncs();
 bool ident_is_builtin(const char *identifier);
 RtObject *get_builtinfunc(const char *identifier);
 void cleanup_builtin();
+int register_BuiltinFunc(const char *name, RtObject *(*func)(RtObject **, int), size_t arg_count);
 
 #define BUILT_IN_SCRIPT_ARGS_VAR "__args__"
 
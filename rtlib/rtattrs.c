@@ -24,7 +24,7 @@ static GenericMap *attrsRegistry = NULL;
 
 static unsigned int _hash_attrbuiltin(const AttrBuiltinKey *attr)
 {
-    return djb2_string_hash(attr->attrname);
+    return string_hash(attr->attrname);
 }
 
 static bool _attrbuiltinin_equal(const AttrBuiltinKey *attr1, const AttrBuiltinKey *attr2)
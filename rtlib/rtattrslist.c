@@ -3,11 +3,16 @@
 #include "../generics/hashmap.h"
 #include "../generics/utilities.h"
 #include "../runtime/rtexchandler.h"
+#include "../runtime/runtime.h"
+#include "../runtime/gc.h"
 
 static RtObject *builtin_list_append(RtObject *list, RtObject **args, int argcount);
 static RtObject *builtin_list_pop(RtObject *target, RtObject **args, int argcount);
 static RtObject *builtin_list_popLast(RtObject *target, RtObject **args, int argcount);
 static RtObject *builtin_list_popFirst(RtObject *target, RtObject **args, int argcount);
+static RtObject *builtin_list_pushFront(RtObject *target, RtObject **args, int argcount);
+static RtObject *builtin_list_popFront(RtObject *target, RtObject **args, int argcount);
+static RtObject *builtin_list_popBack(RtObject *target, RtObject **args, int argcount);
 static RtObject *builtin_list_clear(RtObject *target, RtObject **args, int argcount);
 static RtObject *builtin_list_contains(RtObject *target, RtObject **args, int argcount);
 static RtObject *builtin_list_remove(RtObject *target, RtObject **args, int argcount);
@@ -33,6 +38,22 @@ static const AttrBuiltinKey _list_popFirst_key = {LIST_TYPE, "popFirst"};
 static const AttrBuiltin _list_popFirst = 
 {LIST_TYPE, {.builtin_func = builtin_list_popFirst}, 0, "popFirst", true};
 
+static const AttrBuiltinKey _list_pushFront_key = {LIST_TYPE, "pushFront"};
+static const AttrBuiltin _list_pushFront = 
+{LIST_TYPE, {.builtin_func = builtin_list_pushFront}, 1, "pushFront", true};
+
+static const AttrBuiltinKey _list_pushBack_key = {LIST_TYPE, "pushBack"};
+static const AttrBuiltin _list_pushBack = 
+{LIST_TYPE, {.builtin_func = builtin_list_append}, -1, "pushBack", true};
+
+static const AttrBuiltinKey _list_popFront_key = {LIST_TYPE, "popFront"};
+static const AttrBuiltin _list_popFront = 
+{LIST_TYPE, {.builtin_func = builtin_list_popFront}, 0, "popFront", true};
+
+static const AttrBuiltinKey _list_popBack_key = {LIST_TYPE, "popBack"};
+static const AttrBuiltin _list_popBack = 
+{LIST_TYPE, {.builtin_func = builtin_list_popBack}, 0, "popBack", true};
+
 static const AttrBuiltinKey _list_clear_key = {LIST_TYPE, "clear"};
 static const AttrBuiltin _list_clear = 
 {LIST_TYPE, {.builtin_func = builtin_list_clear}, 0, "clear", true};
@@ -84,6 +105,10 @@ void init_RtListAttr(GenericMap *registry) {
     addToAttrRegistry(registry, _list_pop_key, _list_pop);
     addToAttrRegistry(registry, _list_popLast_key, _list_popLast);
     addToAttrRegistry(registry, _list_popFirst_key, _list_popFirst);
+    addToAttrRegistry(registry, _list_pushFront_key, _list_pushFront);
+    addToAttrRegistry(registry, _list_pushBack_key, _list_pushBack);
+    addToAttrRegistry(registry, _list_popFront_key, _list_popFront);
+    addToAttrRegistry(registry, _list_popBack_key, _list_popBack);
     addToAttrRegistry(registry, _list_clear_key, _list_clear);
     addToAttrRegistry(registry, _list_contains_key, _list_contains);
     addToAttrRegistry(registry, _list_remove_key, _list_remove);
@@ -138,9 +163,9 @@ static RtObject *builtin_list_pop(RtObject *target, RtObject **args, int argcoun
     size_t list_len = list->length;
     double number = args[0]->data.Number->number;
 
-    RtObject *removed = rtlist_removeindex(list, (size_t)number);
+    bool removed = rtlist_removeindex(list, (size_t)number);
 
-    // If NULL is returned, then its an out of bounds exception
+    // If false is returned, then its an out of bounds exception
     if(!removed) {  
         setIndexOutOfBoundsException(target, number, list_len);
         return NULL;
@@ -164,10 +189,10 @@ static RtObject *builtin_list_popLast(RtObject *target, RtObject **args, int arg
 
     (void)args;
 
-    RtObject *obj = rtlist_poplast(target->data.List);
+    bool popped = rtlist_poplast(target->data.List);
     
-    // If NULL is returned, then list is empty
-    if(!obj) {
+    // If false is returned, then list is empty
+    if(!popped) {
         setIndexOutOfBoundsException(target, 0, 0);
         return NULL;
     }
@@ -189,10 +214,10 @@ static RtObject *builtin_list_popFirst(RtObject *target, RtObject **args, int ar
     }
 
     (void)args;
-    RtObject *obj = rtlist_popfirst(target->data.List);
+    bool popped = rtlist_popfirst(target->data.List);
 
-    // If NULL is returned, then list is empty
-    if(!obj) {
+    // If false is returned, then list is empty
+    if(!popped) {
         setIndexOutOfBoundsException(target, 0, 0);
         return NULL;
     }
@@ -200,6 +225,86 @@ static RtObject *builtin_list_popFirst(RtObject *target, RtObject **args, int ar
     return target;
 }
 
+/**
+ * DESCRIPTION:
+ * Builtin function for adding an object at the front of a rt list, in amortized constant time (see rtlist_prepend)
+ * Along with pushBack, popFront and popBack, it lets a list be used as a double ended queue
+ * EX:
+ * list->pushFront(obj)
+ */
+static RtObject *builtin_list_pushFront(RtObject *target, RtObject **args, int argcount) {
+    assert(target->type == LIST_TYPE);
+
+    // Checks # of arguments     
+    if(argcount != 1) {
+        setInvalidNumberOfArgsIntermediateException("pushFront()", argcount, 1);
+        return NULL;
+    }
+
+    rtlist_prepend(target->data.List, args[0]);
+    return target;
+}
+
+/**
+ * DESCRIPTION:
+ * Helper for popFront and popBack, removes the first or last element of a list and returns it
+ * The element of an unboxed list is returned as a new object, otherwise the object stored by the list is returned
+ */
+static RtObject *_list_pop_end(RtObject *target, bool front) {
+    RtList *list = target->data.List;
+
+    // list is empty
+    if(list->length == 0) {
+        setIndexOutOfBoundsException(target, 0, 0);
+        return NULL;
+    }
+
+    RtObject *obj = rtlist_get(list, front ? 0 : list->length - 1);
+    bool popped = front ? rtlist_popfirst(list) : rtlist_poplast(list);
+    assert(popped);
+    (void)popped;
+
+    return obj;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for removing the first element of a rt list and returning it, in constant time
+ * EX:
+ * let first = list->popFront()
+*/
+static RtObject *builtin_list_popFront(RtObject *target, RtObject **args, int argcount) {
+    assert(target->type == LIST_TYPE);
+
+    // Checks # of arguments     
+    if(argcount != 0) {
+        setInvalidNumberOfArgsIntermediateException("popFront()", argcount, 0);
+        return NULL;
+    }
+
+    (void)args;
+    return _list_pop_end(target, true);
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for removing the last element of a rt list and returning it
+ * EX:
+ * let last = list->popBack()
+*/
+static RtObject *builtin_list_popBack(RtObject *target, RtObject **args, int argcount) {
+    assert(target->type == LIST_TYPE);
+
+    // Checks # of arguments     
+    if(argcount != 0) {
+        setInvalidNumberOfArgsIntermediateException("popBack()", argcount, 0);
+        return NULL;
+    }
+
+    (void)args;
+    return _list_pop_end(target, false);
+}
+
 /**
  * DESCRIPTION:
  * Built in function for adding a element into a specific index of a rt list
@@ -272,7 +377,16 @@ static RtObject *builtin_list_toset(RtObject *target, RtObject **args, int argco
     RtSet* set = init_RtSet(list->length);
 
     for(size_t i=0; i < list->length; i++) {
-        rtset_insert(set, list->objs[i]);
+        RtObject *obj = rtlist_get(list, i);
+
+        // unboxed elements get a new wrapper, which must live in the GC like any other element
+        // other elements may be variables too (see rtobj_key_cpy)
+        if(rtlist_unboxed(list))
+            add_to_GC_registry(obj);
+        else
+            obj = rtobj_key_cpy(obj);
+
+        rtset_insert(set, obj);
     }
 
     RtObject *setobj = init_RtObject(HASHSET_TYPE);
@@ -298,78 +412,147 @@ static RtObject *builtin_list_reverse(RtObject *target, RtObject **args, int arg
     return target;
 }   
 
-static int _rtobj_compare_wrapper(const RtObject **o1, const RtObject **o2);
-static int _rtobj_reverse_compare_wrapper(const RtObject **o1, const RtObject **o2);
-
 /**
- * Useful macro for sorting lists (in regular or reverse order)
+ * Useful function for sorting lists (in regular or reverse order)
+ * Lists of numbers and strings are sorted by value directly, the elements of other lists are compared with rtobj_compare,
+ * lists inside of the list are sorted as well (see rtlist_sort)
+ * The list gets its own array first, since sorting a copy on write list must not reorder its copies
 */
-#define SortList(rtlistobj, reverse) \
-    qsort(rtlistobj->data.List->objs, \
-    rtlistobj->data.List->length, \
-    sizeof(*(rtlistobj->data.List->objs)), \
-    (int (*)(const void *, const void *)) \
-    (reverse? _rtobj_reverse_compare_wrapper :_rtobj_compare_wrapper)); 
+static void sort_list(const RtObject *rtlistobj, bool reverse) {
+    RtList *list = rtlist_unshare(rtlistobj->data.List);
+    if(!rtlist_unboxed(list)) {
+        for(size_t i = 0; i < list->length; i++) {
+            if(list->objs[i]->type == LIST_TYPE && list->objs[i] != rtlistobj)
+                sort_list(list->objs[i], reverse);
+        }
+    }
 
-/**
- * DESCRIPTION:
- * Helper function for sorting in regular order, used by the builtin sort function
- * This function allows us to also sort other lists recursively
-*/
-static int _rtobj_compare_wrapper(const RtObject **o1, const RtObject **o2) {
-    int res = rtobj_compare(*o1, *o2);
-    if((*o1)->type == LIST_TYPE) 
-        SortList((*o1), false);
-    if((*o2)->type == LIST_TYPE) 
-        SortList((*o2), false);
-    return res;
+    rtlist_sort(list, reverse);
 }
 
 /**
  * DESCRIPTION:
- * Helper function for sorting in reverse, used by the builtin sort function
- * This function allows us to also sort other lists recursively
+ * Sorts a list by the result of a key function, which is called exactly once per element (i.e len, or any user function)
+ * Keys are computed over a snapshot of the list, since the key function is free to mutate it
+ *
+ * NOTE:
+ * Returns false if an exception was raised, either by the key function or because it changed the length of the list
 */
-static int _rtobj_reverse_compare_wrapper(const RtObject **o1, const RtObject **o2) {
-    int res = -rtobj_compare(*o1, *o2);
-    if((*o1)->type == LIST_TYPE) 
-        SortList((*o1), true);
-    if((*o2)->type == LIST_TYPE) 
-        SortList((*o2), true);
-    return res;
+static bool sort_list_by_key(RtObject *rtlistobj, RtObject *keyfunc, bool reverse) {
+    RtObject *snapshot = rtobj_cow_cpy(rtlistobj);
+    size_t length = snapshot->data.List->length;
+    RtObject **keys = malloc(sizeof(RtObject *) * (length + 1));
+    if(!keys)
+        MallocError();
+
+    size_t evaluated = 0;
+    for(; evaluated < length; evaluated++) {
+        RtObject *element = rtlist_get(snapshot->data.List, evaluated);
+        RtObject *key = rt_call(keyfunc, &element, 1);
+        if(!key)
+            break;
+
+        // keys are only referenced here, they must survive the GC until the list is sorted
+        rtobj_refcount_increment1(key);
+        keys[evaluated] = key;
+    }
+
+    RtList *list = rtlistobj->data.List;
+    if(!Intermediate_raisedException && list->length != length) {
+        setIntermediateException(InvalidValueException("List attribute function sort() cannot sort a list whose length was changed by the key function"));
+    }
+
+    bool sorted = !Intermediate_raisedException;
+    if(sorted)
+        rtlist_sort_by_keys(list, keys, reverse);
+
+    for(size_t i = 0; i < evaluated; i++)
+        rtobj_refcount_decrement1(keys[i]);
+    free(keys);
+    rtobj_free(snapshot, false, true);
+
+    return sorted;
 }
 
 /**
  * DESCRIPTION:
  * Built in function for sorting a list in place
  * 
- * This function can take a single parameter, if the param = "reverse", 
- * then the list will be sorted in reverse order
+ * This function can take up to 2 parameters, in any order:
+ * if a param = "reverse", then the list will be sorted in reverse order
+ * if a param is a function, elements are ordered by the result of that function, i.e list->sort(len)
 */
 static RtObject *builtin_list_sort(RtObject *target, RtObject **args, int argcount) {
     assert(target->type == LIST_TYPE);
-    (void)args;
 
     // Checks # of arguments     
-    if(argcount != 1 && argcount != 0) {
-        setInvalidNumberOfArgsIntermediateException("sort()", argcount, 1);
+    if(argcount > 2) {
+        setInvalidNumberOfArgsIntermediateException("sort()", argcount, 2);
         return NULL;
     }
 
     bool reverse = false;
-    if( argcount == 1 && 
-        args[0]->type == STRING_TYPE &&
-        strings_equal(args[0]->data.String->string, "reverse")) {
-        
-        reverse = true;
+    RtObject *keyfunc = NULL;
+    for(int i = 0; i < argcount; i++) {
+        if(args[i]->type == FUNCTION_TYPE) {
+            keyfunc = args[i];
+        } else if(args[i]->type == STRING_TYPE &&
+            strings_equal(rtstr_chars(args[i]->data.String), "reverse")) {
+
+            reverse = true;
+        }
     }
 
-    SortList(target, reverse);
+    if(!keyfunc) {
+        sort_list(target, reverse);
+    } else if(!sort_list_by_key(target, keyfunc, reverse)) {
+        return NULL;
+    }
     
     return target;
 }
 
 
+/**
+ * DESCRIPTION:
+ * Helper for the max and min builtins, returns the greatest (or smallest) element of a non empty list
+ * Numbers and strings of unboxed lists are compared directly, in which case a new object is returned for the element
+*/
+static RtObject *_list_extremum(const RtList *list, bool max) {
+    assert(list->length > 0);
+    int sign = max ? 1 : -1;
+
+    if(list->strategy == RTLIST_NUMBERS) {
+        long double extremum = list->numbers[0];
+        for(size_t i = 1; i < list->length; i++) {
+            if(max ? list->numbers[i] > extremum : list->numbers[i] < extremum)
+                extremum = list->numbers[i];
+        }
+
+        RtObject *res = init_RtObject(NUMBER_TYPE);
+        res->data.Number = init_RtNumber(extremum);
+        return res;
+    }
+
+    if(list->strategy == RTLIST_STRINGS) {
+        size_t extremum = 0;
+        for(size_t i = 1; i < list->length; i++) {
+            if(sign * rtstr_compare(list->strings[extremum], list->strings[i]) < 0)
+                extremum = i;
+        }
+        return rtlist_get(list, extremum);
+    }
+
+    RtObject *extremum = list->objs[0];
+    for(size_t i = 1; i < list->length; i++) {
+        if(sign * rtobj_compare(extremum, list->objs[i]) < 0) {
+            extremum = list->objs[i];
+        }
+    }
+
+    return extremum;
+}
+
 /**
  * DESCRIPTION:
  * Built in function for getting the max value of a list
@@ -385,15 +568,12 @@ static RtObject *builtin_list_max(RtObject *target, RtObject **args, int argcoun
         return NULL;
     }
 
-    RtList *list = target->data.List;
-    RtObject *max = list->objs[0];
-    for(size_t i = 1; i < list->length; i++) {
-        if(rtobj_compare(max, list->objs[i]) < 0) {
-            max = list->objs[i];
-        }
+    if(target->data.List->length == 0) {
+        setIndexOutOfBoundsException(target, 0, 0);
+        return NULL;
     }
 
-    return max;
+    return _list_extremum(target->data.List, true);
 }
 
 /**
@@ -411,16 +591,10 @@ static RtObject *builtin_list_min(RtObject *target, RtObject **args, int argcoun
         return NULL;
     }
 
-    RtList *list = target->data.List;
-    RtObject *min = list->objs[0];
-    for(size_t i = 1; i < list->length; i++) {
-        if(rtobj_compare(min, list->objs[i]) > 0) {
-            min = list->objs[i];
-        }
+    if(target->data.List->length == 0) {
+        setIndexOutOfBoundsException(target, 0, 0);
+        return NULL;
     }
 
-    return min;
+    return _list_extremum(target->data.List, false);
 }
-
-
-
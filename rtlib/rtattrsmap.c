@@ -82,7 +82,8 @@ static RtObject *builtin_map_add(RtObject *obj, RtObject **args, int argcount)
     }
 
     RtMap *map = obj->data.Map;
-    RtObject *key = args[0];
+    // the map gets its own key object, the argument may be a variable (see rtobj_key_cpy)
+    RtObject *key = rtobj_key_cpy(args[0]);
     RtObject *val = args[1];
     rtmap_insert(map, key, val);
     return obj;
@@ -144,17 +145,17 @@ static RtObject *builtin_map_contains_val(RtObject *obj, RtObject **args, int ar
     RtObject *val = args[0];
 
     bool contains = false;
-    RtObject **contents = rtmap_getrefs(map, false, true);
+    size_t cursor = 0;
+    RtObject *mapval;
 
-    for (int i = 0; contents[i] != NULL; i++)
+    while (rtmap_iterate(map, &cursor, NULL, &mapval))
     {
-        if (rtobj_equal(val, contents[i]))
+        if (rtobj_equal(val, mapval))
         {
             contains = true;
             break;
         }
     }
-    free(contents);
 
     RtObject *res = init_RtObject(NUMBER_TYPE);
     res->data.Number = init_RtNumber(contains);
@@ -182,7 +183,7 @@ static RtObject *builtin_map_clear(RtObject *obj, RtObject **args, int argcount)
 
 /**
  * DESCRIPTION:
- * Builtin function for getting all keys in a map
+ * Builtin function for getting all keys in a map, in insertion order
  */
 static RtObject *builtin_map_getkeys(RtObject *obj, RtObject **args, int argcount)
 {
@@ -195,13 +196,12 @@ static RtObject *builtin_map_getkeys(RtObject *obj, RtObject **args, int argcoun
     
     (void)args;
     RtMap *map = obj->data.Map;
-    RtObject **keys = rtmap_getrefs(map, true, false);
     RtList *list = init_RtList(map->size);
-    
-    for(size_t i=0; keys[i] != NULL; i++) 
-        rtlist_append(list, keys[i]);
+    size_t cursor = 0;
+    RtObject *key;
 
-    free(keys);
+    while(rtmap_iterate(map, &cursor, &key, NULL))
+        rtlist_append(list, key);
 
     RtObject *newlist = init_RtObject(LIST_TYPE);
     newlist->data.List = list;
@@ -210,7 +210,7 @@ static RtObject *builtin_map_getkeys(RtObject *obj, RtObject **args, int argcoun
 
 /**
  * DESCRIPTION:
- * Builtin function for getting all value in a map
+ * Builtin function for getting all value in a map, in insertion order
  */
 static RtObject *builtin_map_getvalues(RtObject *obj, RtObject **args, int argcount)
 {
@@ -223,13 +223,12 @@ static RtObject *builtin_map_getvalues(RtObject *obj, RtObject **args, int argco
 
     (void)args;
     RtMap *map = obj->data.Map;
-    RtObject **values = rtmap_getrefs(map, false, true);
     RtList *list = init_RtList(map->size);
-    
-    for(size_t i=0; values[i] != NULL; i++) 
-        rtlist_append(list, values[i]);
-        
-    free(values);
+    size_t cursor = 0;
+    RtObject *val;
+
+    while(rtmap_iterate(map, &cursor, NULL, &val))
+        rtlist_append(list, val);
 
     RtObject *newlist = init_RtObject(LIST_TYPE);
     newlist->data.List = list;
@@ -238,7 +237,7 @@ static RtObject *builtin_map_getvalues(RtObject *obj, RtObject **args, int argco
 
 /**
  * DESCRIPTION:
- * Creates a list of 2 size lists representing each key value pair
+ * Creates a list of 2 size lists representing each key value pair, in insertion order
 */
 static RtObject *builtin_map_getitems(RtObject *obj, RtObject **args, int argcount)
 {
@@ -251,21 +250,20 @@ static RtObject *builtin_map_getitems(RtObject *obj, RtObject **args, int argcou
 
     (void)args;
     RtMap *map = obj->data.Map;
-    RtObject **keyval = rtmap_getrefs(map, true, true);
     RtList *list = init_RtList(map->size);
-    
-    for(size_t i=0; keyval[i] != NULL;) {
+    size_t cursor = 0;
+    RtObject *key, *val;
+
+    while(rtmap_iterate(map, &cursor, &key, &val)) {
         RtList *pair = init_RtList(2);
-        rtlist_append(pair, keyval[i++]);
-        rtlist_append(pair, keyval[i++]);
+        rtlist_append(pair, key);
+        rtlist_append(pair, val);
 
         RtObject *obj = init_RtObject(LIST_TYPE);
         obj->data.List = pair;
         add_to_GC_registry(obj);
         rtlist_append(list, obj); 
     }
-        
-    free(keyval);
 
     RtObject *newlist = init_RtObject(LIST_TYPE);
     newlist->data.List = list;
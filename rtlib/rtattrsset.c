@@ -11,6 +11,7 @@ static RtObject *builtin_set_clear(RtObject *target, RtObject **args, int argcou
 static RtObject *builtin_set_tolist(RtObject *target, RtObject **args, int argcount);
 static RtObject *builtin_set_union(RtObject *target, RtObject **args, int argcount);
 static RtObject *builtin_set_intersection(RtObject *target, RtObject **args, int argcount);
+static RtObject *builtin_set_union_update(RtObject *target, RtObject **args, int argcount);
 
 
 static const AttrBuiltinKey _str_uppercase_key = {HASHSET_TYPE, "add"};
@@ -27,7 +28,7 @@ static const AttrBuiltin _set_contains =
 
 static const AttrBuiltinKey _set_clear_key = {HASHSET_TYPE, "clear"};
 static const AttrBuiltin _set_clear =
-    {HASHSET_TYPE, {.builtin_func = builtin_set_clear}, 1, "clear", true};
+    {HASHSET_TYPE, {.builtin_func = builtin_set_clear}, 0, "clear", true};
 
 static const AttrBuiltinKey _set_tolist_key = {HASHSET_TYPE, "toList"};
 static const AttrBuiltin _set_tolist =
@@ -41,6 +42,10 @@ static const AttrBuiltinKey _set_intersection_key = {HASHSET_TYPE, "intersection
 static const AttrBuiltin _set_intersection =
     {HASHSET_TYPE, {.builtin_func = builtin_set_intersection}, 1, "intersection", true};
 
+static const AttrBuiltinKey _set_union_update_key = {HASHSET_TYPE, "unionUpdate"};
+static const AttrBuiltin _set_union_update =
+    {HASHSET_TYPE, {.builtin_func = builtin_set_union_update}, 1, "unionUpdate", true};
+
 // Helper for abstracting away invalid number of arguments exception
 #define setInvalidNumberOfArgsIntermediateException(map_attr, actual_args, expected_args) \
     setIntermediateException(init_InvalidNumberOfArgumentsException( \
@@ -63,6 +68,7 @@ void init_RtSetAttr(GenericMap *registry)
     addToAttrRegistry(registry, _set_tolist_key, _set_tolist);
     addToAttrRegistry(registry, _set_union_key, _set_union);
     addToAttrRegistry(registry, _set_intersection_key, _set_intersection);
+    addToAttrRegistry(registry, _set_union_update_key, _set_union_update);
 }
 
 /**
@@ -92,7 +98,8 @@ static RtObject *builtin_set_add(RtObject *target, RtObject **args, int argcount
         return NULL;
     }
 
-    rtset_insert(set, val);
+    // the set gets its own object, the argument may be a variable (see rtobj_key_cpy)
+    rtset_insert(set, rtobj_key_cpy(val));
     return target;
 }
 
@@ -143,8 +150,8 @@ static RtObject *builtin_set_clear(RtObject *target, RtObject **args, int argcou
 {
     assert(target->type == HASHSET_TYPE);
 
-    if(argcount != 1) {
-        setInvalidNumberOfArgsIntermediateException("clear()", argcount, 1);
+    if(argcount != 0) {
+        setInvalidNumberOfArgsIntermediateException("clear()", argcount, 0);
         return NULL;
     }
 
@@ -224,4 +231,25 @@ static RtObject *builtin_set_intersection(RtObject *target, RtObject **args, int
     obj->data.Set = new_set;
     return obj;
 
-}
\ No newline at end of file
+}
+
+/**
+ * DESCRIPTION:
+ * Builtin function for performing an in place union, elements of the argument are added to the target set
+*/
+static RtObject *builtin_set_union_update(RtObject *target, RtObject **args, int argcount) {
+    assert(target->type == HASHSET_TYPE);
+
+    if(argcount != 1) {
+        setInvalidNumberOfArgsIntermediateException("unionUpdate()", argcount, 1);
+        return NULL;
+    }
+
+    if(args[0]->type != HASHSET_TYPE) {
+        setInvalidArgTypeException("unionUpdate()", "Set", args[0]);
+        return NULL;
+    }
+
+    rtset_union_update(target->data.Set, args[0]->data.Set, true, true);
+    return target;
+}
@@ -2,8 +2,11 @@
 #include <string.h>
 #include <ctype.h>
 #include "rtattrs.h"
+#include "../runtime/gc.h"
+#include "../runtime/rtlists.h"
 #include "../generics/hashmap.h"
 #include "../generics/utilities.h"
+#include "../generics/strkernels.h"
 #include "../runtime/rtexchandler.h"
 
 /**
@@ -20,6 +23,14 @@
  * isspace(): Returns wether string contains ONLY whitespace
  * isupper(): Returns wether string contains ONLY uppercase characters
  * islower(): Returns wether string contains ONLY lowercase characters
+ * split("..."): Splits the string on every occurence of a separator, returns a list of strings
+ * join([...]): Concatenates a list of strings, with the string inserted between each element
+ * replace("...", "..."): Creates new string with all occurences of a sub string replaced
+ * startsWith("..."): Returns wether string starts with a prefix
+ * endsWith("..."): Returns wether string ends with a suffix
+ * count("..."): Returns the number of non overlapping occurences of a sub string
+ *
+ * The byte level work is done by the vectorized kernels of generics/strkernels.c
  */
 
 static RtObject *builtin_str_upper(RtObject *target, RtObject **args, int arg_count);
@@ -32,6 +43,12 @@ static RtObject *builtin_str_isalph(RtObject *target, RtObject **args, int arg_c
 static RtObject *builtin_str_isspace(RtObject *target, RtObject **args, int arg_count);
 static RtObject *builtin_str_isupper(RtObject *target, RtObject **args, int arg_count);
 static RtObject *builtin_str_islower(RtObject *target, RtObject **args, int arg_count);
+static RtObject *builtin_str_split(RtObject *target, RtObject **args, int arg_count);
+static RtObject *builtin_str_join(RtObject *target, RtObject **args, int arg_count);
+static RtObject *builtin_str_replace(RtObject *target, RtObject **args, int arg_count);
+static RtObject *builtin_str_startswith(RtObject *target, RtObject **args, int arg_count);
+static RtObject *builtin_str_endswith(RtObject *target, RtObject **args, int arg_count);
+static RtObject *builtin_str_count(RtObject *target, RtObject **args, int arg_count);
 
 static const AttrBuiltinKey _str_upper_key = {STRING_TYPE, "upper"};
 static const AttrBuiltin _str_upper =
@@ -73,6 +90,30 @@ static const AttrBuiltinKey _str_islower_key = {STRING_TYPE, "islower"};
 static const AttrBuiltin _str_islower =
     {STRING_TYPE, {.builtin_func = builtin_str_islower}, 0, "islower", true};
 
+static const AttrBuiltinKey _str_split_key = {STRING_TYPE, "split"};
+static const AttrBuiltin _str_split =
+    {STRING_TYPE, {.builtin_func = builtin_str_split}, 1, "split", true};
+
+static const AttrBuiltinKey _str_join_key = {STRING_TYPE, "join"};
+static const AttrBuiltin _str_join =
+    {STRING_TYPE, {.builtin_func = builtin_str_join}, 1, "join", true};
+
+static const AttrBuiltinKey _str_replace_key = {STRING_TYPE, "replace"};
+static const AttrBuiltin _str_replace =
+    {STRING_TYPE, {.builtin_func = builtin_str_replace}, 2, "replace", true};
+
+static const AttrBuiltinKey _str_startswith_key = {STRING_TYPE, "startsWith"};
+static const AttrBuiltin _str_startswith =
+    {STRING_TYPE, {.builtin_func = builtin_str_startswith}, 1, "startsWith", true};
+
+static const AttrBuiltinKey _str_endswith_key = {STRING_TYPE, "endsWith"};
+static const AttrBuiltin _str_endswith =
+    {STRING_TYPE, {.builtin_func = builtin_str_endswith}, 1, "endsWith", true};
+
+static const AttrBuiltinKey _str_count_key = {STRING_TYPE, "count"};
+static const AttrBuiltin _str_count =
+    {STRING_TYPE, {.builtin_func = builtin_str_count}, 1, "count", true};
+
 // Helper for abstracting away invalid number of arguments exception
 #define setInvalidNumberOfArgsIntermediateException(map_attr, actual_args, expected_args) \
     setIntermediateException(init_InvalidNumberOfArgumentsException(                      \
@@ -82,32 +123,17 @@ static const AttrBuiltin _str_islower =
 #define setInvalidArgTypeException(attr_name, expected_type, argobj) \
     setIntermediateException(init_InvalidTypeException_Builtin("attribute " attr_name, expected_type, argobj))
 
-/**
- * DESCRIPTION:
- * Useful macro for applying a true/false check on a string
- * Result of that check gets stored in bool_
- */
-#define StrBoolPred(bool, str, length, predicate) \
-    for (unsigned int i = 0; i < length; i++)     \
-    {                                             \
-        if (!predicate(str[i]))                   \
-        {                                         \
-            bool = false;                         \
-            break;                                \
-        }                                         \
-    }
+// Helper for functions that search for a sub string, which cannot be empty
+#define setEmptySubStringException(attr_name) \
+    setIntermediateException(InvalidValueException("String attribute function " attr_name " cannot take an empty string"))
 
 /**
  * DESCRIPTION:
- * Useful macro for initialization a new string on some predicate function
- * Also sets the null char
+ * Useful macro for applying a character class check on a whole string
+ * Result of that check gets stored in bool_
  */
-#define NewStrApply(newstr, str, length, predicate) \
-    for (unsigned int i = 0; i < length; i++)       \
-    {                                               \
-        newstr[i] = predicate(str[i]);              \
-    }                                               \
-    newstr[len] = '\0';
+#define StrBoolPred(bool_, strobj, cls) \
+    bool_ = str_all_in_class(rtstr_data((strobj)->data.String), (strobj)->data.String->length, cls);
 
 /**
  * DESCRIPTION:
@@ -115,6 +141,8 @@ static const AttrBuiltin _str_islower =
  */
 void init_RtStrAttr(GenericMap *registry)
 {
+    init_str_kernels();
+
     addToAttrRegistry(registry, _str_upper_key, _str_upper);
     addToAttrRegistry(registry, _str_lower_key, _str_lower);
     addToAttrRegistry(registry, _str_strip_key, _str_strip);
@@ -125,6 +153,12 @@ void init_RtStrAttr(GenericMap *registry)
     addToAttrRegistry(registry, _str_isspace_key, _str_isspace);
     addToAttrRegistry(registry, _str_isupper_key, _str_isupper);
     addToAttrRegistry(registry, _str_islower_key, _str_islower);
+    addToAttrRegistry(registry, _str_split_key, _str_split);
+    addToAttrRegistry(registry, _str_join_key, _str_join);
+    addToAttrRegistry(registry, _str_replace_key, _str_replace);
+    addToAttrRegistry(registry, _str_startswith_key, _str_startswith);
+    addToAttrRegistry(registry, _str_endswith_key, _str_endswith);
+    addToAttrRegistry(registry, _str_count_key, _str_count);
 }
 
 /**
@@ -142,14 +176,12 @@ static RtObject *builtin_str_upper(RtObject *target, RtObject **args, int arg_co
     }
 
     (void)args;
-    char *str = target->data.String->string;
-    unsigned int len = target->data.String->length;
-    char *newstr = malloc(sizeof(char) * (len + 1));
-    NewStrApply(newstr, str, len, toupper);
+    const char *str = rtstr_data(target->data.String);
+    size_t len = target->data.String->length;
     RtObject *strobj = init_RtObject(STRING_TYPE);
-    strobj->data.String = init_RtString(NULL);
-    strobj->data.String->string = newstr;
-    strobj->data.String->length = len;
+    strobj->data.String = init_RtString_len(NULL, len);
+    char *newstr = strobj->data.String->chars;
+    str_to_upper(newstr, str, len);
     return strobj;
 }
 
@@ -168,20 +200,18 @@ static RtObject *builtin_str_lower(RtObject *target, RtObject **args, int arg_co
     }
 
     (void)args;
-    char *str = target->data.String->string;
-    unsigned int len = target->data.String->length;
-    char *newstr = malloc(sizeof(char) * (len + 1));
-    NewStrApply(newstr, str, len, tolower);
+    const char *str = rtstr_data(target->data.String);
+    size_t len = target->data.String->length;
     RtObject *strobj = init_RtObject(STRING_TYPE);
-    strobj->data.String = init_RtString(NULL);
-    strobj->data.String->string = newstr;
-    strobj->data.String->length = len;
+    strobj->data.String = init_RtString_len(NULL, len);
+    char *newstr = strobj->data.String->chars;
+    str_to_lower(newstr, str, len);
     return strobj;
 }
 
 /**
  * DESCRIPTION:
- * Built in function for stripping a string of its whitespace
+ * Built in function for stripping a string of its whitespace, the result is a slice of the string
  */
 static RtObject *builtin_str_strip(RtObject *target, RtObject **args, int arg_count)
 {
@@ -194,25 +224,13 @@ static RtObject *builtin_str_strip(RtObject *target, RtObject **args, int arg_co
     }
 
     (void)args;
-    char *str = target->data.String->string;
-    unsigned int len = target->data.String->length;
-
-    unsigned int start = 0;
-    unsigned int end = len - 1;
-    unsigned int i, j;
-    for (i = start; i < len; i++)
-        if (!isspace(str[i]))
-            break;
+    const char *str = rtstr_data(target->data.String);
+    size_t len = target->data.String->length;
 
-    for (j = end; j >= 0; j--)
-        if (!isspace(str[j]))
-            break;
-    start = i;
-    end = j;
+    size_t start = str_leading_space(str, len);
+    size_t end = start == len ? len : len - str_trailing_space(str + start, len - start);
 
-    RtString *stripped_str = init_RtString(NULL);
-    stripped_str->string = malloc_substring(str, start, end);
-    stripped_str->length = end - start;
+    RtString *stripped_str = rtstr_slice(target->data.String, start, end);
 
     RtObject *strobj = init_RtObject(STRING_TYPE);
     strobj->data.String = stripped_str;
@@ -236,16 +254,17 @@ static RtObject *builtin_str_find(RtObject *target, RtObject **args, int arg_cou
         return NULL;
     }
 
-    char *str1 = target->data.String->string;
-    char *str2 = args[0]->data.String->string;
+    if (args[0]->type != STRING_TYPE)
+    {
+        setInvalidArgTypeException("find()", "String", args[0]);
+        return NULL;
+    }
+
+    RtString *str = target->data.String;
+    RtString *substr = args[0]->data.String;
+    long occurence = str_find(rtstr_data(str), str->length, rtstr_data(substr), substr->length);
     RtObject *res = init_RtObject(NUMBER_TYPE);
-    char *occurence = strstr(str1, str2);
-    double index;
-    if (occurence)
-        index = (occurence - str1) / sizeof(char) + 1;
-    else
-        index = -1;
-    res->data.Number = init_RtNumber(index);
+    res->data.Number = init_RtNumber(occurence < 0 ? -1 : occurence + 1);
     return res;
 }
 
@@ -264,8 +283,8 @@ static RtObject *builtin_str_isalnum(RtObject *target, RtObject **args, int arg_
     }
 
     (void)args;
-    bool ans = true;
-    StrBoolPred(ans, target->data.String->string, target->data.String->length, isalnum);
+    bool ans;
+    StrBoolPred(ans, target, STR_CLASS_ALNUM);
     RtObject *res = init_RtObject(NUMBER_TYPE);
     res->data.Number = init_RtNumber(ans);
     return res;
@@ -286,8 +305,8 @@ static RtObject *builtin_str_isnumeric(RtObject *target, RtObject **args, int ar
     }
 
     (void)args;
-    bool ans = true;
-    StrBoolPred(ans, target->data.String->string, target->data.String->length, isdigit);
+    bool ans;
+    StrBoolPred(ans, target, STR_CLASS_DIGIT);
     RtObject *res = init_RtObject(NUMBER_TYPE);
     res->data.Number = init_RtNumber(ans);
     return res;
@@ -308,8 +327,8 @@ static RtObject *builtin_str_isalph(RtObject *target, RtObject **args, int arg_c
     }
 
     (void)args;
-    bool ans = true;
-    StrBoolPred(ans, target->data.String->string, target->data.String->length, isalpha);
+    bool ans;
+    StrBoolPred(ans, target, STR_CLASS_ALPHA);
     RtObject *res = init_RtObject(NUMBER_TYPE);
     res->data.Number = init_RtNumber(ans);
     return res;
@@ -330,8 +349,8 @@ static RtObject *builtin_str_isspace(RtObject *target, RtObject **args, int arg_
     }
 
     (void)args;
-    bool ans = true;
-    StrBoolPred(ans, target->data.String->string, target->data.String->length, isspace);
+    bool ans;
+    StrBoolPred(ans, target, STR_CLASS_SPACE);
     RtObject *res = init_RtObject(NUMBER_TYPE);
     res->data.Number = init_RtNumber(ans);
     return res;
@@ -352,8 +371,8 @@ static RtObject *builtin_str_isupper(RtObject *target, RtObject **args, int arg_
     }
 
     (void)args;
-    bool ans = true;
-    StrBoolPred(ans, target->data.String->string, target->data.String->length, isupper);
+    bool ans;
+    StrBoolPred(ans, target, STR_CLASS_UPPER);
     RtObject *res = init_RtObject(NUMBER_TYPE);
     res->data.Number = init_RtNumber(ans);
     return res;
@@ -374,9 +393,280 @@ static RtObject *builtin_str_islower(RtObject *target, RtObject **args, int arg_
     }
 
     (void)args;
-    bool ans = true;
-    StrBoolPred(ans, target->data.String->string, target->data.String->length, islower);
+    bool ans;
+    StrBoolPred(ans, target, STR_CLASS_LOWER);
+    RtObject *res = init_RtObject(NUMBER_TYPE);
+    res->data.Number = init_RtNumber(ans);
+    return res;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for splitting a string on every occurence of a separator
+ * The number of pieces is counted beforehand, so that the list is allocated once at its final size
+ * Long pieces are slices of the string (see rtstr_slice)
+ */
+static RtObject *builtin_str_split(RtObject *target, RtObject **args, int arg_count)
+{
+    assert(target->type == STRING_TYPE);
+
+    if (arg_count != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("split()", arg_count, 1);
+        return NULL;
+    }
+
+    if (args[0]->type != STRING_TYPE)
+    {
+        setInvalidArgTypeException("split()", "String", args[0]);
+        return NULL;
+    }
+
+    size_t seplen = args[0]->data.String->length;
+    if (seplen == 0)
+    {
+        setEmptySubStringException("split()");
+        return NULL;
+    }
+
+    const char *str = rtstr_data(target->data.String);
+    const char *sep = rtstr_data(args[0]->data.String);
+    size_t len = target->data.String->length;
+
+    RtList *list = init_RtList(str_count(str, len, sep, seplen) + 1);
+    size_t start = 0;
+    while (true)
+    {
+        long found = str_find(str + start, len - start, sep, seplen);
+        size_t end = found < 0 ? len : start + (size_t)found;
+
+        RtObject *piece = init_RtObject(STRING_TYPE);
+        piece->data.String = rtstr_slice(target->data.String, start, end);
+        add_to_GC_registry(piece);
+        rtlist_append(list, piece);
+
+        if (found < 0)
+            break;
+        start = end + seplen;
+    }
+
+    RtObject *res = init_RtObject(LIST_TYPE);
+    res->data.List = list;
+    return res;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for concatenating a list of strings, separated by the target string
+ * The total length is computed first, so the result is built with a single allocation
+ */
+static RtObject *builtin_str_join(RtObject *target, RtObject **args, int arg_count)
+{
+    assert(target->type == STRING_TYPE);
+
+    if (arg_count != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("join()", arg_count, 1);
+        return NULL;
+    }
+
+    if (args[0]->type != LIST_TYPE)
+    {
+        setInvalidArgTypeException("join()", "List", args[0]);
+        return NULL;
+    }
+
+    RtList *list = args[0]->data.List;
+    size_t seplen = target->data.String->length;
+    size_t total = list->length > 0 ? seplen * (list->length - 1) : 0;
+    // a list of strings stores the string payloads directly, a list of numbers cannot be joined
+    if (list->strategy == RTLIST_NUMBERS && list->length > 0)
+    {
+        RtObject *number = rtlist_get(list, 0);
+        setInvalidArgTypeException("join()", "List of Strings", number);
+        rtobj_free(number, false, true);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < list->length && list->strategy == RTLIST_OBJECTS; i++)
+    {
+        if (list->objs[i]->type != STRING_TYPE)
+        {
+            setInvalidArgTypeException("join()", "List of Strings", list->objs[i]);
+            return NULL;
+        }
+    }
+
+    for (size_t i = 0; i < list->length; i++)
+    {
+        total += list->strategy == RTLIST_STRINGS ? list->strings[i]->length : list->objs[i]->data.String->length;
+    }
+
+    const char *sep = rtstr_data(target->data.String);
+    RtString *joined = init_RtString_len(NULL, total);
+    char *out = joined->chars;
+    for (size_t i = 0; i < list->length; i++)
+    {
+        if (i > 0)
+        {
+            memcpy(out, sep, seplen);
+            out += seplen;
+        }
+        RtString *elem = list->strategy == RTLIST_STRINGS ? list->strings[i] : list->objs[i]->data.String;
+        memcpy(out, rtstr_data(elem), elem->length);
+        out += elem->length;
+    }
+
+    RtObject *res = init_RtObject(STRING_TYPE);
+    res->data.String = joined;
+    return res;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for replacing all non overlapping occurences of a sub string
+ * The occurences are counted first, so the new string is allocated once at its final length
+ */
+static RtObject *builtin_str_replace(RtObject *target, RtObject **args, int arg_count)
+{
+    assert(target->type == STRING_TYPE);
+
+    if (arg_count != 2)
+    {
+        setInvalidNumberOfArgsIntermediateException("replace()", arg_count, 2);
+        return NULL;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (args[i]->type != STRING_TYPE)
+        {
+            setInvalidArgTypeException("replace()", "String", args[i]);
+            return NULL;
+        }
+    }
+
+    size_t oldlen = args[0]->data.String->length;
+    if (oldlen == 0)
+    {
+        setEmptySubStringException("replace()");
+        return NULL;
+    }
+
+    const char *str = rtstr_data(target->data.String);
+    const char *old = rtstr_data(args[0]->data.String);
+    const char *new = rtstr_data(args[1]->data.String);
+    size_t len = target->data.String->length;
+    size_t newlen = args[1]->data.String->length;
+
+    size_t occurences = str_count(str, len, old, oldlen);
+    RtString *replaced = init_RtString_len(NULL, len - occurences * oldlen + occurences * newlen);
+    char *out = replaced->chars;
+    size_t start = 0;
+    for (size_t i = 0; i < occurences; i++)
+    {
+        size_t found = (size_t)str_find(str + start, len - start, old, oldlen);
+        memcpy(out, str + start, found);
+        out += found;
+        memcpy(out, new, newlen);
+        out += newlen;
+        start += found + oldlen;
+    }
+    memcpy(out, str + start, len - start);
+
+    RtObject *res = init_RtObject(STRING_TYPE);
+    res->data.String = replaced;
+    return res;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for checking if a string starts with a prefix
+ */
+static RtObject *builtin_str_startswith(RtObject *target, RtObject **args, int arg_count)
+{
+    assert(target->type == STRING_TYPE);
+
+    if (arg_count != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("startsWith()", arg_count, 1);
+        return NULL;
+    }
+
+    if (args[0]->type != STRING_TYPE)
+    {
+        setInvalidArgTypeException("startsWith()", "String", args[0]);
+        return NULL;
+    }
+
+    RtString *str = target->data.String;
+    RtString *prefix = args[0]->data.String;
+    bool ans = prefix->length <= str->length &&
+               memcmp(rtstr_data(str), rtstr_data(prefix), prefix->length) == 0;
     RtObject *res = init_RtObject(NUMBER_TYPE);
     res->data.Number = init_RtNumber(ans);
     return res;
 }
+
+/**
+ * DESCRIPTION:
+ * Built in function for checking if a string ends with a suffix
+ */
+static RtObject *builtin_str_endswith(RtObject *target, RtObject **args, int arg_count)
+{
+    assert(target->type == STRING_TYPE);
+
+    if (arg_count != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("endsWith()", arg_count, 1);
+        return NULL;
+    }
+
+    if (args[0]->type != STRING_TYPE)
+    {
+        setInvalidArgTypeException("endsWith()", "String", args[0]);
+        return NULL;
+    }
+
+    RtString *str = target->data.String;
+    RtString *suffix = args[0]->data.String;
+    bool ans = suffix->length <= str->length &&
+               memcmp(rtstr_data(str) + str->length - suffix->length, rtstr_data(suffix), suffix->length) == 0;
+    RtObject *res = init_RtObject(NUMBER_TYPE);
+    res->data.Number = init_RtNumber(ans);
+    return res;
+}
+
+/**
+ * DESCRIPTION:
+ * Built in function for counting the non overlapping occurences of a sub string
+ */
+static RtObject *builtin_str_count(RtObject *target, RtObject **args, int arg_count)
+{
+    assert(target->type == STRING_TYPE);
+
+    if (arg_count != 1)
+    {
+        setInvalidNumberOfArgsIntermediateException("count()", arg_count, 1);
+        return NULL;
+    }
+
+    if (args[0]->type != STRING_TYPE)
+    {
+        setInvalidArgTypeException("count()", "String", args[0]);
+        return NULL;
+    }
+
+    RtString *substr = args[0]->data.String;
+    if (substr->length == 0)
+    {
+        setEmptySubStringException("count()");
+        return NULL;
+    }
+
+    RtString *str = target->data.String;
+    size_t occurences = str_count(rtstr_data(str), str->length, rtstr_data(substr), substr->length);
+    RtObject *res = init_RtObject(NUMBER_TYPE);
+    res->data.Number = init_RtNumber(occurences);
+    return res;
+}
@@ -3,7 +3,7 @@
 NbOfTests=0
 passed=0
 failed=0
-test_files=($(ls ./tests/test*))
+test_files=($(ls ./tests/test*.tl))
 
 
 make clean
@@ -21,4 +21,141 @@ for file in "${test_files[@]}"; do
     ((NbOfTests++))
 done
 
+# GC policy flags and environment variables, each case is: expected exit code, environment, arguments
+gc_cases=(
+    "0||tests/test44.tl --gc-max-heap 2000 --script-args oom"
+    "0|TLANG_GC_MAX_HEAP=2000|tests/test44.tl --script-args oom"
+    "0|TLANG_GC_MAX_HEAP=2000|tests/test44.tl --gc-max-heap 0"
+    "0|TLANG_GC_MAX_HEAP=abc|tests/test44.tl"
+    "1||tests/test44.tl --gc-max-heap abc"
+    "1||tests/test44.tl --gc-initial-heap ''"
+    "1||tests/test44.tl --gc-growth-factor 0.5"
+)
+for gc_case in "${gc_cases[@]}"; do
+    IFS='|' read -r expected gc_env gc_args <<< "$gc_case"
+    eval "env $gc_env ./main.out $gc_args" >/dev/null 2>&1
+    if [ $? -eq $expected ]; then
+        ((passed++))
+        echo "TEST $ite main.out $gc_args ($gc_env): PASSED"
+    else
+        echo "TEST $ite main.out $gc_args ($gc_env): FAILED"
+    fi
+    ((ite++))
+    ((NbOfTests++))
+done
+
+# class attributes are printed in declaration order, whatever the hash seed of the process
+class_outputs=()
+for seed in 1 2; do
+    class_outputs+=("$(TLANG_HASH_SEED=$seed ./main.out tests/test14.tl --no-cache 2>&1 | sed 's/@0x[0-9a-f]*//g')")
+done
+if [ "${class_outputs[0]}" == "${class_outputs[1]}" ]; then
+    ((passed++))
+    echo "TEST $ite main.out tests/test14.tl (TLANG_HASH_SEED=1, 2): PASSED"
+else
+    echo "TEST $ite main.out tests/test14.tl (TLANG_HASH_SEED=1, 2): FAILED"
+fi
+((ite++))
+((NbOfTests++))
+
+# heap snapshots, written by heap_snapshot(path) then on SIGUSR1, --analyze-heap must report the list 'big' as the top retainer
+snapshot_prefix=/tmp/tlang_test_heap_$$
+./main.out tests/test45.tl --script-args write $snapshot_prefix.json >/dev/null 2>&1
+TLANG_HEAP_SNAPSHOT_PREFIX=$snapshot_prefix ./main.out tests/test45.tl --script-args signal >/dev/null 2>&1 &
+snapshot_pid=$!
+sleep 0.5
+kill -USR1 $snapshot_pid
+wait $snapshot_pid
+for snapshot in $snapshot_prefix.json $snapshot_prefix-$snapshot_pid-0.json; do
+    ./main.out --analyze-heap $snapshot 2>/dev/null | grep -A2 "Top retainers:" | tail -n 1 | grep -q "'big'"
+    if [ $? -eq 0 ]; then
+        ((passed++))
+        echo "TEST $ite main.out --analyze-heap $snapshot: PASSED"
+    else
+        echo "TEST $ite main.out --analyze-heap $snapshot: FAILED"
+    fi
+    ((ite++))
+    ((NbOfTests++))
+done
+rm -f $snapshot_prefix*
+
+# bytecode cache (.tlc), every run must print what a fresh compile prints,
+# the cache is only read back while it matches its source, otherwise it is compiled and written again
+cache_dir=/tmp/tlang_test_cache_$$
+cache_script=$cache_dir/test47.tl
+cache_file=$cache_dir/test47.tlc
+mkdir -p $cache_dir
+cp tests/test47.tl $cache_script
+cache_expected=$(./main.out tests/test47.tl --no-cache 2>&1)
+
+# runs the cached script with the environment and arguments given, sets cache_output and cache_written (the cache was replaced)
+cache_run() {
+    local before=$(stat -c %i $cache_file 2>/dev/null)
+    cache_output=$(eval "env $1 ./main.out $cache_script $2" 2>&1)
+    local after=$(stat -c %i $cache_file 2>/dev/null)
+    [ "$before" != "$after" ] && cache_written=1 || cache_written=0
+}
+
+# $1 describes the case, $2 is the expected output, $3 is 1 if the cache must have been written by the run, 0 if it was reused or bypassed
+cache_check() {
+    if [ "$cache_output" == "$2" ] && [ $cache_written -eq $3 ]; then
+        ((passed++))
+        echo "TEST $ite bytecode cache, $1: PASSED"
+    else
+        echo "TEST $ite bytecode cache, $1: FAILED"
+    fi
+    ((ite++))
+    ((NbOfTests++))
+}
+
+cache_run "" ""
+cache_check "first run writes it" "$cache_expected" 1
+cache_run "" ""
+cache_check "second run reuses it" "$cache_expected" 0
+
+echo 'println("edited");' >> $cache_script
+cache_run "" ""
+cache_check "edited source" "$cache_expected"$'\n'"edited" 1
+cp tests/test47.tl $cache_script
+cache_run "" ""
+
+# header: magic (4 bytes), cache format version (u32), compiler version (u32)
+printf '\377' | dd of=$cache_file bs=1 seek=8 conv=notrunc 2>/dev/null
+cache_run "" ""
+cache_check "other compiler version" "$cache_expected" 1
+
+truncate -s 100 $cache_file
+cache_run "" ""
+cache_check "truncated" "$cache_expected" 1
+
+printf 'CORRUPT!' | dd of=$cache_file bs=1 seek=$(($(stat -c %s $cache_file) / 2)) conv=notrunc 2>/dev/null
+cp $cache_file $cache_dir/corrupted.tlc
+cache_run "" ""
+cache_check "corrupted" "$cache_expected" 1
+
+# bypassing the cache neither reads the corrupted cache nor replaces it
+cp $cache_dir/corrupted.tlc $cache_file
+cache_run "" "--no-cache"
+cache_check "--no-cache" "$cache_expected" 0
+cache_run "TLANG_NO_CACHE=1" ""
+cache_check "TLANG_NO_CACHE=1" "$cache_expected" 0
+cmp -s $cache_file $cache_dir/corrupted.tlc
+cache_written=$?
+cache_check "bypassed cache is left as is" "$cache_expected" 0
+rm -rf $cache_dir
+
+# native tests, linked against the interpreter
+for native_test in test_vm_threads test_embed test_vm_server; do
+    make $native_test >/dev/null
+    ./$native_test >/dev/null
+    if [ $? -eq 0 ]; then
+        ((passed++))
+        echo "TEST $ite $native_test: PASSED"
+    else
+        echo "TEST $ite $native_test: FAILED"
+    fi
+    ((ite++))
+    ((NbOfTests++))
+done
+
 echo "PASSED $passed / $NbOfTests tests"
\ No newline at end of file
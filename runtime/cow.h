@@ -0,0 +1,61 @@
+#pragma once
+#include <stdlib.h>
+#include <stdbool.h>
+
+/**
+ * Copy on write bookkeeping for container payloads (RtList, RtMap, RtSet)
+ *
+ * A copy of a container does not duplicate anything, it points to the same storage block (array or buckets)
+ * as the original and both containers point to the same share counter.
+ * The first mutating operation on a container whose storage is shared gives it a private storage block,
+ * the other containers keep the original one.
+ *
+ * A container with a NULL share counter owns its storage.
+ */
+
+// wether the storage of the container is currently shared with an other container
+#define cow_is_shared(container) ((container)->cow_shares && *(container)->cow_shares > 1)
+
+/**
+ * DESCRIPTION:
+ * Registers one more container on the storage tracked by *shares, the share counter is allocated on the first copy.
+ * Both the original container and the copy must end up pointing to the returned counter
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ */
+static inline size_t *cow_share(size_t **shares)
+{
+    if (!*shares)
+    {
+        *shares = malloc(sizeof(size_t));
+        if (!*shares)
+            return NULL;
+        **shares = 1;
+    }
+
+    (**shares)++;
+    return *shares;
+}
+
+/**
+ * DESCRIPTION:
+ * Detaches a container from its storage block, *shares is always set to NULL afterwards.
+ *
+ * Returns true if the container was the last one using the storage, i.e it now owns it and can modify or free it.
+ * Returns false if other containers still use the storage, in which case it must NOT be touched by the caller
+ */
+static inline bool cow_release(size_t **shares)
+{
+    size_t *counter = *shares;
+    *shares = NULL;
+
+    if (!counter)
+        return true;
+
+    if (--(*counter) > 0)
+        return false;
+
+    free(counter);
+    return true;
+}
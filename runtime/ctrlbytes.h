@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Control bytes of open addressing hash tables (SwissTable layout)
+ *
+ * Every slot of the table has one control byte:
+ * - CTRL_EMPTY: the slot was never used, a probe sequence stops at a group containing one
+ * - CTRL_DELETED: tombstone, the slot was used then removed, probe sequences continue past it
+ * - 0..127: the slot is full, the byte holds 7 bits of the hash of the key (H2)
+ *
+ * Slots are probed by groups of CTRL_GROUP_SIZE control bytes, which are compared all at once (with SSE2 when available).
+ * Groups are aligned, a table always has a power of 2 number of groups
+ */
+
+#define CTRL_GROUP_SIZE 16
+
+#define CTRL_EMPTY ((int8_t)-128)
+#define CTRL_DELETED ((int8_t)-2)
+
+#define ctrl_is_full(ctrl) ((ctrl) >= 0)
+
+// group index and tag of a hash, hashes must be well mixed 64 bit hashes (see rtobj_hash)
+#define ctrl_h1(hash) ((hash) >> 7)
+#define ctrl_h2(hash) ((int8_t)((hash) & 0x7f))
+
+/**
+ * DESCRIPTION:
+ * Returns a bit mask where bit i is set if ctrl[i] == tag, for the CTRL_GROUP_SIZE control bytes of a group
+ */
+static inline uint32_t ctrl_group_match(const int8_t *group, int8_t tag)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < CTRL_GROUP_SIZE; i++)
+        mask |= (uint32_t)(group[i] == tag) << i;
+    return mask;
+#endif
+}
+
+/**
+ * DESCRIPTION:
+ * Returns a bit mask of the slots of a group that are EMPTY or DELETED, i.e available for insertion
+ * Both have their high bit set, which is exactly what movemask extracts
+ */
+static inline uint32_t ctrl_group_match_free(const int8_t *group)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < CTRL_GROUP_SIZE; i++)
+        mask |= (uint32_t)(group[i] < 0) << i;
+    return mask;
+#endif
+}
+
+// Bit mask of the EMPTY slots of a group
+#define ctrl_group_match_empty(group) ctrl_group_match(group, CTRL_EMPTY)
+
+// Index of the lowest set bit of a non zero mask
+#define ctrl_mask_first(mask) ((size_t)__builtin_ctz(mask))
+
+// Sets every control byte of a table to EMPTY
+#define ctrl_reset(ctrl, capacity) memset(ctrl, (unsigned char)CTRL_EMPTY, capacity)
@@ -26,11 +26,12 @@ typedef struct FileEntry {
     bool was_occupied;
 } FileEntry;
 
-static FileEntry *table = NULL;
-static size_t table_length = DEFAULT_BUCKET_COUNT;
+// each running VM has its own table (see vm.h)
+static _Thread_local FileEntry *table = NULL;
+static _Thread_local size_t table_length = DEFAULT_BUCKET_COUNT;
 
-static size_t entry_count = 0;
-static size_t file_counter = 0;
+static _Thread_local size_t entry_count = 0;
+static _Thread_local size_t file_counter = 0;
 
 /**
  * DESCRIPTION:
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <time.h>
 #include "rtobjects.h"
 #include "runtime.h"
 #include "identtable.h"
@@ -10,29 +11,38 @@
 #include "../generics/utilities.h"
 #include "gc.h"
 #include "rttype.h"
+#include "rtexchandler.h"
 
 /**
  * This is temporary file in order to implement the large scale refactor of the GC
  */
 /**
  * This File contains the implementation of the runtime garbage collector
+ * Each thread running a runtime has its own heap (see rtparallel.c), so the state of the GC is thread local
  */
 
 /* When the number of active objects reached this amount, garbage collector performs a rotation     */
-static size_t GC_THRESHOLD = 2;
-static size_t GC_TICK_THRESHOLD = 100000;
-static size_t liveObjCount = 0;
+static _Thread_local size_t GC_THRESHOLD = 2;
+static _Thread_local size_t liveObjCount = 0;
 
-static size_t ticks_since_last_collection = 0;
+// Default pacing: first collection at 2 live objects, then every time the heap doubles or every 100000 instructions
+#define DEFAULT_GC_POLICY {             \
+    .initial_heap = 2,                  \
+    .growth_factor = 2.0,               \
+    .tick_interval = 100000,            \
+    .max_heap = 0,                      \
+    .next_threshold = GC_geometric_threshold}
 
-static bool gc_active = false;
-static GenericSet *GCregistry = NULL;
-static GenericSet *freed_ptrs_set = NULL;
+static _Thread_local GCPolicy gc_policy = DEFAULT_GC_POLICY;
 
-bool is_GC_Active() { return gc_active; }
+static _Thread_local size_t ticks_since_last_collection = 0;
+
+static _Thread_local bool gc_active = false;
+static _Thread_local GenericSet *GCregistry = NULL;
 
-// Macro for
-#define InitPtrSet(free_func) init_GenericSet(ptr_equal, hash_pointer, free_func);
+static _Thread_local GCStats gc_stats;
+
+bool is_GC_Active() { return gc_active; }
 
 /**
  * DESCRIPTION:
@@ -71,17 +81,310 @@ bool GC_Registry_has(const RtObject *obj)
     return GenericSet_has(GCregistry, obj);
 }
 
+/**
+ * DESCRIPTION:
+ * Returns a NULL terminated array of every object in the GC registry, the array must be freed by the caller
+ */
+RtObject **GC_Registry_to_list()
+{
+    RtObject **objs = (RtObject **)GenericSet_to_list(GCregistry);
+    if (!objs)
+        MallocError();
+    return objs;
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the current time in microseconds, used for timing collections
+ */
+static double now_us()
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/**
+ * DESCRIPTION:
+ * Records a new GC threshold in the stats history
+ */
+static void record_threshold(size_t threshold)
+{
+    gc_stats.threshold = threshold;
+    if (threshold > gc_stats.max_threshold)
+        gc_stats.max_threshold = threshold;
+
+    gc_stats.threshold_history[gc_stats.threshold_history_len % GC_THRESHOLD_HISTORY_LEN] = threshold;
+    gc_stats.threshold_history_len++;
+}
+
+/**
+ * DESCRIPTION:
+ * Records the pause time of a single collection in the log scale histogram
+ */
+static void record_pause(double pause_us)
+{
+    gc_stats.last_pause_us = pause_us;
+    gc_stats.total_pause_us += pause_us;
+    if (pause_us > gc_stats.max_pause_us)
+        gc_stats.max_pause_us = pause_us;
+
+    // bucket i holds pauses in [2^(i-1), 2^i) microseconds
+    size_t bucket = 0;
+    while (bucket < GC_PAUSE_HISTOGRAM_BUCKETS - 1 && pause_us >= (double)(1UL << bucket))
+        bucket++;
+
+    gc_stats.pause_histogram[bucket]++;
+}
+
+/**
+ * DESCRIPTION:
+ * Refreshes the live object counts (per type) from the GC registry
+ */
+static void count_live_objects()
+{
+    memset(gc_stats.live_by_type, 0, sizeof(gc_stats.live_by_type));
+    gc_stats.live_objects = liveObjCount;
+
+    if (!GCregistry)
+        return;
+
+    RtObject **objs = (RtObject **)GenericSet_to_list(GCregistry);
+    if (!objs)
+        MallocError();
+
+    for (size_t i = 0; objs[i] != NULL; i++)
+        gc_stats.live_by_type[objs[i]->type]++;
+
+    free(objs);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the GC statistics gathered so far, live object counts are refreshed on every call
+ */
+const GCStats *get_GC_stats()
+{
+    count_live_objects();
+    return &gc_stats;
+}
+
+/**
+ * DESCRIPTION:
+ * Gets the i'th oldest threshold still kept in the threshold history
+ *
+ * NOTE:
+ * i must be smaller than min(stats->threshold_history_len, GC_THRESHOLD_HISTORY_LEN)
+ */
+size_t GC_threshold_history_at(const GCStats *stats, size_t i)
+{
+    size_t start = stats->threshold_history_len > GC_THRESHOLD_HISTORY_LEN
+                       ? stats->threshold_history_len - GC_THRESHOLD_HISTORY_LEN
+                       : 0;
+    return stats->threshold_history[(start + i) % GC_THRESHOLD_HISTORY_LEN];
+}
+
+/**
+ * DESCRIPTION:
+ * Prints the GC statistics as a JSON object to the given stream
+ */
+void print_GC_stats_json(FILE *out)
+{
+    const GCStats *stats = get_GC_stats();
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"collections\": %zu,\n", stats->collections);
+    fprintf(out, "  \"total_pause_us\": %.3f,\n", stats->total_pause_us);
+    fprintf(out, "  \"max_pause_us\": %.3f,\n", stats->max_pause_us);
+    fprintf(out, "  \"mean_pause_us\": %.3f,\n",
+            stats->collections ? stats->total_pause_us / stats->collections : 0.0);
+
+    fprintf(out, "  \"pause_histogram_us\": [");
+    bool first = true;
+    for (size_t i = 0; i < GC_PAUSE_HISTOGRAM_BUCKETS; i++)
+    {
+        if (!stats->pause_histogram[i])
+            continue;
+        fprintf(out, "%s{\"lt\": %lu, \"count\": %zu}", first ? "" : ", ", 1UL << i, stats->pause_histogram[i]);
+        first = false;
+    }
+    fprintf(out, "],\n");
+
+    fprintf(out, "  \"objects_scanned\": %zu,\n", stats->total_scanned);
+    fprintf(out, "  \"objects_freed\": %zu,\n", stats->total_freed);
+    fprintf(out, "  \"threshold\": %zu,\n", stats->threshold);
+    fprintf(out, "  \"max_threshold\": %zu,\n", stats->max_threshold);
+
+    fprintf(out, "  \"threshold_history\": [");
+    size_t history_len = stats->threshold_history_len < GC_THRESHOLD_HISTORY_LEN
+                             ? stats->threshold_history_len
+                             : GC_THRESHOLD_HISTORY_LEN;
+    for (size_t i = 0; i < history_len; i++)
+        fprintf(out, "%s%zu", i ? ", " : "", GC_threshold_history_at(stats, i));
+    fprintf(out, "],\n");
+
+    fprintf(out, "  \"policy\": {\"initial_heap\": %zu, \"growth_factor\": %.3f, \"tick_interval\": %zu, \"max_heap\": %zu},\n",
+            gc_policy.initial_heap, gc_policy.growth_factor, gc_policy.tick_interval, gc_policy.max_heap);
+
+    fprintf(out, "  \"live_objects\": %zu,\n", stats->live_objects);
+    fprintf(out, "  \"live_by_type\": {");
+    for (int i = 0; i < NB_OF_TYPES; i++)
+        fprintf(out, "%s\"%s\": %zu", i ? ", " : "", rtobj_type_toString((RtType)i), stats->live_by_type[i]);
+    fprintf(out, "}\n");
+
+    fprintf(out, "}\n");
+}
+
+/**
+ * DESCRIPTION:
+ * Default pacing strategy, the next collection happens once the heap has grown by the policy growth factor
+ * The threshold never goes below the initial heap size
+ */
+size_t GC_geometric_threshold(const GCPolicy *policy, size_t live_objects)
+{
+    size_t threshold = (size_t)(live_objects * policy->growth_factor);
+    return threshold > policy->initial_heap ? threshold : policy->initial_heap;
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the default GC pacing policy
+ */
+GCPolicy default_GC_policy()
+{
+    GCPolicy policy = DEFAULT_GC_POLICY;
+    return policy;
+}
+
+/**
+ * DESCRIPTION:
+ * Helpers for parsing GC policy values, returns false if the string is not a valid value
+ */
+static bool parse_policy_size(const char *str, size_t *out)
+{
+    char *end = NULL;
+    if (!str || !*str || *str == '-')
+        return false;
+
+    unsigned long long val = strtoull(str, &end, 10);
+    if (*end != '\0')
+        return false;
+
+    *out = (size_t)val;
+    return true;
+}
+
+static bool parse_policy_factor(const char *str, double *out)
+{
+    char *end = NULL;
+    if (!str || !*str)
+        return false;
+
+    double val = strtod(str, &end);
+    if (*end != '\0' || val < 1.0)
+        return false;
+
+    *out = val;
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Overrides fields of the input policy using the TLANG_GC_* environment variables.
+ * Invalid values are reported and ignored, returns false if any variable was invalid
+ */
+bool load_GC_policy_env(GCPolicy *policy)
+{
+    bool valid = true;
+    const char *val;
+
+    if ((val = getenv(GC_INITIAL_HEAP_ENV)) && !parse_policy_size(val, &policy->initial_heap))
+    {
+        fprintf(stderr, "Ignoring invalid %s value '%s'\n", GC_INITIAL_HEAP_ENV, val);
+        valid = false;
+    }
+
+    if ((val = getenv(GC_GROWTH_FACTOR_ENV)) && !parse_policy_factor(val, &policy->growth_factor))
+    {
+        fprintf(stderr, "Ignoring invalid %s value '%s' (must be >= 1)\n", GC_GROWTH_FACTOR_ENV, val);
+        valid = false;
+    }
+
+    if ((val = getenv(GC_TICK_INTERVAL_ENV)) && !parse_policy_size(val, &policy->tick_interval))
+    {
+        fprintf(stderr, "Ignoring invalid %s value '%s'\n", GC_TICK_INTERVAL_ENV, val);
+        valid = false;
+    }
+
+    if ((val = getenv(GC_MAX_HEAP_ENV)) && !parse_policy_size(val, &policy->max_heap))
+    {
+        fprintf(stderr, "Ignoring invalid %s value '%s'\n", GC_MAX_HEAP_ENV, val);
+        valid = false;
+    }
+
+    return valid;
+}
+
+/**
+ * DESCRIPTION:
+ * Sets the GC pacing policy, should be called before the GC is initialized
+ * If next_threshold is NULL, the default geometric strategy is used
+ */
+void set_GC_policy(const GCPolicy *policy)
+{
+    assert(policy);
+    gc_policy = *policy;
+    if (!gc_policy.next_threshold)
+        gc_policy.next_threshold = GC_geometric_threshold;
+}
+
+const GCPolicy *get_GC_policy()
+{
+    return &gc_policy;
+}
+
+/**
+ * DESCRIPTION:
+ * Caps the threshold so that a collection happens as soon as the heap goes over the max heap size
+ */
+static size_t cap_threshold(size_t threshold)
+{
+    if (gc_policy.max_heap && threshold > gc_policy.max_heap + 1)
+        return gc_policy.max_heap + 1;
+    return threshold;
+}
+
 /**
  * DESCRIPTION:
  * Triggers garbage collection if GC threshold as been reached
+ *
+ * NOTE:
+ * If the heap is still larger than the max heap size after the collection, an OutOfMemoryException is raised.
+ * The threshold is then left uncapped, so that the exception handler has room to run
  */
 void trigger_GC()
 {
-    if (liveObjCount >= GC_THRESHOLD || ticks_since_last_collection >= GC_TICK_THRESHOLD)
+    if (liveObjCount >= GC_THRESHOLD || ticks_since_last_collection >= gc_policy.tick_interval)
     {
         garbageCollect();
-        GC_THRESHOLD = liveObjCount * 2;
+        size_t threshold = gc_policy.next_threshold(&gc_policy, liveObjCount);
         ticks_since_last_collection = 0;
+
+        if (gc_policy.max_heap && liveObjCount > gc_policy.max_heap)
+        {
+            GC_THRESHOLD = threshold;
+            record_threshold(GC_THRESHOLD);
+
+            char buffer[150];
+            snprintf(buffer, sizeof(buffer),
+                     "Heap limit of %zu live objects exceeded (%zu live objects after collection)",
+                     gc_policy.max_heap, liveObjCount);
+            raiseException(OutOfMemoryException(buffer));
+            return;
+        }
+
+        GC_THRESHOLD = cap_threshold(threshold);
+        record_threshold(GC_THRESHOLD);
     }
     else
     {
@@ -149,6 +452,11 @@ void init_GarbageCollector()
 {
     // TODO
     gc_active = true;
+    GC_THRESHOLD = cap_threshold(gc_policy.initial_heap);
+    ticks_since_last_collection = 0;
+    memset(&gc_stats, 0, sizeof(GCStats));
+    gc_stats.threshold = GC_THRESHOLD;
+    gc_stats.max_threshold = GC_THRESHOLD;
     GCregistry = init_GenericSet(
         (bool (*)(const void *, const void *))_compare_rtdatactn,
         (unsigned int (*)(const void *))_hash_rtobjptr,
@@ -170,29 +478,11 @@ static void cleanup_GCRegistry()
     RtObject **objs = (RtObject **)GenericSet_to_list(GCregistry);
     GenericSet_free(GCregistry, false);
 
-    // lazily inits the freed pointer set
-    if (!freed_ptrs_set)
-        freed_ptrs_set = InitPtrSet(NULL);
-    
-    assert(freed_ptrs_set->size == 0);
-
-    // marks all unique pointers to free
+    // payloads are freed along with their last owner, so each wrapper can simply be freed
     for (unsigned long i = 0; objs[i] != NULL; i++)
-    {
-        void *data = rtobj_getdata(objs[i]);
-        if (GenericSet_has(freed_ptrs_set, data))
-        {
-            rtobj_shallow_free(objs[i]);
-        }
-        else
-        {
-            GenericSet_insert(freed_ptrs_set, data, false);
-            rtobj_free(objs[i], false, false);
-        }
-    }
+        rtobj_free(objs[i], false, false);
 
     free(objs);
-    GenericSet_free(freed_ptrs_set, false);
 }
 
 /**
@@ -205,7 +495,6 @@ void cleanup_GarbageCollector()
     cleanup_GCRegistry();
     liveObjCount = 0;
     GCregistry = NULL;
-    freed_ptrs_set = NULL;
 }
 
 /*DEPRECATED*/
@@ -341,44 +630,39 @@ static void traverse_reference_graph(RtObject *root)
  * This a reference count algorihtm for performing garbage collection during runtime
  * 
  * 1- Gets all active objects into an array
- * 2- Lazily intitializes freed pointer set
- * 3- For every active object
- *      3.1 - If data contained by object as already been freed then we perform a shallow free of the RtObject struct
- *      3.2 Otherwise, we add data pointer to a set of freed pointers, then frees all relevant memory
- * 4- After, we clear the entire freed pointer set for next time this function is called
+ * 2- For every active object whose payload reference count is 0, the object is removed from the registry and freed
+ * 
+ * NOTE:
+ * Several wrappers can share a payload, each of them is an owner of the payload (see RtGCHeader).
+ * Freeing a wrapper only frees the payload when its the last owner, so no double free can occur
 */
 void garbageCollect() {
+    double start = now_us();
+    size_t freed = 0;
+
     RtObject **all_active_objs = (RtObject**)GenericSet_to_list(GCregistry);
     if(!all_active_objs) {
         MallocError();
     }
 
-    // lazily inits the freed pointer set
-    if (!freed_ptrs_set)
-        freed_ptrs_set = InitPtrSet(NULL);
-    
-    for(int i=0; all_active_objs[i] != NULL; i++) {
-        assert(all_active_objs[i]);
-        RtType type = all_active_objs[i]->type;
-        void *data = rtobj_getdata(all_active_objs[i]);
-
-        // if pointer as already beed freed
-        if(GenericSet_has(freed_ptrs_set, data)) {
-            rtobj_shallow_free(all_active_objs[i]);
-            continue;
-        }
+    size_t scanned = 0;
+    for(int i=0; all_active_objs[i] != NULL; i++, scanned++) {
+        RtObject *obj = all_active_objs[i];
 
-        size_t refcount = rttype_get_refcount(data, type);
-
-        // we free obj from GC if object as already been freed 
-        if(refcount == 0) {
-            RtObject *obj = remove_from_GC_registry(all_active_objs[i], false);
-            assert(obj == all_active_objs[i]);
-            GenericSet_insert(freed_ptrs_set, data, false);
+        if(rtobj_refcount(obj) == 0) {
+            GenericSet_remove(GCregistry, obj);
+            liveObjCount--;
             rtobj_free(obj, false, true);
+            freed++;
         }
     }
 
-    GenericSet_clear(freed_ptrs_set, false);
     free(all_active_objs);
+
+    gc_stats.collections++;
+    gc_stats.last_scanned = scanned;
+    gc_stats.total_scanned += scanned;
+    gc_stats.last_freed = freed;
+    gc_stats.total_freed += freed;
+    record_pause(now_us() - start);
 }
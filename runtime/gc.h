@@ -1,12 +1,79 @@
 #pragma once
 #include "rtobjects.h"
+#include "rttype.h"
 #include <stdbool.h>
+#include <stdio.h>
+
+// Number of log2 buckets in the GC pause histogram, bucket i counts pauses shorter than 2^i microseconds
+#define GC_PAUSE_HISTOGRAM_BUCKETS 24
+
+// Number of most recent GC threshold values kept by the GC stats
+#define GC_THRESHOLD_HISTORY_LEN 32
+
+/**
+ * Telemetry gathered by the garbage collector
+ */
+typedef struct GCStats
+{
+    size_t collections;
+
+    // pause times in microseconds
+    double total_pause_us;
+    double max_pause_us;
+    double last_pause_us;
+    size_t pause_histogram[GC_PAUSE_HISTOGRAM_BUCKETS];
+
+    // objects visited / freed by collections
+    size_t total_scanned;
+    size_t total_freed;
+    size_t last_scanned;
+    size_t last_freed;
+
+    // threshold evolution, history is a circular buffer of the last GC_THRESHOLD_HISTORY_LEN thresholds
+    size_t threshold;
+    size_t max_threshold;
+    size_t threshold_history[GC_THRESHOLD_HISTORY_LEN];
+    size_t threshold_history_len;
+
+    size_t live_objects;
+    size_t live_by_type[NB_OF_TYPES];
+} GCStats;
+
+/**
+ * Pacing policy of the garbage collector
+ * next_threshold computes the number of live objects that triggers the next collection,
+ * it can be swapped out to plug in a different pacing strategy
+ */
+typedef struct GCPolicy GCPolicy;
+typedef struct GCPolicy
+{
+    size_t initial_heap;  // live objects before the first collection
+    double growth_factor; // threshold = live objects * growth factor after each collection
+    size_t tick_interval; // max number of instructions between collections
+    size_t max_heap;      // max live objects after a collection, 0 means no limit
+    size_t (*next_threshold)(const GCPolicy *policy, size_t live_objects);
+} GCPolicy;
+
+// Environment variables read by load_GC_policy_env
+#define GC_INITIAL_HEAP_ENV "TLANG_GC_INITIAL_HEAP"
+#define GC_GROWTH_FACTOR_ENV "TLANG_GC_GROWTH_FACTOR"
+#define GC_TICK_INTERVAL_ENV "TLANG_GC_TICK_INTERVAL"
+#define GC_MAX_HEAP_ENV "TLANG_GC_MAX_HEAP"
 
 bool is_GC_Active();
 RtObject *add_to_GC_registry(RtObject *obj);
 bool GC_Registry_has(const RtObject *obj);
+RtObject **GC_Registry_to_list();
 RtObject *remove_from_GC_registry(RtObject *obj, bool free_rtobj);
 void init_GarbageCollector();
 void cleanup_GarbageCollector();
 void garbageCollect();
-void trigger_GC();
\ No newline at end of file
+void trigger_GC();
+const GCStats *get_GC_stats();
+size_t GC_threshold_history_at(const GCStats *stats, size_t i);
+void print_GC_stats_json(FILE *out);
+size_t GC_geometric_threshold(const GCPolicy *policy, size_t live_objects);
+GCPolicy default_GC_policy();
+bool load_GC_policy_env(GCPolicy *policy);
+void set_GC_policy(const GCPolicy *policy);
+const GCPolicy *get_GC_policy();
@@ -0,0 +1,22 @@
+#pragma once
+#include <stddef.h>
+
+/**
+ * Header shared by every runtime payload (RtNumber, RtString, RtList, RtMap, RtSet, RtClass, RtFunction, RtException)
+ * It MUST be the first member of the payload struct, that way the GC can read it from any data pointer without knowing its type
+ *
+ * refcount: number of references (variables, containers, stack machine, closures) to wrappers of this payload
+ * owners: number of RtObject wrappers pointing to this payload, the payload is freed along with its last wrapper
+ */
+typedef struct RtGCHeader
+{
+    size_t refcount;
+    size_t owners;
+} RtGCHeader;
+
+// A freshly created payload belongs to the wrapper its assigned to
+#define init_RtGCHeader(header) \
+    (header)->refcount = 0;     \
+    (header)->owners = 1;
+
+#define rtgcheader(data) ((RtGCHeader *)(data))
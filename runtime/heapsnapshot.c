@@ -0,0 +1,227 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+#include "heapsnapshot.h"
+#include "runtime.h"
+#include "rtobjects.h"
+#include "rttype.h"
+#include "gc.h"
+#include "../generics/utilities.h"
+
+/**
+ * DESCRIPTION:
+ * This file contains the heap snapshot writer, see heapsnapshot.h for the format
+ */
+
+volatile sig_atomic_t heap_snapshot_requested = 0;
+static size_t signal_snapshot_count = 0;
+
+typedef struct SnapshotRoot
+{
+    size_t node;
+    long frame;
+    const char *name;
+} SnapshotRoot;
+
+static int compare_ptrs(const void *ptr1, const void *ptr2)
+{
+    uintptr_t p1 = (uintptr_t)(*(void *const *)ptr1);
+    uintptr_t p2 = (uintptr_t)(*(void *const *)ptr2);
+    return (p1 > p2) - (p1 < p2);
+}
+
+/**
+ * DESCRIPTION:
+ * Binary search for ptr in a sorted array of pointers, returns its index or -1 if its not found
+ */
+static long find_ptr(void **sorted, size_t length, const void *ptr)
+{
+    void **found = bsearch(&ptr, sorted, length, sizeof(void *), compare_ptrs);
+    return found ? (long)(found - sorted) : -1;
+}
+
+/**
+ * DESCRIPTION:
+ * Appends a root to a growable array of roots, objects that are not in the GC registry are ignored
+ */
+static void add_root(SnapshotRoot **roots, size_t *count, size_t *capacity,
+                     RtObject **objs, size_t obj_count, const RtObject *obj, long frame, const char *name)
+{
+    long id = find_ptr((void **)objs, obj_count, obj);
+    if (id < 0)
+        return;
+
+    if (*count == *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 64;
+        *roots = realloc(*roots, sizeof(SnapshotRoot) * (*capacity));
+        if (!*roots)
+            MallocError();
+    }
+
+    (*roots)[(*count)++] = (SnapshotRoot){(size_t)id, frame, name};
+}
+
+/**
+ * DESCRIPTION:
+ * Writes a snapshot of the object graph currently in the GC registry to out
+ *
+ * Node ids [0, objects) are wrappers, node ids [objects, objects + payloads) are payloads.
+ * Roots are the variables of every call frame, and the contents of the stack machine
+ */
+void print_heap_snapshot(FILE *out)
+{
+    RtObject **objs = GC_Registry_to_list();
+    size_t obj_count = 0;
+    while (objs[obj_count])
+        obj_count++;
+
+    qsort(objs, obj_count, sizeof(RtObject *), compare_ptrs);
+
+    // several wrappers can share a payload, each distinct payload is a single node
+    void **payloads = malloc(sizeof(void *) * (obj_count + 1));
+    if (!payloads)
+        MallocError();
+
+    for (size_t i = 0; i < obj_count; i++)
+        payloads[i] = rtobj_getdata(objs[i]);
+
+    qsort(payloads, obj_count, sizeof(void *), compare_ptrs);
+
+    size_t payload_count = 0;
+    for (size_t i = 0; i < obj_count; i++)
+    {
+        if (payload_count == 0 || payloads[payload_count - 1] != payloads[i])
+            payloads[payload_count++] = payloads[i];
+    }
+
+    // any wrapper of a payload can be used to read its type and contents
+    RtObject **payload_owner = calloc(payload_count + 1, sizeof(RtObject *));
+    if (!payload_owner)
+        MallocError();
+
+    fprintf(out, "{\"version\": %d, \"objects\": %zu, \"payloads\": %zu,\n\"nodes\": [\n",
+            HEAP_SNAPSHOT_VERSION, obj_count, payload_count);
+
+    for (size_t i = 0; i < obj_count; i++)
+    {
+        size_t payload = (size_t)find_ptr(payloads, payload_count, rtobj_getdata(objs[i]));
+        if (!payload_owner[payload])
+            payload_owner[payload] = objs[i];
+
+        fprintf(out, "{\"id\": %zu, \"kind\": \"object\", \"type\": \"%s\", \"size\": %zu, \"edges\": [%zu]},\n",
+                i, rtobj_type_toString(objs[i]->type), sizeof(RtObject), obj_count + payload);
+    }
+
+    for (size_t i = 0; i < payload_count; i++)
+    {
+        RtObject *owner = payload_owner[i];
+        fprintf(out, "{\"id\": %zu, \"kind\": \"payload\", \"type\": \"%s\", \"size\": %zu, \"edges\": [",
+                obj_count + i, rtobj_type_toString(owner->type), rtobj_payload_memsize(owner));
+
+        RtObject **refs = rtobj_getrefs(owner);
+        bool first = true;
+        for (size_t j = 0; refs[j] != NULL; j++)
+        {
+            long id = find_ptr((void **)objs, obj_count, refs[j]);
+            if (id < 0)
+                continue;
+
+            fprintf(out, first ? "%ld" : ", %ld", id);
+            first = false;
+        }
+        free(refs);
+
+        fprintf(out, "]}%s\n", i + 1 == payload_count ? "" : ",");
+    }
+
+    SnapshotRoot *roots = NULL;
+    size_t root_count = 0, root_capacity = 0;
+
+    CallFrame **callstack = getCallStack();
+    for (long frame = 0; frame <= getCallStackPointer(); frame++)
+    {
+        Identifier **vars = IdentifierTable_to_IdentList(callstack[frame]->lookup);
+        for (size_t i = 0; vars[i] != NULL; i++)
+            add_root(&roots, &root_count, &root_capacity, objs, obj_count, vars[i]->obj, frame, vars[i]->key);
+
+        free(vars);
+    }
+
+    StackMachine *stk_machine = getCurrentStkMachineInstance();
+    for (StkMachineNode *node = stk_machine ? stk_machine->head : NULL; node; node = node->next)
+        add_root(&roots, &root_count, &root_capacity, objs, obj_count, node->obj, getCallStackPointer(), "<stack>");
+
+    fprintf(out, "],\n\"roots\": [\n");
+    for (size_t i = 0; i < root_count; i++)
+    {
+        fprintf(out, "{\"node\": %zu, \"frame\": %ld, \"name\": \"%s\"}%s\n",
+                roots[i].node, roots[i].frame, roots[i].name, i + 1 == root_count ? "" : ",");
+    }
+    fprintf(out, "]}\n");
+
+    free(roots);
+    free(payload_owner);
+    free(payloads);
+    free(objs);
+}
+
+/**
+ * DESCRIPTION:
+ * Writes a heap snapshot to a file, returns false if the file could not be opened
+ */
+bool write_heap_snapshot(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return false;
+
+    print_heap_snapshot(file);
+    fclose(file);
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Signal handler, writing the snapshot is not async signal safe so it is deferred to the runtime loop
+ */
+static void on_heap_snapshot_signal(int sig)
+{
+    (void)sig;
+    heap_snapshot_requested = 1;
+}
+
+/**
+ * DESCRIPTION:
+ * Makes the process write a heap snapshot every time it receives SIGUSR1 (where the platform supports it)
+ */
+void install_heap_snapshot_signal()
+{
+#ifdef SIGUSR1
+    signal(SIGUSR1, on_heap_snapshot_signal);
+#endif
+}
+
+/**
+ * DESCRIPTION:
+ * Writes the snapshot requested by a signal to <prefix>-<pid>-<n>.json, the prefix can be set with HEAP_SNAPSHOT_PREFIX_ENV
+ */
+void write_requested_heap_snapshot()
+{
+    heap_snapshot_requested = 0;
+
+    const char *prefix = getenv(HEAP_SNAPSHOT_PREFIX_ENV);
+    if (!prefix || prefix[0] == '\0')
+        prefix = DEFAULT_HEAP_SNAPSHOT_PREFIX;
+
+    char path[strlen(prefix) + 64];
+    snprintf(path, sizeof(path), "%s-%ld-%zu.json", prefix, (long)getpid(), signal_snapshot_count++);
+
+    if (write_heap_snapshot(path))
+        fprintf(stderr, "Heap snapshot written to %s\n", path);
+    else
+        fprintf(stderr, "Could not write heap snapshot to %s\n", path);
+}
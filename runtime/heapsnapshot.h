@@ -0,0 +1,34 @@
+#pragma once
+#include <stdbool.h>
+#include <stdio.h>
+#include <signal.h>
+
+/**
+ * Heap snapshots, used for investigating memory growth of a running script
+ *
+ * A snapshot is a JSON document describing the object graph of the GC registry:
+ * - nodes: every RtObject wrapper ("object") and every payload ("payload"), with its type and its size in bytes
+ *          a wrapper has a single edge to its payload, a payload has an edge to every object it contains
+ * - roots: objects referenced by variables of a call frame, or by the stack machine
+ *
+ * Each node and root is written on its own line, so the analyzer (misc/heapanalyzer.c) can read it back line by line
+ */
+
+#define HEAP_SNAPSHOT_VERSION 1
+
+// Prefix of the snapshot files written when the process receives SIGUSR1, files are named <prefix>-<pid>-<n>.json
+#define HEAP_SNAPSHOT_PREFIX_ENV "TLANG_HEAP_SNAPSHOT_PREFIX"
+#define DEFAULT_HEAP_SNAPSHOT_PREFIX "tlang-heap"
+
+bool write_heap_snapshot(const char *path);
+void print_heap_snapshot(FILE *out);
+
+extern volatile sig_atomic_t heap_snapshot_requested;
+
+void install_heap_snapshot_signal();
+void write_requested_heap_snapshot();
+
+// Checked by the runtime between instructions, the signal handler only sets the flag
+#define check_heap_snapshot_request() \
+    if (heap_snapshot_requested)      \
+        write_requested_heap_snapshot();
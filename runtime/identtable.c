@@ -69,6 +69,7 @@ IdentTable *init_IdentifierTable()
         return NULL;
     }
     table->size = 0;
+    table->next_order = 0;
     return table;
 }
 
@@ -78,17 +79,11 @@ IdentTable *init_IdentifierTable()
 void Identifier_Table_add_var(IdentTable *table, const char *key, RtObject *obj, AccessModifier access)
 {
     assert(table);
-    unsigned int index = djb2_string_hash(key) % table->bucket_count;
-    if (!table->buckets[index])
-    {
-        table->buckets[index] = init_Identifier(key, obj, access);
-    }
-    else
-    {
-        Identifier *node = init_Identifier(key, obj, access);
-        node->next = table->buckets[index];
-        table->buckets[index] = node;
-    }
+    unsigned int index = string_hash(key) % table->bucket_count;
+    Identifier *node = init_Identifier(key, obj, access);
+    node->order = table->next_order++;
+    node->next = table->buckets[index];
+    table->buckets[index] = node;
     table->size++;
 }
 
@@ -99,7 +94,7 @@ void Identifier_Table_add_var(IdentTable *table, const char *key, RtObject *obj,
 RtObject *Identifier_Table_remove_var(IdentTable *table, const char *key)
 {
     assert(table);
-    unsigned int index = djb2_string_hash(key) % table->bucket_count;
+    unsigned int index = string_hash(key) % table->bucket_count;
 
     Identifier *node = table->buckets[index];
     Identifier *prev = NULL;
@@ -136,7 +131,7 @@ RtObject *Identifier_Table_remove_var(IdentTable *table, const char *key)
  */
 RtObject *IdentifierTable_get(IdentTable *table, const char *key)
 {
-    unsigned int index = djb2_string_hash(key) % table->bucket_count;
+    unsigned int index = string_hash(key) % table->bucket_count;
     if (!table->buckets[index])
         return NULL;
 
@@ -155,7 +150,7 @@ RtObject *IdentifierTable_get(IdentTable *table, const char *key)
  */
 bool IdentifierTable_contains(IdentTable *table, const char *key)
 {
-    unsigned int index = djb2_string_hash(key) % table->bucket_count;
+    unsigned int index = string_hash(key) % table->bucket_count;
     if (!table->buckets[index])
         return false;
 
@@ -199,9 +194,19 @@ RtObject **IdentifierTable_to_list(IdentTable *table)
     return list;
 }
 
+static int compare_identifier_order(const void *a, const void *b)
+{
+    unsigned int x = (*(Identifier *const *)a)->order, y = (*(Identifier *const *)b)->order;
+    return (x > y) - (x < y);
+}
+
 /**
  * DESCRIPTION:
  * Takes all Identifier nodes in the table puts them in a NULL terminated list
+ *
+ * NOTE:
+ * Nodes are in the order they were added, bucket order depends on the per process hash seed
+ * and would change the order of class attributes from one run to the next
  */
 Identifier **IdentifierTable_to_IdentList(IdentTable *table)
 {
@@ -225,6 +230,7 @@ Identifier **IdentifierTable_to_IdentList(IdentTable *table)
     }
 
     list[table->size] = NULL;
+    qsort(list, table->size, sizeof(Identifier *), compare_identifier_order);
     return list;
 }
 
@@ -233,7 +239,7 @@ Identifier **IdentifierTable_to_IdentList(IdentTable *table)
  */
 int IdentifierTable_aggregate(IdentTable *table, const char *key)
 {
-    unsigned int index = djb2_string_hash(key) % table->bucket_count;
+    unsigned int index = string_hash(key) % table->bucket_count;
     if (!table->buckets[index])
         return 0;
 
@@ -9,6 +9,7 @@ typedef struct Identifier
     RtObject *obj;
     Identifier *next;
     AccessModifier access;
+    unsigned int order; // position of the variable in the order variables were added to the table
 } Identifier;
 
 typedef struct IdentifierTable
@@ -16,6 +17,7 @@ typedef struct IdentifierTable
     Identifier **buckets;
     int bucket_count;
     int size;
+    unsigned int next_order;
 } IdentTable;
 
 IdentTable *init_IdentifierTable();
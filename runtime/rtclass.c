@@ -27,9 +27,9 @@ RtClass *init_RtClass(char *classname) {
         free(class);
         return NULL;
     }
-    class->attrs_table->refcount++;
+    class->attrs_table->gc.refcount++;
     class->classname = classname;
-    class->refcount = 0;
+    init_RtGCHeader(&class->gc);
     return class;
 }
 
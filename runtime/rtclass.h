@@ -1,16 +1,18 @@
 #pragma once
+#include "gcheader.h"
 #include "rtmap.h"
 #include "../compiler/compiler.h"
 
 typedef struct RtMap RtMap;
 
 typedef struct RtClass {
+    RtGCHeader gc;
+
     /// @brief These 2 fields are immutable, they DO NOT get freed during runtime
     char *classname;    
     RtFunction *body;
     
     RtMap *attrs_table;
-    size_t refcount;
 } RtClass;
 
 RtClass *init_RtClass(char *classname);
@@ -17,7 +17,7 @@ RtException *init_RtException(const char *exname, const char *msg)
         MallocError();
     exception->ex_name = cpy_string(exname);
     exception->msg = cpy_string(msg);
-    exception->refcount = 0;
+    init_RtGCHeader(&exception->gc);
     return exception;
 }
 
@@ -221,6 +221,36 @@ RtException *init_IndexOutOfBoundsException(const RtObject *list, size_t index,
     return exc;
 }
 
+/**
+ * DESCRIPTION:
+ * Creates a IndexOutOfBoundsException for slices of lists and strings
+ *
+ * USECASE:
+ * Taking the slice [2:10] of a string of length 5, or a slice whose start is after its end
+ *
+ * PARAMS:
+ * target: sliced object
+ * start: start of the slice
+ * end: end of the slice (exclusive)
+ * length: length of the sliced object
+ */
+RtException *init_InvalidSliceException(const RtObject *target, long start, long end, size_t length)
+{
+    assert(target);
+
+    const char *targettype = rtobj_type_toString(target->type);
+    char *targettostr = rtobj_toString(target);
+    char buffer[200 + strlen(targettype) + strlen(targettostr)];
+
+    snprintf(buffer, sizeof(buffer),
+             "Invalid slice [%ld:%ld] of Object %s with type %s and length %zu",
+             start, end, targettostr, targettype, length);
+
+    free(targettostr);
+    RtException *exc = IndexOutOfBoundsException(buffer);
+    return exc;
+}
+
 /**
  * DESCRIPTION:
  * Creates a KeyErrorException
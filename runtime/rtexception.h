@@ -1,4 +1,5 @@
 #pragma once
+#include "gcheader.h"
 #include "rtobjects.h"
 #include <stdlib.h>
 #include <stdbool.h>
@@ -7,9 +8,9 @@
 
 typedef struct RtException
 {
+    RtGCHeader gc;
     char *ex_name;
     char *msg;
-    size_t refcount;
 } RtException;
 
 #define rtexception_free(exc) \
@@ -41,6 +42,8 @@ RtException *init_InvalidIndexTypeException(
 
 RtException *init_IndexOutOfBoundsException(const RtObject *list, size_t index, size_t length);
 
+RtException *init_InvalidSliceException(const RtObject *target, long start, long end, size_t length);
+
 RtException *init_KeyErrorException(const RtObject *target, const RtObject *key);
 
 RtException *init_InvalidTypeException_BinaryOp(
@@ -107,3 +110,6 @@ RtException *init_InvalidFileIDException_Builtin(const char* builtin_name, size_
 
 #define InvalidFileIDString "InvalidFileIDException"
 #define InvalidFileIDException(msg) init_RtException(InvalidFileIDString, msg)
+
+#define OutOfMemoryExceptionString "OutOfMemoryException"
+#define OutOfMemoryException(msg) init_RtException(OutOfMemoryExceptionString, msg)
@@ -1,10 +1,10 @@
 #include <stdlib.h>
 #include <assert.h>
-#include "../main.h"
 #include "runtime.h"
 #include "../generics/utilities.h"
 #include "rtexception.h"
 #include "rtexchandler.h"
+#include "vm.h"
 
 /**
  * This variable stores the currently raised exception
@@ -13,16 +13,16 @@
  * NOTE:
  * This variable should NEVER be contained within the GC, its always independant
 */
-RtException *raisedException = NULL;
+_Thread_local RtException *raisedException = NULL;
 
 /**
  * This variable is responsible for storing intermediate exceptions created during runtime operations
  * When an exception is raised, this variable gets reset
 */
-RtException *Intermediate_raisedException = NULL;
+_Thread_local RtException *Intermediate_raisedException = NULL;
 
-static RtExceptionHandler *head = NULL;
-static RtExceptionHandler *tail = NULL;
+static _Thread_local RtExceptionHandler *head = NULL;
+static _Thread_local RtExceptionHandler *tail = NULL;
 
 #define HasExceptionHandler() head == NULL &&tail == NULL
 
@@ -59,7 +59,9 @@ void free_exception_handlers()
     while (ptr)
     {
         RtExceptionHandler *tmp = ptr->next;
-        free_exception_handler(ptr)
+        // boundaries belong to rt_call
+        if (!ptr->boundary)
+            free_exception_handler(ptr)
         ptr = tmp;
     }
     head = NULL;
@@ -68,33 +70,58 @@ void free_exception_handlers()
 
 /**
  * DESCRIPTION:
- * Pushes an exception handler on the link list
+ * Links an exception handler at the end of the link list
  */
-RtExceptionHandler *push_exception_handler(size_t stack_ptr, size_t start_of_try_catch, size_t stk_machine_ptr)
+static RtExceptionHandler *link_exception_handler(RtExceptionHandler *handler)
 {
+    handler->next = NULL;
+    handler->prev = tail;
+
     if (!head)
-    {
-        head = initExceptionHandler();
-        head->prev = NULL;
-        head->next = NULL;
-        head->stack_ptr = stack_ptr;
-        head->start_of_try_catch = start_of_try_catch;
-        head->stk_machine_ptr = stk_machine_ptr;
-        tail = head;
-    }
+        head = handler;
     else
-    {
-        tail->next = initExceptionHandler();
-        tail->next->stack_ptr = stack_ptr;
-        tail->next->start_of_try_catch = start_of_try_catch;
-        tail->next->stk_machine_ptr = stk_machine_ptr;
-        tail->next->prev = tail;
-        tail->next->next = NULL;
-        tail = tail->next;
-    }
+        tail->next = handler;
+
+    tail = handler;
     return tail;
 }
 
+/**
+ * DESCRIPTION:
+ * Pushes an exception handler on the link list
+ */
+RtExceptionHandler *push_exception_handler(size_t stack_ptr, size_t start_of_try_catch, size_t stk_machine_ptr)
+{
+    RtExceptionHandler *handler = initExceptionHandler();
+    if (!handler)
+        MallocError();
+
+    handler->stack_ptr = stack_ptr;
+    handler->start_of_try_catch = start_of_try_catch;
+    handler->stk_machine_ptr = stk_machine_ptr;
+    handler->boundary = NULL;
+    return link_exception_handler(handler);
+}
+
+/**
+ * DESCRIPTION:
+ * Pushes the handler of a function called from native code (see rt_call),
+ * exceptions that are not caught by the function are turned into intermediate exceptions, and the handler long jumps to boundary
+ *
+ * PARAMS:
+ * handler: handler owned by the caller (no allocation is made), it must be popped by the caller when the function returns
+ * stack_ptr: call frame calling the function
+ * stk_machine_ptr: size of the stack machine before the call
+ */
+RtExceptionHandler *push_exception_boundary(RtExceptionHandler *handler, size_t stack_ptr, size_t stk_machine_ptr, jmp_buf *boundary)
+{
+    handler->stack_ptr = stack_ptr;
+    handler->start_of_try_catch = 0;
+    handler->stk_machine_ptr = stk_machine_ptr;
+    handler->boundary = boundary;
+    return link_exception_handler(handler);
+}
+
 /**
  * DESCRIPTION:
  * Pops an exception from stack
@@ -111,6 +138,38 @@ RtExceptionHandler *pop_exception_handler()
     return popped;
 }
 
+/**
+ * DESCRIPTION:
+ * Frees the exception handlers pushed by call frames above stack_ptr,
+ * they are left behind when a function returns from within a try block
+ */
+void pop_exception_handlers_above(size_t stack_ptr)
+{
+    while (tail && !tail->boundary && tail->stack_ptr > stack_ptr)
+    {
+        free_exception_handler(pop_exception_handler());
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Pops all call frames until it gets to the one of the handler,
+ * and pops the stack machine until its in the state it was when the handler was pushed
+ */
+static void unwind_to_handler(const RtExceptionHandler *handler)
+{
+    while (getCallStackPointer() > (long)handler->stack_ptr)
+    {
+        free_CallFrame(RunTime_pop_callframe(), false);
+    }
+
+    StackMachine *stkmachine = getCurrentStkMachineInstance();
+    while (stkmachine->size > handler->stk_machine_ptr)
+    {
+        StackMachine_pop(stkmachine, true);
+    }
+}
+
 /**
  * DESCRIPTION:
  * Contains logic for properly handling exception
@@ -122,6 +181,9 @@ RtExceptionHandler *pop_exception_handler()
  * 1- Pops all call frames until it gets to the proper one
  * 2- Pops Stack Machine until its reached the state that it was when the try block was invoked
  * 3- Long jumps to the run_program() and starts running the try block
+ *
+ * Exceptions raised by functions called from native code that are not caught within the function
+ * reach the boundary of the call (see rt_call), the exception then becomes the intermediate exception of the caller
  */
 void handle_runtime_exception(RtException *exception)
 {
@@ -134,6 +196,19 @@ void handle_runtime_exception(RtException *exception)
     }
     
     assert(!Intermediate_raisedException);
+
+    if (tail && tail->boundary) {
+        RtExceptionHandler *boundary = pop_exception_handler();
+        unwind_to_handler(boundary);
+
+        // exception being resolved by a catch block of the function
+        if (raisedException && raisedException != exception)
+            rtexception_free(raisedException);
+        raisedException = NULL;
+
+        setIntermediateException(exception);
+        longjmp(*boundary->boundary, 1);
+    }
     
     // if there is not exception handler, or there is already another raised Exception
     if ((tail == NULL && head == NULL) || raisedException) {
@@ -150,7 +225,7 @@ void handle_runtime_exception(RtException *exception)
         raisedException = NULL;
         free_exception_handlers();
         
-        longjmp(global_program_interrupt, 1);
+        VM_interrupt(1);
         return;
     }
 
@@ -159,19 +234,7 @@ void handle_runtime_exception(RtException *exception)
     RtExceptionHandler *handler = pop_exception_handler();
     assert(handler);
 
-    // pops until we reach the Call Frame with the catch block
-    for (size_t i = 0; i < getCallStackPointer() - handler->stack_ptr; i++)
-    {
-        free_CallFrame(RunTime_pop_callframe(), false);
-    }
-
-    // Resets the stk machine to the original state when the try block was started 
-    StackMachine *stkmachine = getCurrentStkMachineInstance();
-
-    for (size_t i = 0; i < getCurrentStkMachineInstance()->size - handler->stk_machine_ptr; i++)
-    {
-        StackMachine_pop(stkmachine, true);
-    }
+    unwind_to_handler(handler);
 
     // sets the updated to pg counter to the long jump 
     CallFrame *currentframe = getCurrentStackFrame();
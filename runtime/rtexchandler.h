@@ -1,4 +1,5 @@
 #pragma once
+#include <setjmp.h>
 #include "rtexception.h"
 
 typedef struct RtExceptionHandler RtExceptionHandler;
@@ -9,18 +10,21 @@ typedef struct RtExceptionHandler RtExceptionHandler;
  * stack_ptr: the current call depth
  * start_of_try_block: the absolute index of the try catch chain
  * stk_machine_ptr: the current size of the stack machine when entering the try block
+ * boundary: set for the handlers of functions called from native code (see rt_call), where to long jump to, NULL otherwise
  */
 typedef struct RtExceptionHandler
 {
     size_t stack_ptr;
     size_t start_of_try_catch;
     size_t stk_machine_ptr;
+    jmp_buf *boundary;
     RtExceptionHandler *next;
     RtExceptionHandler *prev;
 } RtExceptionHandler;
 
-extern RtException *raisedException;
-extern RtException *Intermediate_raisedException;
+// exceptions are thread local, like the rest of the runtime
+extern _Thread_local RtException *raisedException;
+extern _Thread_local RtException *Intermediate_raisedException;
 
 #define free_exception_handler(handler) free(handler);
 
@@ -28,7 +32,9 @@ void _set_raised_exception(RtException *exc);
 void _set_intermediate_exception(RtException *exc);
 
 RtExceptionHandler *push_exception_handler(size_t stack_ptr, size_t start_of_try_catch, size_t stk_machine_ptr);
+RtExceptionHandler *push_exception_boundary(RtExceptionHandler *handler, size_t stack_ptr, size_t stk_machine_ptr, jmp_buf *boundary);
 RtExceptionHandler *pop_exception_handler();
+void pop_exception_handlers_above(size_t stack_ptr);
 void handle_runtime_exception(RtException *exception);
 void print_unhandledexception(RtException *exception);
 
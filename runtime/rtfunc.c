@@ -51,7 +51,7 @@ init_rtfunc(RtFuncType type)
     if (!func)
         return NULL;
     func->functype = type;
-    func->refcount = 0;
+    init_RtGCHeader(&func->gc);
     return func;
 }
 
@@ -368,7 +368,7 @@ rtfunc_getrefs(const RtFunction *func)
         return refs;
     }
 
-    if (func->functype == BUILTIN_FUNC && func->functype == EXCEPTION_CONSTRUCTOR_FUNC)
+    if (func->functype == BUILTIN_FUNC || func->functype == EXCEPTION_CONSTRUCTOR_FUNC)
     {
         RtObject **refs = malloc(sizeof(RtObject *));
         if (!refs)
@@ -1,4 +1,5 @@
 #pragma once
+#include "gcheader.h"
 #include "rtobjects.h"
 #include "../rtlib/rtattrs.h"
 
@@ -15,6 +16,8 @@ typedef enum RtFuncType
 
 typedef struct RtFunction
 {
+    RtGCHeader gc; // reference count
+
     // bool is_builtin; // flag
     RtFuncType functype;
 
@@ -59,8 +62,6 @@ typedef struct RtFunction
             char *exception_name;
         } exception_constructor;
     } func_data;
-
-    size_t refcount; // reference count
 } RtFunction;
 
 RtObject *mutate_func_data(RtObject *target, const RtObject *new_val, bool deepcpy, bool add_to_GC);
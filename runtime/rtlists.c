@@ -5,12 +5,289 @@
 #include "rtlists.h"
 #include "gc.h"
 #include "rtobjects.h"
+#include "cow.h"
+#include "rtsort.h"
 #include "../generics/utilities.h"
 
+/**
+ * DESCRIPTION:
+ * Size of an element of the array of a list, it depends on the strategy of the list
+ */
+static size_t strategy_itemsize(RtListStrategy strategy)
+{
+    switch (strategy)
+    {
+    case RTLIST_NUMBERS:
+        return sizeof(long double);
+    case RTLIST_STRINGS:
+        return sizeof(RtString *);
+    case RTLIST_OBJECTS:
+    default:
+        return sizeof(RtObject *);
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Size of an element of the array of a list
+ */
+size_t rtlist_itemsize(const RtList *list)
+{
+    return strategy_itemsize(list->strategy);
+}
+
+// address of the element at index i of an array of elements of size itemsize
+#define item_at(items, i, itemsize) ((void *)((char *)(items) + (i) * (itemsize)))
+
+// how many free slots are left in front of the first element of a list, after elements were popped from the front
+#define rtlist_head(list) ((size_t)((char *)(list)->items - (char *)(list)->block) / rtlist_itemsize(list))
+
+/**
+ * DESCRIPTION:
+ * Returns the strategy with which obj would be stored in an empty list
+ */
+static RtListStrategy strategy_of(const RtObject *obj)
+{
+    switch (obj->type)
+    {
+    case NUMBER_TYPE:
+        return RTLIST_NUMBERS;
+    case STRING_TYPE:
+        return RTLIST_STRINGS;
+    default:
+        return RTLIST_OBJECTS;
+    }
+}
+
+// wether obj can be stored in the list without changing its strategy
+#define rtlist_accepts(list, obj) ((list)->strategy == RTLIST_OBJECTS || (list)->strategy == strategy_of(obj))
+
+/**
+ * DESCRIPTION:
+ * Takes a reference on the elements from index start to end (exclusive) of an array of a list,
+ * this must be done for each element a list stores
+ */
+static void retain_items(RtListStrategy strategy, void *items, size_t start, size_t end)
+{
+    for (size_t i = start; i < end; i++)
+    {
+        if (strategy == RTLIST_OBJECTS)
+        {
+            rtobj_refcount_increment1(((RtObject **)items)[i]);
+        }
+        else if (strategy == RTLIST_STRINGS)
+        {
+            ((RtString **)items)[i]->gc.owners++;
+        }
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Drops the reference on the elements from index start to end (exclusive) of an array of a list,
+ * a string payload is freed if the list was its last owner
+ */
+static void release_items(RtListStrategy strategy, void *items, size_t start, size_t end)
+{
+    for (size_t i = start; i < end; i++)
+    {
+        if (strategy == RTLIST_OBJECTS)
+        {
+            rtobj_refcount_decrement1(((RtObject **)items)[i]);
+        }
+        else if (strategy == RTLIST_STRINGS)
+        {
+            RtString *string = ((RtString **)items)[i];
+            assert(string->gc.owners > 0);
+            if (--string->gc.owners == 0)
+                rtstr_free(string);
+        }
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Stores obj at index of a list, which must accept it (see rtlist_accepts), and takes a reference on it
+ * Unboxed lists only keep the value of obj (a number or a string payload), never obj itself
+ */
+static void rtlist_store(RtList *list, size_t index, RtObject *obj)
+{
+    switch (list->strategy)
+    {
+    case RTLIST_NUMBERS:
+        list->numbers[index] = obj->data.Number->number;
+        break;
+    case RTLIST_STRINGS:
+        list->strings[index] = obj->data.String;
+        break;
+    case RTLIST_OBJECTS:
+        list->objs[index] = obj;
+        break;
+    }
+
+    retain_items(list->strategy, list->items, index, index + 1);
+}
+
+__attribute__((warn_unused_result))
+/**
+ * DESCRIPTION:
+ * Returns the element at index of a list as an object.
+ * Elements of unboxed lists do not have a wrapper, so a new object is created for them, it is NOT added to the GC registry.
+ * Like any new object, it gets its own payload, a string payload is a slice of the whole string so the characters are not copied (see rtstr_slice)
+ */
+static RtObject *
+rtlist_box(const RtList *list, size_t index)
+{
+    RtObject *obj = NULL;
+    switch (list->strategy)
+    {
+    case RTLIST_NUMBERS:
+        obj = init_RtObject(NUMBER_TYPE);
+        obj->data.Number = init_RtNumber(list->numbers[index]);
+        if (!obj->data.Number)
+            MallocError();
+        break;
+    case RTLIST_STRINGS:
+        obj = init_RtObject(STRING_TYPE);
+        obj->data.String = rtstr_slice(list->strings[index], 0, list->strings[index]->length);
+        if (!obj->data.String)
+            MallocError();
+        break;
+    case RTLIST_OBJECTS:
+        obj = list->objs[index];
+        break;
+    }
+
+    return obj;
+}
+
+/**
+ * DESCRIPTION:
+ * Changes the strategy of an empty list, the array is resized if the elements of the new strategy have an other size
+ *
+ * NOTE:
+ * The list must own its array (see rtlist_unshare)
+ */
+static void rtlist_restrategize(RtList *list, RtListStrategy strategy)
+{
+    assert(list->length == 0 && !list->cow_shares);
+
+    // the free slots in front of the elements are not needed anymore
+    list->memsize += rtlist_head(list);
+    list->items = list->block;
+
+    if (strategy_itemsize(strategy) != rtlist_itemsize(list))
+    {
+        list->items = realloc(list->block, strategy_itemsize(strategy) * list->memsize);
+        if (!list->items)
+            MallocError();
+        list->block = list->items;
+    }
+
+    list->strategy = strategy;
+}
+
+/**
+ * DESCRIPTION:
+ * Converts an unboxed list into a list of objects, this happens when an element that does not fit the strategy of the list is inserted.
+ * Each element gets its own wrapper, which is added to the GC registry like any other object stored in a list
+ *
+ * NOTE:
+ * The list must own its array (see rtlist_unshare)
+ */
+static void rtlist_generalize(RtList *list)
+{
+    assert(rtlist_unboxed(list) && !list->cow_shares);
+
+    RtObject **objs = malloc(sizeof(RtObject *) * list->memsize);
+    if (!objs)
+        MallocError();
+
+    for (size_t i = 0; i < list->length; i++)
+    {
+        RtObject *obj;
+        if (list->strategy == RTLIST_STRINGS)
+        {
+            // the wrapper takes over the ownership of the string payload from the list
+            obj = init_RtObject(STRING_TYPE);
+            obj->data.String = list->strings[i];
+        }
+        else
+        {
+            obj = rtlist_box(list, i);
+        }
+
+        objs[i] = add_to_GC_registry(obj);
+        rtobj_refcount_increment1(objs[i]);
+    }
+
+    free(list->block);
+
+    list->block = objs;
+    list->objs = objs;
+    list->strategy = RTLIST_OBJECTS;
+}
+
+/**
+ * DESCRIPTION:
+ * Makes room for one more element at the end of a full list.
+ * If at least half of the array is free slots in front of the elements, the elements are moved back to the start of the array,
+ * otherwise the array is doubled. Either way, a list used as a queue only moves each of its elements a constant number of times
+ *
+ * NOTE:
+ * Returns false if resizing fails
+ */
+static bool rtlist_grow(RtList *list)
+{
+    size_t itemsize = rtlist_itemsize(list);
+    size_t head = rtlist_head(list);
+
+    if (head > 0 && head >= list->length)
+    {
+        memmove(list->block, list->items, itemsize * list->length);
+        list->items = list->block;
+        list->memsize += head;
+        return true;
+    }
+
+    void *block = realloc(list->block, itemsize * (head + list->memsize * 2));
+    if (!block)
+        return false;
+
+    list->block = block;
+    list->items = item_at(block, head, itemsize);
+    list->memsize *= 2;
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Halves the array of a list once its only a quarter full, the array always keeps room for one more element
+ * Free slots in front of the elements count as empty, the elements are moved to the start of the array when it is shrunk
+ */
+static void rtlist_shrink(RtList *list)
+{
+    size_t head = rtlist_head(list);
+    size_t capacity = head + list->memsize;
+    if (list->length > capacity / 4 || capacity / 2 <= DEFAULT_RTLIST_LEN)
+        return;
+
+    size_t itemsize = rtlist_itemsize(list);
+    memmove(list->block, list->items, itemsize * list->length);
+    list->items = list->block;
+    list->memsize = capacity / 2;
+
+    // if shrinking fails, the list simply keeps its larger array
+    void *block = realloc(list->block, itemsize * list->memsize);
+    if (block)
+        list->block = list->items = block;
+}
+
 __attribute__((warn_unused_result))
 /**
  * DESCRIPTION:
  * Initializes a new runtime list with a initial memory size
+ * A new list stores objects, its strategy is picked when its first element is appended (see rtlist_append)
  *
  * PARAMS:
  * initial_memsize: intial size of array block
@@ -21,6 +298,12 @@ init_RtList(unsigned long initial_memsize)
     RtList *list = malloc(sizeof(RtList));
     if (!list)
         return NULL;
+
+    // the array always has room for at least one object
+    if (initial_memsize == 0)
+        initial_memsize = 1;
+
+    list->strategy = RTLIST_OBJECTS;
     list->memsize = initial_memsize;
     list->length = 0;
     list->objs = malloc(sizeof(RtObject *) * (initial_memsize));
@@ -29,17 +312,23 @@ init_RtList(unsigned long initial_memsize)
         free(list);
         return NULL;
     }
+    list->block = list->items;
     for (unsigned long i = 0; i < initial_memsize; i++)
     {
         list->objs[i] = NULL;
     }
-    list->refcount = 0;
+    list->cow_shares = NULL;
+    list->shared_items = NULL;
+    list->shared_length = 0;
+    init_RtGCHeader(&list->gc);
     return list;
 }
 
 /**
  * DESCRIPTION:
  * Pushes a runtime objects to runtime list and returns the object
+ * An empty list takes the strategy of its first element, lists of numbers and lists of strings store their elements unboxed,
+ * they fall back to storing objects once an element of an other type is appended
  *
  * PARAMS:
  * list: list to push to
@@ -51,53 +340,120 @@ init_RtList(unsigned long initial_memsize)
 RtObject *rtlist_append(RtList *list, RtObject *obj)
 {
     assert(list && obj);
-    list->objs[list->length++] = obj;
+    rtlist_unshare(list);
+
+    if (list->length == 0)
+        rtlist_restrategize(list, strategy_of(obj));
+    else if (!rtlist_accepts(list, obj))
+        rtlist_generalize(list);
 
     // updates reference count
-    rtobj_refcount_increment1(obj);
-    
+    rtlist_store(list, list->length++, obj);
+
     // resizes array if needed
-    if (list->length == list->memsize)
-    {
-        list->objs = realloc(list->objs, sizeof(RtObject *) * list->length * 2);
-        if (!list->objs)
-            return NULL;
-        list->memsize *= 2;
-    }
+    if (list->length == list->memsize && !rtlist_grow(list))
+        return NULL;
 
     return obj;
 }
 
 /**
  * DESCRIPTION:
- * Pops a runtime objects the from list and returns the object
+ * Inserts a runtime object at the front of a list and returns the object, in amortized constant time
+ * The elements are never shifted, the list uses the free slots in front of its first element,
+ * when there is none left, the array is copied with as many free slots in front as it holds elements
  *
  * PARAMS:
  * list: list to push to
  * obj: object to add
  *
  * NOTE:
- * If list is empty function will return NULL
+ * If resizing fails, function WILL return NULL;
  */
-RtObject *rtlist_poplast(RtList *list)
+RtObject *rtlist_prepend(RtList *list, RtObject *obj)
 {
-    assert(list);
-    if(list->length == 0)
-        return NULL;
-    RtObject *obj = list->objs[--list->length];
+    assert(list && obj);
+    rtlist_unshare(list);
 
-    rtobj_refcount_decrement1(obj);
+    if (list->length == 0)
+        rtlist_restrategize(list, strategy_of(obj));
+    else if (!rtlist_accepts(list, obj))
+        rtlist_generalize(list);
 
-    // resizes array if needed
-    if (list->length == list->memsize / 2 && list->length > DEFAULT_RTLIST_LEN)
+    size_t itemsize = rtlist_itemsize(list);
+    if (list->items == list->block)
     {
-        list->objs = realloc(list->objs, sizeof(RtObject *) * list->length / 2);
-        list->memsize /= 2;
+        size_t room = list->length > DEFAULT_RTLIST_LEN ? list->length : DEFAULT_RTLIST_LEN;
+        void *block = malloc(itemsize * (room + list->memsize));
+        if (!block)
+            return NULL;
+
+        memcpy(item_at(block, room, itemsize), list->items, itemsize * list->length);
+        free(list->block);
+        list->block = block;
+        list->items = item_at(block, room, itemsize);
     }
 
+    list->items = (char *)list->items - itemsize;
+    list->memsize++;
+    list->length++;
+
+    // updates reference count
+    rtlist_store(list, 0, obj);
     return obj;
 }
 
+/**
+ * DESCRIPTION:
+ * Replaces the element at a certain index of a list and returns the new element
+ * i.e list[index] = obj
+ *
+ * PARAMS:
+ * list: list
+ * index: index, MUST be in bounds
+ * obj: new element
+ */
+RtObject *rtlist_set(RtList *list, size_t index, RtObject *obj)
+{
+    assert(list && obj && index < list->length);
+    rtlist_unshare(list);
+
+    if (!rtlist_accepts(list, obj))
+        rtlist_generalize(list);
+
+    // the old element is released after the new one is stored, since they could be the same
+    long double old;
+    memcpy(&old, item_at(list->items, index, rtlist_itemsize(list)), rtlist_itemsize(list));
+    rtlist_store(list, index, obj);
+    release_items(list->strategy, &old, 0, 1);
+
+    return obj;
+}
+
+/**
+ * DESCRIPTION:
+ * Pops the last element of a list
+ *
+ * PARAMS:
+ * list: list
+ *
+ * NOTE:
+ * If list is empty function will return false
+ */
+bool rtlist_poplast(RtList *list)
+{
+    assert(list);
+    if(list->length == 0)
+        return false;
+    rtlist_unshare(list);
+    list->length--;
+    release_items(list->strategy, list->items, list->length, list->length + 1);
+
+    // resizes array if needed
+    rtlist_shrink(list);
+    return true;
+}
+
 /**
  * DESCRIPTION:
  * Removes the first element of a list
@@ -108,7 +464,7 @@ RtObject *rtlist_poplast(RtList *list)
  * NOTE:
  * This function is basically just wrapper for the remove function
  */
-RtObject *rtlist_popfirst(RtList *list)
+bool rtlist_popfirst(RtList *list)
 {
     return rtlist_removeindex(list, 0);
 }
@@ -116,36 +472,43 @@ RtObject *rtlist_popfirst(RtList *list)
 /**
  * DESCRIPTION:
  * Removes a object from a list using its index, and makes sure the list's integrity stays intact
+ * Whichever side of the index holds the fewest elements is shifted, elements before the index move up by one
+ * and the list starts one slot further in its array, so removing the first element takes constant time
  *
  * PARAMS:
  * list: runtime list
  * index: index at which to remove from
  *
  * NOTE:
- * if index is out of bounds, function will return NULL
+ * if index is out of bounds, function will return false
  */
-RtObject *rtlist_removeindex(RtList *list, size_t index)
+bool rtlist_removeindex(RtList *list, size_t index)
 {
     assert(list);
     if (index >= list->length)
-        return NULL;
+        return false;
 
-    RtObject *obj = list->objs[index];
-    rtobj_refcount_decrement1(obj);
+    rtlist_unshare(list);
+    release_items(list->strategy, list->items, index, index + 1);
 
-    for (size_t i = index + 1; i < list->length; i++)
+    size_t itemsize = rtlist_itemsize(list);
+    if (index < list->length / 2)
     {
-        list->objs[i - 1] = list->objs[i];
+        memmove(item_at(list->items, 1, itemsize), list->items, itemsize * index);
+        list->items = item_at(list->items, 1, itemsize);
+        list->memsize--;
+    }
+    else
+    {
+        memmove(item_at(list->items, index, itemsize),
+                item_at(list->items, index + 1, itemsize),
+                itemsize * (list->length - index - 1));
     }
     list->length--;
 
     // resizes array if needed
-    if (list->length == list->memsize / 2 && list->length > DEFAULT_RTLIST_LEN)
-    {
-        list->objs = realloc(list->objs, sizeof(RtObject *) * list->length / 2);
-        list->memsize /= 2;
-    }
-    return obj;
+    rtlist_shrink(list);
+    return true;
 }
 
 /**
@@ -158,14 +521,15 @@ RtObject *rtlist_removeindex(RtList *list, size_t index)
  *
  * NOTES:
  * This function will return NULL if the index is out of bounds
+ * The elements of unboxed lists (see rtlist_unboxed) are returned as NEW objects, which are NOT in the GC registry
  */
 RtObject *rtlist_get(const RtList *list, long index)
 {
     assert(list);
-    if ((size_t)index >= list->length && (size_t)index < 0)
+    if ((size_t)index >= list->length)
         return NULL;
     else
-        return list->objs[index];
+        return rtlist_box(list, index);
 }
 
 /**
@@ -173,20 +537,40 @@ RtObject *rtlist_get(const RtList *list, long index)
  * Frees runtime list
  *
  * NOTE:
- * Does NOT free objects inside list
+ * Does NOT free objects inside list, the string payloads of a list of strings are released though
+ * If the array is shared with copies of the list (copy on write), only the list struct is freed
+ * The last list using a shared array releases all of its objects, even when its a slice only seeing some of them
  */
 void rtlist_free(RtList *list, bool free_refs, bool update_ref_counts)
 {
-    for (size_t i = 0; i < list->length; i++) {
-        
-        if(update_ref_counts)
-            rtobj_refcount_decrement1(list->objs[i]);
+    // other copies still use the array, along with the objects inside it
+    if (!cow_release(&list->cow_shares))
+    {
+        free(list);
+        return;
+    }
 
-        if(free_refs) 
-            rtobj_free(list->objs[i], false, update_ref_counts);        
+    void *items = list->shared_items ? list->shared_items : list->items;
+    size_t length = list->shared_items ? list->shared_length : list->length;
+
+    if (list->strategy == RTLIST_OBJECTS)
+    {
+        RtObject **objs = items;
+        for (size_t i = 0; i < length; i++) {
+            
+            if(update_ref_counts)
+                rtobj_refcount_decrement1(objs[i]);
+
+            if(free_refs) 
+                rtobj_free(objs[i], false, update_ref_counts);        
+        }
+    }
+    else
+    {
+        release_items(list->strategy, items, 0, length);
     }
 
-    free(list->objs);
+    free(list->block);
     free(list);
 }
 
@@ -194,6 +578,7 @@ __attribute__((warn_unused_result))
 /**
  * DESCRIPTION:
  * Copies runtime list, either a deep copy or shallow copy
+ * Unboxed elements are values, so they are simply copied either way
  *
  * PARAMS:
  * list: list to copy
@@ -207,6 +592,15 @@ rtlist_cpy(const RtList *list, bool deepcpy, bool add_to_GC)
     if (!newlist)
         return NULL;
 
+    if (rtlist_unboxed(list))
+    {
+        rtlist_restrategize(newlist, list->strategy);
+        memcpy(newlist->items, list->items, rtlist_itemsize(list) * list->length);
+        newlist->length = list->length;
+        retain_items(newlist->strategy, newlist->items, 0, newlist->length);
+        return newlist;
+    }
+
     for (size_t i = 0; i < list->length; i++)
     {
         assert(list->objs[i]);
@@ -222,6 +616,146 @@ rtlist_cpy(const RtList *list, bool deepcpy, bool add_to_GC)
     return newlist;
 }
 
+__attribute__((warn_unused_result))
+/**
+ * DESCRIPTION:
+ * Creates a copy on write shallow copy of a list, in constant time.
+ * The copy shares the array of list, no objects are copied until either of the 2 lists gets mutated (see rtlist_unshare)
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ */
+RtList *
+rtlist_cow_cpy(RtList *list)
+{
+    assert(list);
+    RtList *cpy = malloc(sizeof(RtList));
+    if (!cpy)
+        return NULL;
+
+    if (!cow_share(&list->cow_shares))
+    {
+        free(cpy);
+        return NULL;
+    }
+
+    if (!list->shared_items)
+    {
+        list->shared_items = list->items;
+        list->shared_length = list->length;
+    }
+
+    cpy->strategy = list->strategy;
+    cpy->block = list->block;
+    cpy->items = list->items;
+    cpy->length = list->length;
+    cpy->memsize = list->memsize;
+    cpy->cow_shares = list->cow_shares;
+    cpy->shared_items = list->shared_items;
+    cpy->shared_length = list->shared_length;
+    init_RtGCHeader(&cpy->gc);
+    return cpy;
+}
+
+__attribute__((warn_unused_result))
+/**
+ * DESCRIPTION:
+ * Creates a slice of a list, i.e a list of the objects from index start to end (exclusive), in constant time.
+ * Like a copy on write copy, the slice shares the array of list and objs points inside of it,
+ * it gets its own array the first time either of them is mutated (see rtlist_unshare)
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ */
+RtList *
+rtlist_slice(RtList *list, size_t start, size_t end)
+{
+    assert(list);
+    assert(start <= end && end <= list->length);
+
+    RtList *slice = rtlist_cow_cpy(list);
+    if (!slice)
+        return NULL;
+
+    slice->items = item_at(list->items, start, rtlist_itemsize(list));
+    slice->length = end - start;
+    // room for one more object, as for any list, in case the slice is unshared
+    slice->memsize = slice->length + 1;
+    return slice;
+}
+
+/**
+ * DESCRIPTION:
+ * Makes a list the owner of the shared array it was the last one using.
+ * A slice keeps its own objects, moved to the start of the array, the other objects of the array are released
+ */
+static void rtlist_own_shared_items(RtList *list)
+{
+    void *shared = list->shared_items;
+    list->shared_items = NULL;
+    if (!shared || (shared == list->items && list->length == list->shared_length))
+        return;
+
+    size_t itemsize = rtlist_itemsize(list);
+    size_t offset = ((char *)list->items - (char *)shared) / itemsize;
+    release_items(list->strategy, shared, 0, offset);
+    release_items(list->strategy, shared, offset + list->length, list->shared_length);
+
+    memmove(shared, list->items, itemsize * list->length);
+    list->items = shared;
+    // the array always had room for one more object than it held
+    list->memsize = list->shared_length + 1;
+}
+
+/**
+ * DESCRIPTION:
+ * Gives the list its own private array, this MUST be called before the list (or an element of the list) gets mutated.
+ * If the array is still shared with copies of the list, then the array is copied,
+ * each element is replaced by a new wrapper sharing the same payload, that way assigning to an index of this list does not affect the others.
+ * Unboxed elements are values, they are copied as is.
+ *
+ * NOTE:
+ * Does nothing if the list already owns its array, returns the input list
+ */
+RtList *rtlist_unshare(RtList *list)
+{
+    assert(list);
+    void *shared = list->items;
+
+    if (cow_release(&list->cow_shares))
+    {
+        rtlist_own_shared_items(list);
+        return list;
+    }
+
+    list->items = malloc(rtlist_itemsize(list) * list->memsize);
+    if (!list->items)
+    {
+        MallocError();
+        return NULL;
+    }
+    list->block = list->items;
+
+    if (rtlist_unboxed(list))
+    {
+        memcpy(list->items, shared, rtlist_itemsize(list) * list->length);
+        retain_items(list->strategy, list->items, 0, list->length);
+    }
+    else
+    {
+        RtObject **objs = shared;
+        for (size_t i = 0; i < list->length; i++)
+        {
+            RtObject *cpy = rtobj_shallow_cpy(objs[i]);
+            rtobj_refcount_increment1(cpy);
+            list->objs[i] = add_to_GC_registry(cpy);
+        }
+    }
+
+    list->shared_items = NULL;
+    return list;
+}
+
 /**
  * DESCRIPTION:
  * Helper function for multiplying a list, this function creates a new list
@@ -238,9 +772,10 @@ rtlist_cpy(const RtList *list, bool deepcpy, bool add_to_GC)
  * This function assumes that all elements in the input list are in the GC registry 
  * 
  * If list contains an other list, then that list is copied
+ * The elements of an unboxed list are values, they are copied with a single memcpy per repetition
 */
 RtList *rtlist_mult(const RtList *list, unsigned int number, bool add_to_GC) {
-    RtList *newlist = init_RtList(list->length * number);
+    RtList *newlist = init_RtList(list->length * number + 1);
     if(!newlist) {
         MallocError();
         return NULL;
@@ -248,6 +783,17 @@ RtList *rtlist_mult(const RtList *list, unsigned int number, bool add_to_GC) {
 
     if(number == 0)
         return newlist;
+
+    if(rtlist_unboxed(list)) {
+        rtlist_restrategize(newlist, list->strategy);
+        size_t itemsize = rtlist_itemsize(list);
+        for(unsigned int i = 0; i < number; i++)
+            memcpy(item_at(newlist->items, i * list->length, itemsize), list->items, itemsize * list->length);
+
+        newlist->length = list->length * number;
+        retain_items(newlist->strategy, newlist->items, 0, newlist->length);
+        return newlist;
+    }
     
     for(unsigned int i = 0; i < number; i++) {
         for(size_t j = 0 ; j < list->length; j ++) {
@@ -261,6 +807,48 @@ RtList *rtlist_mult(const RtList *list, unsigned int number, bool add_to_GC) {
     return newlist;
 }
 
+/**
+ * DESCRIPTION:
+ * Helper for rtlist_concat, appends all the elements of src at the end of list
+ * Unboxed elements are copied as is if list can store them without changing its strategy,
+ * otherwise a wrapper is created for them, and added to the GC registry
+ */
+static void rtlist_extend(RtList *list, const RtList *src, bool cpy, bool add_to_GC)
+{
+    if (rtlist_unboxed(src) && (list->length == 0 || list->strategy == src->strategy))
+    {
+        if (list->length == 0)
+            rtlist_restrategize(list, src->strategy);
+
+        size_t itemsize = rtlist_itemsize(list);
+        if (list->length + src->length >= list->memsize)
+        {
+            size_t head = rtlist_head(list);
+            list->memsize = list->length + src->length + 1;
+            list->block = realloc(list->block, itemsize * (head + list->memsize));
+            if (!list->block)
+                MallocError();
+            list->items = item_at(list->block, head, itemsize);
+        }
+
+        memcpy(item_at(list->items, list->length, itemsize), src->items, itemsize * src->length);
+        retain_items(list->strategy, list->items, list->length, list->length + src->length);
+        list->length += src->length;
+        return;
+    }
+
+    for (size_t i = 0; i < src->length; i++)
+    {
+        RtObject *obj;
+        if (rtlist_unboxed(src))
+            obj = add_to_GC_registry(rtlist_box(src, i));
+        else
+            obj = cpy ? rtobj_rt_preprocess(src->objs[i], false, add_to_GC) : src->objs[i];
+
+        // this function will handle updating the reference count
+        rtlist_append(list, obj);
+    }
+}
 
 /**
  * DESCRIPTION:
@@ -279,31 +867,15 @@ RtList *rtlist_mult(const RtList *list, unsigned int number, bool add_to_GC) {
 RtList *rtlist_concat(const RtList *list1, const RtList *list2, bool cpy, bool add_to_GC) {
     assert(list1 && list2);
 
-    RtList *newlist = init_RtList(list1->length + list2->length);
+    RtList *newlist = init_RtList(list1->length + list2->length + 1);
     
     if(!newlist) {
         MallocError();
         return NULL;
     }
 
-    for(size_t i=0; i < list1->length; i++) {
-        RtObject *obj = list1->objs[i];
-        if(cpy)
-            obj = rtobj_rt_preprocess(list1->objs[i], false, add_to_GC);
-
-        // this function will handle updating the reference count
-        rtlist_append(newlist, obj);
-    }
-
-    for(size_t i=0; i < list2->length; i++) {
-        RtObject *obj = list2->objs[i];
-
-        if(cpy)
-            obj = rtobj_rt_preprocess(list2->objs[i], false, add_to_GC);
-
-        // this function will handle updating the reference count
-        rtlist_append(newlist, obj);
-    }
+    rtlist_extend(newlist, list1, cpy, add_to_GC);
+    rtlist_extend(newlist, list2, cpy, add_to_GC);
     
     return newlist;
 
@@ -315,21 +887,41 @@ RtList *rtlist_concat(const RtList *list1, const RtList *list2, bool cpy, bool a
  *
  * NOTE:
  * returns NULL pointer if allocation fails. If list length is 1, then it will allocate a single word with a NULL value.
+ * Unboxed lists do not reference any object, the array only holds the NULL terminator for them
  */
 RtObject **rtlist_getrefs(const RtList *list)
 {
     assert(list);
-    RtObject **refs = malloc(sizeof(RtObject *) * (list->length + 1));
+    size_t length = rtlist_unboxed(list) ? 0 : list->length;
+    RtObject **refs = malloc(sizeof(RtObject *) * (length + 1));
     if (!refs)
         return NULL;
-    for (size_t i = 0; i < list->length; i++)
+    for (size_t i = 0; i < length; i++)
     {
         refs[i] = list->objs[i];
     }
-    refs[list->length] = NULL;
+    refs[length] = NULL;
     return refs;
 }
 
+/**
+ * DESCRIPTION:
+ * Checks if the element at index of a list is equal to obj (see rtobj_equal), no wrapper is created for unboxed elements
+ */
+static bool rtlist_item_equals(const RtList *list, size_t index, const RtObject *obj)
+{
+    switch (list->strategy)
+    {
+    case RTLIST_NUMBERS:
+        return obj->type == NUMBER_TYPE && list->numbers[index] == obj->data.Number->number;
+    case RTLIST_STRINGS:
+        return obj->type == STRING_TYPE && rtstr_equal(list->strings[index], obj->data.String);
+    case RTLIST_OBJECTS:
+    default:
+        return rtobj_equal(list->objs[index], obj);
+    }
+}
+
 /**
  * DESCRIPTION:
  * Checks if 2 lists are equal
@@ -338,12 +930,50 @@ RtObject **rtlist_getrefs(const RtList *list)
  * l1: list 1
  * l2: list 2
  * deep_compare: wether they should be compared by reference only or not
+ *
+ * NOTE:
+ * Unboxed elements are values, they are always compared by value
  */
 bool rtlist_equals(const RtList *l1, const RtList *l2, bool deep_compare)
 {
     if (l1->length != l2->length)
         return false;
 
+    // l1 is the unboxed list if only one of them is
+    if (rtlist_unboxed(l2))
+    {
+        const RtList *tmp = l1;
+        l1 = l2;
+        l2 = tmp;
+    }
+
+    if (rtlist_unboxed(l1) && l1->strategy == l2->strategy)
+    {
+        for (size_t i = 0; i < l1->length; i++)
+        {
+            if (l1->strategy == RTLIST_NUMBERS && l1->numbers[i] != l2->numbers[i])
+                return false;
+
+            if (l1->strategy == RTLIST_STRINGS && !rtstr_equal(l1->strings[i], l2->strings[i]))
+                return false;
+        }
+        return true;
+    }
+
+    if (rtlist_unboxed(l1))
+    {
+        // elements of different unboxed strategies have different types
+        if (rtlist_unboxed(l2))
+            return l1->length == 0;
+
+        for (size_t i = 0; i < l1->length; i++)
+        {
+            if (!rtlist_item_equals(l1, i, l2->objs[i]))
+                return false;
+        }
+        return true;
+    }
+
     for (size_t i = 0; i < l1->length; i++)
     {
         if (deep_compare && !rtobj_equal(l1->objs[i], l2->objs[i]))
@@ -358,6 +988,7 @@ bool rtlist_equals(const RtList *l1, const RtList *l2, bool deep_compare)
 /**
  * DESCRIPTION:
  * Useful function for checking if a object is contained within a list
+ * Unboxed lists are scanned directly, and only when obj has the type of their elements
  *
  * PARAMS:
  * list: list
@@ -367,6 +998,30 @@ bool rtlist_contains(const RtList *list, RtObject *obj)
 {
     assert(list && obj);
 
+    if (rtlist_unboxed(list) && list->strategy != strategy_of(obj))
+        return false;
+
+    if (list->strategy == RTLIST_NUMBERS)
+    {
+        long double number = obj->data.Number->number;
+        for (size_t i = 0; i < list->length; i++)
+        {
+            if (list->numbers[i] == number)
+                return true;
+        }
+        return false;
+    }
+
+    if (list->strategy == RTLIST_STRINGS)
+    {
+        for (size_t i = 0; i < list->length; i++)
+        {
+            if (rtstr_equal(list->strings[i], obj->data.String))
+                return true;
+        }
+        return false;
+    }
+
     for (size_t i = 0; i < list->length; i++)
     {
         if (rtobj_equal(list->objs[i], obj))
@@ -381,32 +1036,89 @@ bool rtlist_contains(const RtList *list, RtObject *obj)
 */
 RtList *rtlist_reverse(RtList *list) {
     assert(list);
+    rtlist_unshare(list);
+    size_t itemsize = rtlist_itemsize(list);
+    long double tmp;
     for(size_t i =0; i < (list->length/2); i++) {
-        RtObject *tmp= list->objs[i];
-        list->objs[i] = list->objs[list->length-i -1];
-        list->objs[list->length-i -1] = tmp;
+        void *first = item_at(list->items, i, itemsize);
+        void *last = item_at(list->items, list->length - i - 1, itemsize);
+        memcpy(&tmp, first, itemsize);
+        memcpy(first, last, itemsize);
+        memcpy(last, &tmp, itemsize);
+    }
+    return list;
+}
+
+/**
+ * DESCRIPTION:
+ * Sorts a list in place (in regular or reverse order), see rtsort.h
+ * Numbers and strings of unboxed lists are compared directly, the elements of other lists are compared with rtobj_compare
+ */
+RtList *rtlist_sort(RtList *list, bool reverse)
+{
+    assert(list);
+    rtlist_unshare(list);
+
+    switch (list->strategy)
+    {
+    case RTLIST_NUMBERS:
+        rtsort_numbers(list->numbers, list->length, reverse);
+        return list;
+    case RTLIST_STRINGS:
+        rtsort_strings(list->strings, list->length, reverse);
+        return list;
+    case RTLIST_OBJECTS:
+    default:
+        return rtlist_sort_by_keys(list, list->objs, reverse);
     }
+}
+
+/**
+ * DESCRIPTION:
+ * Stable sort of a list in place (in regular or reverse order), elements are ordered by their key,
+ * keys[i] is the key of the element at index i, keys are compared with rtobj_compare
+ *
+ * NOTE:
+ * keys must NOT be the array of the list, unless its a list of objects sorted by its own elements
+ */
+RtList *rtlist_sort_by_keys(RtList *list, RtObject **keys, bool reverse)
+{
+    assert(list && keys);
+    rtlist_unshare(list);
+
+    size_t itemsize = rtlist_itemsize(list);
+    size_t *order = malloc(sizeof(size_t) * list->length);
+    void *sorted = malloc(itemsize * list->length);
+    if (!order || !sorted || !rtsort_order(keys, order, list->length, reverse))
+    {
+        MallocError();
+        return NULL;
+    }
+
+    for (size_t i = 0; i < list->length; i++)
+        memcpy(item_at(sorted, i, itemsize), item_at(list->items, order[i], itemsize), itemsize);
+    memcpy(list->items, sorted, itemsize * list->length);
+
+    free(order);
+    free(sorted);
     return list;
 }
 
 /**
  * DESCRIPTION:
- * Removes first occurence of object in list, and returns the matching object.
- * If not match is found then NULL is returned
+ * Removes first occurence of object in list, returns wether a match was found and removed
  * PARAMS:
  * list: list
  * obj: obj
  */
-RtObject *rtlist_remove(RtList *list, RtObject *obj)
+bool rtlist_remove(RtList *list, RtObject *obj)
 {
     assert(list && obj);
     for (size_t i = 0; i < list->length; i++) {
-        if (rtobj_equal(list->objs[i], obj)) {
-            rtlist_removeindex(list, i);
-            return list->objs[i];
-        }
+        if (rtlist_item_equals(list, i, obj))
+            return rtlist_removeindex(list, i);
     }
-    return NULL;
+    return false;
 }
 
 /**
@@ -418,13 +1130,16 @@ void rtlist_print(const RtList *list) {
 
     printf("[");
     for (size_t i = 0; i < list->length; i++) {
-        char *obj_to_str = rtobj_toString(list->objs[i]);
-        if (list->objs[i]->type == STRING_TYPE)
+        RtObject *obj = rtlist_get(list, i);
+        char *obj_to_str = rtobj_toString(obj);
+        if (obj->type == STRING_TYPE)
             printf("\"%s\"", obj_to_str);
         else
             printf("%s", obj_to_str);
         
         free(obj_to_str);
+        if (rtlist_unboxed(list))
+            rtobj_free(obj, false, true);
         if(i + 1 == list->length) 
             break;
         
@@ -467,10 +1182,14 @@ _rtlist_toString(const RtList *list)
 
     for (size_t i = 0; i < list->length; i++)
     {
-        char *obj_to_str = rtobj_toString(list->objs[i]);
+        RtObject *obj = rtlist_get(list, i);
+        char *obj_to_str = rtobj_toString(obj);
+        bool is_string = obj->type == STRING_TYPE;
+        if (rtlist_unboxed(list))
+            rtobj_free(obj, false, true);
 
         // if its a string
-        if (list->objs[i]->type == STRING_TYPE)
+        if (is_string)
         {
             char *tmp = concat_strings("\"", obj_to_str);
             free(obj_to_str);
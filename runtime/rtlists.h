@@ -1,32 +1,75 @@
 #pragma once
+#include "gcheader.h"
 #include <stddef.h>
 #include "rtobjects.h"
+#include "rtstring.h"
 
 #define DEFAULT_RTLIST_LEN 16
 
+/**
+ * How the elements of a list are stored, lists of numbers and lists of strings store their elements unboxed
+ * (i.e without a RtObject wrapper and a payload per element), see rtlist_append.
+ * A list falls back to RTLIST_OBJECTS as soon as an element of an other type is inserted into it
+ */
+typedef enum RtListStrategy
+{
+    RTLIST_OBJECTS, // array of objects, for any type of element
+    RTLIST_NUMBERS, // array of the values of the numbers
+    RTLIST_STRINGS, // array of string payloads, the list is one of the owners of each of them
+} RtListStrategy;
+
 typedef struct RtList
 {
-    RtObject **objs;
+    RtGCHeader gc; // used by GC for ref counting
+    RtListStrategy strategy;
+
+    // start of the allocated array, elements start further in it once some were popped from the front (see rtlist_removeindex)
+    void *block;
+
+    // first element of the array, the member to use depends on the strategy of the list
+    union
+    {
+        void *items;
+        RtObject **objs;
+        long double *numbers;
+        RtString **strings;
+    };
+
     size_t length; // how many rt objects in the list
-    size_t memsize; // keep track of size of array block
-    size_t refcount; // used by GC for ref counting
+    size_t memsize; // keep track of size of array block, counted from items
+    size_t *cow_shares; // share counter of objs when its shared with copies of the list, NULL when private (see cow.h)
+
+    // while the array is shared, where it starts and how many objects it holds, objs points inside of it for slices (see rtlist_slice)
+    void *shared_items;
+    size_t shared_length;
 } RtList;
 
+// wether elements are stored without a wrapper, in which case rtlist_get creates a new object for them
+#define rtlist_unboxed(list) ((list)->strategy != RTLIST_OBJECTS)
+
 RtList *init_RtList(unsigned long initial_memsize);
 RtObject *rtlist_append(RtList *list, RtObject *obj);
-RtObject *rtlist_poplast(RtList *list);
-RtObject *rtlist_removeindex(RtList *list, size_t index);
-RtObject *rtlist_popfirst(RtList *list);
+RtObject *rtlist_prepend(RtList *list, RtObject *obj);
+RtObject *rtlist_set(RtList *list, size_t index, RtObject *obj);
+bool rtlist_poplast(RtList *list);
+bool rtlist_removeindex(RtList *list, size_t index);
+bool rtlist_popfirst(RtList *list);
 RtObject *rtlist_get(const RtList *list, long index);
 RtList *rtlist_cpy(const RtList *list, bool deepcpy, bool add_to_GC);
+RtList *rtlist_cow_cpy(RtList *list);
+RtList *rtlist_slice(RtList *list, size_t start, size_t end);
+RtList *rtlist_unshare(RtList *list);
 RtList *rtlist_mult(const RtList *list, unsigned int number, bool add_to_GC);
 RtList *rtlist_concat(const RtList *list1, const RtList *list2, bool cpy, bool add_to_GC);
+size_t rtlist_itemsize(const RtList *list);
 
 RtObject **rtlist_getrefs(const RtList *list);
-RtObject *rtlist_remove(RtList *list, RtObject *obj);
+bool rtlist_remove(RtList *list, RtObject *obj);
 
 bool rtlist_equals(const RtList *l1, const RtList *l2, bool deep_compare);
 RtList *rtlist_reverse(RtList *list);
+RtList *rtlist_sort(RtList *list, bool reverse);
+RtList *rtlist_sort_by_keys(RtList *list, RtObject **keys, bool reverse);
 bool rtlist_contains(const RtList *list, RtObject *obj);
 void rtlist_free(RtList *list, bool free_refs, bool update_ref_counts);
 void rtlist_print(const RtList *list);
@@ -5,269 +5,271 @@
 #include "rtmap.h"
 #include "gc.h"
 #include "rtobjects.h"
-#include "../generics/utilities.h"
+#include "cow.h"
+#include "ctrlbytes.h"
 
 /**
  * DESCRIPTION:
  * This file contains the implementation of the runtime maps (i.e dicts in python basically)
+ *
+ * Maps use a compact layout, like python dicts:
+ * - entries: dense array of key value pairs in insertion order, removed entries are left as holes (NULL key)
+ * - index: sparse open addressing table (SwissTable layout, see ctrlbytes.h) mapping hashes to positions in entries
+ *
+ * Iterating over the map is a linear scan of entries, and the order is deterministic.
+ * Holes are squeezed out whenever the table is rebuilt
  */
 
-#define GetIndexedHash(map, key) rtobj_hash(key) % map->bucket_size;
-
-typedef struct MapNode MapNode;
-typedef struct MapNode
+typedef struct MapEntry
 {
-    RtObject *key;
+    uint64_t hash; // hash of key, the index can be rebuilt without calling rtobj_hash again
+    RtObject *key; // NULL if the entry was removed
     RtObject *value;
-    MapNode *next;
-} MapNode;
+} MapEntry;
 
-#define DEFAUL_RTMAP_BUCKET_SIZE 16
+#define DEFAULT_RTMAP_CAPACITY 16
 
-// Determines the minimal amount of buckets for resizing to be done
+// Determines the minimal capacity for downsizing to be done
 #define DOWNSIZING_THRESHOLD 64
 
-__attribute__((warn_unused_result))
+// Max number of entries (including holes) for an index with the given capacity, i.e 7/8 of the index
+#define max_load(capacity) ((capacity) - (capacity) / 8)
+
+#define group_count(map) ((map)->capacity / CTRL_GROUP_SIZE)
+
+/**
+ * DESCRIPTION:
+ * Smallest valid capacity (power of 2, at least one group) that holds size elements without exceeding the max load
+ */
+static size_t capacity_for(size_t size)
+{
+    size_t capacity = DEFAULT_RTMAP_CAPACITY;
+    while (max_load(capacity) < size)
+        capacity *= 2;
+    return capacity;
+}
+
 /**
  * DESCRIPTION:
- * Initializes a new rtmap with a initial_bucket_size
+ * Allocates the index and the entries array of a map with the given index capacity, the map is left empty
  *
- * if the initial bucket size is smaller than the default, then the default value is used
+ * NOTE:
+ * Returns false if malloc fails
+ */
+static bool alloc_table(RtMap *map, size_t capacity)
+{
+    map->ctrl = malloc(sizeof(int8_t) * capacity);
+    map->index = malloc(sizeof(uint32_t) * capacity);
+    map->entries = malloc(sizeof(MapEntry) * max_load(capacity));
+    if (!map->ctrl || !map->index || !map->entries)
+    {
+        free(map->ctrl);
+        free(map->index);
+        free(map->entries);
+        return false;
+    }
+
+    ctrl_reset(map->ctrl, capacity);
+    map->capacity = capacity;
+    map->tombstones = 0;
+    map->entry_count = 0;
+    return true;
+}
+
+__attribute__((warn_unused_result))
+/**
+ * DESCRIPTION:
+ * Initializes a new rtmap able to hold initial_size elements before growing
  *
  * NOTE:
  * This function returns NULL, if malloc fails
  */
 RtMap *
-init_RtMap(unsigned long initial_bucket_size)
+init_RtMap(unsigned long initial_size)
 {
     RtMap *map = malloc(sizeof(RtMap));
     if (!map)
         return NULL;
-    map->bucket_size =
-        initial_bucket_size > DEFAUL_RTMAP_BUCKET_SIZE ? initial_bucket_size : DEFAUL_RTMAP_BUCKET_SIZE;
 
-    map->buckets = calloc(map->bucket_size, sizeof(MapNode *));
-    if (!map->buckets)
+    if (!alloc_table(map, capacity_for(initial_size)))
     {
         free(map);
         return NULL;
     }
+
     map->size = 0;
-    map->refcount = 0;
+    map->cow_shares = NULL;
+    init_RtGCHeader(&map->gc);
     return map;
 }
 
-__attribute__((warn_unused_result))
 /**
  * DESCRIPTION:
- * Initializes MapNode with key and val
- */
-static MapNode *
-init_MapNode(RtObject *key, RtObject *val)
-{
-    MapNode *node = malloc(sizeof(MapNode));
-    if (!node)
-    {
-        MallocError();
-        return NULL;
-    }
-    node->key = key;
-    node->value = val;
-    node->next = NULL;
-    return node;
-}
-
-/**
- * DESCRIPTION:
- * Helper for resizing the number of buckets by factor of 2 when the size of the map gets too big compared to the max buckets
+ * Finds the index slot pointing to the entry of key, returns -1 if the key is not in the map
  *
- * NOTE:
- * This function returns the modified input map, it will return NULL, if malloc fails
  * PARAMS:
- * map: map to be reisized
- * fact
+ * map: map
+ * key: key to find
+ * hash: hash of the key (rtobj_hash)
  */
-static RtMap *rtmap_resize(RtMap *map)
+static long find_slot(const RtMap *map, const RtObject *key, uint64_t hash)
 {
-    assert(map);
-    MapNode **resized = calloc(map->bucket_size * 2, sizeof(MapNode *));
-    if (!resized)
-        return NULL;
+    const size_t group_mask = group_count(map) - 1;
+    const int8_t tag = ctrl_h2(hash);
+    size_t group = ctrl_h1(hash) & group_mask;
 
-    size_t old_bucket_size = map->bucket_size;
-    map->bucket_size *= 2;
-    for (size_t i = 0; i < old_bucket_size; i++)
+    for (size_t probe = 1; probe <= group_count(map); probe++)
     {
-        if (!map->buckets[i])
-            continue;
+        const int8_t *ctrl = map->ctrl + group * CTRL_GROUP_SIZE;
 
-        MapNode *ptr = map->buckets[i];
-        while (ptr)
+        for (uint32_t match = ctrl_group_match(ctrl, tag); match; match &= match - 1)
         {
-            MapNode *tmp = ptr->next;
-            unsigned int index = GetIndexedHash(map, ptr->key);
-            if (!resized[index])
-            {
-                ptr->next = NULL;
-                resized[index] = ptr;
-            }
-            else
-            {
-                ptr->next = resized[index];
-                resized[index] = ptr;
-            }
-
-            ptr = tmp;
+            size_t slot = group * CTRL_GROUP_SIZE + ctrl_mask_first(match);
+            const MapEntry *entry = &map->entries[map->index[slot]];
+            if (entry->hash == hash && rtobj_equal(entry->key, key))
+                return (long)slot;
         }
+
+        // the key would have been inserted in this group
+        if (ctrl_group_match_empty(ctrl))
+            return -1;
+
+        // triangular probing visits every group, since the number of groups is a power of 2
+        group = (group + probe) & group_mask;
     }
 
-    free(map->buckets);
-    map->buckets = resized;
-    return map;
+    return -1;
 }
 
 /**
  * DESCRIPTION:
- * Helper for downsizing the number of buckets when the size of the map is too small compared to the number of buckets
- *
- * NOTE:
- * This function returns the original map inputted
- *
- * PARAMS:
- * map: map to be downsized
+ * Finds the first EMPTY or DELETED index slot on the probe sequence of a hash, the index must not be full
  */
-static RtMap *rtmap_downsize(RtMap *map)
+static size_t find_free_slot(const RtMap *map, uint64_t hash)
 {
-    assert(map);
-    MapNode **resized = calloc(map->bucket_size / 2, sizeof(MapNode *));
-    if (!resized)
-        return NULL;
+    const size_t group_mask = group_count(map) - 1;
+    size_t group = ctrl_h1(hash) & group_mask;
 
-    size_t old_bucket_size = map->bucket_size;
-    map->bucket_size /= 2;
-    for (size_t i = 0; i < old_bucket_size; i++)
+    for (size_t probe = 1;; probe++)
     {
-        if (!map->buckets[i])
-            continue;
+        uint32_t match = ctrl_group_match_free(map->ctrl + group * CTRL_GROUP_SIZE);
+        if (match)
+            return group * CTRL_GROUP_SIZE + ctrl_mask_first(match);
 
-        MapNode *ptr = map->buckets[i];
-        while (ptr)
-        {
-            MapNode *tmp = ptr->next;
-            unsigned int index = GetIndexedHash(map, ptr->key);
-            if (!resized[index])
-            {
-                ptr->next = NULL;
-                resized[index] = ptr;
-            }
-            else
-            {
-                ptr->next = resized[index];
-                resized[index] = ptr;
-            }
-
-            ptr = tmp;
-        }
+        group = (group + probe) & group_mask;
     }
+}
 
-    free(map->buckets);
-    map->buckets = resized;
-    return map;
+/**
+ * DESCRIPTION:
+ * Points a free index slot to the entry at position pos of the entries array
+ */
+static void index_entry(RtMap *map, uint64_t hash, size_t pos)
+{
+    size_t slot = find_free_slot(map, hash);
+    if (map->ctrl[slot] == CTRL_DELETED)
+        map->tombstones--;
+
+    map->ctrl[slot] = ctrl_h2(hash);
+    map->index[slot] = (uint32_t)pos;
 }
 
 /**
  * DESCRIPTION:
- * Frees Map node
+ * Rebuilds the map with a new index capacity, entries keep their order but holes are removed
  *
- * PARAMS:
- * node: Map Node to free
- * free_key: wether the associated key object should be freed
- * free_val: wether the associated value object should be freed
- * update_ref_counts: wether reference counts should be updated
+ * NOTE:
+ * This function returns the modified input map, it will return NULL, if malloc fails
  */
-static void free_MapNode(MapNode *node, bool free_key, bool free_val, bool free_immutable, bool update_ref_counts)
+static RtMap *rtmap_rebuild(RtMap *map, size_t capacity)
 {
-    if (!node)
-        return;
-    if (free_key)
-        rtobj_free(node->key, free_immutable, update_ref_counts);
+    assert(map && max_load(capacity) >= map->size);
+    int8_t *old_ctrl = map->ctrl;
+    uint32_t *old_index = map->index;
+    MapEntry *old_entries = map->entries;
+    size_t old_entry_count = map->entry_count;
 
-    if (free_val)
-        rtobj_free(node->value, free_immutable, update_ref_counts);
+    if (!alloc_table(map, capacity))
+    {
+        map->ctrl = old_ctrl;
+        map->index = old_index;
+        map->entries = old_entries;
+        return NULL;
+    }
 
-    free(node);
+    for (size_t i = 0; i < old_entry_count; i++)
+    {
+        if (!old_entries[i].key)
+            continue;
+
+        map->entries[map->entry_count] = old_entries[i];
+        index_entry(map, old_entries[i].hash, map->entry_count);
+        map->entry_count++;
+    }
+
+    free(old_ctrl);
+    free(old_index);
+    free(old_entries);
+    return map;
 }
 
 /**
  * DESCRIPTION:
  * Inserts a key value pair inside given map
  *
- * Buckets will be resized if:
- * size = # of buckets + # of buckets / 2
+ * New keys are appended at the end of the entries array. Once it is full, the map is rebuilt:
+ * it doubles in size if it is more than half full, otherwise holes left by removed keys are simply squeezed out
  * NOTE:
- * If a duplicate is found, then that node is replaced with our new info, no new Map Node is created.
+ * If a duplicate is found, its value is replaced in place (the key keeps its position), and the key is returned
  */
 RtObject *rtmap_insert(RtMap *map, RtObject *key, RtObject *val)
 {
     assert(map && key && val);
-    unsigned int index = GetIndexedHash(map, key);
+    rtmap_unshare(map);
+
+    uint64_t hash = rtobj_hash(key);
+    long found = find_slot(map, key, hash);
 
-    // if chain is empty
-    if (!map->buckets[index])
+    // replaces key/val pair in place
+    if (found >= 0)
     {
-        map->buckets[index] = init_MapNode(key, val);
-        map->size++;
+        MapEntry *entry = &map->entries[map->index[found]];
+        rtobj_refcount_decrement1(entry->key);
+        rtobj_refcount_decrement1(entry->value);
+
+        entry->key = key;
+        entry->value = val;
 
         rtobj_refcount_increment1(key);
         rtobj_refcount_increment1(val);
-        return val;
+        return key;
     }
 
-    MapNode *ptr = map->buckets[index];
-
-    while (ptr)
+    // trailing holes are reused by rtmap_remove, so tombstones can outnumber holes
+    if (map->entry_count == max_load(map->capacity) || map->size + map->tombstones + 1 > max_load(map->capacity))
     {
-        // replaces key/val pair in place
-        if (rtobj_equal(ptr->key, key))
-        {
-            rtobj_refcount_decrement1(ptr->key);
-            rtobj_refcount_decrement1(ptr->value);
-
-            ptr->key = key;
-            ptr->value = val;
-
-            rtobj_refcount_increment1(key);
-            rtobj_refcount_increment1(val);
-            return key;
-        }
-
-        ptr = ptr->next;
+        size_t capacity = map->size + 1 > map->capacity / 2 ? map->capacity * 2 : map->capacity;
+        if (!rtmap_rebuild(map, capacity))
+            MallocError();
     }
 
-    MapNode *node = init_MapNode(key, val);
-    node->next = map->buckets[index];
-    map->buckets[index] = node;
+    map->entries[map->entry_count] = (MapEntry){hash, key, val};
+    index_entry(map, hash, map->entry_count);
+    map->entry_count++;
     map->size++;
 
     rtobj_refcount_increment1(key);
     rtobj_refcount_increment1(val);
-
-    // Resizes buckets array if needed
-    if (map->size == (map->bucket_size + map->bucket_size / 2))
-    {
-        if (!rtmap_resize(map))
-            MallocError();
-    }
-
     return val;
 }
 
 /**
  * DESCRIPTION:
- * Removes a key value pair from map, and returns the value in the map. This function will return NULL if the key was not found in the map
+ * Removes a key value pair from map, and returns the key in the map. This function will return NULL if the key was not found in the map
  *
- * This function will downsize the number of buckets if:
- * size == # of buckets / 2
+ * The entry becomes a hole, and its index slot becomes EMPTY if its group still has an EMPTY slot
+ * (no probe sequence can go past such a group), otherwise a tombstone.
+ * The map is downsized when it is less than 1/8 full
  * NOTE:
  * Key and value inside the map is not freed, its assumed the GC will take care of that
  *
@@ -275,47 +277,44 @@ RtObject *rtmap_insert(RtMap *map, RtObject *key, RtObject *val)
 RtObject *rtmap_remove(RtMap *map, RtObject *key)
 {
     assert(map && key);
-    unsigned int index = GetIndexedHash(map, key);
+    rtmap_unshare(map);
 
-    if (!map->buckets[index])
+    long found = find_slot(map, key, rtobj_hash(key));
+    if (found < 0)
         return NULL;
 
-    MapNode *prev = NULL;
-    MapNode *ptr = map->buckets[index];
+    MapEntry *entry = &map->entries[map->index[found]];
+    RtObject *tmp = entry->key;
 
-    while (ptr)
+    rtobj_refcount_decrement1(entry->key);
+    rtobj_refcount_decrement1(entry->value);
+    entry->key = NULL;
+    entry->value = NULL;
+
+    const int8_t *group = map->ctrl + ((size_t)found / CTRL_GROUP_SIZE) * CTRL_GROUP_SIZE;
+    if (ctrl_group_match_empty(group))
     {
-        // replaces key/val pair in place
-        if (rtobj_equal(ptr->key, key))
-        {
-            if (!prev)
-            {
-                map->buckets[index] = ptr->next;
-            }
-            else
-            {
-                prev->next = ptr->next;
-            }
-            RtObject *tmp = ptr->key;
-
-            rtobj_refcount_decrement1(ptr->key);
-            rtobj_refcount_decrement1(ptr->value);
-
-            free(ptr);
-            map->size--;
-
-            // downsizes buckets array if needed
-            if (map->size == map->bucket_size / 2 && map->bucket_size >= DOWNSIZING_THRESHOLD)
-            {
-                if (!rtmap_downsize(map))
-                    MallocError();
-            }
-            return tmp;
-        }
-        prev = ptr;
-        ptr = ptr->next;
+        map->ctrl[found] = CTRL_EMPTY;
     }
-    return NULL;
+    else
+    {
+        map->ctrl[found] = CTRL_DELETED;
+        map->tombstones++;
+    }
+    map->size--;
+
+    // trailing holes can be reused right away
+    while (map->entry_count > 0 && !map->entries[map->entry_count - 1].key)
+        map->entry_count--;
+
+    // downsizes table if needed
+    if (map->capacity >= DOWNSIZING_THRESHOLD && map->size < map->capacity / 8)
+    {
+        if (!rtmap_rebuild(map, map->capacity / 2))
+            MallocError();
+    }
+
+    return tmp;
 }
 
 /**
@@ -329,30 +328,45 @@ RtObject *rtmap_remove(RtMap *map, RtObject *key)
 RtObject *rtmap_get(const RtMap *map, const RtObject *key)
 {
     assert(map && key);
-    unsigned int index = GetIndexedHash(map, key);
-    if (!map->buckets[index])
-        return NULL;
-
-    MapNode *ptr = map->buckets[index];
+    long found = find_slot(map, key, rtobj_hash(key));
+    return found >= 0 ? map->entries[map->index[found]].value : NULL;
+}
 
-    while (ptr)
+/**
+ * DESCRIPTION:
+ * Iterates over the key value pairs of a map in insertion order
+ *
+ * PARAMS:
+ * map: map
+ * cursor: iteration state, must be set to 0 before the first call
+ * key: set to the next key (can be NULL)
+ * val: set to the next value (can be NULL)
+ *
+ * NOTE:
+ * Returns false once every pair has been visited, the map must not be mutated during the iteration
+ */
+bool rtmap_iterate(const RtMap *map, size_t *cursor, RtObject **key, RtObject **val)
+{
+    assert(map && cursor);
+    while (*cursor < map->entry_count)
     {
-        // replaces key/val pair in place
-        if (rtobj_equal(ptr->key, key))
-        {
-            return ptr->value;
-        }
+        const MapEntry *entry = &map->entries[(*cursor)++];
+        if (!entry->key)
+            continue;
 
-        ptr = ptr->next;
+        if (key)
+            *key = entry->key;
+        if (val)
+            *val = entry->value;
+        return true;
     }
-
-    return NULL;
+    return false;
 }
 
 __attribute__((warn_unused_result))
 /**
  * DESCRIPTION:
- * Gets all elements in the map and puts them into a NULL terminated array
+ * Gets all elements in the map and puts them into a NULL terminated array, in insertion order
  *
  * NOTE:
  * Returns NULL if malloc fails
@@ -384,29 +398,16 @@ rtmap_getrefs(const RtMap *map, bool getkeys, bool getvals)
     }
 
     unsigned int index = 0;
+    size_t cursor = 0;
+    RtObject *key, *val;
 
-    for (size_t i = 0; i < map->bucket_size; i++)
+    while (rtmap_iterate(map, &cursor, &key, &val))
     {
-        if (!map->buckets[i])
-            continue;
+        if (getkeys)
+            arr[index++] = key;
 
-        MapNode *ptr = map->buckets[i];
-        while (ptr)
-        {
-            if (getkeys)
-            {
-                arr[index] = ptr->key;
-                index++;
-            }
-
-            if (getvals)
-            {
-                arr[index] = ptr->value;
-                index++;
-            }
-
-            ptr = ptr->next;
-        }
+        if (getvals)
+            arr[index++] = val;
     }
     arr[getkeys && getvals ? map->size * 2 : map->size] = NULL;
     return arr;
@@ -415,7 +416,7 @@ rtmap_getrefs(const RtMap *map, bool getkeys, bool getvals)
 __attribute__((warn_unused_result))
 /**
  * DESCRIPTION:
- * Creates a copy of a runtime map
+ * Creates a copy of a runtime map, the copy keeps the insertion order
  *
  * PARAMS:
  * map: map to copy
@@ -427,31 +428,121 @@ RtMap *
 rtmap_cpy(const RtMap *map, bool deepcpy_key, bool deepcpy_val, bool add_to_GC)
 {
     assert(map);
-    RtMap *cpy = init_RtMap(map->bucket_size);
+    RtMap *cpy = init_RtMap(map->size);
     if (!cpy)
         return NULL;
 
-    RtObject **refs = rtmap_getrefs(map, true, true);
+    size_t cursor = 0;
+    RtObject *key, *val;
 
-    for (int i = 0; refs[i] != NULL;) {
-        RtObject *key = deepcpy_key? rtobj_deep_cpy(refs[i], add_to_GC): refs[i];
-        RtObject *val = deepcpy_val? rtobj_deep_cpy(refs[i+1], add_to_GC) : refs[i+1];
+    while (rtmap_iterate(map, &cursor, &key, &val))
+    {
+        if (deepcpy_key)
+            key = rtobj_deep_cpy(key, add_to_GC);
+        if (deepcpy_val)
+            val = rtobj_deep_cpy(val, add_to_GC);
 
         // this function will update the reference counts
         rtmap_insert(cpy, key, val);
 
-        if(add_to_GC) {
+        if (add_to_GC)
+        {
             add_to_GC_registry(key);
             add_to_GC_registry(val);
         }
-        
-        i += 2;
     }
-    free(refs);
+
     assert(map->size == cpy->size);
     return cpy;
 }
 
+__attribute__((warn_unused_result))
+/**
+ * DESCRIPTION:
+ * Creates a copy on write shallow copy of a map in constant time, the copy shares the table of the input map
+ * until one of them gets mutated (see rtmap_unshare)
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ */
+RtMap *
+rtmap_cow_cpy(RtMap *map)
+{
+    assert(map);
+    RtMap *cpy = malloc(sizeof(RtMap));
+    if (!cpy)
+        return NULL;
+
+    if (!cow_share(&map->cow_shares))
+    {
+        free(cpy);
+        return NULL;
+    }
+
+    *cpy = *map;
+    init_RtGCHeader(&cpy->gc);
+    return cpy;
+}
+
+/**
+ * DESCRIPTION:
+ * Gives the map its own private table, this MUST be called before mutating the map or one of its values.
+ * If the table is shared with other copies, the index is copied as is, entries are copied with their holes so that positions stay valid.
+ * Keys are reused as is, values are replaced by new wrappers sharing the same payload, since values can be assigned to in place (i.e map[key] = val)
+ *
+ * NOTE:
+ * Does nothing if the map already owns its table, returns the input map
+ */
+RtMap *rtmap_unshare(RtMap *map)
+{
+    assert(map);
+    const int8_t *shared_ctrl = map->ctrl;
+    const uint32_t *shared_index = map->index;
+    const MapEntry *shared_entries = map->entries;
+
+    if (cow_release(&map->cow_shares))
+        return map;
+
+    size_t tombstones = map->tombstones;
+    size_t entry_count = map->entry_count;
+    if (!alloc_table(map, map->capacity))
+    {
+        MallocError();
+        return NULL;
+    }
+
+    memcpy(map->ctrl, shared_ctrl, sizeof(int8_t) * map->capacity);
+    memcpy(map->index, shared_index, sizeof(uint32_t) * map->capacity);
+    map->tombstones = tombstones;
+    map->entry_count = entry_count;
+
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        map->entries[i] = shared_entries[i];
+        if (!shared_entries[i].key)
+            continue;
+
+        RtObject *key = shared_entries[i].key;
+        RtObject *val = add_to_GC_registry(rtobj_shallow_cpy(shared_entries[i].value));
+        map->entries[i].value = val;
+
+        rtobj_refcount_increment1(key);
+        rtobj_refcount_increment1(val);
+    }
+
+    return map;
+}
+
+/**
+ * DESCRIPTION:
+ * Number of bytes used by the map struct, its index and its entries (keys and values are not included)
+ */
+size_t rtmap_memsize(const RtMap *map)
+{
+    assert(map);
+    return sizeof(RtMap) + map->capacity * (sizeof(int8_t) + sizeof(uint32_t)) + max_load(map->capacity) * sizeof(MapEntry);
+}
+
 /**
  * DESCRIPTION:
  * Frees map, and its associated objects if desired
@@ -464,28 +555,35 @@ rtmap_cpy(const RtMap *map, bool deepcpy_key, bool deepcpy_val, bool add_to_GC)
  */
 void rtmap_free(RtMap *map, bool free_keys, bool free_vals, bool free_immutable, bool update_ref_counts)
 {
-
-    for (size_t i = 0; i < map->bucket_size; i++)
+    // table is still used by other copies of the map
+    if (!cow_release(&map->cow_shares))
     {
-        if (!map->buckets[i])
-            continue;
+        free(map);
+        return;
+    }
+
+    size_t cursor = 0;
+    RtObject *key, *val;
 
-        MapNode *ptr = map->buckets[i];
-        while (ptr)
+    while (rtmap_iterate(map, &cursor, &key, &val))
+    {
+        // updates reference counts
+        if (update_ref_counts)
         {
-            MapNode *tmp = ptr->next;
+            rtobj_refcount_decrement1(key);
+            rtobj_refcount_decrement1(val);
+        }
 
-            // updates reference counts
-            if(update_ref_counts) {
-                rtobj_refcount_decrement1(ptr->key);
-                rtobj_refcount_decrement1(ptr->value);
-            }
+        if (free_keys)
+            rtobj_free(key, free_immutable, update_ref_counts);
 
-            free_MapNode(ptr, free_keys, free_vals, free_immutable, update_ref_counts);
-            ptr = tmp;
-        }
+        if (free_vals)
+            rtobj_free(val, free_immutable, update_ref_counts);
     }
-    free(map->buckets);
+
+    free(map->ctrl);
+    free(map->index);
+    free(map->entries);
     free(map);
 }
 
@@ -497,37 +595,31 @@ void rtmap_print(const RtMap *map)
 {
     assert(map);
     size_t counter = 0;
+    size_t cursor = 0;
+    RtObject *key, *val;
+
     printf("{");
-    for (size_t i = 0; i < map->bucket_size; i++)
+    while (rtmap_iterate(map, &cursor, &key, &val))
     {
-        if (!map->buckets[i])
-            continue;
-
-        MapNode *ptr = map->buckets[i];
-        while (ptr)
-        {
-            char *val_to_string = rtobj_toString(ptr->value);
-            char *key_to_string = rtobj_toString(ptr->key);
-            if (ptr->key->type == STRING_TYPE)
-                printf("\"%s\": ", key_to_string);
-            else
-                printf("%s: ", key_to_string);
-
-            if (ptr->value->type == STRING_TYPE)
-                printf("\"%s\"", val_to_string);
-            else
-                printf("%s", val_to_string);
-            
-
-            free(val_to_string);
-            free(key_to_string);
-            counter++;
-            if (counter == map->size)
-                break;
-
-            printf(", ");
-            ptr = ptr->next;
-        }
+        char *val_to_string = rtobj_toString(val);
+        char *key_to_string = rtobj_toString(key);
+        if (key->type == STRING_TYPE)
+            printf("\"%s\": ", key_to_string);
+        else
+            printf("%s: ", key_to_string);
+
+        if (val->type == STRING_TYPE)
+            printf("\"%s\"", val_to_string);
+        else
+            printf("%s", val_to_string);
+
+        free(val_to_string);
+        free(key_to_string);
+        counter++;
+        if (counter == map->size)
+            break;
+
+        printf(", ");
     }
     assert(counter == map->size);
     printf("}");
@@ -619,6 +711,7 @@ _rtmap_toString(const RtMap *map)
     return str;
 }
 
+
 /**
  * DESCRIPTION:
  * Checks if 2 maps are equivalent, i.e contains the same number of elements and each key-value pair is equivalent
@@ -632,19 +725,15 @@ bool rtmap_equal(const RtMap *map1, const RtMap *map2)
     if (map1->size != map2->size)
         return false;
 
-    RtObject **refs = rtmap_getrefs(map1, true, false);
-    for (size_t i = 0; refs[i] != NULL; i++)
-    {
-        const RtObject *tmp2 = rtmap_get(map1, refs[i]);
-        const RtObject *tmp1 = rtmap_get(map1, refs[i]);
+    size_t cursor = 0;
+    RtObject *key, *val;
 
-        if (!tmp1 || !tmp2 || !rtobj_equal(tmp2, tmp2))
-        {
-            free(refs);
+    while (rtmap_iterate(map1, &cursor, &key, &val))
+    {
+        const RtObject *other = rtmap_get(map2, key);
+        if (!other || !rtobj_equal(val, other))
             return false;
-        }
     }
-    free(refs);
     return true;
 }
 
@@ -663,27 +752,36 @@ RtMap *rtmap_clear(RtMap *map, bool free_key, bool free_val, bool free_immutable
 {
     assert(map);
 
-    for (size_t i = 0; i < map->bucket_size; i++)
+    // no need to copy a table that is about to be emptied, the other copies keep it
+    if (!cow_release(&map->cow_shares))
     {
-        if (!map->buckets[i])
-            continue;
+        if (!alloc_table(map, DEFAULT_RTMAP_CAPACITY))
+            MallocError();
+        map->size = 0;
+        return map;
+    }
+
+    size_t cursor = 0;
+    RtObject *key, *val;
 
-        MapNode *node = map->buckets[i];
-        while (node)
+    while (rtmap_iterate(map, &cursor, &key, &val))
+    {
+        if (update_ref_counts)
         {
-            MapNode *tmp = node->next;
-            
-            rtobj_refcount_decrement1(node->key);
-            rtobj_refcount_decrement1(node->value);
-
-            free_MapNode(node, free_key, free_val, free_immutable, update_ref_counts);
-            map->size--;
-            node = tmp;
+            rtobj_refcount_decrement1(key);
+            rtobj_refcount_decrement1(val);
         }
 
-        map->buckets[i] = NULL;
+        if (free_key)
+            rtobj_free(key, free_immutable, update_ref_counts);
+
+        if (free_val)
+            rtobj_free(val, free_immutable, update_ref_counts);
     }
 
-    assert(map->size == 0);
+    ctrl_reset(map->ctrl, map->capacity);
+    map->tombstones = 0;
+    map->entry_count = 0;
+    map->size = 0;
     return map;
 }
@@ -1,26 +1,37 @@
 #pragma once
+#include "gcheader.h"
 #include <stdlib.h>
+#include <stdint.h>
 #include "rtobjects.h"
 
-typedef struct MapNode MapNode;
+typedef struct MapEntry MapEntry;
 
 typedef struct RtMap
 {
-    size_t size;        // number of elements in the set
-    size_t bucket_size; // number of buckets
-    MapNode **buckets;
-    size_t refcount;
+    RtGCHeader gc;
+    size_t size;        // number of key value pairs in the map
+    size_t capacity;    // number of index slots, always a power of 2 multiple of CTRL_GROUP_SIZE
+    size_t tombstones;  // number of DELETED index slots
+    size_t entry_count; // number of used entries, including holes left by removed keys
+    int8_t *ctrl;       // one control byte per index slot (see ctrlbytes.h)
+    uint32_t *index;    // position in entries of each full index slot
+    MapEntry *entries;  // key value pairs in insertion order, room for 7/8 of capacity
+    size_t *cow_shares; // share counter of the table when its shared with copies of the map, NULL when private (see cow.h)
 } RtMap;
 
-RtMap *init_RtMap(unsigned long initial_bucket_size);
+RtMap *init_RtMap(unsigned long initial_size);
 RtObject *rtmap_insert(RtMap *map, RtObject *key, RtObject *val);
 RtObject *rtmap_remove(RtMap *map, RtObject *key);
 RtObject *rtmap_get(const RtMap *map, const RtObject *key);
+bool rtmap_iterate(const RtMap *map, size_t *cursor, RtObject **key, RtObject **val);
 RtObject **rtmap_getrefs(const RtMap *map, bool getkeys, bool getvals);
 void rtmap_free(RtMap *map, bool free_keys, bool free_vals, bool free_immutable, bool update_ref_counts);
 char *rtmap_toString(const RtMap *map);
 void rtmap_print(const RtMap *map);
 RtMap *rtmap_cpy(const RtMap *map, bool deepcpy_key, bool deepcpy_val, bool add_to_GC);
+RtMap *rtmap_cow_cpy(RtMap *map);
+RtMap *rtmap_unshare(RtMap *map);
 bool rtmap_equal(const RtMap *map1, const RtMap *map2);
+size_t rtmap_memsize(const RtMap *map);
 RtMap *rtmap_clear(RtMap *map, bool free_key, bool free_val, bool free_immutable, bool update_ref_counts);
 
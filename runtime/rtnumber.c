@@ -13,7 +13,7 @@ RtNumber *init_RtNumber(long double number) {
     RtNumber *num = malloc(sizeof(RtNumber));
     if(!num) MallocError();
     num->number=number;
-    num->refcount = 0;
+    init_RtGCHeader(&num->gc);
     return num;
 }
 
@@ -1,9 +1,10 @@
 #pragma once
 #include <stdbool.h>
+#include "gcheader.h"
 
 typedef struct RtNumber {
+    RtGCHeader gc;
     long double number;
-    size_t refcount;
 } RtNumber;
 
 typedef struct RtInteger {
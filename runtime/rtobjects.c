@@ -7,6 +7,7 @@
 #include "../compiler/compiler.h"
 #include "./rtexchandler.h"
 #include "../generics/utilities.h"
+#include "../generics/hashmap.h"
 #include "rtfunc.h"
 #include "gc.h"
 #include "string.h"
@@ -72,7 +73,7 @@ __attribute__((warn_unused_result))
  * Function types are set to non built in by default
  *
  * NOTE:
- * If the type is NULL_TYPE or UNDEFINED_TYPE, then a GC Flag is malloced
+ * If the type is NULL_TYPE or UNDEFINED_TYPE, then a GC header is malloced
  */
 RtObject *
 init_RtObject(RtType type)
@@ -88,13 +89,17 @@ init_RtObject(RtType type)
     // special cases for null type and undefined type
     if (type == NULL_TYPE)
     {
-        obj->data.GCrefcount_NULL_TYPE = malloc(sizeof(size_t));
-        *obj->data.GCrefcount_NULL_TYPE = 0;
+        obj->data.GCheader_NULL_TYPE = malloc(sizeof(RtGCHeader));
+        if (!obj->data.GCheader_NULL_TYPE)
+            MallocError();
+        init_RtGCHeader(obj->data.GCheader_NULL_TYPE);
     }
     else if (type == UNDEFINED_TYPE)
     {
-        obj->data.GCrefcount_UNDEFINED_TYPE = malloc(sizeof(size_t));
-        *obj->data.GCrefcount_UNDEFINED_TYPE = 0;
+        obj->data.GCheader_UNDEFINED_TYPE = malloc(sizeof(RtGCHeader));
+        if (!obj->data.GCheader_UNDEFINED_TYPE)
+            MallocError();
+        init_RtGCHeader(obj->data.GCheader_UNDEFINED_TYPE);
     }
 
     return obj;
@@ -132,6 +137,30 @@ RtObject *rtobj_rt_preprocess(RtObject *obj, bool disposable, bool add_to_GC)
     return obj;
 }
 
+/**
+ * DESCRIPTION:
+ * Gets the object to store as the key of a map or as the element of a set, from an object that may be referred to elsewhere (i.e a variable)
+ * Keys are hashed once inserted, but mutating a variable (a = [2]) replaces the payload of its object in place,
+ * so the key gets its own object sharing the payload, which nothing else can mutate
+ *
+ * PARAMS:
+ * key: key after rtobj_rt_preprocess
+ *
+ * NOTE:
+ * primitives were already copied by rtobj_rt_preprocess, they are returned as is
+ * the new object is added to the GC
+ */
+RtObject *rtobj_key_cpy(RtObject *key)
+{
+    assert(key);
+    if (rttype_isprimitive(key->type))
+        return key;
+
+    RtObject *cpy = rtobj_shallow_cpy(key);
+    add_to_GC_registry(cpy);
+    return cpy;
+}
+
 __attribute__((warn_unused_result))
 /**
  * Converts a string into its corresponding string representation
@@ -152,7 +181,7 @@ rtobj_toString(const RtObject *obj)
         return rtnumber_toString(obj->data.Number);
 
     case STRING_TYPE:
-        return cpy_string(obj->data.String->string);
+        return cpy_string(rtstr_chars(obj->data.String));
 
     case FUNCTION_TYPE:
         return rtfunc_toString(obj->data.Func);
@@ -171,6 +200,9 @@ rtobj_toString(const RtObject *obj)
 
     case EXCEPTION_TYPE:
         return rtexception_toString(obj->data.Exception);
+
+    case RANGE_TYPE:
+        return rtrange_toString(obj->data.Range);
     }
 }
 
@@ -197,7 +229,7 @@ void rtobj_print(const RtObject *obj)
         return;
 
     case STRING_TYPE:
-        printf("%s", obj->data.String->string);
+        fwrite(rtstr_data(obj->data.String), 1, obj->data.String->length, stdout);
         return;
 
     case FUNCTION_TYPE:
@@ -224,6 +256,10 @@ void rtobj_print(const RtObject *obj)
     case EXCEPTION_TYPE:
         rtexception_print(obj->data.Exception);
         return;
+
+    case RANGE_TYPE:
+        printf("range(%Lg, %Lg, %Lg)", obj->data.Range->start, obj->data.Range->end, obj->data.Range->step);
+        return;
     }
 }
 
@@ -277,21 +313,15 @@ multiply_obj_by_multiplier(const RtObject *multiplier_obj, const RtObject *obj)
         RtObject *result = init_RtObject(STRING_TYPE);
 
         unsigned int multiplicand_len = obj->data.String->length;
-        char *multiplicand = obj->data.String->string;
-        char *new_str = malloc(sizeof(char) * (multiplicand_len * multiplier + 1));
+        const char *multiplicand = rtstr_data(obj->data.String);
 
-        for (unsigned int i = 0; i < (unsigned int)multiplier; i++)
-        {
-            for (unsigned int j = 0; j < multiplicand_len; j++)
-            {
-                new_str[multiplicand_len * i + j] = multiplicand[j];
-            }
-        }
-        new_str[multiplicand_len * (int)multiplier] = '\0';
+        result->data.String = init_RtString_len(NULL, multiplicand_len * (unsigned int)multiplier);
+        if (!result->data.String)
+            MallocError();
 
-        result->data.String = init_RtString(NULL);
-        result->data.String->string = new_str;
-        result->data.String->length = multiplicand_len * multiplier;
+        char *new_str = result->data.String->chars;
+        for (unsigned int i = 0; i < (unsigned int)multiplier; i++)
+            memcpy(new_str + multiplicand_len * i, multiplicand, multiplicand_len);
         return result;
     }
 
@@ -408,18 +438,15 @@ add_objs(RtObject *obj1, RtObject *obj2)
 
     case STRING_TYPE:
     {
-        char *adder1 = obj1->data.String->string;
-        int length1 = obj1->data.String->length;
         switch (obj2->type)
         {
         case STRING_TYPE:
         {
+            // appends to the builder of obj1 when possible, see rtstr_concat
             RtObject *result = init_RtObject(STRING_TYPE);
-            char *adder2 = obj2->data.String->string;
-            int length2 = obj2->data.String->length;
-            result->data.String = init_RtString(NULL);
-            result->data.String->string = concat_strings(adder1, adder2);
-            result->data.String->length = length1 + length2;
+            result->data.String = rtstr_concat(obj1->data.String, obj2->data.String);
+            if (!result->data.String)
+                MallocError();
             return result;
         }
 
@@ -492,6 +519,7 @@ add_objs(RtObject *obj1, RtObject *obj2)
     case HASHMAP_TYPE:
     case CLASS_TYPE:
     case EXCEPTION_TYPE:
+    case RANGE_TYPE:
         break;
     }
 
@@ -586,6 +614,7 @@ substract_objs(RtObject *obj1, RtObject *obj2)
     case FUNCTION_TYPE:
     case UNDEFINED_TYPE:
     case EXCEPTION_TYPE:
+    case RANGE_TYPE:
         break;
     }
 
@@ -810,7 +839,7 @@ greater_than_op(RtObject *obj1, RtObject *obj2)
     else if (obj1->type == STRING_TYPE && obj2->type == STRING_TYPE)
     {
         RtObject *obj = init_RtObject(NUMBER_TYPE);
-        double num = strcmp(obj1->data.String->string, obj2->data.String->string) > 0;
+        double num = rtstr_compare(obj1->data.String, obj2->data.String) > 0;
         set_rtobj_number_data(obj, num);
         return obj;
     }
@@ -841,7 +870,7 @@ greater_equal_op(RtObject *obj1, RtObject *obj2)
     else if (obj1->type == STRING_TYPE && obj2->type == STRING_TYPE)
     {
         RtObject *obj = init_RtObject(NUMBER_TYPE);
-        double num = strcmp(obj1->data.String->string, obj2->data.String->string) >= 0;
+        double num = rtstr_compare(obj1->data.String, obj2->data.String) >= 0;
         set_rtobj_number_data(obj, num);
         return obj;
     }
@@ -872,7 +901,7 @@ lesser_than_op(RtObject *obj1, RtObject *obj2)
     else if (obj1->type == STRING_TYPE && obj2->type == STRING_TYPE)
     {
         RtObject *obj = init_RtObject(NUMBER_TYPE);
-        double num = strcmp(obj1->data.String->string, obj2->data.String->string) < 0;
+        double num = rtstr_compare(obj1->data.String, obj2->data.String) < 0;
         set_rtobj_number_data(obj, num);
         return obj;
     }
@@ -903,7 +932,7 @@ lesser_equal_op(RtObject *obj1, RtObject *obj2)
     else if (obj1->type == STRING_TYPE && obj2->type == STRING_TYPE)
     {
         RtObject *obj = init_RtObject(NUMBER_TYPE);
-        double num = strcmp(obj1->data.String->string, obj2->data.String->string) <= 0;
+        double num = rtstr_compare(obj1->data.String, obj2->data.String) <= 0;
         set_rtobj_number_data(obj, num);
         return obj;
     }
@@ -1007,6 +1036,8 @@ bool eval_obj(const RtObject *obj)
         return obj->data.Map->size > 0;
     case HASHSET_TYPE:
         return obj->data.Set->size > 0;
+    case RANGE_TYPE:
+        return rtrange_length(obj->data.Range) > 0;
     }
 }
 
@@ -1029,6 +1060,7 @@ void rtobj_init_cmp_tbl()
     RtObjTypeCompareTbl[HASHMAP_TYPE] = 6;
     RtObjTypeCompareTbl[CLASS_TYPE] = 7;
     RtObjTypeCompareTbl[EXCEPTION_TYPE] = 8;
+    RtObjTypeCompareTbl[RANGE_TYPE] = 9;
 }
 
 /**
@@ -1048,7 +1080,7 @@ long double rtobj_compare(const RtObject *obj1, const RtObject *obj2)
         return 0;
 
     if (obj1->type != obj2->type)
-        return (size_t)(RtObjTypeCompareTbl[obj1->type] - RtObjTypeCompareTbl[obj2->type]);
+        return RtObjTypeCompareTbl[obj1->type] - RtObjTypeCompareTbl[obj2->type];
 
     switch (obj1->type)
     {
@@ -1058,7 +1090,7 @@ long double rtobj_compare(const RtObject *obj1, const RtObject *obj2)
     case NUMBER_TYPE:
         return obj1->data.Number->number - obj2->data.Number->number;
     case STRING_TYPE:
-        return strcmp(obj1->data.String->string, obj2->data.String->string);
+        return rtstr_compare(obj1->data.String, obj2->data.String);
     case CLASS_TYPE:
         return strcmp(obj1->data.Class->classname, obj2->data.Class->classname);
     case EXCEPTION_TYPE:
@@ -1067,6 +1099,7 @@ long double rtobj_compare(const RtObject *obj1, const RtObject *obj2)
     case LIST_TYPE:
     case HASHMAP_TYPE:
     case HASHSET_TYPE:
+    case RANGE_TYPE:
         return 0;
     }
     return 0;
@@ -1075,33 +1108,51 @@ long double rtobj_compare(const RtObject *obj1, const RtObject *obj2)
 /**
  * DESCRIPTION:
  * Hashes runtime object, used for built in data strutures (list, set, map)
+ * The hash is seeded (see hash_bytes), and must be consistent with rtobj_equal:
+ * - numbers and strings are hashed by value
+ * - functions are hashed by the function they point to
+ * - lists, maps, sets, classes and exceptions are equal only to themselves, so they are hashed by identity (their payload)
+ * Keys of maps and sets are inserted as their own object (see rtobj_key_cpy), so their payload, and their hash, never changes
  */
-unsigned int rtobj_hash(const RtObject *obj)
+uint64_t rtobj_hash(const RtObject *obj)
 {
     switch (obj->type)
     {
 
     case NUMBER_TYPE:
-        return murmurHashUInt(obj->data.Number->number);
+    {
+        // 0.0 and -0.0 are equal, but their bits are not
+        double number = obj->data.Number->number == 0 ? 0 : obj->data.Number->number;
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        return hash_u64(bits);
+    }
     case STRING_TYPE:
-        return djb2_string_hash(obj->data.String->string);
+        return hash_bytes(rtstr_data(obj->data.String), obj->data.String->length);
     case FUNCTION_TYPE:
-        return rtfunc_hash(obj->data.Func);
-
-    case CLASS_TYPE:
-        // TODO
-        return false;
+        return hash_u64(rtfunc_hash(obj->data.Func));
+    case RANGE_TYPE:
+    {
+        // equal ranges yield the same values, so they are hashed by their length and first value
+        size_t length = rtrange_length(obj->data.Range);
+        double start = length == 0 || obj->data.Range->start == 0 ? 0 : obj->data.Range->start;
+        uint64_t bits;
+        memcpy(&bits, &start, sizeof(bits));
+        return hash_u64(bits ^ hash_u64(length));
+    }
 
-    case UNDEFINED_TYPE:
-    case NULL_TYPE:
     case LIST_TYPE:
     case HASHMAP_TYPE:
     case HASHSET_TYPE:
+    case CLASS_TYPE:
     case EXCEPTION_TYPE:
-        // NOT HASHABLE
-        // TODO, SHOULD RAISE EXCEPTION
-        return 0;
+        return hash_u64((uint64_t)(uintptr_t)rtobj_getdata(obj));
+
+    case UNDEFINED_TYPE:
+    case NULL_TYPE:
+        return hash_u64(obj->type);
     }
+    return 0;
 }
 
 /**
@@ -1121,9 +1172,9 @@ unsigned int rtobj_hash_data_ptr(const RtObject *obj)
     case CLASS_TYPE:
         return hash_pointer(obj->data.Func);
     case UNDEFINED_TYPE:
-        return hash_pointer(obj->data.GCrefcount_UNDEFINED_TYPE);
+        return hash_pointer(obj->data.GCheader_UNDEFINED_TYPE);
     case NULL_TYPE:
-        return hash_pointer(obj->data.GCrefcount_NULL_TYPE);
+        return hash_pointer(obj->data.GCheader_NULL_TYPE);
     case LIST_TYPE:
         return hash_pointer(obj->data.List);
     case HASHMAP_TYPE:
@@ -1132,6 +1183,8 @@ unsigned int rtobj_hash_data_ptr(const RtObject *obj)
         return hash_pointer(obj->data.Set);
     case EXCEPTION_TYPE:
         return hash_pointer(obj->data.Exception);
+    case RANGE_TYPE:
+        return hash_pointer(obj->data.Range);
     }
 }
 
@@ -1157,9 +1210,9 @@ bool rtobj_shallow_equal(const RtObject *obj1, const RtObject *obj2)
     case CLASS_TYPE:
         return obj1->data.Class == obj2->data.Class;
     case UNDEFINED_TYPE:
-        return obj1->data.GCrefcount_UNDEFINED_TYPE == obj2->data.GCrefcount_UNDEFINED_TYPE;
+        return obj1->data.GCheader_UNDEFINED_TYPE == obj2->data.GCheader_UNDEFINED_TYPE;
     case NULL_TYPE:
-        return obj1->data.GCrefcount_NULL_TYPE == obj2->data.GCrefcount_NULL_TYPE;
+        return obj1->data.GCheader_NULL_TYPE == obj2->data.GCheader_NULL_TYPE;
     case LIST_TYPE:
         return obj1->data.List == obj2->data.List;
     case HASHMAP_TYPE:
@@ -1168,6 +1221,8 @@ bool rtobj_shallow_equal(const RtObject *obj1, const RtObject *obj2)
         return obj1->data.Set == obj2->data.Set;
     case EXCEPTION_TYPE:
         return obj1->data.Exception == obj2->data.Exception;
+    case RANGE_TYPE:
+        return obj1->data.Range == obj2->data.Range;
     }
 }
 
@@ -1195,7 +1250,7 @@ bool rtobj_equal(const RtObject *obj1, const RtObject *obj2)
         return obj1->data.Number->number == obj2->data.Number->number;
 
     case STRING_TYPE:
-        return strings_equal(obj1->data.String->string, obj2->data.String->string);
+        return rtstr_equal(obj1->data.String, obj2->data.String);
 
     case FUNCTION_TYPE:
         return rtfunc_equal(obj1->data.Func, obj2->data.Func);
@@ -1214,6 +1269,9 @@ bool rtobj_equal(const RtObject *obj1, const RtObject *obj2)
 
     case EXCEPTION_TYPE:
         return obj1->data.Exception == obj2->data.Exception;
+
+    case RANGE_TYPE:
+        return rtrange_equal(obj1->data.Range, obj2->data.Range);
     }
 }
 
@@ -1222,6 +1280,7 @@ __attribute__((warn_unused_result))
  * DESCRIPTION:
  * Creates a new shallow copy of a Runtime Object,
  * Out references are malloced
+ * The copy shares its payload with obj, and becomes one of its owners
  *
  * NOTE: For Function Type, a shallow copy is always peformed, since there is only one function instance
  *
@@ -1230,82 +1289,91 @@ RtObject *
 rtobj_shallow_cpy(const RtObject *obj)
 {
     RtObject *cpy = init_RtObject(obj->type);
-    // rtobj_refcount_increment1(obj);
     if (!cpy)
         return NULL;
 
+    // needs to be freed since init_RtObject malloced it
+    if (obj->type == NULL_TYPE || obj->type == UNDEFINED_TYPE)
+        free(cpy->data.GCheader_NULL_TYPE);
+
+    // all union members are pointers to a payload starting with a GC header
+    cpy->data = obj->data;
+    rtgcheader(rtobj_getdata(cpy))->owners++;
+    return cpy;
+}
+
+__attribute__((warn_unused_result))
+/**
+ * DESCRIPTION:
+ * Creates a new shallow copy of a Runtime Object with its own payload.
+ * For containers (lists, maps, sets) the copy is copy on write, its storage is shared with obj
+ * until one of them is mutated, so copying a container that is never mutated is constant time.
+ * Every other type behaves exactly like rtobj_shallow_cpy
+ *
+ * NOTE:
+ * Elements are not copied, so both containers still point to the same nested containers
+ */
+RtObject *
+rtobj_cow_cpy(RtObject *obj)
+{
     switch (obj->type)
     {
-    case NUMBER_TYPE:
+    case LIST_TYPE:
     {
-        cpy->data.Number = obj->data.Number;
-        break;
+        RtObject *cpy = init_RtObject(LIST_TYPE);
+        cpy->data.List = rtlist_cow_cpy(obj->data.List);
+        if (!cpy->data.List)
+            MallocError();
+        return cpy;
     }
-
-    case NULL_TYPE:
+    case HASHMAP_TYPE:
     {
-        // needs to be freed since init_RtObject malloced it
-        free(cpy->data.GCrefcount_NULL_TYPE);
-        cpy->data.GCrefcount_NULL_TYPE = obj->data.GCrefcount_NULL_TYPE;
-        break;
+        RtObject *cpy = init_RtObject(HASHMAP_TYPE);
+        cpy->data.Map = rtmap_cow_cpy(obj->data.Map);
+        if (!cpy->data.Map)
+            MallocError();
+        return cpy;
     }
-
-    case UNDEFINED_TYPE:
+    case HASHSET_TYPE:
     {
-        // needs to be freed since init_RtObject malloced it
-        free(cpy->data.GCrefcount_UNDEFINED_TYPE);
-        cpy->data.GCrefcount_UNDEFINED_TYPE = obj->data.GCrefcount_UNDEFINED_TYPE;
-        break;
+        RtObject *cpy = init_RtObject(HASHSET_TYPE);
+        cpy->data.Set = rtset_cow_cpy(obj->data.Set);
+        if (!cpy->data.Set)
+            MallocError();
+        return cpy;
     }
-
-    case STRING_TYPE:
-    {
-        cpy->data.String = obj->data.String;
-        break;
+    default:
+        return rtobj_shallow_cpy(obj);
     }
+}
 
-    case FUNCTION_TYPE:
+/**
+ * DESCRIPTION:
+ * Makes sure the storage of a container object is not shared with any copy (see rtobj_cow_cpy),
+ * this must be called before an element of the container is mutated in place (i.e index assignment)
+ *
+ * NOTE:
+ * Does nothing for non container types, always returns obj
+ */
+RtObject *rtobj_unshare(RtObject *obj)
+{
+    switch (obj->type)
     {
-        cpy->data.Func = obj->data.Func;
-        break;
-    }
-
     case LIST_TYPE:
-    {
-        cpy->data.List = obj->data.List;
+        rtlist_unshare(obj->data.List);
         break;
-    }
-
     case HASHMAP_TYPE:
-    {
-
-        cpy->data.Map = obj->data.Map;
+        rtmap_unshare(obj->data.Map);
         break;
-    }
-
-    case CLASS_TYPE:
-    {
-
-        cpy->data.Class = obj->data.Class;
-        break;
-    }
-
     case HASHSET_TYPE:
-    {
-        cpy->data.Set = obj->data.Set;
+        rtset_unshare(obj->data.Set);
         break;
-    }
-    case EXCEPTION_TYPE:
-    {
-        cpy->data.Exception = obj->data.Exception;
+    default:
         break;
     }
-    }
-    // rtobj_refcount_increment1(cpy);
-    return cpy;
+    return obj;
 }
 
-__attribute__((warn_unused_result))
 /**
  * DESCRIPTION:
  * Creates a new deep copy of a Runtime Object,
@@ -1334,9 +1402,21 @@ rtobj_deep_cpy(const RtObject *obj, bool add_to_gc)
         break;
     }
 
+    // strings are immutable once created, so the copy can safely share the payload
     case STRING_TYPE:
     {
-        cpy->data.String = init_RtString(obj->data.String->string);
+        cpy->data.String = obj->data.String;
+        cpy->data.String->gc.owners++;
+        if (add_to_gc)
+            add_to_GC_registry(cpy);
+        break;
+    }
+
+    // same goes for ranges
+    case RANGE_TYPE:
+    {
+        cpy->data.Range = obj->data.Range;
+        cpy->data.Range->gc.owners++;
         if (add_to_gc)
             add_to_GC_registry(cpy);
         break;
@@ -1393,103 +1473,303 @@ rtobj_deep_cpy(const RtObject *obj, bool add_to_gc)
     return cpy;
 }
 
+static RtObject *isolated_cpy(const RtObject *obj, GenericMap *copies);
+
 /**
  * DESCRIPTION:
- * Performs a mutation on the target, with the new value
+ * Helper for rtobj_isolated_cpy, copies an object contained by the object being copied and adds the copy to the GC registry.
+ * Objects referenced multiple times (or by themselves) are copied once, copies maps each object to its copy
+ */
+static RtObject *isolated_cpy_ref(const RtObject *obj, GenericMap *copies)
+{
+    RtObject *cpy = GenericHashMap_get(copies, (void *)obj);
+    if (cpy)
+        return cpy;
+
+    return add_to_GC_registry(isolated_cpy(obj, copies));
+}
+
+/**
+ * DESCRIPTION:
+ * Helper appending an isolated copy of the element at index of src to dest.
+ * Elements of unboxed lists are copied into temporary objects, which are freed if dest only stores their value
  *
  * PARAMS:
- * new_val_disposable: wether new_value data is disposable (i.e. will be freed after use)
- *
+ * copies: copies made so far by rtobj_isolated_cpy, NULL if the element is copied on its own
  */
-RtObject *rtobj_mutate(RtObject *target, const RtObject *new_value, bool new_val_disposable)
+static void append_isolated_element(RtList *dest, const RtList *src, size_t index, GenericMap *copies)
 {
-    assert(target && new_value);
-
-    if (target == new_value)
+    if (!rtlist_unboxed(src))
     {
-        return target;
+        RtObject *element = copies ? isolated_cpy_ref(src->objs[index], copies) : add_to_GC_registry(rtobj_isolated_cpy(src->objs[index]));
+        rtlist_append(dest, element);
+        return;
     }
 
-    switch (new_value->type)
+    RtObject *element = init_RtObject(src->strategy == RTLIST_NUMBERS ? NUMBER_TYPE : STRING_TYPE);
+    if (src->strategy == RTLIST_NUMBERS)
+        element->data.Number = init_RtNumber(src->numbers[index]);
+    else
+        element->data.String = init_RtString_len(rtstr_data(src->strings[index]), src->strings[index]->length);
+
+    if (!rtobj_getdata(element))
+        MallocError();
+
+    rtlist_append(dest, element);
+    if (rtlist_unboxed(dest))
+        rtobj_free(element, false, true);
+    else
+        add_to_GC_registry(element);
+}
+
+/**
+ * DESCRIPTION:
+ * Helper for rtobj_isolated_cpy, copies the elements of a list
+ */
+static RtList *isolated_list_cpy(const RtList *list, GenericMap *copies)
+{
+    RtList *cpy = init_RtList(list->length + 1);
+    if (!cpy)
+        MallocError();
+
+    for (size_t i = 0; i < list->length; i++)
+        append_isolated_element(cpy, list, i, copies);
+
+    return cpy;
+}
+
+/**
+ * DESCRIPTION:
+ * Helper for rtobj_isolated_cpy, copies the key value pairs of a map into dest
+ */
+static void isolated_map_cpy(RtMap *dest, const RtMap *map, GenericMap *copies)
+{
+    size_t cursor = 0;
+    RtObject *key, *val;
+    while (rtmap_iterate(map, &cursor, &key, &val))
+        rtmap_insert(dest, isolated_cpy_ref(key, copies), isolated_cpy_ref(val, copies));
+}
+
+/**
+ * DESCRIPTION:
+ * Helper for rtobj_isolated_cpy, copies a function along with its closures and the target of attribute functions
+ * Bytecode, argument names and other immutable data embedded within the bytecode are shared
+ */
+static RtFunction *isolated_func_cpy(const RtFunction *func, GenericMap *copies)
+{
+    RtFunction *cpy = NULL;
+    switch (func->functype)
     {
-    case NUMBER_TYPE:
+    case REGULAR_FUNC:
     {
-        // new copy is created each time
-        target->data.Number =
-            new_val_disposable ? new_value->data.Number : 
-            init_RtNumber(new_value->data.Number->number);
-        
-        break;
-    }
+        cpy = rtfunc_cpy(func, false);
+        if (!cpy)
+            MallocError();
 
-    case NULL_TYPE:
-    {
-        if (new_val_disposable)
-        {
-            target->data.GCrefcount_NULL_TYPE = malloc(sizeof(size_t));
-            *target->data.GCrefcount_NULL_TYPE = 0;
-        }
-        else
+        if (!func->func_data.user_func.closure_obj)
+            break;
+
+        size_t count = func->func_data.user_func.closure_count;
+        RtObject **closures = malloc(sizeof(RtObject *) * count);
+        if (!closures)
+            MallocError();
+
+        for (size_t i = 0; i < count; i++)
         {
-            target->data.GCrefcount_NULL_TYPE = new_value->data.GCrefcount_NULL_TYPE;
+            closures[i] = isolated_cpy_ref(func->func_data.user_func.closure_obj[i], copies);
+            rtobj_refcount_increment1(closures[i]);
         }
+        cpy->func_data.user_func.closure_obj = closures;
         break;
     }
 
-    case UNDEFINED_TYPE:
+    case ATTR_BUILTIN_FUNC:
     {
-        if (new_val_disposable)
-        {
-            target->data.GCrefcount_UNDEFINED_TYPE = malloc(sizeof(size_t));
-            *target->data.GCrefcount_UNDEFINED_TYPE = 0;
-        }
-        else
-        {
-            target->data.GCrefcount_UNDEFINED_TYPE = new_value->data.GCrefcount_UNDEFINED_TYPE;
-        }
+        // rtfunc_cpy would update the reference count of the original target
+        cpy = init_rtfunc(ATTR_BUILTIN_FUNC);
+        if (!cpy)
+            MallocError();
+
+        cpy->func_data.attr_built_in.func = func->func_data.attr_built_in.func;
+        cpy->func_data.attr_built_in.target = isolated_cpy_ref(func->func_data.attr_built_in.target, copies);
+        rtobj_refcount_increment1(cpy->func_data.attr_built_in.target);
         break;
     }
 
-    case STRING_TYPE:
-    {
-        target->data.String = new_value->data.String;
+    default:
+        cpy = rtfunc_cpy(func, true);
+        if (!cpy)
+            MallocError();
         break;
     }
+    return cpy;
+}
 
-    case FUNCTION_TYPE:
+/**
+ * DESCRIPTION:
+ * Helper for rtobj_isolated_cpy, copies obj without adding the copy to the GC registry
+ * copies is NULL for objects that cannot contain other objects
+ */
+static RtObject *isolated_cpy(const RtObject *obj, GenericMap *copies)
+{
+    RtObject *cpy = init_RtObject(obj->type);
+    if (!cpy)
+        MallocError();
+
+    // recorded before its contents are copied, so that objects containing themselves are copied once
+    if (copies)
+        GenericHashMap_insert(copies, (void *)obj, cpy, false);
+
+    switch (obj->type)
     {
-        target->data.Func = new_value->data.Func;
+    case NUMBER_TYPE:
+        cpy->data.Number = init_RtNumber(obj->data.Number->number);
+        break;
+
+    case STRING_TYPE:
+        cpy->data.String = init_RtString_len(rtstr_data(obj->data.String), obj->data.String->length);
+        break;
+
+    case RANGE_TYPE:
+        cpy->data.Range = init_RtRange(obj->data.Range->start, obj->data.Range->end, obj->data.Range->step);
+        break;
+
+    case NULL_TYPE:
+    case UNDEFINED_TYPE:
+        break;
+
+    case FUNCTION_TYPE:
+        cpy->data.Func = isolated_func_cpy(obj->data.Func, copies);
         break;
-    }
 
     case LIST_TYPE:
-    {
-        target->data.List = new_value->data.List;
+        cpy->data.List = isolated_list_cpy(obj->data.List, copies);
         break;
-    }
 
     case HASHMAP_TYPE:
-    {
-        target->data.Map = new_value->data.Map;
+        cpy->data.Map = init_RtMap(obj->data.Map->size);
+        if (cpy->data.Map)
+            isolated_map_cpy(cpy->data.Map, obj->data.Map, copies);
         break;
-    }
 
     case HASHSET_TYPE:
     {
-        target->data.Set = new_value->data.Set;
+        cpy->data.Set = init_RtSet(obj->data.Set->size);
+        if (!cpy->data.Set)
+            break;
+
+        size_t cursor = 0;
+        RtObject *element;
+        while (rtset_iterate(obj->data.Set, &cursor, &element))
+            rtset_insert(cpy->data.Set, isolated_cpy_ref(element, copies));
         break;
     }
 
     case CLASS_TYPE:
-    {
-        target->data.Class = new_value->data.Class;
+        cpy->data.Class = init_RtClass(obj->data.Class->classname);
+        if (!cpy->data.Class)
+            break;
+
+        cpy->data.Class->body = obj->data.Class->body;
+        isolated_map_cpy(cpy->data.Class->attrs_table, obj->data.Class->attrs_table, copies);
         break;
-    }
+
     case EXCEPTION_TYPE:
+        cpy->data.Exception = rtexception_cpy(obj->data.Exception);
+        break;
+    }
+
+    if (!rtobj_getdata(cpy))
+        MallocError();
+
+    return cpy;
+}
+
+/**
+ * DESCRIPTION:
+ * Creates a deep copy of a Runtime Object that shares nothing with it, not even the payloads of strings (unlike rtobj_deep_cpy).
+ * The copy can be handed to another runtime, running on another thread with its own heap (see rtparallel.c)
+ *
+ * NOTE:
+ * obj is only read, several threads can copy it at once as long as the thread owning it does not run in the meantime.
+ * Objects contained by the copy are added to the GC registry of the calling thread, the copy itself is not
+ */
+RtObject *rtobj_isolated_cpy(const RtObject *obj)
+{
+    // objects that cannot contain other objects are copied without keeping track of the copies
+    switch (obj->type)
     {
-        target->data.Exception = new_value->data.Exception;
+    case FUNCTION_TYPE:
+    case LIST_TYPE:
+    case HASHMAP_TYPE:
+    case HASHSET_TYPE:
+    case CLASS_TYPE:
         break;
+    default:
+        return isolated_cpy(obj, NULL);
     }
+
+    GenericMap *copies = init_GenericMap(
+        (unsigned int (*)(const void *))hash_pointer,
+        (bool (*)(const void *, const void *))ptr_equal,
+        NULL,
+        NULL);
+    if (!copies)
+        MallocError();
+
+    RtObject *cpy = isolated_cpy(obj, copies);
+    free_GenericMap(copies, false, false);
+    return cpy;
+}
+
+/**
+ * DESCRIPTION:
+ * Appends an isolated copy (see rtobj_isolated_cpy) of the element at index of src to dest,
+ * elements of unboxed lists are copied without creating an object for them in the heap of src
+ *
+ * NOTE:
+ * The copy is added to the GC registry of the calling thread
+ */
+void rtobj_append_isolated_cpy(RtList *dest, const RtList *src, size_t index)
+{
+    assert(index < src->length);
+    append_isolated_element(dest, src, index, NULL);
+}
+
+/**
+ * DESCRIPTION:
+ * Performs a mutation on the target, with the new value
+ *
+ * PARAMS:
+ * new_val_disposable: wether new_value data is disposable (i.e. will be freed after use)
+ *
+ * NOTE:
+ * target becomes an owner of new_value's payload (or of a copy for numbers), and stops owning its old payload
+ */
+RtObject *rtobj_mutate(RtObject *target, const RtObject *new_value, bool new_val_disposable)
+{
+    assert(target && new_value);
+
+    if (target == new_value)
+    {
+        return target;
+    }
+
+    // target gives up ownership of its current payload
+    // the caller is responsible for keeping another owner alive if the payload is still referenced
+    RtGCHeader *old_header = rtgcheader(rtobj_getdata(target));
+    assert(old_header->owners > 0);
+    old_header->owners--;
+
+    // numbers are values, a new copy is created each time unless new value is disposable
+    if (new_value->type == NUMBER_TYPE && !new_val_disposable)
+    {
+        target->data.Number = init_RtNumber(new_value->data.Number->number);
+    }
+    else
+    {
+        target->data = new_value->data;
+        rtgcheader(rtobj_getdata(target))->owners++;
     }
 
     target->type = new_value->type;
@@ -1497,12 +1777,39 @@ RtObject *rtobj_mutate(RtObject *target, const RtObject *new_value, bool new_val
     return target;
 }
 
+/**
+ * DESCRIPTION:
+ * Helper for indexing a list, checks that index is a number within the bounds of the list
+ * If it is not, an intermediate exception is set and false is returned
+ */
+static bool rtlist_index_valid(const RtObject *obj, const RtObject *index)
+{
+    // Index must be a number type
+    if (index->type != NUMBER_TYPE)
+    {
+        setIntermediateException(init_InvalidIndexTypeException(index, obj, "Number"));
+        return false;
+    }
+
+    long i = (long)index->data.Number->number;
+
+    // Index out of bounds
+    if ((size_t)i >= obj->data.List->length)
+    {
+        setIntermediateException(init_IndexOutOfBoundsException(obj, i, obj->data.List->length));
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * DESCRIPTION:
  * Takes index from element. The latter can be a list, set, map, etc..
  *
  * NOTE:
  * IF a runtime exception occurs during this function, it returns NULL, and the current raisedException is set to the relevant RtException struct
+ * The elements of unboxed lists are returned as new objects, which the caller is responsible for (see rtlist_get)
  *
  * PARAMS:
  * obj: object to index from
@@ -1521,6 +1828,7 @@ RtObject *rtobj_getindex(const RtObject *obj, const RtObject *index)
     case FUNCTION_TYPE:
     case EXCEPTION_TYPE:
     case CLASS_TYPE:
+    case RANGE_TYPE:
     {
         // cannot take index of these types
         setIntermediateException(init_NonIndexibleObjectException(obj));
@@ -1529,23 +1837,10 @@ RtObject *rtobj_getindex(const RtObject *obj, const RtObject *index)
 
     case LIST_TYPE:
     {
-        // Index must be a number type
-        if (index->type != NUMBER_TYPE)
-        {
-            setIntermediateException(init_InvalidIndexTypeException(index, obj, "Number"));
-            return NULL;
-        }
-
-        long i = (long)index->data.Number->number;
-
-        // Index out of bounds
-        if ((size_t)i >= obj->data.List->length)
-        {
-            setIntermediateException(init_IndexOutOfBoundsException(obj, i, obj->data.List->length));
+        if (!rtlist_index_valid(obj, index))
             return NULL;
-        }
 
-        return rtlist_get(obj->data.List, i);
+        return rtlist_get(obj->data.List, (long)index->data.Number->number);
     }
 
     case HASHMAP_TYPE:
@@ -1576,6 +1871,204 @@ RtObject *rtobj_getindex(const RtObject *obj, const RtObject *index)
     }
 }
 
+/**
+ * DESCRIPTION:
+ * Replaces the element at an index of a list by value, i.e obj[index] = value
+ * The list takes a reference on value, which must be in the GC registry
+ *
+ * NOTE:
+ * Only lists support this, the elements of other containers are mutated in place
+ * IF a runtime exception occurs during this function, it returns NULL, and the current raisedException is set to the relevant RtException struct
+ */
+RtObject *rtobj_setindex(RtObject *obj, const RtObject *index, RtObject *value)
+{
+    assert(obj && index && value);
+    assert(obj->type == LIST_TYPE);
+
+    if (!rtlist_index_valid(obj, index))
+        return NULL;
+
+    return rtlist_set(obj->data.List, (size_t)index->data.Number->number, value);
+}
+
+/**
+ * DESCRIPTION:
+ * Gets the slice [start:end] (end is exclusive) of a list or string, a Null bound stands for an omitted one, i.e a[:j] or a[i:]
+ * The slice shares the storage of obj instead of copying it (see rtlist_slice and rtstr_slice)
+ *
+ * NOTE:
+ * If the object cannot be sliced, or the bounds are invalid, an intermediate exception is set and NULL is returned
+ */
+RtObject *rtobj_getslice(RtObject *obj, const RtObject *start, const RtObject *end)
+{
+    assert(obj && start && end);
+
+    size_t length;
+    switch (obj->type)
+    {
+    case LIST_TYPE:
+        length = obj->data.List->length;
+        break;
+    case STRING_TYPE:
+        length = obj->data.String->length;
+        break;
+    default:
+        setIntermediateException(init_NonIndexibleObjectException(obj));
+        return NULL;
+    }
+
+    const RtObject *bounds[] = {start, end};
+    for (int i = 0; i < 2; i++)
+    {
+        if (bounds[i]->type != NUMBER_TYPE && bounds[i]->type != NULL_TYPE)
+        {
+            setIntermediateException(init_InvalidIndexTypeException(bounds[i], obj, "Number"));
+            return NULL;
+        }
+    }
+
+    long from = start->type == NULL_TYPE ? 0 : (long)start->data.Number->number;
+    long to = end->type == NULL_TYPE ? (long)length : (long)end->data.Number->number;
+    if (from < 0 || to < from || (size_t)to > length)
+    {
+        setIntermediateException(init_InvalidSliceException(obj, from, to, length));
+        return NULL;
+    }
+
+    RtObject *slice = init_RtObject(obj->type);
+    if (obj->type == LIST_TYPE)
+    {
+        slice->data.List = rtlist_slice(obj->data.List, from, to);
+        if (!slice->data.List)
+            MallocError();
+    }
+    else
+    {
+        slice->data.String = rtstr_slice(obj->data.String, from, to);
+        if (!slice->data.String)
+            MallocError();
+    }
+
+    return slice;
+}
+
+/**
+ * DESCRIPTION:
+ * Wether elements of the object can be iterated over (see rtobj_iterate)
+ */
+bool rtobj_iterable(const RtObject *obj)
+{
+    assert(obj);
+    switch (obj->type)
+    {
+    case LIST_TYPE:
+    case STRING_TYPE:
+    case HASHSET_TYPE:
+    case HASHMAP_TYPE:
+    case RANGE_TYPE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Gets the number of elements yielded when iterating over an iterable object
+ */
+size_t rtobj_iter_length(const RtObject *obj)
+{
+    assert(rtobj_iterable(obj));
+    switch (obj->type)
+    {
+    case LIST_TYPE:
+        return obj->data.List->length;
+    case STRING_TYPE:
+        return obj->data.String->length;
+    case HASHSET_TYPE:
+        return obj->data.Set->size;
+    case HASHMAP_TYPE:
+        return obj->data.Map->size;
+    case RANGE_TYPE:
+        return rtrange_length(obj->data.Range);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Gets the next element of an iterable object, elements are computed one at a time:
+ * - ranges yield their numbers
+ * - lists yield their elements
+ * - strings yield their characters
+ * - sets yield their elements
+ * - maps yield their keys
+ *
+ * PARAMS:
+ * obj: object to iterate over, it must not be mutated during the iteration
+ * cursor: iteration state, must be set to 0 before the first call
+ * fresh: set to wether the element is a new object, which the caller is responsible for (i.e numbers of a range, elements of unboxed lists),
+ * otherwise the element is an object stored inside of obj
+ *
+ * NOTE:
+ * Returns NULL once every element has been visited
+ */
+RtObject *rtobj_iterate(const RtObject *obj, size_t *cursor, bool *fresh)
+{
+    assert(obj && cursor && fresh);
+    size_t i = *cursor;
+    RtObject *next = NULL;
+    *fresh = true;
+
+    switch (obj->type)
+    {
+    case RANGE_TYPE:
+        if (i < rtrange_length(obj->data.Range))
+        {
+            next = init_RtObject(NUMBER_TYPE);
+            next->data.Number = init_RtNumber(rtrange_get(obj->data.Range, i));
+            *cursor = i + 1;
+        }
+        break;
+
+    case LIST_TYPE:
+        if (i < obj->data.List->length)
+        {
+            next = rtlist_get(obj->data.List, i);
+            *fresh = rtlist_unboxed(obj->data.List);
+            *cursor = i + 1;
+        }
+        break;
+
+    case STRING_TYPE:
+        if (i < obj->data.String->length)
+        {
+            next = init_RtObject(STRING_TYPE);
+            next->data.String = rtstr_slice(obj->data.String, i, i + 1);
+            *cursor = i + 1;
+        }
+        break;
+
+    case HASHSET_TYPE:
+        *fresh = false;
+        if (!rtset_iterate(obj->data.Set, cursor, &next))
+            next = NULL;
+        break;
+
+    case HASHMAP_TYPE:
+        *fresh = false;
+        if (!rtmap_iterate(obj->data.Map, cursor, &next, NULL))
+            next = NULL;
+        break;
+
+    default:
+        assert(false);
+    }
+
+    return next;
+}
+
 /**
  * DESCRIPTION:
  * Gets an object's references
@@ -1595,6 +2088,7 @@ RtObject **rtobj_getrefs(const RtObject *obj)
     case NUMBER_TYPE:
     case STRING_TYPE:
     case EXCEPTION_TYPE:
+    case RANGE_TYPE:
     {
         RtObject **tmp = malloc(sizeof(RtObject *));
         tmp[0] = NULL;
@@ -1635,33 +2129,63 @@ RtObject **rtobj_getrefs(const RtObject *obj)
 
 /**
  * DESCRIPTION:
- * Gets the objects associated type reference count
-*/
-size_t rtobj_refcount(const RtObject *obj) {
+ * Gets the number of bytes used by the payload of an object, objects referenced by the payload are not included.
+ * Used for heap snapshots
+ */
+size_t rtobj_payload_memsize(const RtObject *obj)
+{
     assert(obj);
     switch (obj->type)
     {
     case NULL_TYPE:
-        return *obj->data.GCrefcount_NULL_TYPE;
     case UNDEFINED_TYPE:
-        return *obj->data.GCrefcount_UNDEFINED_TYPE;
+        return sizeof(RtGCHeader);
+
     case NUMBER_TYPE:
-        return obj->data.Number->refcount;
+        return sizeof(RtNumber);
+
+    case RANGE_TYPE:
+        return sizeof(RtRange);
+
     case STRING_TYPE:
-        return obj->data.String->refcount;
+        return sizeof(RtString) + obj->data.String->length + 1;
+
     case LIST_TYPE:
-        return obj->data.List->refcount;
-    case FUNCTION_TYPE:
-        return obj->data.Func->refcount;
-    case CLASS_TYPE:
-        return obj->data.Class->refcount;
+        return sizeof(RtList) + obj->data.List->memsize * rtlist_itemsize(obj->data.List);
+
     case HASHMAP_TYPE:
-        return obj->data.Map->refcount;
+        return rtmap_memsize(obj->data.Map);
+
     case HASHSET_TYPE:
-        return obj->data.Set->refcount;
+        return rtset_memsize(obj->data.Set);
+
+    case CLASS_TYPE:
+        return sizeof(RtClass) + rtmap_memsize(obj->data.Class->attrs_table);
+
+    case FUNCTION_TYPE:
+    {
+        const RtFunction *func = obj->data.Func;
+        if (func->functype == REGULAR_FUNC)
+            return sizeof(RtFunction) + func->func_data.user_func.closure_count * sizeof(RtObject *);
+        return sizeof(RtFunction);
+    }
+
     case EXCEPTION_TYPE:
-        return obj->data.Exception->refcount;
+    {
+        const RtException *exc = obj->data.Exception;
+        return sizeof(RtException) + strlen(exc->ex_name) + 1 + (exc->msg ? strlen(exc->msg) + 1 : 0);
+    }
     }
+    return 0;
+}
+
+/**
+ * DESCRIPTION:
+ * Gets the objects associated type reference count
+*/
+size_t rtobj_refcount(const RtObject *obj) {
+    assert(obj);
+    return rtgcheader(rtobj_getdata(obj))->refcount;
 }
 
 /**
@@ -1672,44 +2196,9 @@ size_t rtobj_refcount(const RtObject *obj) {
 */
 size_t rtobj_increment_refcount(RtObject *obj, size_t n) {
     assert(obj);
-    size_t *refcount = NULL;
-
-    switch (obj->type)
-    {
-    case NULL_TYPE:
-        refcount = obj->data.GCrefcount_NULL_TYPE;
-        break;
-    case UNDEFINED_TYPE:
-        refcount = obj->data.GCrefcount_UNDEFINED_TYPE;
-        break;
-    case NUMBER_TYPE:
-        refcount = &obj->data.Number->refcount;
-        break;
-    case STRING_TYPE:
-        refcount = &obj->data.String->refcount;
-        break;
-    case LIST_TYPE:
-        refcount = &obj->data.List->refcount;
-        break;
-    case FUNCTION_TYPE:
-        refcount = &obj->data.Func->refcount;
-        break;
-    case CLASS_TYPE:
-        refcount = &obj->data.Class->refcount;
-        break;
-    case HASHMAP_TYPE:
-        refcount = &obj->data.Map->refcount;
-        break;
-    case HASHSET_TYPE:
-        refcount = &obj->data.Set->refcount;
-        break;
-    case EXCEPTION_TYPE:
-        refcount = &obj->data.Exception->refcount;
-        break;
-    }
-
-    *refcount += n;
-    return *refcount;
+    RtGCHeader *header = rtgcheader(rtobj_getdata(obj));
+    header->refcount += n;
+    return header->refcount;
 }
 
 /**
@@ -1720,46 +2209,10 @@ size_t rtobj_increment_refcount(RtObject *obj, size_t n) {
 */
 size_t rtobj_decrement_refcount(RtObject *obj, size_t n) {
     assert(obj);
-    size_t *refcount = NULL;
-
-    switch (obj->type)
-    {
-    case NULL_TYPE:
-        refcount = obj->data.GCrefcount_NULL_TYPE;
-        break;
-    case UNDEFINED_TYPE:
-        refcount = obj->data.GCrefcount_UNDEFINED_TYPE;
-        break;
-    case NUMBER_TYPE:
-        refcount = &obj->data.Number->refcount;
-        break;
-    case STRING_TYPE:
-        refcount = &obj->data.String->refcount;
-        break;
-    case LIST_TYPE:
-        refcount = &obj->data.List->refcount;
-        break;
-    case FUNCTION_TYPE:
-        refcount = &obj->data.Func->refcount;
-        break;
-    case CLASS_TYPE:
-        refcount = &obj->data.Class->refcount;
-        break;
-    case HASHMAP_TYPE:
-        refcount = &obj->data.Map->refcount;
-        break;
-    case HASHSET_TYPE:
-        refcount = &obj->data.Set->refcount;
-        break;
-    case EXCEPTION_TYPE:
-        refcount = &obj->data.Exception->refcount;
-        break;
-    }
-
-    assert((*refcount) >= n);
-
-    *refcount -= n;
-    return *refcount;
+    RtGCHeader *header = rtgcheader(rtobj_getdata(obj));
+    assert(header->refcount >= n);
+    header->refcount -= n;
+    return header->refcount;
 }
 
 /**
@@ -1775,9 +2228,9 @@ void *rtobj_getdata(const RtObject *obj)
     switch (obj->type)
     {
     case NULL_TYPE:
-        return obj->data.GCrefcount_NULL_TYPE;
+        return obj->data.GCheader_NULL_TYPE;
     case UNDEFINED_TYPE:
-        return obj->data.GCrefcount_UNDEFINED_TYPE;
+        return obj->data.GCheader_UNDEFINED_TYPE;
     case NUMBER_TYPE:
         return obj->data.Number;
     case STRING_TYPE:
@@ -1794,6 +2247,8 @@ void *rtobj_getdata(const RtObject *obj)
         return obj->data.Set;
     case EXCEPTION_TYPE:
         return obj->data.Exception;
+    case RANGE_TYPE:
+        return obj->data.Range;
     }
     return NULL;
 }
@@ -1815,14 +2270,17 @@ void rtobj_free_data(RtObject *obj, bool free_immutable, bool update_ref_counts)
     switch (obj->type)
     {
     case UNDEFINED_TYPE:
-        free(obj->data.GCrefcount_UNDEFINED_TYPE);
+        free(obj->data.GCheader_UNDEFINED_TYPE);
         break;
     case NULL_TYPE:
-        free(obj->data.GCrefcount_NULL_TYPE);
+        free(obj->data.GCheader_NULL_TYPE);
         break;
     case NUMBER_TYPE:
         rtnum_free(obj->data.Number);
         break;
+    case RANGE_TYPE:
+        rtrange_free(obj->data.Range);
+        break;
     case STRING_TYPE:
         rtstr_free(obj->data.String);
         obj->data.String = NULL;
@@ -1870,6 +2328,7 @@ void rtobj_free_data(RtObject *obj, bool free_immutable, bool update_ref_counts)
 /**
  * DESCRIPTION:
  * Frees Runtime object, functions and objects are immutable
+ * The payload is only freed if obj is its last owner
  *
  * PARAMS:
  * free_immutable: if true, it will metadata associated with the object
@@ -1879,13 +2338,21 @@ void rtobj_free(RtObject *obj, bool free_immutable, bool update_ref_counts)
 {
     if (!obj)
         return;
-    rtobj_free_data(obj, free_immutable, update_ref_counts);
+
+    RtGCHeader *header = rtgcheader(rtobj_getdata(obj));
+    assert(header->owners > 0);
+    if (--header->owners == 0)
+        rtobj_free_data(obj, free_immutable, update_ref_counts);
+
     free(obj);
 }
 
 /**
  * DESCRIPTION:
  * Frees rt object without freeing any object data
+ *
+ * NOTE:
+ * Payload MUST have another owner, otherwise it would be lost
  */
 
 void rtobj_shallow_free(RtObject *obj)
@@ -1894,6 +2361,10 @@ void rtobj_shallow_free(RtObject *obj)
     {
         return;
     }
+
+    RtGCHeader *header = rtgcheader(rtobj_getdata(obj));
+    assert(header->owners > 1);
+    header->owners--;
     free(obj);
 }
 
@@ -1922,7 +2393,7 @@ void rtobj_deconstruct(RtObject *obj, int offset)
         printf(" %Lf \n", obj->data.Number->number);
         break;
     case STRING_TYPE:
-        printf(" \"%s\" \n", obj->data.String->string);
+        printf(" \"%s\" \n", rtstr_chars(obj->data.String));
         break;
     case FUNCTION_TYPE:
     {
@@ -2002,4 +2473,4 @@ void rtobj_deconstruct(RtObject *obj, int offset)
     default:
         break;
     }
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
 #include "rttype.h"
+#include "gcheader.h"
 #include "../rtlib/builtinfuncs.h"
 #include "rtexception.h"
 #include "rtlists.h"
@@ -10,6 +12,7 @@
 #include "rtclass.h"
 #include "rtstring.h"
 #include "rtnumber.h"
+#include "rtrange.h"
 
 // Forward declaration
 typedef struct RtObject RtObject;
@@ -29,9 +32,9 @@ typedef struct RtObject
 
     union
     {
-        size_t *GCrefcount_NULL_TYPE;
+        RtGCHeader *GCheader_NULL_TYPE;
 
-        size_t *GCrefcount_UNDEFINED_TYPE;
+        RtGCHeader *GCheader_UNDEFINED_TYPE;
 
         RtNumber *Number;
 
@@ -48,12 +51,15 @@ typedef struct RtObject
         RtSet *Set;
 
         RtException *Exception;
+
+        RtRange *Range;
     } data;
 } RtObject;
 
 RtObject *init_RtObject(RtType type);
 
 RtObject *rtobj_rt_preprocess(RtObject *obj, bool disposable, bool add_to_GC);
+RtObject *rtobj_key_cpy(RtObject *key);
 
 char *rtobj_toString(const RtObject *obj);
 RtObject *multiply_objs(RtObject *obj1, RtObject *obj2);
@@ -83,19 +89,29 @@ long double rtobj_compare(const RtObject *obj1, const RtObject *obj2);
 
 void rtobj_print(const RtObject *obj);
 
-unsigned int rtobj_hash(const RtObject *obj);
+uint64_t rtobj_hash(const RtObject *obj);
 unsigned int rtobj_hash_data_ptr(const RtObject *obj);
 bool rtobj_shallow_equal(const RtObject *obj1, const RtObject *obj2);
 bool rtobj_equal(const RtObject *obj1, const RtObject *obj2);
 
 RtObject *rtobj_shallow_cpy(const RtObject *obj);
 RtObject *rtobj_deep_cpy(const RtObject *obj, bool add_to_gc);
+RtObject *rtobj_isolated_cpy(const RtObject *obj);
+void rtobj_append_isolated_cpy(RtList *dest, const RtList *src, size_t index);
+RtObject *rtobj_cow_cpy(RtObject *obj);
+RtObject *rtobj_unshare(RtObject *obj);
 
 RtObject *rtobj_mutate(RtObject *target, const RtObject *new_value, bool new_val_disposable);
 RtObject *rtobj_getindex(const RtObject *obj, const RtObject *index);
+RtObject *rtobj_setindex(RtObject *obj, const RtObject *index, RtObject *value);
+RtObject *rtobj_getslice(RtObject *obj, const RtObject *start, const RtObject *end);
+bool rtobj_iterable(const RtObject *obj);
+size_t rtobj_iter_length(const RtObject *obj);
+RtObject *rtobj_iterate(const RtObject *obj, size_t *cursor, bool *fresh);
 
 RtObject **rtobj_getrefs(const RtObject *obj);
 void *rtobj_getdata(const RtObject *obj);
+size_t rtobj_payload_memsize(const RtObject *obj);
 
 size_t rtobj_refcount(const RtObject *obj);
 size_t rtobj_increment_refcount(RtObject *obj, size_t n);
@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include "rtparallel.h"
+#include "runtime.h"
+#include "gc.h"
+#include "rtexchandler.h"
+#include "../generics/workpool.h"
+#include "../generics/utilities.h"
+
+/**
+ * DESCRIPTION:
+ * This file contains the implementation of data parallel function calls, see rtparallel.h
+ */
+
+/**
+ * DESCRIPTION:
+ * Where the result of a call is, the results of a worker are appended to a list of its heap as they come
+ */
+typedef struct ParallelResult
+{
+    unsigned int worker;
+    size_t position;
+} ParallelResult;
+
+/**
+ * DESCRIPTION:
+ * State shared by the caller and the workers of a parallel call
+ *
+ * func, inputs: objects of the heap of the caller, only read by the workers while the caller waits
+ * results: where the result of each call is
+ * finished: number of workers done calling the function
+ * merged: set once the caller copied the results, workers can then free their heap
+ * exception: exception raised by the call with the lowest index, at exception_index
+ */
+typedef struct ParallelJob
+{
+    const RtObject *func;
+    RtObject **inputs;
+    size_t length;
+    ParallelResult *results;
+    WorkPool *pool;
+
+    // top level call frame and GC policy of the runtimes of the workers
+    ByteCodeList *code;
+    const char *filename;
+    const GCPolicy *policy;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned int finished;
+    bool merged;
+    RtException *exception;
+    size_t exception_index;
+} ParallelJob;
+
+typedef struct ParallelWorker
+{
+    ParallelJob *job;
+    unsigned int id;
+    pthread_t thread;
+
+    // list of the results of the calls run by the worker, in its own heap
+    RtObject *results;
+} ParallelWorker;
+
+/**
+ * DESCRIPTION:
+ * Returns the number of workers used when none is given, either PARALLEL_WORKERS_ENV or the number of online cores
+ */
+unsigned int parallel_default_workers()
+{
+    long workers = 0;
+    const char *env = getenv(PARALLEL_WORKERS_ENV);
+    if (env && env[0] != '\0')
+        workers = strtol(env, NULL, 10);
+
+    if (workers <= 0)
+        workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (workers <= 0)
+        return 1;
+
+    return workers > PARALLEL_MAX_WORKERS ? PARALLEL_MAX_WORKERS : (unsigned int)workers;
+}
+
+/**
+ * DESCRIPTION:
+ * Records an exception raised by the call at index, only the one with the lowest index is kept.
+ * Calls after index are dropped, calls before it still run, one of them may raise an exception with a lower index
+ */
+static void report_exception(ParallelJob *job, size_t index, RtException *exception)
+{
+    pthread_mutex_lock(&job->lock);
+    if (!job->exception || index < job->exception_index)
+    {
+        rtexception_free(job->exception);
+        job->exception = exception;
+        job->exception_index = index;
+    }
+    else
+    {
+        rtexception_free(exception);
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    WorkPool_truncate(job->pool, index);
+}
+
+/**
+ * DESCRIPTION:
+ * Runs the call at index on the runtime of the calling worker, an exception it raises is reported to the job
+ *
+ * PARAMS:
+ * func: copy of the function in the heap of the worker
+ */
+static void run_call(ParallelWorker *worker, RtObject *func, size_t index)
+{
+    ParallelJob *job = worker->job;
+    RtObject *arg;
+    if (job->inputs)
+    {
+        arg = rtobj_isolated_cpy(job->inputs[index]);
+    }
+    else
+    {
+        arg = init_RtObject(NUMBER_TYPE);
+        arg->data.Number = init_RtNumber(index);
+        if (!arg->data.Number)
+            MallocError();
+    }
+
+    RtObject *result = rt_call(func, &arg, 1);
+    if (!result)
+    {
+        RtException *exception = Intermediate_raisedException;
+        Intermediate_raisedException = NULL;
+        report_exception(job, index, exception);
+        return;
+    }
+
+    // results must live until the caller copied them, numbers and strings are then stored unboxed,
+    // which keeps the heap of the worker small, since every collection goes through all of it
+    RtList *results = worker->results->data.List;
+    rtlist_append(results, result);
+    job->results[index].worker = worker->id;
+    job->results[index].position = results->length - 1;
+}
+
+/**
+ * DESCRIPTION:
+ * Entry point of the threads of the workers
+ */
+static void *run_worker(void *arg)
+{
+    ParallelWorker *worker = arg;
+    ParallelJob *job = worker->job;
+
+    bool ready = prep_isolated_runtime_env(job->code, job->filename, job->policy);
+    if (ready)
+    {
+        RtObject *func = add_to_GC_registry(rtobj_isolated_cpy(job->func));
+        rtobj_refcount_increment1(func);
+
+        worker->results = init_RtObject(LIST_TYPE);
+        worker->results->data.List = newDefaultList();
+        if (!worker->results->data.List)
+            MallocError();
+
+        add_to_GC_registry(worker->results);
+        rtobj_refcount_increment1(worker->results);
+
+        // a worker keeps going once a call raised, the calls before it must still run (see report_exception)
+        size_t begin, end;
+        while (WorkPool_next(job->pool, worker->id, &begin, &end))
+        {
+            for (size_t i = begin; i < end && i < WorkPool_limit(job->pool); i++)
+                run_call(worker, func, i);
+        }
+    }
+    else
+    {
+        report_exception(job, 0, OutOfMemoryException("Failed to set up the runtime of a parallel worker"));
+    }
+
+    // the results belong to the heap of the worker, it is only freed once the caller copied them
+    pthread_mutex_lock(&job->lock);
+    job->finished++;
+    pthread_cond_broadcast(&job->cond);
+    while (!job->merged)
+        pthread_cond_wait(&job->cond, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+
+    if (ready)
+        perform_isolated_runtime_cleanup();
+
+    return NULL;
+}
+
+/**
+ * DESCRIPTION:
+ * Starts the threads of the workers, returns how many could be started.
+ * Workers block every signal, signals are handled by the main thread
+ */
+static unsigned int start_workers(ParallelWorker *workers, unsigned int count)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, PARALLEL_WORKER_STACK_SIZE);
+
+    sigset_t blocked, previous;
+    sigfillset(&blocked);
+    pthread_sigmask(SIG_SETMASK, &blocked, &previous);
+
+    unsigned int started = 0;
+    while (started < count && pthread_create(&workers[started].thread, &attr, run_worker, &workers[started]) == 0)
+        started++;
+
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    pthread_attr_destroy(&attr);
+    return started;
+}
+
+/**
+ * DESCRIPTION:
+ * Calls func on every input in parallel, and returns the list of the results, in the same order as the inputs.
+ * Returns NULL if a call raised an exception, Intermediate_raisedException is then set to the exception raised by the call with the lowest index,
+ * every call before it is run to find it, so it is the exception a sequential loop over the calls would raise
+ *
+ * PARAMS:
+ * func: function to call, it is called with a single argument
+ * inputs: arguments of the calls, if NULL func is called with every index in [0, length) instead
+ * length: number of calls
+ * workers: number of threads running the calls, at most one per call is started
+ *
+ * NOTE:
+ * The returned list is not in the GC registry, its elements are
+ */
+RtObject *parallel_call(const RtObject *func, RtObject **inputs, size_t length, unsigned int workers)
+{
+    assert(workers > 0);
+
+    RtObject *list = init_RtObject(LIST_TYPE);
+    list->data.List = init_RtList(length + 1);
+    if (!list->data.List)
+        MallocError();
+
+    if (length == 0)
+        return list;
+
+    if (workers > length)
+        workers = length;
+
+    // the seed is picked lazily, it must be set before workers hash anything
+    init_hash_seed();
+
+    CallFrame *frame = getCurrentStackFrame();
+    ParallelJob job = {
+        .func = func,
+        .inputs = inputs,
+        .length = length,
+        .results = malloc(sizeof(ParallelResult) * length),
+        .pool = init_WorkPool(length, workers),
+        .code = frame->pg,
+        .filename = frame->code_file_location,
+        .policy = get_GC_policy(),
+        .finished = 0,
+        .merged = false,
+        .exception = NULL,
+        .exception_index = 0};
+
+    ParallelWorker *pool_workers = malloc(sizeof(ParallelWorker) * workers);
+    if (!job.results || !job.pool || !pool_workers)
+        MallocError();
+
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        pool_workers[i].job = &job;
+        pool_workers[i].id = i;
+        pool_workers[i].results = NULL;
+    }
+
+    // the indices of workers that could not be started are stolen by the others
+    unsigned int started = start_workers(pool_workers, workers);
+
+    pthread_mutex_lock(&job.lock);
+    while (job.finished < started)
+        pthread_cond_wait(&job.cond, &job.lock);
+
+    if (started == 0)
+        job.exception = OutOfMemoryException("Failed to start the threads of parallel workers");
+
+    // workers wait for the results to be copied before freeing their heap
+    if (!job.exception)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            const ParallelResult *result = &job.results[i];
+            rtobj_append_isolated_cpy(list->data.List, pool_workers[result->worker].results->data.List, result->position);
+        }
+    }
+
+    job.merged = true;
+    pthread_cond_broadcast(&job.cond);
+    pthread_mutex_unlock(&job.lock);
+
+    for (unsigned int i = 0; i < started; i++)
+        pthread_join(pool_workers[i].thread, NULL);
+
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+    free_WorkPool(job.pool);
+    free(job.results);
+    free(pool_workers);
+
+    if (job.exception)
+    {
+        rtobj_free(list, false, true);
+        setIntermediateException(job.exception);
+        return NULL;
+    }
+
+    return list;
+}
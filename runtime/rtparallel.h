@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include "rtobjects.h"
+
+/**
+ * Data parallel calls of functions, used by the parallel_map and parallel_for built in functions
+ *
+ * Each worker is a thread running its own isolated runtime with its own heap (see prep_isolated_runtime_env):
+ * - the function and its arguments are copied into the heap of the worker (see rtobj_isolated_cpy), the caller waits in the meantime
+ * - calls are distributed between the workers by a work stealing pool (see generics/workpool.h)
+ * - once every call returned, the caller copies the results into its own heap, then the heaps of the workers are freed
+ *
+ * The function should be pure, mutations of its closures or of its arguments are only made to the copies of the worker running the call,
+ * and file built in functions must not be used by it
+ */
+
+// Number of workers used when none is given, defaults to the number of online cores
+#define PARALLEL_WORKERS_ENV "TLANG_PARALLEL_WORKERS"
+
+#define PARALLEL_MAX_WORKERS 256
+
+// Functions called from native code are run by nested dispatch loops, so workers get as much stack as the main thread
+#define PARALLEL_WORKER_STACK_SIZE (8 * 1024 * 1024)
+
+unsigned int parallel_default_workers();
+RtObject *parallel_call(const RtObject *func, RtObject **inputs, size_t length, unsigned int workers);
@@ -0,0 +1,76 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+#include "rtrange.h"
+#include "../generics/utilities.h"
+
+/**
+ * DESCRIPTION:
+ * Initializes rt range struct
+ *
+ * NOTE:
+ * step must not be 0
+ */
+RtRange *init_RtRange(long double start, long double end, long double step)
+{
+    assert(step != 0);
+    RtRange *range = malloc(sizeof(RtRange));
+    if (!range)
+        MallocError();
+    range->start = start;
+    range->end = end;
+    range->step = step;
+    init_RtGCHeader(&range->gc);
+    return range;
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the number of values yielded by the range
+ */
+size_t rtrange_length(const RtRange *range)
+{
+    assert(range);
+    long double span = range->end - range->start;
+    if ((range->step > 0 && span <= 0) || (range->step < 0 && span >= 0))
+        return 0;
+    return (size_t)ceill(span / range->step);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the value at index in the range, index must be smaller than the length of the range
+ */
+long double rtrange_get(const RtRange *range, size_t index)
+{
+    assert(range);
+    return range->start + (long double)index * range->step;
+}
+
+/**
+ * DESCRIPTION:
+ * Two ranges are equal if they yield the same values
+ */
+bool rtrange_equal(const RtRange *range1, const RtRange *range2)
+{
+    assert(range1 && range2);
+    size_t length = rtrange_length(range1);
+    if (length != rtrange_length(range2))
+        return false;
+    if (length == 0)
+        return true;
+    return range1->start == range2->start && (length == 1 || range1->step == range2->step);
+}
+
+/**
+ * DESCRIPTION:
+ * Converts rt range to string, in the form range(start, end, step)
+ */
+char *rtrange_toString(const RtRange *range)
+{
+    assert(range);
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "range(%Lg, %Lg, %Lg)", range->start, range->end, range->step);
+    return cpy_string(buffer);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include "gcheader.h"
+
+/**
+ * Lazy arithmetic sequence returned by range(), values are computed on demand rather than stored
+ * Ranges are immutable, they are treated like primitives (copied when assigned)
+ */
+typedef struct RtRange
+{
+    RtGCHeader gc;
+    long double start;
+    long double end;
+    long double step;
+} RtRange;
+
+#define rtrange_free(range) free(range);
+
+RtRange *init_RtRange(long double start, long double end, long double step);
+size_t rtrange_length(const RtRange *range);
+long double rtrange_get(const RtRange *range, size_t index);
+bool rtrange_equal(const RtRange *range1, const RtRange *range2);
+char *rtrange_toString(const RtRange *range);
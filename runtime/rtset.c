@@ -1,69 +1,75 @@
 #include <assert.h>
+#include <string.h>
 #include "../generics/utilities.h"
 #include "rtobjects.h"
 #include "rtset.h"
 #include "gc.h"
+#include "cow.h"
+#include "ctrlbytes.h"
 
 /**
  * DESCRIPTION:
  * This file contains runtime set implementation
+ *
+ * Sets are open addressing hash tables with the same SwissTable layout as maps (see ctrlbytes.h),
+ * each slot also stores the hash of its element, which makes rehashing and set algebra cheaper
  */
 
-typedef struct SetNode SetNode;
-
-typedef struct SetNode
+typedef struct SetSlot
 {
+    uint64_t hash; // hash of obj, so the table can be rehashed and probed without calling rtobj_hash again
     RtObject *obj;
-    SetNode *next;
-} SetNode;
-
-#define GetIndexedHash(set, obj) rtobj_hash(obj) % set->bucket_size;
+} SetSlot;
 
 #define DOWNSIZING_THRESHOLD 64
-#define DEFAULT_SET_BUCKETS 16
+#define DEFAULT_SET_CAPACITY 16
+
+// A table is rehashed when full slots + tombstones exceed 7/8 of its capacity
+#define max_load(capacity) ((capacity) - (capacity) / 8)
+
+#define group_count(set) ((set)->capacity / CTRL_GROUP_SIZE)
 
 /**
  * DESCRIPTION:
- * Helper for creating a Set chaining node with RtObject
+ * Smallest valid capacity (power of 2, at least one group) that holds size elements without exceeding the max load
  */
-static SetNode *init_SetNode(RtObject *obj)
+static size_t capacity_for(size_t size)
 {
-    SetNode *node = malloc(sizeof(SetNode));
-    if (!node)
-    {
-        MallocError();
-        return NULL;
-    }
-    node->obj = obj;
-    node->next = NULL;
-    return node;
+    size_t capacity = DEFAULT_SET_CAPACITY;
+    while (max_load(capacity) < size)
+        capacity *= 2;
+    return capacity;
 }
 
 /**
  * DESCRIPTION:
- * Frees Set node
+ * Allocates the control bytes and slots of a set with the given capacity, every slot is EMPTY
  *
- * PARAMS:
- * node: Map Node to free
- * free_val: wether the associated object should be freed
- * update_ref_counts: wether references counts should be updated
+ * NOTE:
+ * Returns false if malloc fails
  */
-static void free_SetNode(SetNode *node, bool free_val, bool free_immutable, bool update_ref_counts)
+static bool alloc_table(RtSet *set, size_t capacity)
 {
-    if (!node)
-        return;
-
-    if (free_val)
-        rtobj_free(node->obj, free_immutable, update_ref_counts);
+    set->ctrl = malloc(sizeof(int8_t) * capacity);
+    set->slots = malloc(sizeof(SetSlot) * capacity);
+    if (!set->ctrl || !set->slots)
+    {
+        free(set->ctrl);
+        free(set->slots);
+        return false;
+    }
 
-    free(node);
+    ctrl_reset(set->ctrl, capacity);
+    set->capacity = capacity;
+    set->tombstones = 0;
+    return true;
 }
 
 /**
  * DESCRIPTION:
- * Initializes set
+ * Initializes a set able to hold initial_size elements before growing
  */
-RtSet *init_RtSet(size_t max_buckets)
+RtSet *init_RtSet(size_t initial_size)
 {
     RtSet *set = malloc(sizeof(RtSet));
     if (!set) {
@@ -71,9 +77,7 @@ RtSet *init_RtSet(size_t max_buckets)
         return NULL;
     }
 
-    set->bucket_size = max_buckets > DEFAULT_SET_BUCKETS ? max_buckets : DEFAULT_SET_BUCKETS;
-    set->buckets = calloc(set->bucket_size, sizeof(SetNode *));
-    if (!set->buckets)
+    if (!alloc_table(set, capacity_for(initial_size)))
     {
         free(set);
         MallocError();
@@ -81,167 +85,202 @@ RtSet *init_RtSet(size_t max_buckets)
     }
 
     set->size = 0;
-    set->refcount = 0;
+    set->cow_shares = NULL;
+    init_RtGCHeader(&set->gc);
     return set;
 }
 
 /**
  * DESCRIPTION:
- * Helper for resizing the number of buckets by factor of 2 when the size of the set gets too big compared to the max buckets
+ * Finds the slot holding obj, returns -1 if obj is not in the set
  *
- * NOTE:
- * This function returns the modified input set, it will return NULL, if malloc fails
  * PARAMS:
- * set: set to be reisized
- * fact
+ * set: set
+ * obj: object to find
+ * hash: hash of obj (rtobj_hash)
+ * free_slot: if not NULL and obj is not found, set to the first EMPTY or DELETED slot of the probe sequence,
+ * where obj would be inserted, so inserting does not need a second probe
  */
-static RtSet *rtset_resize(RtSet *set)
+static long find_slot(const RtSet *set, const RtObject *obj, uint64_t hash, size_t *free_slot)
 {
-    assert(set);
-    SetNode **resized = calloc(set->bucket_size * 2, sizeof(SetNode *));
-    if (!resized)
-        return NULL;
+    const size_t group_mask = group_count(set) - 1;
+    const int8_t tag = ctrl_h2(hash);
+    size_t group = ctrl_h1(hash) & group_mask;
+    bool free_found = false;
 
-    size_t old_bucket_size = set->bucket_size;
-    set->bucket_size *= 2;
-    for (size_t i = 0; i < old_bucket_size; i++)
+    for (size_t probe = 1; probe <= group_count(set); probe++)
     {
-        if (!set->buckets[i])
-            continue;
+        const int8_t *ctrl = set->ctrl + group * CTRL_GROUP_SIZE;
 
-        SetNode *ptr = set->buckets[i];
-        while (ptr)
+        for (uint32_t match = ctrl_group_match(ctrl, tag); match; match &= match - 1)
         {
-            SetNode *tmp = ptr->next;
-            unsigned int index = GetIndexedHash(set, ptr->obj);
-            if (!resized[index])
-            {
-                ptr->next = NULL;
-                resized[index] = ptr;
-            }
-            else
+            size_t index = group * CTRL_GROUP_SIZE + ctrl_mask_first(match);
+
+            // full hashes are compared first, rtobj_equal is only called on likely matches
+            if (set->slots[index].hash == hash && rtobj_equal(set->slots[index].obj, obj))
+                return (long)index;
+        }
+
+        if (free_slot && !free_found)
+        {
+            uint32_t match = ctrl_group_match_free(ctrl);
+            if (match)
             {
-                ptr->next = resized[index];
-                resized[index] = ptr;
+                *free_slot = group * CTRL_GROUP_SIZE + ctrl_mask_first(match);
+                free_found = true;
             }
-
-            ptr = tmp;
         }
+
+        if (ctrl_group_match_empty(ctrl))
+            return -1;
+
+        group = (group + probe) & group_mask;
     }
 
-    free(set->buckets);
-    set->buckets = resized;
-    return set;
+    return -1;
 }
 
 /**
  * DESCRIPTION:
- * Helper for downsizing the number of buckets when the size of the set is too small compared to the number of buckets
- *
- * NOTE:
- * This function returns the original set
- *
- * PARAMS:
- * set: set to be downsized
+ * Finds the first EMPTY or DELETED slot on the probe sequence of a hash, the table must not be full
  */
-static RtSet *rtset_downsize(RtSet *set)
+static size_t find_free_slot(const RtSet *set, uint64_t hash)
 {
-    assert(set);
-    SetNode **resized = calloc(set->bucket_size / 2, sizeof(SetNode *));
-    if (!resized)
-        return NULL;
+    const size_t group_mask = group_count(set) - 1;
+    size_t group = ctrl_h1(hash) & group_mask;
 
-    size_t old_bucket_size = set->bucket_size;
-    set->bucket_size /= 2;
-    for (size_t i = 0; i < old_bucket_size; i++)
+    for (size_t probe = 1;; probe++)
     {
-        if (!set->buckets[i])
-            continue;
+        uint32_t match = ctrl_group_match_free(set->ctrl + group * CTRL_GROUP_SIZE);
+        if (match)
+            return group * CTRL_GROUP_SIZE + ctrl_mask_first(match);
 
-        SetNode *ptr = set->buckets[i];
-        while (ptr)
-        {
-            SetNode *tmp = ptr->next;
-            unsigned int index = GetIndexedHash(set, ptr->obj);
-            if (!resized[index])
-            {
-                ptr->next = NULL;
-                resized[index] = ptr;
-            }
-            else
-            {
-                ptr->next = resized[index];
-                resized[index] = ptr;
-            }
-
-            ptr = tmp;
-        }
+        group = (group + probe) & group_mask;
     }
-
-    free(set->buckets);
-    set->buckets = resized;
-    return set;
 }
 
-
 /**
  * DESCRIPTION:
- * Inserts a object into a runtime set
+ * Moves every element of the set into a new table with the given capacity, tombstones are dropped
  *
- * Buckets will be resized if:
- * size = # of buckets + # of buckets / 2
  * NOTE:
- * If a duplicate is found, then that node is replaced with our new info, no new Set Node is created.
+ * This function returns the modified input set, it will return NULL, if malloc fails
  */
-RtObject *rtset_insert(RtSet *set, RtObject *val)
+static RtSet *rtset_rehash(RtSet *set, size_t capacity)
 {
-    assert(set);
-    assert(val);
-
-    unsigned int index = GetIndexedHash(set, val);
+    assert(set && capacity >= set->size);
+    int8_t *old_ctrl = set->ctrl;
+    SetSlot *old_slots = set->slots;
+    size_t old_capacity = set->capacity;
 
-    // if chain is empty
-    if (!set->buckets[index])
+    if (!alloc_table(set, capacity))
     {
-        set->buckets[index] = init_SetNode(val);
-        set->size++;
-        rtobj_refcount_increment1(val); 
-        return val;
+        set->ctrl = old_ctrl;
+        set->slots = old_slots;
+        return NULL;
     }
 
-    SetNode *ptr = set->buckets[index];
-
-    while (ptr)
+    for (size_t i = 0; i < old_capacity; i++)
     {
-        // replaces key/val pair in place
-        if (rtobj_equal(ptr->obj, val))
-        {
-            // updates reference counts correctly
-            rtobj_refcount_decrement1(ptr->obj); 
-            ptr->obj = val;
-            rtobj_refcount_increment1(val); 
-            return val;
-        }
+        if (!ctrl_is_full(old_ctrl[i]))
+            continue;
 
-        ptr = ptr->next;
+        size_t index = find_free_slot(set, old_slots[i].hash);
+        set->ctrl[index] = ctrl_h2(old_slots[i].hash);
+        set->slots[index] = old_slots[i];
     }
 
-    SetNode *node = init_SetNode(val);
-    node->next = set->buckets[index];
-    set->buckets[index] = node;
+    free(old_ctrl);
+    free(old_slots);
+    return set;
+}
+
+/**
+ * DESCRIPTION:
+ * Makes sure size elements fit in the set without a rehash
+ */
+static void rtset_reserve(RtSet *set, size_t size)
+{
+    if (size + set->tombstones <= max_load(set->capacity))
+        return;
+
+    if (!rtset_rehash(set, capacity_for(size)))
+        MallocError();
+}
+
+/**
+ * DESCRIPTION:
+ * Stores obj in a free slot of a private table, found by find_slot or find_free_slot
+ */
+static void fill_slot(RtSet *set, size_t index, RtObject *obj, uint64_t hash)
+{
+    assert(index < set->capacity && !ctrl_is_full(set->ctrl[index]));
+    if (set->ctrl[index] == CTRL_DELETED)
+        set->tombstones--;
+
+    set->ctrl[index] = ctrl_h2(hash);
+    set->slots[index] = (SetSlot){hash, obj};
     set->size++;
 
-    // updates the reference count 
-    rtobj_refcount_increment1(val);
+    // updates the reference count
+    rtobj_refcount_increment1(obj);
+}
+
+/**
+ * DESCRIPTION:
+ * Inserts obj in a private table, given its hash
+ * If a duplicate is found and replace is true, the duplicate is replaced by obj, otherwise it is kept
+ *
+ * NOTE:
+ * Returns the object that ends up in the set
+ */
+static RtObject *insert_hashed(RtSet *set, RtObject *obj, uint64_t hash, bool replace)
+{
+    size_t index = SIZE_MAX;
+    long found = find_slot(set, obj, hash, &index);
+    if (found >= 0)
+    {
+        SetSlot *slot = &set->slots[found];
+        if (!replace)
+            return slot->obj;
+
+        // updates reference counts correctly
+        rtobj_refcount_decrement1(slot->obj);
+        slot->obj = obj;
+        rtobj_refcount_increment1(obj);
+        return obj;
+    }
 
-    // Resizes buckets array if needed
-    if (set->size == (set->bucket_size + set->bucket_size / 2))
+    // the set is doubled if it is more than half full, otherwise tombstones are simply reclaimed
+    // the free slot found by the probe is stale once the table is rehashed
+    if (set->size + set->tombstones + 1 > max_load(set->capacity))
     {
-        if (!rtset_resize(set))
+        size_t capacity = set->size + 1 > set->capacity / 2 ? set->capacity * 2 : set->capacity;
+        if (!rtset_rehash(set, capacity))
             MallocError();
+        index = SIZE_MAX;
     }
 
-    return val;
+    if (index == SIZE_MAX)
+        index = find_free_slot(set, hash);
+
+    fill_slot(set, index, obj, hash);
+    return obj;
+}
+
+/**
+ * DESCRIPTION:
+ * Inserts a object into a runtime set
+ *
+ * NOTE:
+ * If a duplicate is found, then it is replaced with the new object
+ */
+RtObject *rtset_insert(RtSet *set, RtObject *val)
+{
+    assert(set);
+    assert(val);
+    rtset_unshare(set);
+    return insert_hashed(set, val, rtobj_hash(val), true);
 }
 
 /**
@@ -255,81 +294,53 @@ RtObject *rtset_insert(RtSet *set, RtObject *val)
 RtObject *rtset_get(const RtSet *set, const RtObject *obj)
 {
     assert(set && obj);
-    unsigned int index = GetIndexedHash(set, obj);
-    if (!set->buckets[index])
-        return NULL;
-
-    SetNode *ptr = set->buckets[index];
-
-    while (ptr)
-    {
-        // replaces key/val pair in place
-        if (rtobj_equal(ptr->obj, obj))
-            return ptr->obj;
-
-        ptr = ptr->next;
-    }
-
-    return NULL;
+    long found = find_slot(set, obj, rtobj_hash(obj), NULL);
+    return found >= 0 ? set->slots[found].obj : NULL;
 }
 
-
 /**
  * DESCRIPTION:
- * Removes an object from set, and returns the value in the map. 
+ * Removes an object from set, and returns the value in the set.
  * This function will return NULL if the object was not found in the set
  *
- * This function will downsize the number of buckets if:
- * size == # of buckets / 2
- *
+ * The table is downsized when it is less than 1/8 full
  */
 RtObject *rtset_remove(RtSet *set, RtObject *obj)
 {
     assert(set && obj);
-    unsigned int index = GetIndexedHash(set, obj);
+    rtset_unshare(set);
 
-    if (!set->buckets[index])
+    long found = find_slot(set, obj, rtobj_hash(obj), NULL);
+    if (found < 0)
         return NULL;
 
-    SetNode *prev = NULL;
-    SetNode *ptr = set->buckets[index];
+    RtObject *tmp = set->slots[found].obj;
 
-    while (ptr)
-    {
-        // replaces key/val pair in place
-        if (rtobj_equal(ptr->obj, obj))
-        {
-            if (!prev)
-            {
-                set->buckets[index] = ptr->next;
-            }
-            else
-            {
-                prev->next = ptr->next;
-            }
-            RtObject *tmp = ptr->obj;
-            
-            // updates reference count
-            rtobj_refcount_decrement1(tmp);
-
-            free(ptr);
-            set->size--;
+    // updates reference count
+    rtobj_refcount_decrement1(tmp);
 
-            // downsizes buckets array if needed
-            if (set->size == set->bucket_size / 2 && set->bucket_size >= DOWNSIZING_THRESHOLD)
-            {
-                if (!rtset_downsize(set))
-                    MallocError();
-            }
+    // no probe sequence goes past a group with an EMPTY slot, so a tombstone is only needed in full groups
+    const int8_t *group = set->ctrl + ((size_t)found / CTRL_GROUP_SIZE) * CTRL_GROUP_SIZE;
+    if (ctrl_group_match_empty(group))
+    {
+        set->ctrl[found] = CTRL_EMPTY;
+    }
+    else
+    {
+        set->ctrl[found] = CTRL_DELETED;
+        set->tombstones++;
+    }
+    set->size--;
 
-            return tmp;
-        }
-        prev = ptr;
-        ptr = ptr->next;
+    // downsizes table if needed
+    if (set->capacity >= DOWNSIZING_THRESHOLD && set->size < set->capacity / 8)
+    {
+        if (!rtset_rehash(set, set->capacity / 2))
+            MallocError();
     }
-    return NULL;
-}
 
+    return tmp;
+}
 
 __attribute__((warn_unused_result))
 /**
@@ -355,22 +366,41 @@ rtset_getrefs(const RtSet *set)
     }
 
     unsigned int index = 0;
-    for (size_t i = 0; i < set->bucket_size; i++)
+    for (size_t i = 0; i < set->capacity; i++)
     {
-        if (!set->buckets[i])
-            continue;
-
-        SetNode *ptr = set->buckets[i];
-        while (ptr)
-        {
-            arr[index++] = ptr->obj;
-            ptr = ptr->next;
-        }
+        if (ctrl_is_full(set->ctrl[i]))
+            arr[index++] = set->slots[i].obj;
     }
     arr[set->size] = NULL;
     return arr;
 }
 
+/**
+ * DESCRIPTION:
+ * Iterates over the elements of a set, in no particular order
+ *
+ * PARAMS:
+ * set: set
+ * cursor: iteration state, must be set to 0 before the first call
+ * obj: set to the next element
+ *
+ * NOTE:
+ * Returns false once every element has been visited, the set must not be mutated during the iteration
+ */
+bool rtset_iterate(const RtSet *set, size_t *cursor, RtObject **obj)
+{
+    assert(set && cursor && obj);
+    while (*cursor < set->capacity)
+    {
+        size_t i = (*cursor)++;
+        if (ctrl_is_full(set->ctrl[i]))
+        {
+            *obj = set->slots[i].obj;
+            return true;
+        }
+    }
+    return false;
+}
 
 /**
  * DESCRIPTION:
@@ -384,27 +414,28 @@ rtset_getrefs(const RtSet *set)
  */
 void rtset_free(RtSet *set, bool free_obj, bool free_immutable, bool update_ref_counts)
 {
-    for (size_t i = 0; i < set->bucket_size; i++)
+    // table is still used by other copies of the set
+    if (!cow_release(&set->cow_shares))
     {
-        if (!set->buckets[i])
-            continue;
+        free(set);
+        return;
+    }
 
-        SetNode *ptr = set->buckets[i];
-        while (ptr)
-        {
-            SetNode *tmp = ptr->next;
-            RtObject *obj = ptr->obj;
-            
-            if(update_ref_counts)
-                rtobj_refcount_decrement1(obj);
+    for (size_t i = 0; i < set->capacity; i++)
+    {
+        if (!ctrl_is_full(set->ctrl[i]))
+            continue;
 
-            free_SetNode(ptr, free_obj, free_immutable, update_ref_counts);
+        RtObject *obj = set->slots[i].obj;
 
+        if(update_ref_counts)
+            rtobj_refcount_decrement1(obj);
 
-            ptr = tmp;
-        }
+        if (free_obj)
+            rtobj_free(obj, free_immutable, update_ref_counts);
     }
-    free(set->buckets);
+    free(set->ctrl);
+    free(set->slots);
     free(set);
 }
 
@@ -423,27 +454,107 @@ RtSet *
 rtset_cpy(const RtSet *set, bool deepcpy, bool add_to_GC)
 {
     assert(set);
-    RtSet *cpy = init_RtSet(set->bucket_size);
+    RtSet *cpy = init_RtSet(set->size);
     if (!cpy)
         return NULL;
 
-    RtObject **refs = rtset_getrefs(set);
+    for (size_t i = 0; i < set->capacity; i++) {
+        if (!ctrl_is_full(set->ctrl[i]))
+            continue;
 
-    for (int i = 0; refs[i] != NULL; i++) {
-        RtObject *val = deepcpy ? rtobj_deep_cpy(refs[i], add_to_GC) : refs[i];
+        // a deep copy is equal to the original, so it has the same hash
+        RtObject *val = deepcpy ? rtobj_deep_cpy(set->slots[i].obj, add_to_GC) : set->slots[i].obj;
 
         // this function will update reference count
-        rtset_insert(cpy, val);
+        insert_hashed(cpy, val, set->slots[i].hash, true);
 
         if(add_to_GC)
             add_to_GC_registry(val);
     }
 
-    free(refs);
     assert(set->size == cpy->size);
     return cpy;
 }
 
+__attribute__((warn_unused_result))
+/**
+ * DESCRIPTION:
+ * Creates a copy on write shallow copy of a set in constant time, the copy shares the table of the input set
+ * until one of them gets mutated (see rtset_unshare)
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ */
+RtSet *
+rtset_cow_cpy(RtSet *set)
+{
+    assert(set);
+    RtSet *cpy = malloc(sizeof(RtSet));
+    if (!cpy)
+        return NULL;
+
+    if (!cow_share(&set->cow_shares))
+    {
+        free(cpy);
+        return NULL;
+    }
+
+    *cpy = *set;
+    init_RtGCHeader(&cpy->gc);
+    return cpy;
+}
+
+/**
+ * DESCRIPTION:
+ * Gives the set its own private table, this MUST be called before mutating the set.
+ * If the table is shared with other copies, it is copied slot for slot, elements are replaced by new wrappers sharing the same payload
+ *
+ * NOTE:
+ * Does nothing if the set already owns its table, returns the input set
+ */
+RtSet *rtset_unshare(RtSet *set)
+{
+    assert(set);
+    const int8_t *shared_ctrl = set->ctrl;
+    const SetSlot *shared_slots = set->slots;
+
+    if (cow_release(&set->cow_shares))
+        return set;
+
+    size_t tombstones = set->tombstones;
+    if (!alloc_table(set, set->capacity))
+    {
+        MallocError();
+        return NULL;
+    }
+
+    memcpy(set->ctrl, shared_ctrl, sizeof(int8_t) * set->capacity);
+    set->tombstones = tombstones;
+
+    for (size_t i = 0; i < set->capacity; i++)
+    {
+        if (!ctrl_is_full(set->ctrl[i]))
+            continue;
+
+        RtObject *obj = add_to_GC_registry(rtobj_shallow_cpy(shared_slots[i].obj));
+        set->slots[i] = (SetSlot){shared_slots[i].hash, obj};
+
+        rtobj_refcount_increment1(obj);
+    }
+
+    return set;
+}
+
+
+/**
+ * DESCRIPTION:
+ * Number of bytes used by the set struct and its table (elements are not included)
+ */
+size_t rtset_memsize(const RtSet *set)
+{
+    assert(set);
+    return sizeof(RtSet) + set->capacity * (sizeof(int8_t) + sizeof(SetSlot));
+}
 
 /**
  * DESCRIPTION:
@@ -458,18 +569,12 @@ bool rtset_equal(const RtSet *set1, const RtSet *set2)
     if (set1->size != set2->size)
         return false;
 
-    RtObject **refs = rtset_getrefs(set1);
-    for (size_t i = 0; refs[i] != NULL; i++)
+    for (size_t i = 0; i < set1->capacity; i++)
     {
-        RtObject *tmp = rtset_get(set2, refs[i]);
-        if (!tmp || !rtobj_equal(tmp, refs[i]))
-        {
-            free(refs);
+        if (ctrl_is_full(set1->ctrl[i]) && find_slot(set2, set1->slots[i].obj, set1->slots[i].hash, NULL) < 0)
             return false;
-        }
     }
 
-    free(refs);
     return true;
 }
 
@@ -487,76 +592,120 @@ __attribute__((warn_unused_result))
 RtSet *rtset_clear(RtSet *set, bool free_obj, bool free_immutable, bool update_ref_counts) {
     assert(set);
 
-    for(size_t i=0; i < set->bucket_size; i++) {
-        if(!set->buckets[i])
+    // the other copies keep the shared table
+    if(!cow_release(&set->cow_shares)) {
+        if(!alloc_table(set, DEFAULT_SET_CAPACITY))
+            MallocError();
+        set->size = 0;
+        return set;
+    }
+
+    for(size_t i=0; i < set->capacity; i++) {
+        if(!ctrl_is_full(set->ctrl[i]))
             continue;
-        
-        SetNode *node = set->buckets[i];
-        while(node) {
-            SetNode *tmp = node->next;
-
-            // this function will update reference count correctly
-            if(update_ref_counts)
-                rtobj_refcount_decrement1(tmp->obj);
-
-            free_SetNode(node, free_obj, free_immutable, update_ref_counts);
-            set->size--;
-            node = tmp;
-        }
 
-        set->buckets[i]= NULL;
+        RtObject *obj = set->slots[i].obj;
+
+        if(update_ref_counts)
+            rtobj_refcount_decrement1(obj);
+
+        if(free_obj)
+            rtobj_free(obj, free_immutable, update_ref_counts);
     }
 
-    assert(set->size == 0);
+    ctrl_reset(set->ctrl, set->capacity);
+    set->tombstones = 0;
+    set->size = 0;
     return set;
 }
 
+/**
+ * DESCRIPTION:
+ * Adds every element of src to dest, the table of dest is grown once upfront.
+ * Elements already in dest are kept, stored hashes of src are reused and each element is probed once
+ *
+ * PARAMS:
+ * dest: private set to add elements to
+ * src: set whose elements are added
+ * cpy: wether the added objects should be run through rtobj_rt_preprocess first
+ * add_to_GC: wether the copies should be added to the GC registry
+*/
+static void rtset_add_all(RtSet *dest, const RtSet *src, bool cpy, bool add_to_GC) {
+    rtset_reserve(dest, dest->size + src->size);
+
+    for(size_t i = 0; i < src->capacity; i++) {
+        if(!ctrl_is_full(src->ctrl[i]))
+            continue;
+
+        // a single probe finds either the element or the slot to insert it in,
+        // dest was reserved upfront so that slot stays valid
+        const SetSlot *slot = &src->slots[i];
+        size_t index = SIZE_MAX;
+        if(find_slot(dest, slot->obj, slot->hash, &index) >= 0)
+            continue;
+
+        RtObject *obj = cpy ? rtobj_rt_preprocess(slot->obj, false, add_to_GC) : slot->obj;
+
+        // this function will update the reference count
+        fill_slot(dest, index, obj, slot->hash);
+    }
+}
+
 __attribute__((warn_unused_result))
 /**
  * DESCRIPTION:
  * Performs a union set operation on two sets, and returns a new set
- * 
+ * The new set is sized for both operands upfront, the larger set is added first, so only the elements of the smaller one need a lookup
+ *
  * PARAMS:
  * set1: set1
  * set2: set2
  * cpy: wether the contents of the new set should be run through rtobj_rt_preprocess first
  * add_to_GC: wether objs in the new set should be added to the GC registry
+ *
+ * NOTE:
+ * When an element is in both sets, the object from the larger set is kept
 */
 RtSet *rtset_union(const RtSet *set1, const RtSet *set2, bool cpy, bool add_to_GC) {
-    RtSet *newset = init_RtSet(DEFAULT_SET_BUCKETS);
-    if(!newset) return NULL;
-    RtObject **contents1 = rtset_getrefs(set1);
-    RtObject **contents2 = rtset_getrefs(set2);
-
-    // go through first set
-    for(size_t i = 0; contents1[i] != NULL; i++) {
-        RtObject *obj = contents1[i];
-        if(cpy)
-            obj = rtobj_rt_preprocess(contents1[i], false, add_to_GC);
-
-        // this function will update the reference count
-        rtset_insert(newset, obj);
-    }
+    assert(set1 && set2);
+    const RtSet *larger = set1->size >= set2->size ? set1 : set2;
+    const RtSet *smaller = larger == set1 ? set2 : set1;
 
-    // go through second set
-    for(size_t i = 0; contents2[i] != NULL; i++) {
-        RtObject *obj = contents2[i];
+    RtSet *newset = init_RtSet(set1->size + set2->size);
+    if(!newset) return NULL;
 
-        if(cpy)
-            obj = rtobj_rt_preprocess(contents2[i], false, add_to_GC);
+    rtset_add_all(newset, larger, cpy, add_to_GC);
+    rtset_add_all(newset, smaller, cpy, add_to_GC);
+    return newset;
+}
 
-        // this function will update the reference count
-        rtset_insert(newset, obj);
-    }
+/**
+ * DESCRIPTION:
+ * Performs an in place union, every element of set2 is added to set1, no new set is allocated
+ *
+ * PARAMS:
+ * set1: set to update
+ * set2: set whose elements are added
+ * cpy: wether the added objects should be run through rtobj_rt_preprocess first
+ * add_to_GC: wether the copies should be added to the GC registry
+ *
+ * NOTE:
+ * returns set1
+*/
+RtSet *rtset_union_update(RtSet *set1, const RtSet *set2, bool cpy, bool add_to_GC) {
+    assert(set1 && set2);
+    if(set1 == set2 || set1->slots == set2->slots)
+        return set1;
 
-    free(contents1);
-    free(contents2);
-    return newset;
+    rtset_unshare(set1);
+    rtset_add_all(set1, set2, cpy, add_to_GC);
+    return set1;
 }
 
 /**
  * DESCRIPTION:
  * Performs a intersection set operation on two sets, and returns a new set
+ * The new set is sized for the smaller operand, whose elements are looked up in the larger one
  * 
  * PARAMS:
  * set1: set1
@@ -565,31 +714,34 @@ RtSet *rtset_union(const RtSet *set1, const RtSet *set2, bool cpy, bool add_to_G
  * add_to_GC: wether objs in the new set should be added to the GC registry
  * 
  * NOTE:
- * if a shallow copy is performed then object from the first set will be added to the new set
+ * objects from the first set are added to the new set
 */
 RtSet *rtset_intersection(const RtSet *set1, const RtSet *set2, bool cpy, bool add_to_GC) {
-    RtSet *newset = init_RtSet(DEFAULT_SET_BUCKETS);
+    assert(set1 && set2);
+    const bool set1_smaller = set1->size <= set2->size;
+    const RtSet *smaller = set1_smaller ? set1 : set2;
+    const RtSet *larger = set1_smaller ? set2 : set1;
+
+    RtSet *newset = init_RtSet(smaller->size);
     if(!newset) return NULL;
 
-    RtObject **contents1 = rtset_getrefs(set1);
-    RtObject **contents2 = rtset_getrefs(set2);
+    for(size_t i = 0; i < smaller->capacity; i++) {
+        if(!ctrl_is_full(smaller->ctrl[i]))
+            continue;
 
-    for(size_t i = 0; contents1[i] != NULL && contents2[i] != NULL; i++) {
-        RtObject *tmp1 = contents1[i];
-        RtObject *tmp2 = contents2[i];
-        
-        if(rtset_get(set1, tmp2)) {
-            RtObject *obj = tmp1;
-            if(cpy)
-                obj =  rtobj_rt_preprocess(obj, false, add_to_GC);
+        const SetSlot *slot = &smaller->slots[i];
+        long found = find_slot(larger, slot->obj, slot->hash, NULL);
+        if(found < 0)
+            continue;
 
-            // this function will update the reference count
-            rtset_insert(newset, obj);
-        }
+        RtObject *obj = set1_smaller ? slot->obj : larger->slots[found].obj;
+        if(cpy)
+            obj = rtobj_rt_preprocess(obj, false, add_to_GC);
+
+        // this function will update the reference count
+        insert_hashed(newset, obj, slot->hash, true);
     }
 
-    free(contents1);
-    free(contents2);
     return newset;
 }
 
@@ -603,27 +755,24 @@ void rtset_print(const RtSet *set) {
 
     size_t counter = 0;
     printf("{");
-    for(size_t i=0; i < set->bucket_size; i++) {
-        if(!set->buckets[i])
+    for(size_t i=0; i < set->capacity; i++) {
+        if(!ctrl_is_full(set->ctrl[i]))
             continue;
-        
-        SetNode *node = set->buckets[i];
-        while(node) {
-            char *obj_to_str = rtobj_toString(node->obj);
-
-            if (node->obj->type == STRING_TYPE)
-                printf("\"%s\"", obj_to_str);
-            else
-                printf("%s", obj_to_str);
-
-            free(obj_to_str);
-            counter++;
-            if(counter == set->size) 
-                break;
-            
-            printf(", ");
-            node = node->next;
-        }
+
+        const RtObject *obj = set->slots[i].obj;
+        char *obj_to_str = rtobj_toString(obj);
+
+        if (obj->type == STRING_TYPE)
+            printf("\"%s\"", obj_to_str);
+        else
+            printf("%s", obj_to_str);
+
+        free(obj_to_str);
+        counter++;
+        if(counter == set->size)
+            break;
+
+        printf(", ");
     }
     printf("}");
 }
@@ -1,30 +1,40 @@
 #pragma once
+#include "gcheader.h"
 #include <stdlib.h>
+#include <stdint.h>
 
-typedef struct SetNode SetNode;
+typedef struct SetSlot SetSlot;
 
 typedef struct RtSet
 {
-    size_t size;
-    size_t bucket_size;
+    RtGCHeader gc;
 
-    SetNode **buckets;
+    size_t size;       // number of elements in the set
+    size_t capacity;   // number of slots, always a power of 2 multiple of CTRL_GROUP_SIZE
+    size_t tombstones; // number of DELETED slots
 
-    size_t refcount;
+    int8_t *ctrl; // one control byte per slot (see ctrlbytes.h)
+    SetSlot *slots;
+    size_t *cow_shares; // share counter of the table when its shared with copies of the set, NULL when private (see cow.h)
 } RtSet;
 
 
-RtSet *init_RtSet(size_t max_buckets);
+RtSet *init_RtSet(size_t initial_size);
 RtObject *rtset_insert(RtSet *set, RtObject *val);
 RtObject *rtset_get(const RtSet *set, const RtObject *obj);
 RtObject *rtset_remove(RtSet *set, RtObject *obj);
 RtObject **rtset_getrefs(const RtSet *set);
+bool rtset_iterate(const RtSet *set, size_t *cursor, RtObject **obj);
 void rtset_free(RtSet *set, bool free_obj, bool free_immutable, bool update_ref_counts);
 void rtset_print(const RtSet *set);
 char *rtset_toString(const RtSet *set);
 RtSet *rtset_cpy(const RtSet *set, bool deepcpy, bool add_to_GC);
+RtSet *rtset_cow_cpy(RtSet *set);
+RtSet *rtset_unshare(RtSet *set);
 bool rtset_equal(const RtSet *set1, const RtSet *set2);
+size_t rtset_memsize(const RtSet *set);
 RtSet *rtset_clear(RtSet *set, bool free_obj, bool free_immutable, bool update_ref_counts);
 RtSet *rtset_intersection(const RtSet *set1, const RtSet *set2, bool cpy, bool add_to_GC);
 RtSet *rtset_union(const RtSet *set1, const RtSet *set2, bool cpy, bool add_to_GC);
+RtSet *rtset_union_update(RtSet *set1, const RtSet *set2, bool cpy, bool add_to_GC);
 
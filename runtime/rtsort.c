@@ -0,0 +1,630 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "rtsort.h"
+#include "../generics/utilities.h"
+
+/**
+ * Pattern defeating quicksort (pdqsort, by Orson Peters), specialized on the type of the elements and
+ * on a LESS(a, b) comparison macro, so that comparisons are inlined.
+ * Introsort with median of 3 (ninther on large partitions) pivots, insertion sort on small partitions,
+ * partial insertion sort on partitions that were already partitioned (sorted inputs are linear),
+ * partitioning around equal elements (inputs with few distinct values are linear),
+ * and shuffling of unbalanced partitions, with heapsort as a last resort.
+ */
+
+// partitions smaller than this are sorted with insertion sort
+#define PDQ_INSERTION_THRESHOLD 24
+// partitions larger than this use the pseudo median of 9 as their pivot
+#define PDQ_NINTHER_THRESHOLD 128
+// partial insertion sort gives up after moving elements this many times
+#define PDQ_PARTIAL_INSERTION_LIMIT 8
+
+#define DEFINE_PDQSORT(name, T, LESS)                                                        \
+    static void name##_swap(T *a, size_t i, size_t j)                                        \
+    {                                                                                        \
+        T tmp = a[i];                                                                        \
+        a[i] = a[j];                                                                         \
+        a[j] = tmp;                                                                          \
+    }                                                                                        \
+                                                                                             \
+    /* sorts a[i], a[j] and a[k] */                                                          \
+    static void name##_sort3(T *a, size_t i, size_t j, size_t k)                             \
+    {                                                                                        \
+        if (LESS(a[j], a[i]))                                                                \
+            name##_swap(a, i, j);                                                            \
+        if (LESS(a[k], a[j]))                                                                \
+        {                                                                                    \
+            name##_swap(a, j, k);                                                            \
+            if (LESS(a[j], a[i]))                                                            \
+                name##_swap(a, i, j);                                                        \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
+    /* insertion sort, returns false as soon as more than limit elements were moved */       \
+    static bool name##_insertion(T *a, size_t n, size_t limit)                               \
+    {                                                                                        \
+        size_t moved = 0;                                                                    \
+        for (size_t i = 1; i < n; i++)                                                       \
+        {                                                                                    \
+            if (!LESS(a[i], a[i - 1]))                                                       \
+                continue;                                                                    \
+                                                                                             \
+            T tmp = a[i];                                                                    \
+            size_t j = i;                                                                    \
+            do                                                                               \
+            {                                                                                \
+                a[j] = a[j - 1];                                                             \
+                j--;                                                                         \
+            } while (j > 0 && LESS(tmp, a[j - 1]));                                          \
+            a[j] = tmp;                                                                      \
+                                                                                             \
+            moved += i - j;                                                                  \
+            if (moved > limit)                                                               \
+                return false;                                                                \
+        }                                                                                    \
+        return true;                                                                         \
+    }                                                                                        \
+                                                                                             \
+    static void name##_sift_down(T *a, size_t n, size_t i)                                   \
+    {                                                                                        \
+        while (2 * i + 1 < n)                                                                \
+        {                                                                                    \
+            size_t child = 2 * i + 1;                                                        \
+            if (child + 1 < n && LESS(a[child], a[child + 1]))                               \
+                child++;                                                                     \
+            if (!LESS(a[i], a[child]))                                                       \
+                return;                                                                      \
+            name##_swap(a, i, child);                                                        \
+            i = child;                                                                       \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
+    static void name##_heapsort(T *a, size_t n)                                              \
+    {                                                                                        \
+        for (size_t i = n / 2; i-- > 0;)                                                     \
+            name##_sift_down(a, n, i);                                                       \
+        for (size_t i = n; i-- > 1;)                                                         \
+        {                                                                                    \
+            name##_swap(a, 0, i);                                                            \
+            name##_sift_down(a, i, 0);                                                       \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
+    /* partitions around the pivot a[0], elements equal to it go to the right */             \
+    /* the median of 3 guarantees an element >= pivot ends the array */                      \
+    static size_t name##_partition_right(T *a, size_t n, bool *already_partitioned)          \
+    {                                                                                        \
+        T pivot = a[0];                                                                      \
+        size_t first = 0, last = n;                                                          \
+                                                                                             \
+        do                                                                                   \
+            first++;                                                                         \
+        while (LESS(a[first], pivot));                                                       \
+        if (first == 1)                                                                      \
+            do                                                                               \
+                last--;                                                                      \
+            while (first < last && !LESS(a[last], pivot));                                   \
+        else                                                                                 \
+            do                                                                               \
+                last--;                                                                      \
+            while (!LESS(a[last], pivot));                                                   \
+                                                                                             \
+        *already_partitioned = first >= last;                                                \
+        while (first < last)                                                                 \
+        {                                                                                    \
+            name##_swap(a, first, last);                                                     \
+            do                                                                               \
+                first++;                                                                     \
+            while (LESS(a[first], pivot));                                                   \
+            do                                                                               \
+                last--;                                                                      \
+            while (!LESS(a[last], pivot));                                                   \
+        }                                                                                    \
+                                                                                             \
+        size_t pivot_pos = first - 1;                                                        \
+        a[0] = a[pivot_pos];                                                                 \
+        a[pivot_pos] = pivot;                                                                \
+        return pivot_pos;                                                                    \
+    }                                                                                        \
+                                                                                             \
+    /* partitions around the pivot a[0], elements equal to it go to the left */              \
+    static size_t name##_partition_left(T *a, size_t n)                                      \
+    {                                                                                        \
+        T pivot = a[0];                                                                      \
+        size_t first = 0, last = n;                                                          \
+                                                                                             \
+        do                                                                                   \
+            last--;                                                                          \
+        while (LESS(pivot, a[last]));                                                        \
+        if (last + 1 == n)                                                                   \
+            do                                                                               \
+                first++;                                                                     \
+            while (first < last && !LESS(pivot, a[first]));                                  \
+        else                                                                                 \
+            do                                                                               \
+                first++;                                                                     \
+            while (!LESS(pivot, a[first]));                                                  \
+                                                                                             \
+        while (first < last)                                                                 \
+        {                                                                                    \
+            name##_swap(a, first, last);                                                     \
+            do                                                                               \
+                last--;                                                                      \
+            while (LESS(pivot, a[last]));                                                    \
+            do                                                                               \
+                first++;                                                                     \
+            while (!LESS(pivot, a[first]));                                                  \
+        }                                                                                    \
+                                                                                             \
+        a[0] = a[last];                                                                      \
+        a[last] = pivot;                                                                     \
+        return last;                                                                         \
+    }                                                                                        \
+                                                                                             \
+    /* a[-1] exists and is <= to every element of a, unless leftmost */                      \
+    static void name##_loop(T *a, size_t n, int bad_allowed, bool leftmost)                  \
+    {                                                                                        \
+        while (true)                                                                         \
+        {                                                                                    \
+            if (n < PDQ_INSERTION_THRESHOLD)                                                 \
+            {                                                                                \
+                name##_insertion(a, n, SIZE_MAX);                                            \
+                return;                                                                      \
+            }                                                                                \
+                                                                                             \
+            size_t s2 = n / 2;                                                               \
+            if (n > PDQ_NINTHER_THRESHOLD)                                                   \
+            {                                                                                \
+                name##_sort3(a, 0, s2, n - 1);                                               \
+                name##_sort3(a, 1, s2 - 1, n - 2);                                           \
+                name##_sort3(a, 2, s2 + 1, n - 3);                                           \
+                name##_sort3(a, s2 - 1, s2, s2 + 1);                                         \
+                name##_swap(a, 0, s2);                                                       \
+            }                                                                                \
+            else                                                                             \
+            {                                                                                \
+                name##_sort3(a, s2, 0, n - 1);                                               \
+            }                                                                                \
+                                                                                             \
+            /* the pivot is equal to the previous one, the partition is all equal elements */ \
+            if (!leftmost && !LESS(a[-1], a[0]))                                             \
+            {                                                                                \
+                size_t pivot_pos = name##_partition_left(a, n);                              \
+                a += pivot_pos + 1;                                                          \
+                n -= pivot_pos + 1;                                                          \
+                continue;                                                                    \
+            }                                                                                \
+                                                                                             \
+            bool already_partitioned;                                                        \
+            size_t p = name##_partition_right(a, n, &already_partitioned);                   \
+            size_t l = p, r = n - p - 1;                                                     \
+                                                                                             \
+            if (l < n / 8 || r < n / 8)                                                      \
+            {                                                                                \
+                if (--bad_allowed == 0)                                                      \
+                {                                                                            \
+                    name##_heapsort(a, n);                                                   \
+                    return;                                                                  \
+                }                                                                            \
+                                                                                             \
+                if (l >= PDQ_INSERTION_THRESHOLD)                                            \
+                {                                                                            \
+                    name##_swap(a, 0, l / 4);                                                \
+                    name##_swap(a, p - 1, p - l / 4);                                        \
+                    if (l > PDQ_NINTHER_THRESHOLD)                                           \
+                    {                                                                        \
+                        name##_swap(a, 1, l / 4 + 1);                                        \
+                        name##_swap(a, 2, l / 4 + 2);                                        \
+                        name##_swap(a, p - 2, p - (l / 4 + 1));                              \
+                        name##_swap(a, p - 3, p - (l / 4 + 2));                              \
+                    }                                                                        \
+                }                                                                            \
+                if (r >= PDQ_INSERTION_THRESHOLD)                                            \
+                {                                                                            \
+                    name##_swap(a, p + 1, p + 1 + r / 4);                                    \
+                    name##_swap(a, n - 1, n - r / 4);                                        \
+                    if (r > PDQ_NINTHER_THRESHOLD)                                           \
+                    {                                                                        \
+                        name##_swap(a, p + 2, p + 2 + r / 4);                                \
+                        name##_swap(a, p + 3, p + 3 + r / 4);                                \
+                        name##_swap(a, n - 2, n - (1 + r / 4));                              \
+                        name##_swap(a, n - 3, n - (2 + r / 4));                              \
+                    }                                                                        \
+                }                                                                            \
+            }                                                                                \
+            else if (already_partitioned &&                                                  \
+                     name##_insertion(a, l, PDQ_PARTIAL_INSERTION_LIMIT) &&                  \
+                     name##_insertion(a + p + 1, r, PDQ_PARTIAL_INSERTION_LIMIT))            \
+            {                                                                                \
+                return;                                                                      \
+            }                                                                                \
+                                                                                             \
+            name##_loop(a, l, bad_allowed, leftmost);                                        \
+            a += p + 1;                                                                      \
+            n = r;                                                                           \
+            leftmost = false;                                                                \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
+    static void name(T *a, size_t n)                                                         \
+    {                                                                                        \
+        int depth = 1;                                                                       \
+        for (size_t i = n; i > 1; i >>= 1)                                                   \
+            depth++;                                                                         \
+        name##_loop(a, n, depth, true);                                                      \
+    }
+
+#define NUMBER_LESS(a, b) ((a) < (b))
+DEFINE_PDQSORT(pdqsort_numbers, long double, NUMBER_LESS)
+
+/**
+ * A string along with its first 8 bytes packed in big endian order (zero padded),
+ * comparing prefixes as integers orders strings like memcmp does, the characters are only read on ties
+ */
+typedef struct StrSortKey
+{
+    uint64_t prefix;
+    RtString *string;
+} StrSortKey;
+
+/**
+ * DESCRIPTION:
+ * Compares 2 strings with equal prefixes, the first 8 bytes are skipped
+ */
+static int compare_string_tails(const RtString *str1, const RtString *str2)
+{
+    size_t common = str1->length < str2->length ? str1->length : str2->length;
+    if (common > sizeof(uint64_t))
+    {
+        int cmp = memcmp(rtstr_data(str1) + sizeof(uint64_t), rtstr_data(str2) + sizeof(uint64_t),
+                         common - sizeof(uint64_t));
+        if (cmp != 0)
+            return cmp;
+    }
+    return (str1->length > str2->length) - (str1->length < str2->length);
+}
+
+#define STRING_LESS(a, b) \
+    ((a).prefix != (b).prefix ? (a).prefix < (b).prefix : compare_string_tails((a).string, (b).string) < 0)
+DEFINE_PDQSORT(pdqsort_strings, StrSortKey, STRING_LESS)
+
+/**
+ * DESCRIPTION:
+ * Reverses an array of elements of size itemsize in place
+ */
+static void reverse_items(void *items, size_t length, size_t itemsize)
+{
+    char tmp[sizeof(long double)];
+    assert(itemsize <= sizeof(tmp));
+    for (size_t i = 0; i < length / 2; i++)
+    {
+        char *first = (char *)items + i * itemsize;
+        char *last = (char *)items + (length - i - 1) * itemsize;
+        memcpy(tmp, first, itemsize);
+        memcpy(first, last, itemsize);
+        memcpy(last, tmp, itemsize);
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Maps the bits of a double to an unsigned integer with the same ordering,
+ * the sign bit is flipped for positive numbers and every bit is flipped for negative numbers
+ */
+static uint64_t double_to_key(double number)
+{
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    return bits & (1ULL << 63) ? ~bits : bits | (1ULL << 63);
+}
+
+static double key_to_double(uint64_t key)
+{
+    uint64_t bits = key & (1ULL << 63) ? key & ~(1ULL << 63) : ~key;
+    double number;
+    memcpy(&number, &bits, sizeof(number));
+    return number;
+}
+
+/**
+ * DESCRIPTION:
+ * LSD radix sort, one byte per pass, passes where all keys have the same byte are skipped
+ * (i.e the 3 or 4 lowest bytes of small integers, which are all zeros)
+ * Numbers are sorted as doubles, which only works if they all are exactly representable as one (any integer up to 2^53)
+ *
+ * NOTE:
+ * Returns false, leaving the array untouched, if a number is not exactly a double (or NaN) or if malloc fails
+ */
+static bool radix_sort_numbers(long double *numbers, size_t length)
+{
+    uint64_t *block = malloc(sizeof(uint64_t) * length * 2);
+    if (!block)
+        return false;
+
+    uint64_t *keys = block;
+    uint64_t *sorted = block + length;
+    size_t counts[sizeof(uint64_t)][256] = {{0}};
+
+    for (size_t i = 0; i < length; i++)
+    {
+        double number = (double)numbers[i];
+        if ((long double)number != numbers[i])
+        {
+            free(block);
+            return false;
+        }
+
+        keys[i] = double_to_key(number);
+        for (size_t byte = 0; byte < sizeof(uint64_t); byte++)
+            counts[byte][(keys[i] >> (byte * 8)) & 0xff]++;
+    }
+
+    for (size_t byte = 0; byte < sizeof(uint64_t); byte++)
+    {
+        size_t *count = counts[byte];
+        if (count[(keys[0] >> (byte * 8)) & 0xff] == length)
+            continue;
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; digit++)
+        {
+            size_t tmp = count[digit];
+            count[digit] = offset;
+            offset += tmp;
+        }
+
+        for (size_t i = 0; i < length; i++)
+            sorted[count[(keys[i] >> (byte * 8)) & 0xff]++] = keys[i];
+
+        uint64_t *tmp = keys;
+        keys = sorted;
+        sorted = tmp;
+    }
+
+    for (size_t i = 0; i < length; i++)
+        numbers[i] = key_to_double(keys[i]);
+
+    free(block);
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Sorts an array of numbers in place, in regular or reverse order
+ */
+void rtsort_numbers(long double *numbers, size_t length, bool reverse)
+{
+    if (length < RTSORT_RADIX_THRESHOLD || !radix_sort_numbers(numbers, length))
+        pdqsort_numbers(numbers, length);
+
+    if (reverse)
+        reverse_items(numbers, length, sizeof(long double));
+}
+
+/**
+ * DESCRIPTION:
+ * Sorts an array of strings in place, in regular or reverse order
+ * Strings are ordered like rtstr_compare does, byte by byte, a prefix of a string comes before it
+ */
+void rtsort_strings(RtString **strings, size_t length, bool reverse)
+{
+    StrSortKey *keys = malloc(sizeof(StrSortKey) * length);
+    if (!keys)
+    {
+        MallocError();
+        return;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        const char *chars = rtstr_data(strings[i]);
+        size_t prefix_len = strings[i]->length < sizeof(uint64_t) ? strings[i]->length : sizeof(uint64_t);
+        uint64_t prefix = 0;
+        for (size_t j = 0; j < prefix_len; j++)
+            prefix |= (uint64_t)(unsigned char)chars[j] << (56 - j * 8);
+
+        keys[i].prefix = prefix;
+        keys[i].string = strings[i];
+    }
+
+    pdqsort_strings(keys, length);
+
+    for (size_t i = 0; i < length; i++)
+        strings[i] = keys[reverse ? length - i - 1 : i].string;
+
+    free(keys);
+}
+
+/**
+ * An object along with its index in the array being sorted, so that the sorted order can be applied to an other array
+ */
+typedef struct ObjSortItem
+{
+    RtObject *key;
+    size_t index;
+} ObjSortItem;
+
+// sorted runs shorter than this are extended with binary insertion sort, before being merged
+#define MERGESORT_MIN_RUN 32
+
+/**
+ * DESCRIPTION:
+ * Compares the keys of 2 items with rtobj_compare, only the sign of the result is kept,
+ * the difference of 2 numbers can be fractional
+ */
+static int compare_items(const ObjSortItem *item1, const ObjSortItem *item2, bool reverse)
+{
+    long double diff = rtobj_compare(item1->key, item2->key);
+    int cmp = (diff > 0) - (diff < 0);
+    return reverse ? -cmp : cmp;
+}
+
+/**
+ * DESCRIPTION:
+ * Length of the run starting at items, i.e the longest sorted (or strictly descending, which is then reversed) prefix
+ */
+static size_t count_run(ObjSortItem *items, size_t length, bool reverse)
+{
+    if (length < 2)
+        return length;
+
+    size_t run = 2;
+    if (compare_items(&items[1], &items[0], reverse) < 0)
+    {
+        while (run < length && compare_items(&items[run], &items[run - 1], reverse) < 0)
+            run++;
+        reverse_items(items, run, sizeof(ObjSortItem));
+    }
+    else
+    {
+        while (run < length && compare_items(&items[run], &items[run - 1], reverse) >= 0)
+            run++;
+    }
+
+    return run;
+}
+
+/**
+ * DESCRIPTION:
+ * Stable binary insertion sort of items, whose first sorted elements are already sorted
+ */
+static void binary_insertion_sort(ObjSortItem *items, size_t length, size_t sorted, bool reverse)
+{
+    for (size_t i = sorted; i < length; i++)
+    {
+        ObjSortItem item = items[i];
+        size_t lo = 0, hi = i;
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (compare_items(&item, &items[mid], reverse) < 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        memmove(&items[lo + 1], &items[lo], sizeof(ObjSortItem) * (i - lo));
+        items[lo] = item;
+    }
+}
+
+/**
+ * DESCRIPTION:
+ * Stable merge of the 2 adjacent sorted runs items[0, left) and items[left, left + right), tmp must hold left items
+ */
+static void merge_runs(ObjSortItem *items, size_t left, size_t right, ObjSortItem *tmp, bool reverse)
+{
+    // runs are already in order
+    if (compare_items(&items[left], &items[left - 1], reverse) >= 0)
+        return;
+
+    memcpy(tmp, items, sizeof(ObjSortItem) * left);
+    size_t i = 0, j = left, k = 0;
+    while (i < left && j < left + right)
+    {
+        if (compare_items(&items[j], &tmp[i], reverse) < 0)
+            items[k++] = items[j++];
+        else
+            items[k++] = tmp[i++];
+    }
+    memcpy(&items[k], &tmp[i], sizeof(ObjSortItem) * (left - i));
+}
+
+/**
+ * DESCRIPTION:
+ * Minimum length of runs, between MERGESORT_MIN_RUN and 2 * MERGESORT_MIN_RUN,
+ * such that the number of runs is a power of 2 or close to it, which keeps merges balanced
+ */
+static size_t min_run(size_t length)
+{
+    size_t r = 0;
+    while (length >= 2 * MERGESORT_MIN_RUN)
+    {
+        r |= length & 1;
+        length >>= 1;
+    }
+    return length + r;
+}
+
+/**
+ * DESCRIPTION:
+ * Computes the stable sorted order of an array of objects (compared with rtobj_compare), in regular or reverse order
+ * order[i] is set to the index in keys of the i-th smallest object, equal objects keep their relative order.
+ * Runs that are already sorted are detected and merged like timsort does (without galloping),
+ * sorted and reverse sorted arrays take linear time
+ *
+ * NOTE:
+ * Returns false if malloc fails
+ */
+bool rtsort_order(RtObject **keys, size_t *order, size_t length, bool reverse)
+{
+    // the second half of the block is used to merge runs
+    ObjSortItem *items = malloc(sizeof(ObjSortItem) * length * 2);
+    if (!items)
+        return false;
+    ObjSortItem *tmp = items + length;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        items[i].key = keys[i];
+        items[i].index = i;
+    }
+
+    // pending runs, their lengths decrease at least as fast as the fibonacci sequence, so 128 runs is plenty
+    size_t run_start[128];
+    size_t run_len[128];
+    size_t runs = 0;
+    size_t minrun = min_run(length);
+
+    for (size_t start = 0; start < length;)
+    {
+        size_t len = count_run(items + start, length - start, reverse);
+        if (len < minrun)
+        {
+            size_t forced = length - start < minrun ? length - start : minrun;
+            binary_insertion_sort(items + start, forced, len, reverse);
+            len = forced;
+        }
+
+        run_start[runs] = start;
+        run_len[runs] = len;
+        runs++;
+        start += len;
+
+        // merges runs until their lengths satisfy the invariants of timsort, all runs are merged once everything was scanned
+        while (runs > 1)
+        {
+            size_t n = runs - 2;
+            if (start < length)
+            {
+                bool unbalanced = (n > 0 && run_len[n - 1] <= run_len[n] + run_len[n + 1]) ||
+                                  (n > 1 && run_len[n - 2] <= run_len[n - 1] + run_len[n]);
+                if (!unbalanced && run_len[n] > run_len[n + 1])
+                    break;
+                if (unbalanced && run_len[n - 1] < run_len[n + 1])
+                    n--;
+            }
+            else if (n > 0 && run_len[n - 1] < run_len[n + 1])
+            {
+                n--;
+            }
+
+            merge_runs(items + run_start[n], run_len[n], run_len[n + 1], tmp, reverse);
+            run_len[n] += run_len[n + 1];
+            if (n + 2 < runs)
+            {
+                run_start[n + 1] = run_start[n + 2];
+                run_len[n + 1] = run_len[n + 2];
+            }
+            runs--;
+        }
+    }
+
+    for (size_t i = 0; i < length; i++)
+        order[i] = items[i].index;
+
+    free(items);
+    return true;
+}
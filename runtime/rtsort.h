@@ -0,0 +1,19 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include "rtobjects.h"
+#include "rtstring.h"
+
+/**
+ * Sort engine used by lists (see rtlist_sort), each kind of element has its own algorithm:
+ * - numbers: LSD radix sort on the bits of the numbers, pattern defeating quicksort (pdqsort) for small arrays
+ * - strings: pdqsort comparing cached 8 byte prefixes of the strings first, the rest of the characters only on ties
+ * - objects: stable merge sort of natural runs (timsort without galloping), through rtobj_compare
+ */
+
+// arrays of numbers smaller than this are sorted with pdqsort rather than radix sort
+#define RTSORT_RADIX_THRESHOLD 256
+
+void rtsort_numbers(long double *numbers, size_t length, bool reverse);
+void rtsort_strings(RtString **strings, size_t length, bool reverse);
+bool rtsort_order(RtObject **keys, size_t *order, size_t length, bool reverse);
@@ -5,36 +5,296 @@
 #include "rtstring.h"
 #include "../generics/utilities.h"
 
+/**
+ * DESCRIPTION:
+ * This file contains the implementation of runtime strings
+ *
+ * A string and its characters are a single allocation (see RtString), short strings such as map keys are therefore a single small block.
+ * Strings are immutable, but concatenating to a long string (i.e s = s + x in a loop) does not copy it:
+ * the result appends to the builder buffer of its left operand, which grows geometrically.
+ * The left operand keeps seeing its own prefix of the buffer, it gets its own copy (flattened) only if it is read again
+ *
+ * Slices (i.e s[i:j]) point inside the characters of the string they were taken from, they are only flattened
+ * when null terminated characters are needed (see rtstr_chars), length aware code reads them through rtstr_data
+ */
+
+struct RtStrBuilder
+{
+    size_t refs;     // number of strings using the buffer
+    size_t length;   // length of the tip, chars[length] is always '\0'
+    size_t capacity; // number of bytes allocated for chars, including the null terminator
+    char chars[];
+};
+
+/**
+ * DESCRIPTION:
+ * Initializes a RtString holding the first length chars of str, struct and characters are a single allocation
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ *
+ * PARAMS:
+ * str: characters to copy, if NULL the characters are left for the caller to fill (the null terminator is set)
+ * length: number of characters
+*/
+RtString *init_RtString_len(const char *str, size_t length) {
+    RtString *rtstring = malloc(sizeof(RtString) + length + 1);
+    if(!rtstring) return NULL;
+
+    if(str)
+        memcpy(rtstring->chars, str, length);
+    rtstring->chars[length] = '\0';
+
+    rtstring->string = rtstring->chars;
+    rtstring->length = length;
+    rtstring->builder = NULL;
+    rtstring->base = NULL;
+    rtstring->slices = 0;
+    rtstring->released = false;
+    rtstring->concatenated = false;
+    init_RtGCHeader(&rtstring->gc);
+    return rtstring;
+}
+
+/**
+ * DESCRIPTION:
+ * Initializes a RtString without inline characters, for strings pointing into characters they share
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+*/
+static RtString *init_RtString_shared(char *string, size_t length) {
+    RtString *rtstring = malloc(sizeof(RtString));
+    if(!rtstring) return NULL;
+
+    rtstring->string = string;
+    rtstring->length = length;
+    rtstring->builder = NULL;
+    rtstring->base = NULL;
+    rtstring->slices = 0;
+    rtstring->released = false;
+    rtstring->concatenated = false;
+    init_RtGCHeader(&rtstring->gc);
+    return rtstring;
+}
+
+// wether the string is the longest one using its builder, i.e the only one that can append to it
+#define rtstr_is_tip(str) \
+    ((str)->string == (str)->builder->chars && (str)->length == (str)->builder->length)
+
 /**
  * DEESCRIPTION:
- * Initializes a RtString struct, input str is malloced
+ * Initializes a RtString struct, input str is copied
  * 
  * NOTE:
  * Returns NULL if malloc fails
  * 
  * PARAMS:
- * str: string
+ * str: string, NULL for the empty string
  * 
 */
 RtString *init_RtString(const char* str) {
-    RtString *rtstring = malloc(sizeof(RtString));
-    if(!rtstring) return NULL;
-    rtstring->string = str? cpy_string(str): NULL;
-    if(!rtstring->string && str) {
-        free(rtstring);
+    return str ? init_RtString_len(str, strlen(str)) : init_RtString_len("", 0);
+}
+
+/**
+ * DESCRIPTION:
+ * Creates a builder buffer holding the concatenation of 2 strings, with room for as many bytes again
+*/
+static RtStrBuilder *init_RtStrBuilder(const char *str1, size_t length1, const char *str2, size_t length2) {
+    size_t length = length1 + length2;
+    size_t capacity = 2 * length + 1;
+    RtStrBuilder *builder = malloc(sizeof(RtStrBuilder) + capacity);
+    if(!builder) return NULL;
+
+    memcpy(builder->chars, str1, length1);
+    memcpy(builder->chars + length1, str2, length2);
+    builder->chars[length] = '\0';
+    builder->length = length;
+    builder->capacity = capacity;
+    builder->refs = 0;
+    return builder;
+}
+
+/**
+ * DESCRIPTION:
+ * Concatenates 2 strings into a new string
+ *
+ * If str1 is the tip of a builder with enough room, str2 is appended in place and the new string shares the builder,
+ * otherwise a long result of a chain of concatenations gets a new builder twice its size, so that the chain is amortized O(1) per char
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+*/
+RtString *rtstr_concat(const RtString *str1, const RtString *str2) {
+    assert(str1 && str2);
+    size_t length = str1->length + str2->length;
+    RtStrBuilder *builder = str1->builder;
+    const char *chars2 = rtstr_data(str2);
+
+    if(builder && rtstr_is_tip(str1) && length < builder->capacity) {
+        // str2 may share the builder, its chars are before the appended region
+        memcpy(builder->chars + builder->length, chars2, str2->length);
+        builder->length = length;
+        builder->chars[length] = '\0';
+    }
+    // a one off concatenation stays a plain string, only chains of concatenations (i.e s = s + x) get a builder
+    else if(str1->concatenated && length >= RTSTR_BUILDER_THRESHOLD) {
+        builder = init_RtStrBuilder(str1->string, str1->length, chars2, str2->length);
+        if(!builder) return NULL;
+    }
+    else {
+        RtString *result = init_RtString_len(NULL, length);
+        if(!result) return NULL;
+
+        memcpy(result->chars, str1->string, str1->length);
+        memcpy(result->chars + str1->length, chars2, str2->length);
+        result->concatenated = true;
+        return result;
+    }
+
+    // characters live in the builder, the struct has no inline characters
+    RtString *result = init_RtString_shared(builder->chars, length);
+    if(!result) {
+        if(builder->refs == 0)
+            free(builder);
         return NULL;
     }
-    rtstring->length = str? strlen(str): 0;
-    rtstring->refcount = 0;
-    return rtstring;
+
+    result->concatenated = true;
+    builder->refs++;
+    result->builder = builder;
+    return result;
+}
+
+/**
+ * DESCRIPTION:
+ * Creates a slice of a string, i.e the characters from index start to end (exclusive), without copying them
+ * The slice shares the builder of the string, or points inside the characters of the string, which then stays alive as long as the slice does
+ *
+ * NOTE:
+ * Returns NULL if malloc fails
+ * Slices shorter than RTSTR_SLICE_THRESHOLD are plain copies
+*/
+RtString *rtstr_slice(RtString *string, size_t start, size_t end) {
+    assert(string);
+    assert(start <= end && end <= string->length);
+    size_t length = end - start;
+
+    if(length < RTSTR_SLICE_THRESHOLD)
+        return init_RtString_len(string->string + start, length);
+
+    RtString *slice = init_RtString_shared(string->string + start, length);
+    if(!slice) return NULL;
+
+    if(string->builder) {
+        slice->builder = string->builder;
+        slice->builder->refs++;
+    }
+    else {
+        // a slice of a slice points directly into the characters of the original string
+        RtString *base = string->base ? string->base : string;
+        slice->base = base;
+        base->slices++;
+    }
+
+    return slice;
+}
+
+/**
+ * DESCRIPTION:
+ * Compares the contents of 2 strings
+*/
+bool rtstr_equal(const RtString *str1, const RtString *str2) {
+    assert(str1 && str2);
+    return str1->length == str2->length && memcmp(rtstr_data(str1), rtstr_data(str2), str1->length) == 0;
+}
+
+/**
+ * DESCRIPTION:
+ * Orders 2 strings lexicographically, like strcmp
+*/
+int rtstr_compare(const RtString *str1, const RtString *str2) {
+    assert(str1 && str2);
+    size_t common = str1->length < str2->length ? str1->length : str2->length;
+    int cmp = memcmp(rtstr_data(str1), rtstr_data(str2), common);
+    if(cmp != 0)
+        return cmp;
+    return (str1->length > str2->length) - (str1->length < str2->length);
+}
+
+/**
+ * DESCRIPTION:
+ * Releases the characters a slice points into, the string owning them is freed if it was only kept alive by its slices
+*/
+static void rtstr_release_base(RtString *string) {
+    RtString *base = string->base;
+    string->base = NULL;
+
+    if(--base->slices == 0 && base->released)
+        rtstr_free(base);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the null terminated characters of a string
+ * A string that is no longer the tip of its builder, or a slice ending before its base, is flattened first, i.e it gets its own copy of its characters
+ *
+ * NOTE:
+ * The returned pointer is valid until the string is freed, or used as the left operand of rtstr_concat
+*/
+char *rtstr_chars(const RtString *string) {
+    assert(string);
+    RtStrBuilder *builder = string->builder;
+    RtString *base = string->base;
+
+    if(builder ? rtstr_is_tip(string) : !base || string->string + string->length == base->string + base->length)
+        return string->string;
+
+    // flattening does not change the contents of the string, only its representation
+    RtString *flat = (RtString *)string;
+    char *chars = malloc(flat->length + 1);
+    if(!chars) MallocError();
+
+    memcpy(chars, flat->string, flat->length);
+    chars[flat->length] = '\0';
+
+    if(builder) {
+        if(--builder->refs == 0)
+            free(builder);
+        flat->builder = NULL;
+    }
+    else {
+        rtstr_release_base(flat);
+    }
+
+    flat->string = chars;
+    return chars;
 }
 
 /**
  * DESCRIPTION:
  * Frees RtString 
+ * A string whose characters are still used by slices is only marked as released, the last slice frees it
 */
 void rtstr_free(RtString *string) {
     if(!string) return;
-    free(string->string);
+
+    if(string->slices > 0) {
+        string->released = true;
+        return;
+    }
+
+    if(string->builder) {
+        if(--string->builder->refs == 0)
+            free(string->builder);
+    }
+    else if(string->base) {
+        rtstr_release_base(string);
+    }
+    else if(string->string != string->chars) {
+        free(string->string);
+    }
+
     free(string);
-}
\ No newline at end of file
+}
@@ -1,12 +1,48 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "gcheader.h"
+
+/**
+ * Buffer shared by strings built through repeated concatenation (see rtstr_concat)
+ * Every string using the buffer is a prefix of its contents, only the longest one (the tip) can append to it
+ */
+typedef struct RtStrBuilder RtStrBuilder;
+
+/**
+ * Strings are allocated in one block, their characters are stored inline in chars.
+ * string points to chars, except for strings sharing a builder buffer, slices (see rtstr_slice), or strings given a malloced buffer, which they then own
+ */
 typedef struct RtString {
+    RtGCHeader gc;
     char* string;
     size_t length;
-    size_t refcount;
+    RtStrBuilder *builder; // set when string points into a builder buffer, string is then only null terminated for the tip
+    struct RtString *base; // set for slices of a string without builder, string then points inside the characters of base
+    unsigned int slices;   // number of slices using the characters of this string, it outlives its owners until they are freed
+    bool released;         // freed by its owners while slices still used it
+    bool concatenated;     // result of rtstr_concat, concatenating to it again starts a builder
+    char chars[];
 } RtString;
 
+// Concatenations shorter than this always produce plain strings
+#define RTSTR_BUILDER_THRESHOLD 64
+
+// Slices shorter than this are copied, a copy is then as cheap as a slice and does not keep its parent alive
+#define RTSTR_SLICE_THRESHOLD 32
+
+/**
+ * Characters of a string, which are NOT null terminated for slices and non tip builder strings,
+ * they must be read along with the length of the string, rtstr_chars gives null terminated characters
+ */
+#define rtstr_data(str) ((const char *)(str)->string)
 
 RtString *init_RtString(const char* str);
+RtString *init_RtString_len(const char *str, size_t length);
+RtString *rtstr_concat(const RtString *str1, const RtString *str2);
+RtString *rtstr_slice(RtString *string, size_t start, size_t end);
+bool rtstr_equal(const RtString *str1, const RtString *str2);
+int rtstr_compare(const RtString *str1, const RtString *str2);
+char *rtstr_chars(const RtString *string);
 void rtstr_free(RtString *string);
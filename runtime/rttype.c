@@ -40,6 +40,8 @@ const char *rtobj_type_toString(RtType type)
         return "Set";
     case EXCEPTION_TYPE:
         return "Exception";
+    case RANGE_TYPE:
+        return "Range";
     }
 }
 
@@ -66,6 +68,9 @@ void rttype_freedata(RtType type, void *data, bool freerefs, bool update_ref_cou
     case NUMBER_TYPE:
         rtnum_free(data);
         return;
+    case RANGE_TYPE:
+        rtrange_free(data);
+        return;
     case STRING_TYPE:
         rtstr_free(data);
         return;
@@ -92,30 +97,12 @@ void rttype_freedata(RtType type, void *data, bool freerefs, bool update_ref_cou
 /**
  * DESCRIPTION:
  * Helper function for getting the refence count of some type
+ * Every payload starts with a RtGCHeader, so the type is only used for sanity checks
 */
 size_t rttype_get_refcount(void* data, RtType type) {
     assert(data);
-    switch (type)
-    {
-    case NULL_TYPE:
-    case UNDEFINED_TYPE:
-        return *((size_t*)data);
-    case NUMBER_TYPE:
-        return ((RtNumber*)data)->refcount;
-    case STRING_TYPE:
-        return ((RtString*)data)->refcount;
-    case LIST_TYPE:
-        return ((RtList*)data)->refcount;
-    case FUNCTION_TYPE:
-        return ((RtFunction*)data)->refcount;
-    case HASHMAP_TYPE:
-        return ((RtMap*)data)->refcount;
-    case CLASS_TYPE:
-        return ((RtClass*)data)->refcount;
-    case HASHSET_TYPE:
-        return ((RtSet*)data)->refcount;
-    case EXCEPTION_TYPE:
-        return ((RtException*)data)->refcount;
-    }
+    assert(type < NB_OF_TYPES);
+    (void)type;
+    return rtgcheader(data)->refcount;
 }
 
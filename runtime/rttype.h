@@ -14,10 +14,11 @@ typedef enum RtType
     LIST_TYPE,
     HASHMAP_TYPE,
     HASHSET_TYPE,
-    EXCEPTION_TYPE
+    EXCEPTION_TYPE,
+    RANGE_TYPE
 } RtType;
 
-#define NB_OF_TYPES 10
+#define NB_OF_TYPES 11
 
 bool rttype_isprimitive(RtType type);
 const char *rtobj_type_toString(RtType type);
@@ -12,6 +12,7 @@
 #include "rttype.h"
 #include "filetable.h"
 #include "gc.h"
+#include "heapsnapshot.h"
 #include "rtexchandler.h"
 
 /**
@@ -22,21 +23,33 @@
 /**
  * Important static declarations
  *
+ * NOTE:
+ * The state of the runtime is thread local, every worker of parallel_map / parallel_for runs its own runtime (see rtparallel.c)
  */
 
 /* Stores call stack */
-static CallFrame *callStack[MAX_STACK_SIZE] = {NULL};
+static _Thread_local CallFrame *callStack[MAX_STACK_SIZE] = {NULL};
 
 size_t MAX_CALLSTACK_SIZE = MAX_STACK_SIZE;
 
 /* Flag for storing current status of runtime environment */
-static bool Runtime_active = false;
+static _Thread_local bool Runtime_active = false;
+
+/* Set for the runtimes of parallel_map / parallel_for workers, which share the bytecode of the main runtime (see rtparallel.c) */
+static _Thread_local bool Runtime_isolated = false;
+
+/* Set when other threads may run the same bytecode at the same time (isolated runtimes, VMs with concurrent_runs),
+   constants are then copied with rtobj_isolated_cpy, which only reads them */
+static _Thread_local bool Runtime_shared_bytecode = false;
 
 /* Stack machine */
-static StackMachine *stk_machine;
+static _Thread_local StackMachine *stk_machine;
 
 /* Stack Call Frame pointer */
-static long stack_ptr = -1;
+static _Thread_local long stack_ptr = -1;
+
+/* Number of nested calls from native code (see rt_call) */
+static _Thread_local unsigned int rt_call_depth = 0;
 
 StackMachine *getCurrentStkMachineInstance() { return stk_machine; }
 
@@ -124,20 +137,70 @@ void init_ScriptArgs(int argc, char **argv) {
  * It initializes the stack machine
  * Adds top level Call frame
  * The runtime struct
- * Std lib functions
+ *
+ * PARAMS:
+ * shared_bytecode: wether other threads may run code at the same time
+ *
+ * NOTE:
+ * Built in functions and attributes are shared by every runtime, they are set up by init_VM_shared (see vm.c)
  */
-int prep_runtime_env(ByteCodeList *code, const char *mainfile, int argc, char **argv)
+int prep_runtime_env(ByteCodeList *code, const char *mainfile, int argc, char **argv, bool shared_bytecode)
 {
     int returncode = init_RunTime();
+    Runtime_shared_bytecode = shared_bytecode;
     RunTime_push_callframe(init_CallFrame(code, NULL, mainfile));
     init_GarbageCollector();
-    init_AttrRegistry();
     init_FileTable();
-    rtobj_init_cmp_tbl();
     init_ScriptArgs(argc, argv);
     return returncode ? 1 : 0;
 }
 
+/**
+ * DESCRIPTION:
+ * Sets up an isolated runtime on the calling thread, used by the workers of parallel_map / parallel_for (see rtparallel.c).
+ * It gets its own stack machine, call stack, exception handlers and heap,
+ * the bytecode, built in functions and attributes are shared with the main runtime
+ *
+ * PARAMS:
+ * code: bytecode of the top level call frame, it is never run, functions are called from it (see rt_call)
+ * filename: file of the top level call frame
+ * policy: pacing policy of the GC of the new heap
+ */
+int prep_isolated_runtime_env(ByteCodeList *code, const char *filename, const GCPolicy *policy)
+{
+    if (!init_RunTime())
+        return 0;
+
+    Runtime_isolated = true;
+    Runtime_shared_bytecode = true;
+    RunTime_push_callframe(init_CallFrame(code, NULL, filename));
+    set_GC_policy(policy);
+    init_GarbageCollector();
+    return 1;
+}
+
+/**
+ * DESCRIPTION:
+ * Tears down the isolated runtime of the calling thread, every object of its heap is freed
+ */
+void perform_isolated_runtime_cleanup()
+{
+    while (stack_ptr >= 0)
+        free_CallFrame(RunTime_pop_callframe(), false);
+
+    free_StackMachine(stk_machine, true, false);
+    stk_machine = NULL;
+
+    cleanup_GarbageCollector();
+
+    rtexception_free(raisedException);
+    raisedException = NULL;
+
+    Runtime_isolated = false;
+    Runtime_shared_bytecode = false;
+    Runtime_active = false;
+}
+
 /**
  * DESCRIPTION:
  * This function performs runtime cleanup
@@ -150,14 +213,13 @@ void perform_runtime_cleanup()
     free_StackMachine(stk_machine, true, false);
     stk_machine = NULL;
 
-    cleanup_builtin();
     cleanup_GarbageCollector();
-    cleanup_AttrsRegistry();
     cleanup_FileTable();
     
     rtexception_free(raisedException);
     raisedException = NULL;
 
+    Runtime_shared_bytecode = false;
     Runtime_active = false;
 }
 
@@ -465,6 +527,7 @@ static int perform_exit()
  */
 
 static CallFrame *perform_regular_func_call(RtObject *funcobj, bool funcobj_disposable, RtObject **arguments, bool disposable[], size_t arg_count);
+static RtObject *perform_builtin_call(RtObject *func, RtObject **arguments, size_t arg_count);
 
 CallFrame *perform_function_call(size_t arg_count)
 {
@@ -517,84 +580,100 @@ CallFrame *perform_function_call(size_t arg_count)
         raiseException(StackOverflowException(buffer));
     }
 
-    CallFrame *new_frame = NULL;
+    if (func->data.Func->functype == REGULAR_FUNC)
+    {
+        CallFrame *new_frame =
+            perform_regular_func_call(func, func_disposable, arguments, arg_disposable, arg_count);
+        dispose_disposable_obj(func, func_disposable);
+        return new_frame;
+    }
+
+    RtObject *obj = perform_builtin_call(func, arguments, arg_count);
+
+    // if an exception occured during execution of built in function
+    if (!obj)
+    {
+        dispose_disposable_obj(func, func_disposable);
+        raiseException(Intermediate_raisedException);
+    }
+
+    // built in functions may also return an object that is already stored somewhere (i.e an element popped from a list),
+    // such objects are in the GC registry and are not disposable
+    RtObject *target = func->data.Func->functype == ATTR_BUILTIN_FUNC ? func->data.Func->func_data.attr_built_in.target : NULL;
+    StackMachine_push(StackMachine, obj, obj != target && !GC_Registry_has(obj));
+
+    dispose_disposable_obj(func, func_disposable);
+    return NULL;
+}
+
+/**
+ * DESCRIPTION:
+ * Helper for running built in functions, built in attributes and exception constructors
+ * Returns the result of the call, or NULL if an exception occured, in which case Intermediate_raisedException is set
+ *
+ * NOTE:
+ * Built in functions can call back into the runtime (see rt_call), which may trigger the GC,
+ * therefore the arguments and the function are referenced for the duration of the call
+ */
+static RtObject *perform_builtin_call(RtObject *func, RtObject **arguments, size_t arg_count)
+{
+    assert(!Intermediate_raisedException);
+    RtFunction *function = func->data.Func;
+    RtObject *obj = NULL;
 
-    switch (func->data.Func->functype)
+    for (size_t i = 0; i < arg_count; i++)
+        rtobj_refcount_increment1(arguments[i]);
+    rtobj_refcount_increment1(func);
+
+    switch (function->functype)
     {
     case EXCEPTION_CONSTRUCTOR_FUNC:
     {
-        const char *funcname = func->data.Func->func_data.exception_constructor.exception_name;
+        const char *funcname = function->func_data.exception_constructor.exception_name;
         if (arg_count > 1)
         {
             char buffer[110 + strlen(funcname)];
             snprintf(buffer, sizeof(buffer),
                      "%s Exception Constructor can only take 1 or 0 arguments, but was given %zu",
                      funcname, arg_count);
-
-            dispose_disposable_obj(func, func_disposable);
-            raiseException(InvalidNumberOfArgumentsException(buffer));
+            setIntermediateException(InvalidNumberOfArgumentsException(buffer));
+            break;
         }
 
-        RtObject *exception_obj = init_RtObject(EXCEPTION_TYPE);
-        exception_obj->data.Exception = init_RtException(funcname, NULL);
-        exception_obj->data.Exception->msg =
+        obj = init_RtObject(EXCEPTION_TYPE);
+        obj->data.Exception = init_RtException(funcname, NULL);
+        obj->data.Exception->msg =
             arg_count == 1 ? rtobj_toString(arguments[0]) : cpy_string("");
-
-        StackMachine_push(stk_machine, exception_obj, true);
         break;
     }
+
     case BUILTIN_FUNC:
     {
-
-        assert(func->data.Func->func_data.built_in.func);
-        assert(!Intermediate_raisedException);
-
-        BuiltinFunc *builtin = func->data.Func->func_data.built_in.func;
-        RtObject *obj = builtin->builtin_func((RtObject **)arguments, arg_count);
-
-        // if an exception occured during execution of built in function
-        if (Intermediate_raisedException)
-        {
-            assert(!obj);
-            dispose_disposable_obj(func, func_disposable);
-            raiseException(Intermediate_raisedException);
-        }
-        assert(obj);
-
-        // pushes result of function onto stack machine
-        StackMachine_push(StackMachine, obj, true);
+        assert(function->func_data.built_in.func);
+        BuiltinFunc *builtin = function->func_data.built_in.func;
+        obj = builtin->builtin_func((RtObject **)arguments, arg_count);
         break;
     }
 
     case ATTR_BUILTIN_FUNC:
     {
-        assert(!Intermediate_raisedException);
-
-        AttrBuiltin *attrfunc = func->data.Func->func_data.attr_built_in.func;
-        RtObject *target = func->data.Func->func_data.attr_built_in.target;
-        RtObject *obj = attrfunc->func.builtin_func(target, arguments, arg_count);
-
-        // exception occurred during execution of built in attribute function
-        if (Intermediate_raisedException)
-        {
-            assert(!obj);
-            dispose_disposable_obj(func, func_disposable);
-            raiseException(Intermediate_raisedException);
-        }
-        assert(obj);
-
-        StackMachine_push(StackMachine, obj, obj != target);
+        AttrBuiltin *attrfunc = function->func_data.attr_built_in.func;
+        RtObject *target = function->func_data.attr_built_in.target;
+        obj = attrfunc->func.builtin_func(target, arguments, arg_count);
         break;
     }
 
     case REGULAR_FUNC:
-        new_frame =
-            perform_regular_func_call(func, func_disposable, arguments, arg_disposable, arg_count);
+        assert(false);
         break;
     }
 
-    dispose_disposable_obj(func, func_disposable);
-    return new_frame;
+    for (size_t i = 0; i < arg_count; i++)
+        rtobj_refcount_decrement1(arguments[i]);
+    rtobj_refcount_decrement1(func);
+
+    assert(obj ? !Intermediate_raisedException : Intermediate_raisedException != NULL);
+    return obj;
 }
 
 /**
@@ -624,13 +703,14 @@ static CallFrame *perform_regular_func_call(
         func->func_data.user_func.arg_count != arg_count)
     {
         size_t expected_arg_count = func->func_data.user_func.arg_count;
+        const char *name = funcname ? funcname : "(Unknown)";
 
-        char buffer[110 + strlen(funcname)];
+        char buffer[110 + strlen(name)];
         snprintf(
             buffer,
             sizeof(buffer),
             "'%s': Function expected %zu arguments, but got %zu\n",
-            funcname ? funcname : "(Unknown)",
+            name,
             expected_arg_count,
             arg_count);
 
@@ -717,7 +797,7 @@ static void perform_create_list(unsigned long length)
     listobj->data.List = list;
     StackMachine_push(StackMachine, listobj, true);
 
-    for (unsigned long i = 0; i < list->length; i++)
+    for (unsigned long i = 0; i < list->length && !rtlist_unboxed(list); i++)
     {
         add_to_GC_registry(list->objs[i]);
     }
@@ -729,17 +809,20 @@ static void perform_create_list(unsigned long length)
  *
  * PARAMS:
  * size: refers to the number of key value pairs
+ *
+ * NOTE:
+ * pairs are inserted in source order, so the map keeps the order of the literal and its last duplicate key wins
  */
 static void perform_create_map(unsigned long size)
 {
 
-    RtObject *keys[size / 2];
-    RtObject *values[size / 2];
+    RtObject *keys[size];
+    RtObject *values[size];
 
-    RtMap *map = init_RtMap(size / 2);
+    RtMap *map = init_RtMap(size);
 
-    // fetches all maps and keys
-    for (unsigned long i = 0; i < size; i++)
+    // fetches all maps and keys, the last pair is on top of the stack
+    for (unsigned long i = size; i > 0; i--)
     {
         bool valdispose = disposable();
         RtObject *val = StackMachine_pop(StackMachine, false);
@@ -747,12 +830,20 @@ static void perform_create_map(unsigned long size)
         RtObject *key = StackMachine_pop(StackMachine, false);
 
         val = rtobj_rt_preprocess(val, valdispose, false);
-        key = rtobj_rt_preprocess(key, valdispose, false);
-        rtmap_insert(map, key, val);
+        key = rtobj_rt_preprocess(key, keydispose, false);
 
         addDisposablePrimitiveToGC(valdispose, val);
         addDisposablePrimitiveToGC(keydispose, key);
+
+        values[i - 1] = val;
+        keys[i - 1] = keydispose ? key : rtobj_key_cpy(key);
+    }
+
+    for (unsigned long i = 0; i < size; i++)
+    {
+        rtmap_insert(map, keys[i], values[i]);
     }
+
     RtObject *mapobj = init_RtObject(HASHMAP_TYPE);
     mapobj->data.Map = map;
 
@@ -761,23 +852,29 @@ static void perform_create_map(unsigned long size)
 
 /**
  * DESCRIPTION:
- * Creates a runtime set by popping some amount of objects from the stack machine
+ * Creates a runtime set by popping some amount of objects from the stack machine, elements are inserted in source order
  */
 static void perform_create_set(int setsize)
 {
 
     RtSet *set = init_RtSet(setsize + 1);
+    RtObject *elements[setsize];
 
-    for (int i = 0; i < setsize; i++)
+    for (int i = setsize - 1; i >= 0; i--)
     {
         bool dispose = disposable();
         RtObject *obj = StackMachine_pop(StackMachine, false);
         assert(obj);
         obj = rtobj_rt_preprocess(obj, dispose, false);
-        rtset_insert(set, obj);
 
         addDisposablePrimitiveToGC(dispose, obj);
         // add_to_GC_registry(obj);
+        elements[i] = dispose ? obj : rtobj_key_cpy(obj);
+    }
+
+    for (int i = 0; i < setsize; i++)
+    {
+        rtset_insert(set, elements[i]);
     }
 
     RtObject *setobj = init_RtObject(HASHSET_TYPE);
@@ -801,6 +898,9 @@ static void perform_get_index()
 
     RtObject *indexed_obj = rtobj_getindex(obj, index_);
 
+    // elements of unboxed lists are fetched as new objects, nothing else refers to them
+    bool boxed = obj->type == LIST_TYPE && rtlist_unboxed(obj->data.List);
+
     dispose_disposable_obj(index_, index_disposable);
     dispose_disposable_obj(obj, obj_disposable);
 
@@ -813,7 +913,93 @@ static void perform_get_index()
     }
 
     // object was fetched from an other object, therefor it should be disposed, since the latter has ref to it
-    StackMachine_push(StackMachine, indexed_obj, false);
+    StackMachine_push(StackMachine, indexed_obj, boxed);
+}
+
+/**
+ * DESCRIPTION:
+ * Assigns a new element to an index of an object (i.e obj[index] = val)
+ * The container is given its own storage first, since it must not be shared with its copies (see cow.h)
+ *
+ * NOTE:
+ * The element of a list is replaced, that way unboxed lists can store the new value directly,
+ * the element of other containers is mutated in place
+ */
+static void perform_store_index()
+{
+    bool val_disposable = disposable();
+    RtObject *val = StackMachine_pop(StackMachine, false);
+    bool index_disposable = disposable();
+    RtObject *index_ = StackMachine_pop(StackMachine, false);
+    bool obj_disposable = disposable();
+    RtObject *obj = StackMachine_pop(StackMachine, false);
+
+    assert(!Intermediate_raisedException);
+
+    rtobj_unshare(obj);
+
+    if (obj->type == LIST_TYPE)
+    {
+        // the new element must live in the GC like any other element, numbers are copied
+        val = rtobj_rt_preprocess(val, val_disposable, true);
+        rtobj_setindex(obj, index_, val);
+
+        dispose_disposable_obj(index_, index_disposable);
+        dispose_disposable_obj(obj, obj_disposable);
+
+        if (Intermediate_raisedException)
+            raiseException(Intermediate_raisedException);
+        return;
+    }
+
+    RtObject *old_val = rtobj_getindex(obj, index_);
+
+    dispose_disposable_obj(index_, index_disposable);
+    dispose_disposable_obj(obj, obj_disposable);
+
+    if (Intermediate_raisedException)
+    {
+        assert(!old_val);
+        dispose_disposable_obj(val, val_disposable);
+        raiseException(Intermediate_raisedException);
+        return;
+    }
+
+    StackMachine_push(StackMachine, old_val, false);
+    StackMachine_push(StackMachine, val, val_disposable);
+    perform_var_mutation();
+}
+
+/**
+ * DESCRIPTION:
+ * Performs the slice operation object[start : end], the bounds are null when they were omitted
+ * The slice is a new object, but it shares the buffer of the sliced string or list
+ */
+static void perform_get_slice()
+{
+    bool end_disposable = disposable();
+    RtObject *end = StackMachine_pop(StackMachine, false);
+    bool start_disposable = disposable();
+    RtObject *start = StackMachine_pop(StackMachine, false);
+    bool obj_disposable = disposable();
+    RtObject *obj = StackMachine_pop(StackMachine, false);
+
+    assert(!Intermediate_raisedException);
+
+    RtObject *slice = rtobj_getslice(obj, start, end);
+
+    dispose_disposable_obj(end, end_disposable);
+    dispose_disposable_obj(start, start_disposable);
+    dispose_disposable_obj(obj, obj_disposable);
+
+    if (Intermediate_raisedException)
+    {
+        assert(!slice);
+        raiseException(Intermediate_raisedException);
+        return;
+    }
+
+    StackMachine_push(StackMachine, slice, true);
 }
 
 /**
@@ -884,6 +1070,70 @@ static void perform_create_var(char *varname, AccessModifier access)
     // addDisposablePrimitiveToGC(disposable, cpy);
 }
 
+/**
+ * DESCRIPTION:
+ * Logic for GET_ITER, replaces the object on top of the stack by an iterator over it (the iterated object, and a cursor above it)
+ * Containers are iterated over a copy on write snapshot, so the loop body can mutate them, which is constant time (see cow.h)
+ */
+static void perform_get_iter()
+{
+    bool iterable_disposable = disposable();
+    RtObject *iterable = StackMachine_pop(StackMachine, false);
+    RtObject *snapshot = NULL;
+
+    if (!rtobj_iterable(iterable))
+    {
+        const char *type = rtobj_type_toString(iterable->type);
+        char buffer[strlen(type) + 50];
+        snprintf(buffer, sizeof(buffer), "Object of type %s is not iterable", type);
+        dispose_disposable_obj(iterable, iterable_disposable);
+        raiseException(InvalidTypeException(buffer));
+        return;
+    }
+
+    // strings and ranges are immutable, so the copy simply shares their payload
+    snapshot = iterable_disposable ? iterable : rtobj_cow_cpy(iterable);
+
+    RtObject *cursor = init_RtObject(NUMBER_TYPE);
+    cursor->data.Number = init_RtNumber(0);
+
+    StackMachine_push(StackMachine, snapshot, true);
+    StackMachine_push(StackMachine, cursor, true);
+}
+
+/**
+ * DESCRIPTION:
+ * Logic for FOR_ITER, advances the iterator on top of the stack (see perform_get_iter) and binds the next value to varname
+ * Values are computed one at a time, no intermediate list is ever created
+ *
+ * PARAMS:
+ * varname: loop variable, it must already exist, it is rebound to a new variable at every iteration
+ * offset: jump performed once the iterator is exhausted
+ */
+static void perform_for_iter(const char *varname, int offset)
+{
+    CallFrame *frame = getCurrentStackFrame();
+    RtObject *cursor = StackMachine->head->obj;
+    RtObject *iterable = StackMachine->head->next->obj;
+    assert(cursor->type == NUMBER_TYPE);
+
+    size_t i = (size_t)cursor->data.Number->number;
+    bool fresh;
+    RtObject *next = rtobj_iterate(iterable, &i, &fresh);
+    cursor->data.Number->number = i;
+
+    if (!next)
+    {
+        frame->pg_counter += offset;
+        return;
+    }
+
+    Identifier_Table_remove_var(frame->lookup, varname);
+    StackMachine_push(StackMachine, next, fresh);
+    perform_create_var((char *)varname, PUBLIC_ACCESS);
+    frame->pg_counter++;
+}
+
 /**
  * DESCRIPTION:
  * Logic for creating a variable
@@ -1042,8 +1292,19 @@ static void perform_raise_exception()
     handle_runtime_exception(exception);
 }
 
-int run_program()
+/**
+ * DESCRIPTION:
+ * Main dispatch loop of the VM, runs the call frame on top of the call stack
+ *
+ * PARAMS:
+ * base: the dispatch loop returns once the call frame at this index of the call stack returns,
+ * run_program runs the whole program with a base of 0, while rt_call runs a single function call
+ */
+static int run_dispatch(long base)
 {
+    // exceptions may long jump out of nested dispatch loops (see rt_call)
+    unsigned int depth = rt_call_depth;
+
     while (true)
     {
         CallFrame *frame = callStack[stack_ptr];
@@ -1056,6 +1317,7 @@ int run_program()
         if (new_pg_counter != 0)
         {
             frame->pg_counter = new_pg_counter;
+            rt_call_depth = depth;
         }
 
         while (true)
@@ -1069,8 +1331,11 @@ int run_program()
             {
                 // contants are imbedded within the bytecode
                 // therefore a deep copy is created
+                // the bytecode may be shared with other threads, copies must then not share the payload of the constant
                 StackMachine_push(StackMachine,
-                                  rtobj_deep_cpy(code->data.LOAD_CONST.constant, false), true);
+                                  Runtime_shared_bytecode ? rtobj_isolated_cpy(code->data.LOAD_CONST.constant)
+                                                   : rtobj_deep_cpy(code->data.LOAD_CONST.constant, false),
+                                  true);
                 break;
             }
 
@@ -1279,6 +1544,9 @@ int run_program()
                 StackMachine_push(StackMachine, init_RtObject(UNDEFINED_TYPE), true);
                 CallFrame *poppedFrame = RunTime_pop_callframe();
                 free_CallFrame(poppedFrame, false);
+                pop_exception_handlers_above(stack_ptr);
+                if (stack_ptr < base)
+                    return 0;
                 loop = false;
                 getCurrentStackFrame()->pg_counter++;
                 break;
@@ -1289,6 +1557,9 @@ int run_program()
             {
                 assert(TopStkMachineObject());
                 free_CallFrame(RunTime_pop_callframe(), false);
+                pop_exception_handlers_above(stack_ptr);
+                if (stack_ptr < base)
+                    return 0;
                 loop = false;
                 getCurrentStackFrame()->pg_counter++;
                 break;
@@ -1298,6 +1569,9 @@ int run_program()
             {
                 perform_return_class();
                 free_CallFrame(RunTime_pop_callframe(), false);
+                pop_exception_handlers_above(stack_ptr);
+                if (stack_ptr < base)
+                    return 0;
                 loop = false;
                 getCurrentStackFrame()->pg_counter++;
                 break;
@@ -1338,6 +1612,31 @@ int run_program()
                 perform_get_index();
                 break;
             }
+
+            case STORE_INDEX:
+            {
+                perform_store_index();
+                break;
+            }
+
+            case LOAD_SLICE:
+            {
+                perform_get_slice();
+                break;
+            }
+
+            case GET_ITER:
+            {
+                perform_get_iter();
+                break;
+            }
+
+            case FOR_ITER:
+            {
+                perform_for_iter(code->data.FOR_ITER.var, code->data.FOR_ITER.offset);
+                continue;
+            }
+
             case PUSH_EXCEPTION_HANDLER:
             {
                 push_exception_handler(
@@ -1395,6 +1694,10 @@ int run_program()
 
             trigger_GC();
 
+            // heap snapshots are written by the main runtime
+            if (!Runtime_isolated)
+                check_heap_snapshot_request();
+
             if (!loop)
                 break;
 
@@ -1403,3 +1706,113 @@ int run_program()
     }
     return 0;
 }
+
+/**
+ * DESCRIPTION:
+ * Runs the program on top of the call stack
+ */
+int run_program()
+{
+    return run_dispatch(0);
+}
+
+/**
+ * DESCRIPTION:
+ * Calls a function from native code (i.e built in functions such as map or filter) and returns its result
+ * User functions are run by a nested dispatch loop until their call frame returns (see run_dispatch)
+ *
+ * PARAMS:
+ * func: the function to call
+ * args: arguments of the call, arguments that are not in the GC registry are added to it
+ * argcount: number of arguments
+ *
+ * NOTE:
+ * The result is in the GC registry but may not be referenced by anything,
+ * it must be stored (or referenced) before running any other code, since the GC may free it
+ * Returns NULL if an exception occured during the call, Intermediate_raisedException is then set,
+ * exceptions not caught within the called function stop at the boundary of the call (see push_exception_boundary),
+ * the built in function then returns NULL and the exception is raised again where it was called
+ */
+RtObject *rt_call(RtObject *func, RtObject **args, size_t argcount)
+{
+    assert(!Intermediate_raisedException);
+
+    RtObject *arguments[argcount];
+    bool arg_disposable[argcount];
+
+    // exceptions that are not caught by the function are turned into intermediate exceptions at this boundary,
+    // the caller may itself be resolving an exception in a catch block, which is put aside during the call
+    RtExceptionHandler boundary;
+    jmp_buf jump;
+    RtException *pending = raisedException;
+    unsigned int depth = rt_call_depth;
+
+    raisedException = NULL;
+    push_exception_boundary(&boundary, stack_ptr, stk_machine->size, &jump);
+
+    if (setjmp(jump))
+    {
+        rt_call_depth = depth;
+        raisedException = pending;
+        return NULL;
+    }
+
+    // no instruction is run when built in functions are called from native code, the GC gets a chance to run here instead,
+    // before the arguments are added to the registry
+    trigger_GC();
+
+    for (size_t i = 0; i < argcount; i++)
+    {
+        arg_disposable[i] = !GC_Registry_has(args[i]);
+        arguments[i] = rtobj_rt_preprocess(args[i], arg_disposable[i], true);
+    }
+
+    RtObject *result = NULL;
+    RtFunction *function = func->type == FUNCTION_TYPE ? func->data.Func : NULL;
+
+    if (!function)
+    {
+        const char *type = rtobj_type_toString(func->type);
+        char buffer[strlen(type) + 50];
+        snprintf(buffer, sizeof(buffer), "Object of type %s is not a callable", type);
+        setIntermediateException(ObjectNotCallableException(buffer));
+    }
+    // every nested call also grows the native stack
+    else if (rt_call_depth >= MAX_RT_CALL_DEPTH || stack_ptr >= MAX_STACK_SIZE - 1)
+    {
+        const char *funcname = rtfunc_get_funcname(function);
+        char buffer[strlen(funcname) + 50];
+        snprintf(buffer, sizeof(buffer), "Stack Overflow Error when calling function '%s'", funcname);
+        setIntermediateException(StackOverflowException(buffer));
+    }
+    else if (function->functype != REGULAR_FUNC)
+    {
+        rt_call_depth++;
+        result = perform_builtin_call(func, arguments, argcount);
+        rt_call_depth--;
+
+        // attributes can return their target, which belongs to the function
+        RtObject *target = function->functype == ATTR_BUILTIN_FUNC ? function->func_data.attr_built_in.target : NULL;
+        if (result && result != target)
+            add_to_GC_registry(result);
+    }
+    else
+    {
+        long base = stack_ptr + 1;
+        rt_call_depth++;
+        perform_regular_func_call(func, false, arguments, arg_disposable, argcount);
+        run_dispatch(base);
+        rt_call_depth--;
+
+        bool ret_disposable = disposable();
+        RtObject *ret = StackMachine_pop(StackMachine, false);
+        result = rtobj_rt_preprocess(ret, ret_disposable, true);
+    }
+
+    RtExceptionHandler *popped = pop_exception_handler();
+    assert(popped == &boundary);
+    (void)popped;
+    raisedException = pending;
+
+    return result;
+}
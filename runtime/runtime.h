@@ -9,6 +9,9 @@
 
 #define MAX_STACK_SIZE 16000
 
+// maximum number of nested calls from native code (see rt_call)
+#define MAX_RT_CALL_DEPTH 1000
+
 extern size_t MAX_CALLSTACK_SIZE;
 
 typedef struct CallFrame
@@ -55,9 +58,12 @@ CallFrame *RunTime_pop_callframe();
 
 void dispose_disposable_obj(RtObject *obj, bool disposable);
 
-int prep_runtime_env(ByteCodeList *code, const char *mainfile, int argc, char **argv);
+int prep_runtime_env(ByteCodeList *code, const char *mainfile, int argc, char **argv, bool shared_bytecode);
+int prep_isolated_runtime_env(ByteCodeList *code, const char *filename, const GCPolicy *policy);
+void perform_isolated_runtime_cleanup();
 CallFrame *perform_function_call(size_t arg_count);
 int run_program();
+RtObject *rt_call(RtObject *func, RtObject **args, size_t argcount);
 bool isRuntimeActive();
 void perform_runtime_cleanup();
 
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include "../generics/utilities.h"
+#include "../parser/keywords.h"
+#include "../parser/lexer.h"
+#include "../parser/parser.h"
+#include "../parser/semanalysis.h"
+#include "../misc/dbgtools.h"
+#include "../compiler/bytecodecache.h"
+#include "../rtlib/builtinfuncs.h"
+#include "../rtlib/rtattrs.h"
+#include "runtime.h"
+#include "vm.h"
+
+/**
+ * DESCRIPTION:
+ * This file contains the implementation of VMs, the entry point for compiling and running programs (see vm.h)
+ */
+
+/* VM currently run by the calling thread */
+static _Thread_local VM *current_vm = NULL;
+
+/* Unhandled exceptions long jump here, ending the run of the calling thread (see VM_interrupt) */
+static _Thread_local jmp_buf run_interrupt;
+
+static pthread_once_t shared_init = PTHREAD_ONCE_INIT;
+
+/**
+ * DESCRIPTION:
+ * Sets up the tables shared by every VM, they are only read afterwards
+ */
+static void init_shared_tables()
+{
+    init_hash_seed();
+    init_keyword_table();
+    init_Precedence();
+    if (!init_BuiltinFuncs())
+        exitprogram(FAILED_BUILTINS_INIT);
+    init_AttrRegistry();
+    rtobj_init_cmp_tbl();
+}
+
+/**
+ * DESCRIPTION:
+ * Sets up the tables shared by every VM, must be called before creating VMs, the tables are only set up by the first call
+ */
+void init_VM_shared()
+{
+    pthread_once(&shared_init, init_shared_tables);
+}
+
+/**
+ * DESCRIPTION:
+ * Frees the tables shared by every VM
+ *
+ * NOTE:
+ * No VM can be running, and none can be created afterwards
+ */
+void cleanup_VM_shared()
+{
+    free_keyword_table();
+    cleanup_builtin();
+    cleanup_AttrsRegistry();
+}
+
+/**
+ * DESCRIPTION:
+ * Creates a VM with no program, its GC policy is read from the environment
+ *
+ * PARAMS:
+ * filename: file of the program, used by error messages, can be NULL for inline scripts
+ */
+VM *init_VM(const char *filename)
+{
+    init_VM_shared();
+
+    VM *vm = malloc(sizeof(VM));
+    if (!vm)
+        MallocError();
+
+    vm->filename = filename ? cpy_string(filename) : NULL;
+    vm->program = NULL;
+    vm->gc_policy = default_GC_policy();
+    load_GC_policy_env(&vm->gc_policy);
+    vm->bytecode_cache = false;
+    vm->concurrent_runs = false;
+
+    vm->print_tokens = false;
+    vm->print_ast = false;
+    vm->print_bytecode = false;
+    vm->print_gc_stats = false;
+    return vm;
+}
+
+/* performs cleanup operations in case of parsing error */
+static void parser_error_cleanup(Parser *parser)
+{
+    // frees all memory malloced during parsing
+    clear_memtracker_pointers(parser->memtracker);
+    free_parser(parser);
+}
+
+/**
+ * DESCRIPTION:
+ * Parses program and performs semantic analysis. If program is valid, ast is returned. Otheriwise NULL is returned
+ *
+ * PARAMS:
+ * source: raw text of the program
+ * tokens: program tokenized
+ *
+ * NOTE:
+ * tokens is freed in this function
+ */
+static AST_List *generate_AST(VM *vm, const char *source, TokenList *tokens)
+{
+    jmp_buf before_parsing;
+
+    Parser *parser = init_Parser();
+    parser->token_list = tokens;
+    parser->lines.lines =
+        tokenize_str_by_seperators(source, '\n', &parser->lines.line_count);
+
+    // if filename is NULL, then the program is an inline script
+    parser->file_name = cpy_string(vm->filename ? vm->filename : "--script ARG");
+
+    parser->error_handler = &before_parsing;
+    int error_return = setjmp(before_parsing);
+
+    // if an error is detected, long jump is performed and if statement is called
+    if (error_return != 0)
+    {
+    parser_error:;
+        assert(parser->error_indicator);
+        parser_error_cleanup(parser);
+        return NULL;
+    }
+
+    // parses program
+    enum token_type end_of_program[] = {END_OF_FILE};
+    AST_List *ast = parse_code_block(parser, NULL, 0, false, end_of_program, 1);
+
+    if (parser->error_indicator)
+        goto parser_error;
+
+    // for debugging purposes
+    if (vm->print_ast)
+        print_ast_list(ast, "  ", 0);
+
+    // performs semantic anaylsis
+    SemanticAnalyzer *sem_analyser = malloc_semantic_analyser(
+        vm->filename,
+        parser->lines.lines,
+        parser->lines.line_count,
+        parser->token_list);
+
+    free_parser(parser);
+
+    bool is_sem_valid = AST_list_has_consistent_semantics(sem_analyser, ast);
+    if (!is_sem_valid)
+    {
+        free_ast_list(ast);
+    }
+
+    free_semantic_analyser(sem_analyser);
+
+    return is_sem_valid ? ast : NULL;
+}
+
+/**
+ * DESCRIPTION:
+ * Compiles the program of a VM, returns false if it is invalid, errors are then printed
+ *
+ * PARAMS:
+ * source: raw text of the program
+ */
+bool VM_compile(VM *vm, const char *source)
+{
+    assert(!vm->program);
+
+    // tokens and ast are only printed when the program is actually compiled
+    const char *no_cache = getenv(BYTECODE_CACHE_DISABLE_ENV);
+    bool use_cache = vm->bytecode_cache && vm->filename && !vm->print_tokens && !vm->print_ast &&
+                     !(no_cache && no_cache[0] != '\0');
+
+    if (use_cache)
+    {
+        vm->program = load_bytecode_cache(vm->filename, source);
+        if (vm->program)
+        {
+            if (vm->print_bytecode)
+                deconstruct_bytecode(vm->program, 0);
+            return true;
+        }
+    }
+
+    char *file_contents = cpy_string(source);
+    TokenList *tokens = tokenize_file(file_contents);
+
+    // prints lexing info, if user requests it
+    if (vm->print_tokens)
+        print_token_list(tokens);
+
+    AST_List *program_ast = generate_AST(vm, file_contents, tokens);
+    free(file_contents);
+
+    // makes sure that program is valid
+    if (!program_ast)
+        return false;
+
+    Compiler *compiler = init_Compiler(vm->filename);
+    vm->program = compile_code_body(compiler, program_ast, true, false);
+
+    // frees structs that are no longer needed
+    compiler_free(compiler);
+    free_ast_list(program_ast);
+
+    // a cache that cannot be written (e.g read only directory) only means the next run compiles again
+    if (use_cache)
+        write_bytecode_cache(vm->filename, source, vm->program);
+
+    // user requests to deconstruct bytecode
+    if (vm->print_bytecode)
+        deconstruct_bytecode(vm->program, 0);
+
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Runs the compiled program of a VM on the calling thread with a new heap, and returns its return code
+ *
+ * PARAMS:
+ * argc, argv: arguments given to the script
+ *
+ * NOTE:
+ * A thread can only run one VM at a time
+ */
+int VM_run(VM *vm, int argc, char **argv)
+{
+    assert(vm->program);
+    assert(!current_vm);
+
+    current_vm = vm;
+    set_GC_policy(&vm->gc_policy);
+
+    // Inits important structures used by runtime environment
+    if (!prep_runtime_env(vm->program, vm->filename, argc, argv, vm->concurrent_runs))
+    {
+        printf("Error occurred Setting up runtime environment.\n");
+        current_vm = NULL;
+        return 1;
+    }
+
+    // if an unhandled exception occurs, a long jump is performed to this instruction
+    // with a non zero return code
+    int return_code;
+    int error_return = setjmp(run_interrupt);
+
+    // Runs program
+    if (error_return == 0)
+        return_code = run_program();
+    else
+        return_code = error_return;
+
+    // GC stats must be printed before the GC registry is torn down
+    if (vm->print_gc_stats)
+        print_GC_stats_json(stderr);
+
+    perform_runtime_cleanup();
+    current_vm = NULL;
+    return return_code;
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the VM run by the calling thread, NULL if there is none
+ */
+VM *VM_current()
+{
+    return current_vm;
+}
+
+/**
+ * DESCRIPTION:
+ * Ends the run of the calling thread, VM_run then returns return_code (see raiseException)
+ *
+ * NOTE:
+ * return_code must not be 0
+ */
+void VM_interrupt(int return_code)
+{
+    assert(current_vm && return_code != 0);
+    longjmp(run_interrupt, return_code);
+}
+
+/**
+ * DESCRIPTION:
+ * Frees VM and its program, it must not be running
+ */
+void free_VM(VM *vm)
+{
+    if (!vm)
+        return;
+
+    assert(current_vm != vm);
+    free_ByteCodeList(vm->program);
+    free(vm->filename);
+    free(vm);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdbool.h>
+#include "../compiler/compiler.h"
+#include "gc.h"
+
+/**
+ * DESCRIPTION:
+ * An instance of the interpreter, a program is compiled once by a VM and can then be run by it.
+ *
+ * Several VMs can run at the same time, each on its own thread:
+ * - the state of a running program (call stack, stack machine, exception handlers, heap, open files) is thread local,
+ *   a VM is bound to the thread running it for the duration of VM_run (see VM_current)
+ * - a VM with concurrent_runs set can also be run by several threads at once, its bytecode is then only read by runs
+ * - built in functions, attributes, keywords and the hash seed are shared by every VM, they are read only once set up (see init_VM_shared)
+ */
+typedef struct VM
+{
+    char *filename;        // file of the program, NULL for inline scripts
+    ByteCodeList *program; // compiled program, NULL until VM_compile succeeds
+    GCPolicy gc_policy;    // pacing policy of the heap of the program, defaults to the environment
+    bool bytecode_cache;   // VM_compile reads and writes the bytecode cache of filename (see bytecodecache.h)
+    bool concurrent_runs;  // runs copy the constants they load with rtobj_isolated_cpy, so several threads can run the program at once
+
+    // debugging output of VM_compile and VM_run
+    bool print_tokens;
+    bool print_ast;
+    bool print_bytecode;
+    bool print_gc_stats;
+} VM;
+
+void init_VM_shared();
+void cleanup_VM_shared();
+
+VM *init_VM(const char *filename);
+bool VM_compile(VM *vm, const char *source);
+int VM_run(VM *vm, int argc, char **argv);
+VM *VM_current();
+void VM_interrupt(int return_code);
+void free_VM(VM *vm);
@@ -0,0 +1,1049 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "../generics/utilities.h"
+#include "../generics/hashmap.h"
+#include "../parser/lexer.h"
+#include "../compiler/bytecodecache.h"
+#include "vm.h"
+#include "vmserver.h"
+
+/**
+ * DESCRIPTION:
+ * This file contains the server behind --serve, and a client for it (see vmserver.h)
+ */
+
+// file of the functions of programs sent as bytecode
+#define BYTECODE_FILENAME "<bytecode>"
+
+#define OUTPUT_CHUNK_SIZE (64 << 10)
+
+/* Compiled script kept by the server, it is compiled again once its source changes */
+typedef struct CachedProgram
+{
+    char *path;
+    uint64_t source_hash;
+    size_t source_length;
+    VM *vm;
+} CachedProgram;
+
+typedef struct ServerRequest
+{
+    char kind;
+    char *script;
+    size_t size;
+    int argc;
+    char **argv;
+} ServerRequest;
+
+typedef enum ClientState
+{
+    CLIENT_READING, // receiving its request
+    CLIENT_WAITING, // request is complete, waits for a job slot
+    CLIENT_RUNNING, // its script is run by a child of the server
+    CLIENT_CLOSING, // its exit frame is queued, it is closed once its output is sent
+} ClientState;
+
+/* Connection to a client, from its request to the exit frame of its script */
+typedef struct ServerClient
+{
+    int conn;
+    ClientState state;
+    double deadline; // the client is disconnected if it does not send its request or read its output by then
+
+    // request, buffered until it is complete
+    char *input;
+    size_t input_length;
+    size_t input_capacity;
+    ServerRequest request;
+
+    // frames queued for the client
+    char *output;
+    size_t output_length;
+    size_t output_sent;
+    size_t output_capacity;
+    bool broken; // the client is gone or too slow, its output is discarded
+
+    // child running the script
+    pid_t pid;
+    int out; // read ends of the stdout and stderr of the child, -1 once closed
+    int err;
+} ServerClient;
+
+typedef struct VMServer
+{
+    int listener;
+    GCPolicy gc_policy;
+    bool bytecode_cache;
+
+    GenericMap *programs; // maps paths to CachedProgram
+    size_t program_count;
+
+    ServerClient clients[VM_SERVER_MAX_CLIENTS];
+    int client_count;
+    int job_count;
+
+    FILE *compile_output; // stdout of the compiler while compiling scripts, its errors are sent to clients
+} VMServer;
+
+static volatile sig_atomic_t stop_server = 0;
+
+static void handle_stop_signal(int signal)
+{
+    (void)signal;
+    stop_server = 1;
+}
+
+/***** Socket helpers *****/
+
+/**
+ * DESCRIPTION:
+ * Writes or reads exactly size bytes, returns false if the connection failed first
+ */
+static bool write_all(int fd, const void *data, size_t size)
+{
+    const char *bytes = data;
+    while (size > 0)
+    {
+        ssize_t count = write(fd, bytes, size);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t size)
+{
+    char *bytes = data;
+    while (size > 0)
+    {
+        ssize_t count = read(fd, bytes, size);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+static bool init_socket_address(struct sockaddr_un *address, const char *socket_path)
+{
+    if (strlen(socket_path) >= sizeof(address->sun_path))
+        return false;
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socket_path);
+    return true;
+}
+
+static void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/**
+ * DESCRIPTION:
+ * Monotonic time in seconds, used for the deadlines of clients
+ */
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * DESCRIPTION:
+ * Grows buffer so it holds at least size bytes
+ */
+static char *reserve_buffer(char *buffer, size_t *capacity, size_t size)
+{
+    if (size <= *capacity)
+        return buffer;
+
+    size_t new_capacity = *capacity ? *capacity : 256;
+    while (new_capacity < size)
+        new_capacity *= 2;
+
+    buffer = realloc(buffer, new_capacity);
+    if (!buffer)
+        MallocError();
+    *capacity = new_capacity;
+    return buffer;
+}
+
+/***** Client output *****/
+
+static bool has_output(const ServerClient *client)
+{
+    return client->output_sent < client->output_length;
+}
+
+/**
+ * DESCRIPTION:
+ * Queues a frame for the client, it is sent once the connection is writable (see flush_output)
+ */
+static void queue_frame(ServerClient *client, char type, const void *data, uint32_t size)
+{
+    if (client->broken)
+        return;
+
+    // the client has VM_SERVER_IO_TIMEOUT seconds to start reading
+    if (!has_output(client))
+    {
+        client->output_length = client->output_sent = 0;
+        client->deadline = now() + VM_SERVER_IO_TIMEOUT;
+    }
+
+    size_t length = client->output_length;
+    client->output = reserve_buffer(client->output, &client->output_capacity, length + 5 + size);
+    client->output[length] = type;
+    memcpy(client->output + length + 1, &size, sizeof(size));
+    memcpy(client->output + length + 5, data, size);
+    client->output_length = length + 5 + size;
+}
+
+static void queue_exit_frame(ServerClient *client, int32_t return_code)
+{
+    queue_frame(client, VM_SERVER_EXIT, &return_code, sizeof(return_code));
+    client->state = CLIENT_CLOSING;
+}
+
+static void queue_error(ServerClient *client, const char *message)
+{
+    queue_frame(client, VM_SERVER_STDERR, message, strlen(message));
+    queue_exit_frame(client, 1);
+}
+
+/**
+ * DESCRIPTION:
+ * Marks a client as gone, its script is killed, and still drained until it exits
+ */
+static void break_client(ServerClient *client)
+{
+    client->broken = true;
+    client->output_length = client->output_sent = 0;
+    if (client->state == CLIENT_RUNNING)
+        kill(client->pid, SIGKILL);
+}
+
+/**
+ * DESCRIPTION:
+ * Sends as much of the queued output as the connection accepts without blocking
+ */
+static void flush_output(ServerClient *client)
+{
+    while (has_output(client))
+    {
+        ssize_t count = write(client->conn, client->output + client->output_sent,
+                              client->output_length - client->output_sent);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (count <= 0)
+        {
+            break_client(client);
+            return;
+        }
+
+        client->output_sent += count;
+        client->deadline = now() + VM_SERVER_IO_TIMEOUT;
+    }
+}
+
+/***** Requests *****/
+
+static void free_request(ServerRequest *request)
+{
+    for (int i = 0; i < request->argc; i++)
+        free(request->argv[i]);
+    free(request->argv);
+    free(request->script);
+    memset(request, 0, sizeof(*request));
+}
+
+typedef enum RequestStatus
+{
+    REQUEST_INCOMPLETE,
+    REQUEST_MALFORMED,
+    REQUEST_COMPLETE,
+} RequestStatus;
+
+/**
+ * DESCRIPTION:
+ * Reads size bytes at *offset of a buffered request, returns false if they were not received yet
+ */
+static bool take_bytes(const char *input, size_t length, size_t *offset, void *data, size_t size)
+{
+    if (length - *offset < size)
+        return false;
+    if (data)
+        memcpy(data, input + *offset, size);
+    *offset += size;
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Parses the request buffered so far, request is only filled once it is complete
+ * A request is rejected as soon as its header is invalid, without waiting for the rest of it
+ */
+static RequestStatus parse_request(const char *input, size_t length, ServerRequest *request)
+{
+    size_t offset = 0;
+    char magic[4];
+    uint8_t kind;
+    uint32_t size, argc;
+
+    if (!take_bytes(input, length, &offset, magic, sizeof(magic)))
+        return memcmp(input, VM_SERVER_MAGIC, length) == 0 ? REQUEST_INCOMPLETE : REQUEST_MALFORMED;
+    if (memcmp(magic, VM_SERVER_MAGIC, sizeof(magic)) != 0)
+        return REQUEST_MALFORMED;
+
+    if (!take_bytes(input, length, &offset, &kind, sizeof(kind)) ||
+        !take_bytes(input, length, &offset, &size, sizeof(size)))
+        return REQUEST_INCOMPLETE;
+    if ((kind != VM_SERVER_SCRIPT_PATH && kind != VM_SERVER_BYTECODE) || size > VM_SERVER_MAX_REQUEST)
+        return REQUEST_MALFORMED;
+
+    size_t script_offset = offset;
+    if (!take_bytes(input, length, &offset, NULL, size) || !take_bytes(input, length, &offset, &argc, sizeof(argc)))
+        return REQUEST_INCOMPLETE;
+    if (argc > VM_SERVER_MAX_REQUEST / sizeof(uint32_t))
+        return REQUEST_MALFORMED;
+
+    // checks every argument was received before copying anything
+    size_t args_offset = offset;
+    size_t total = size;
+    for (uint32_t i = 0; i < argc; i++)
+    {
+        uint32_t arg_length;
+        if (!take_bytes(input, length, &offset, &arg_length, sizeof(arg_length)))
+            return REQUEST_INCOMPLETE;
+        if ((total += arg_length) > VM_SERVER_MAX_REQUEST)
+            return REQUEST_MALFORMED;
+        if (!take_bytes(input, length, &offset, NULL, arg_length))
+            return REQUEST_INCOMPLETE;
+    }
+
+    request->kind = kind;
+    request->size = size;
+    request->script = malloc(size + 1);
+    request->argv = calloc(argc + 1, sizeof(char *));
+    if (!request->script || !request->argv)
+        MallocError();
+    memcpy(request->script, input + script_offset, size);
+    request->script[size] = '\0';
+
+    offset = args_offset;
+    for (; request->argc < (int)argc; request->argc++)
+    {
+        uint32_t arg_length;
+        if (!take_bytes(input, length, &offset, &arg_length, sizeof(arg_length)) || length - offset < arg_length)
+        {
+            free_request(request);
+            return REQUEST_MALFORMED;
+        }
+
+        char *arg = malloc(arg_length + 1);
+        if (!arg)
+            MallocError();
+        take_bytes(input, length, &offset, arg, arg_length);
+        arg[arg_length] = '\0';
+        request->argv[request->argc] = arg;
+    }
+    return REQUEST_COMPLETE;
+}
+
+/**
+ * DESCRIPTION:
+ * Reads what the client sent so far, without blocking.
+ * Returns false if the client is gone before sending its whole request
+ */
+static bool read_client_request(ServerClient *client)
+{
+    while (true)
+    {
+        client->input = reserve_buffer(client->input, &client->input_capacity, client->input_length + OUTPUT_CHUNK_SIZE);
+        ssize_t count = read(client->conn, client->input + client->input_length, OUTPUT_CHUNK_SIZE);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (count <= 0)
+            return false;
+        client->input_length += count;
+
+        // a request fits in this, whatever is sent past it is left unread
+        if (client->input_length > 2 * (size_t)VM_SERVER_MAX_REQUEST + 16)
+            break;
+    }
+
+    RequestStatus status = parse_request(client->input, client->input_length, &client->request);
+    if (status == REQUEST_INCOMPLETE)
+        return true;
+
+    free(client->input);
+    client->input = NULL;
+    client->input_length = client->input_capacity = 0;
+
+    if (status == REQUEST_MALFORMED)
+        queue_error(client, "Malformed request\n");
+    else
+        client->state = CLIENT_WAITING;
+    return true;
+}
+
+/***** Compiled scripts *****/
+
+static void free_cached_program(CachedProgram *program)
+{
+    free_VM(program->vm);
+    free(program->path);
+    free(program);
+}
+
+static GenericMap *init_program_cache()
+{
+    GenericMap *programs = init_GenericMap(
+        (unsigned int (*)(const void *))string_hash,
+        (bool (*)(const void *, const void *))strings_equal,
+        NULL,
+        (void (*)(void *))free_cached_program);
+    if (!programs)
+        MallocError();
+    return programs;
+}
+
+static VM *init_server_VM(VMServer *server, const char *filename)
+{
+    VM *vm = init_VM(filename);
+    vm->gc_policy = server->gc_policy;
+    vm->bytecode_cache = server->bytecode_cache;
+    return vm;
+}
+
+/**
+ * DESCRIPTION:
+ * Compiles source, returns false if it is invalid, the errors printed by the compiler are then queued for the client
+ */
+static bool compile_for_client(VMServer *server, VM *vm, const char *source, ServerClient *client)
+{
+    int capture = fileno(server->compile_output);
+    int saved_stdout = dup(STDOUT_FILENO);
+    fflush(stdout);
+    ftruncate(capture, 0);
+    lseek(capture, 0, SEEK_SET);
+    dup2(capture, STDOUT_FILENO);
+
+    bool valid = VM_compile(vm, source);
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    if (valid)
+        return true;
+
+    off_t size = lseek(capture, 0, SEEK_END);
+    char *errors = malloc(size > 0 ? size : 1);
+    if (!errors)
+        MallocError();
+
+    if (size > 0 && pread(capture, errors, size, 0) == size)
+        queue_frame(client, VM_SERVER_STDOUT, errors, size);
+    free(errors);
+    return false;
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the compiled script at path, it is compiled if it is not cached or its source changed since.
+ * Returns NULL if it cannot be read or is invalid, after queuing the error for the client
+ */
+static VM *get_script(VMServer *server, const char *path, ServerClient *client)
+{
+    char *source = get_file_contents(path);
+    if (!source)
+    {
+        char message[512];
+        int length = snprintf(message, sizeof(message), "Could not open %s\n", path);
+        queue_frame(client, VM_SERVER_STDOUT, message, length < (int)sizeof(message) ? length : (int)sizeof(message) - 1);
+        return NULL;
+    }
+
+    size_t source_length = strlen(source);
+    uint64_t source_hash = hash_bytes(source, source_length);
+
+    CachedProgram *program = GenericHashMap_get(server->programs, (void *)path);
+    if (program && program->source_length == source_length && program->source_hash == source_hash)
+    {
+        free(source);
+        return program->vm;
+    }
+
+    VM *vm = init_server_VM(server, path);
+    if (!compile_for_client(server, vm, source, client))
+    {
+        free_VM(vm);
+        free(source);
+        return NULL;
+    }
+    free(source);
+
+    if (program)
+    {
+        free_VM(program->vm);
+        program->vm = vm;
+        program->source_length = source_length;
+        program->source_hash = source_hash;
+        return vm;
+    }
+
+    if (server->program_count == VM_SERVER_MAX_PROGRAMS)
+    {
+        free_GenericMap(server->programs, false, true);
+        server->programs = init_program_cache();
+        server->program_count = 0;
+    }
+
+    program = malloc(sizeof(CachedProgram));
+    if (!program)
+        MallocError();
+    program->path = cpy_string(path);
+    program->source_hash = source_hash;
+    program->source_length = source_length;
+    program->vm = vm;
+    GenericHashMap_insert(server->programs, program->path, program, false);
+    server->program_count++;
+    return vm;
+}
+
+/***** Jobs *****/
+
+/**
+ * DESCRIPTION:
+ * Runs vm in a child process, its stdout and stderr are piped back to the server, returns false if it could not be started
+ *
+ * NOTE:
+ * The child never returns, it exits with the return code of the script
+ */
+static bool fork_job(VMServer *server, VM *vm, ServerClient *client)
+{
+    int out[2], err[2];
+    if (pipe(out) != 0)
+        return false;
+    if (pipe(err) != 0)
+    {
+        close(out[0]);
+        close(out[1]);
+        return false;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+
+        // only the pipes of this job are kept, other jobs must see the end of their output when their child exits
+        close(server->listener);
+        fclose(server->compile_output);
+        for (int i = 0; i < server->client_count; i++)
+        {
+            close(server->clients[i].conn);
+            if (server->clients[i].state != CLIENT_RUNNING)
+                continue;
+            if (server->clients[i].out >= 0)
+                close(server->clients[i].out);
+            if (server->clients[i].err >= 0)
+                close(server->clients[i].err);
+        }
+
+        int null_input = open("/dev/null", O_RDONLY);
+        if (null_input >= 0)
+        {
+            dup2(null_input, STDIN_FILENO);
+            close(null_input);
+        }
+        dup2(out[1], STDOUT_FILENO);
+        dup2(err[1], STDERR_FILENO);
+        close(out[0]);
+        close(out[1]);
+        close(err[0]);
+        close(err[1]);
+
+        // a process running the script would return the same code,
+        // _exit skips the exit handlers of the server, which are most of the cost of exiting
+        int return_code = VM_run(vm, client->request.argc, client->request.argv);
+        fflush(stdout);
+        fflush(stderr);
+        _exit(return_code);
+    }
+
+    close(out[1]);
+    close(err[1]);
+    if (pid < 0)
+    {
+        close(out[0]);
+        close(err[0]);
+        return false;
+    }
+
+    client->pid = pid;
+    client->out = out[0];
+    client->err = err[0];
+    client->state = CLIENT_RUNNING;
+    server->job_count++;
+    return true;
+}
+
+/**
+ * DESCRIPTION:
+ * Compiles or decodes the complete request of a client and starts its job, errors are queued for the client
+ *
+ * NOTE:
+ * Scripts are only compiled once their request is complete, compiling never waits on the client
+ */
+static void start_job(VMServer *server, ServerClient *client)
+{
+    ServerRequest *request = &client->request;
+    VM *vm = NULL;
+    VM *bytecode_vm = NULL;
+    if (request->kind == VM_SERVER_SCRIPT_PATH)
+    {
+        // paths cannot have null bytes
+        if (strlen(request->script) == request->size)
+            vm = get_script(server, request->script, client);
+    }
+    else
+    {
+        bytecode_vm = init_server_VM(server, BYTECODE_FILENAME);
+        bytecode_vm->program = decode_bytecode_cache(request->script, request->size, NULL, BYTECODE_FILENAME);
+        if (bytecode_vm->program)
+            vm = bytecode_vm;
+        else
+        {
+            const char *message = "Invalid bytecode\n";
+            queue_frame(client, VM_SERVER_STDERR, message, strlen(message));
+        }
+    }
+
+    if (!vm || !fork_job(server, vm, client))
+        queue_exit_frame(client, 1);
+
+    // the child has its own copy of the program
+    free_VM(bytecode_vm);
+    free_request(request);
+}
+
+/**
+ * DESCRIPTION:
+ * Queues the output available on fd (stdout or stderr of a job) for its client, closes fd once the child closed it
+ */
+static void forward_job_output(ServerClient *client, int *fd, char type)
+{
+    char buffer[OUTPUT_CHUNK_SIZE];
+    ssize_t count = read(*fd, buffer, sizeof(buffer));
+    if (count < 0 && errno == EINTR)
+        return;
+
+    if (count <= 0)
+    {
+        close(*fd);
+        *fd = -1;
+        return;
+    }
+
+    // output is still read once the client is gone, the child would otherwise block on a full pipe
+    queue_frame(client, type, buffer, count);
+}
+
+/**
+ * DESCRIPTION:
+ * Queues the return code of a job whose output is closed
+ */
+static void finish_job(VMServer *server, ServerClient *client)
+{
+    int status = 0;
+    while (waitpid(client->pid, &status, 0) < 0 && errno == EINTR)
+        ;
+
+    server->job_count--;
+    queue_exit_frame(client, WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+}
+
+/***** Clients *****/
+
+static void accept_client(VMServer *server)
+{
+    int conn = accept(server->listener, NULL, NULL);
+    if (conn < 0)
+        return;
+
+    set_nonblocking(conn);
+    ServerClient *client = &server->clients[server->client_count++];
+    memset(client, 0, sizeof(*client));
+    client->conn = conn;
+    client->state = CLIENT_READING;
+    // the whole request must be received by then, however slowly it is sent
+    client->deadline = now() + VM_SERVER_IO_TIMEOUT;
+    client->out = client->err = -1;
+}
+
+static void close_client(VMServer *server, int index)
+{
+    ServerClient *client = &server->clients[index];
+    close(client->conn);
+    free(client->input);
+    free(client->output);
+    free_request(&client->request);
+    server->clients[index] = server->clients[--server->client_count];
+}
+
+/**
+ * DESCRIPTION:
+ * Wether the server waits on the client, which must then make progress before its deadline
+ */
+static bool waits_on_client(const ServerClient *client)
+{
+    return client->state == CLIENT_READING || (!client->broken && has_output(client));
+}
+
+/**
+ * DESCRIPTION:
+ * Adds the file descriptors of a client to the poll set, returns the number added
+ * The output of a job is not read while too much of it is queued, the child then blocks on its pipes
+ */
+static int poll_client(const ServerClient *client, struct pollfd *fds)
+{
+    short events = 0;
+    if (client->state == CLIENT_READING)
+        events = POLLIN;
+    else if (has_output(client))
+        events = POLLOUT;
+
+    // a connection without events still reports the client hanging up
+    fds[0] = (struct pollfd){client->broken ? -1 : client->conn, events, 0};
+    if (client->state != CLIENT_RUNNING)
+        return 1;
+
+    bool reading = client->output_length - client->output_sent < VM_SERVER_MAX_QUEUED_OUTPUT;
+    fds[1] = (struct pollfd){reading ? client->out : -1, POLLIN, 0};
+    fds[2] = (struct pollfd){reading ? client->err : -1, POLLIN, 0};
+    return 3;
+}
+
+/**
+ * DESCRIPTION:
+ * Handles the events of a client, returns false once it is done and must be closed
+ */
+static bool serve_client(ServerClient *client, const struct pollfd *fds, double time)
+{
+    if (client->state == CLIENT_READING && fds[0].revents && !read_client_request(client))
+        return false;
+
+    if (fds[0].revents & POLLOUT)
+        flush_output(client);
+    else if (fds[0].revents & (POLLHUP | POLLERR) && client->state != CLIENT_READING)
+        break_client(client);
+
+    if (client->state == CLIENT_RUNNING)
+    {
+        if (fds[1].revents)
+            forward_job_output(client, &client->out, VM_SERVER_STDOUT);
+        if (fds[2].revents)
+            forward_job_output(client, &client->err, VM_SERVER_STDERR);
+    }
+
+    if (waits_on_client(client) && time > client->deadline)
+    {
+        if (client->state == CLIENT_READING)
+            return false;
+        break_client(client);
+    }
+
+    // the exit frame is sent right away when the connection can take it
+    if (client->state == CLIENT_CLOSING && has_output(client))
+        flush_output(client);
+
+    return client->state != CLIENT_CLOSING || (!client->broken && has_output(client));
+}
+
+/**
+ * DESCRIPTION:
+ * Milliseconds poll can wait before the deadline of a client passes, -1 if the server waits on no client
+ */
+static int poll_timeout(const VMServer *server, double time)
+{
+    double next = -1;
+    for (int i = 0; i < server->client_count; i++)
+    {
+        const ServerClient *client = &server->clients[i];
+        if (waits_on_client(client) && (next < 0 || client->deadline < next))
+            next = client->deadline;
+    }
+
+    if (next < 0)
+        return -1;
+    return next <= time ? 0 : (int)((next - time) * 1000) + 1;
+}
+
+/**
+ * DESCRIPTION:
+ * Creates the listening socket, a stale socket left by a server that is gone is replaced
+ */
+static int init_listener(const char *socket_path)
+{
+    struct sockaddr_un address;
+    if (!init_socket_address(&address, socket_path))
+    {
+        fprintf(stderr, "Socket path %s is too long\n", socket_path);
+        return -1;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        perror("socket");
+        return -1;
+    }
+
+    if (connect(listener, (struct sockaddr *)&address, sizeof(address)) == 0)
+    {
+        fprintf(stderr, "A server is already listening on %s\n", socket_path);
+        close(listener);
+        return -1;
+    }
+    close(listener);
+    unlink(socket_path);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0)
+    {
+        perror(socket_path);
+        if (listener >= 0)
+            close(listener);
+        return -1;
+    }
+
+    // a connection can be gone by the time it is accepted
+    set_nonblocking(listener);
+    return listener;
+}
+
+/**
+ * DESCRIPTION:
+ * Serves scripts on socket_path until SIGINT or SIGTERM, returns the exit code of the server
+ * Requests received by then are finished, requests still being sent are dropped
+ *
+ * PARAMS:
+ * gc_policy: GC policy of the scripts
+ * bytecode_cache: wether scripts are compiled through their bytecode cache file
+ */
+int VM_serve(const char *socket_path, const GCPolicy *gc_policy, bool bytecode_cache)
+{
+    init_VM_shared();
+
+    // too big for the stack
+    VMServer *server = malloc(sizeof(VMServer));
+    if (!server)
+        MallocError();
+
+    server->listener = init_listener(socket_path);
+    if (server->listener < 0)
+    {
+        free(server);
+        return 1;
+    }
+
+    server->gc_policy = *gc_policy;
+    server->bytecode_cache = bytecode_cache;
+    server->programs = init_program_cache();
+    server->program_count = 0;
+    server->client_count = 0;
+    server->job_count = 0;
+    server->compile_output = tmpfile();
+    if (!server->compile_output)
+    {
+        perror("tmpfile");
+        close(server->listener);
+        free_GenericMap(server->programs, false, true);
+        free(server);
+        return 1;
+    }
+
+    // poll is interrupted by the signals ending the server
+    struct sigaction stop_action;
+    memset(&stop_action, 0, sizeof(stop_action));
+    stop_action.sa_handler = handle_stop_signal;
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGINT, &stop_action, NULL);
+    sigaction(SIGTERM, &stop_action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct pollfd fds[3 * VM_SERVER_MAX_CLIENTS + 1];
+    int first_fd[VM_SERVER_MAX_CLIENTS];
+    while (!stop_server || server->client_count > 0)
+    {
+        // clients visited backwards, closed clients are replaced by the last one
+        for (int i = server->client_count - 1; i >= 0; i--)
+        {
+            if (stop_server && server->clients[i].state == CLIENT_READING)
+                close_client(server, i);
+        }
+
+        for (int i = 0; i < server->client_count && server->job_count < VM_SERVER_MAX_JOBS; i++)
+        {
+            if (server->clients[i].state == CLIENT_WAITING)
+                start_job(server, &server->clients[i]);
+        }
+
+        int nfds = 0;
+        for (int i = 0; i < server->client_count; i++)
+        {
+            first_fd[i] = nfds;
+            nfds += poll_client(&server->clients[i], fds + nfds);
+        }
+
+        // new connections wait in the backlog while too many clients are served
+        bool accepting = !stop_server && server->client_count < VM_SERVER_MAX_CLIENTS;
+        if (accepting)
+            fds[nfds++] = (struct pollfd){server->listener, POLLIN, 0};
+
+        if (poll(fds, nfds, poll_timeout(server, now())) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+
+        double time = now();
+        for (int i = server->client_count - 1; i >= 0; i--)
+        {
+            ServerClient *client = &server->clients[i];
+            if (!serve_client(client, fds + first_fd[i], time))
+            {
+                close_client(server, i);
+                continue;
+            }
+
+            if (client->state == CLIENT_RUNNING && client->out < 0 && client->err < 0)
+            {
+                finish_job(server, client);
+                flush_output(client);
+                if (client->broken || !has_output(client))
+                    close_client(server, i);
+            }
+        }
+
+        if (accepting && fds[nfds - 1].revents & POLLIN)
+            accept_client(server);
+    }
+
+    for (int i = server->client_count - 1; i >= 0; i--)
+        close_client(server, i);
+    close(server->listener);
+    unlink(socket_path);
+    fclose(server->compile_output);
+    free_GenericMap(server->programs, false, true);
+    free(server);
+    return 0;
+}
+
+/**
+ * DESCRIPTION:
+ * Runs a script on the server listening on socket_path, returns its return code, or -1 if the server could not be reached
+ *
+ * PARAMS:
+ * kind: VM_SERVER_SCRIPT_PATH or VM_SERVER_BYTECODE
+ * script, size: path of the script, or contents of its .tlc file
+ * argc, argv: arguments of the script
+ * out_fd, err_fd: where the stdout and stderr of the script are written
+ */
+int VM_serve_request(const char *socket_path, char kind, const void *script, size_t size,
+                     int argc, char **argv, int out_fd, int err_fd)
+{
+    struct sockaddr_un address;
+    if (!init_socket_address(&address, socket_path))
+        return -1;
+
+    int conn = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (conn < 0)
+        return -1;
+
+    if (connect(conn, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(conn);
+        return -1;
+    }
+
+    uint8_t request_kind = kind;
+    uint32_t script_size = size, arg_count = argc;
+    bool sent = write_all(conn, VM_SERVER_MAGIC, 4) &&
+                write_all(conn, &request_kind, sizeof(request_kind)) &&
+                write_all(conn, &script_size, sizeof(script_size)) &&
+                write_all(conn, script, size) &&
+                write_all(conn, &arg_count, sizeof(arg_count));
+
+    for (int i = 0; sent && i < argc; i++)
+    {
+        uint32_t length = strlen(argv[i]);
+        sent = write_all(conn, &length, sizeof(length)) && write_all(conn, argv[i], length);
+    }
+
+    int return_code = -1;
+    char *buffer = malloc(OUTPUT_CHUNK_SIZE);
+    if (!buffer)
+        MallocError();
+
+    while (sent)
+    {
+        uint8_t type;
+        uint32_t frame_size;
+        if (!read_all(conn, &type, sizeof(type)) || !read_all(conn, &frame_size, sizeof(frame_size)))
+            break;
+
+        if (type == VM_SERVER_EXIT)
+        {
+            int32_t code;
+            if (frame_size == sizeof(code) && read_all(conn, &code, sizeof(code)))
+                return_code = code;
+            break;
+        }
+
+        // frames are never bigger than the chunks the server reads
+        if (frame_size > OUTPUT_CHUNK_SIZE || !read_all(conn, buffer, frame_size))
+            break;
+        write_all(type == VM_SERVER_STDERR ? err_fd : out_fd, buffer, frame_size);
+    }
+
+    free(buffer);
+    close(conn);
+    return return_code;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include "gc.h"
+
+/**
+ * Warm worker serving scripts over a local UNIX socket (see --serve), it skips the startup of the interpreter
+ * (shared tables, compilation) for every script run by a job runner.
+ *
+ * The server compiles each script once and keeps it until its source changes, every request is then run
+ * by a child process forked from the server: the run gets a fresh heap, and whatever the script does
+ * (exiting, crashing, leaking) stays in the child. Requests are run concurrently.
+ *
+ * The server never waits on a client: connections are non blocking, a request is buffered until it is complete,
+ * and the output of a script is queued until its client reads it, a slow client only delays its own script.
+ *
+ * Protocol, integers are in the byte order of the machine (the socket is local):
+ * - request:  magic (VM_SERVER_MAGIC, 4 bytes), kind (u8), script size (u32), script,
+ *             argument count (u32), then each argument as its size (u32) followed by its characters
+ *             the script is a path (VM_SERVER_SCRIPT_PATH) or the contents of a .tlc file (VM_SERVER_BYTECODE)
+ * - response: frames made of a type (u8), a size (u32) and data, the output of the script is streamed
+ *             as VM_SERVER_STDOUT and VM_SERVER_STDERR frames, the last frame is always VM_SERVER_EXIT,
+ *             its data is the return code of the script (i32), as returned by a process running it (0 to 255)
+ */
+
+#define VM_SERVER_MAGIC "TLRQ"
+
+// kinds of request
+#define VM_SERVER_SCRIPT_PATH 'P'
+#define VM_SERVER_BYTECODE 'B'
+
+// types of response frames
+#define VM_SERVER_STDOUT 'O'
+#define VM_SERVER_STDERR 'E'
+#define VM_SERVER_EXIT 'X'
+
+// max size of a request
+#define VM_SERVER_MAX_REQUEST (64 << 20)
+
+// max number of connections served at the same time, other connections wait in the backlog
+#define VM_SERVER_MAX_CLIENTS 256
+
+// max number of scripts run at the same time, other complete requests wait for one of them to finish
+#define VM_SERVER_MAX_JOBS 64
+
+// output of a script queued for its client, the output of the script is not read anymore past it
+#define VM_SERVER_MAX_QUEUED_OUTPUT (1 << 20)
+
+// max number of compiled scripts kept by the server, the cache is emptied once it is full
+#define VM_SERVER_MAX_PROGRAMS 256
+
+// seconds a client has to send its whole request, then to accept each part of the output of its script, it is disconnected afterwards
+#define VM_SERVER_IO_TIMEOUT 5
+
+int VM_serve(const char *socket_path, const GCPolicy *gc_policy, bool bytecode_cache);
+int VM_serve_request(const char *socket_path, char kind, const void *script, size_t size,
+                     int argc, char **argv, int out_fd, int err_fd);
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "../tlang.h"
+
+/**
+ * DESCRIPTION:
+ * Uses the interpreter through its C API: native functions are added, a program is compiled once,
+ * then run many times with different arguments, sequentially then by several threads at once.
+ * Exits with 0 if every run returned what was expected
+ *
+ * Build and run with: make test_embed && ./test_embed
+ */
+
+#define RUNS 500
+#define RUN_THREADS 8
+
+// native functions are called by every thread running the program
+static atomic_int host_calls = 0;
+
+static TLangValue *host_add(TLangValue **args, int argcount)
+{
+    (void)argcount;
+    host_calls++;
+    if (!tlang_is_number(args[0]) || !tlang_is_number(args[1]))
+        return tlang_raise("HostError", "host_add expects numbers");
+
+    return tlang_number(tlang_get_number(args[0]) + tlang_get_number(args[1]));
+}
+
+static TLangValue *host_concat(TLangValue **args, int argcount)
+{
+    char buffer[256] = "";
+    for (int i = 0; i < argcount; i++)
+    {
+        if (!tlang_is_string(args[i]))
+            return tlang_raise("HostError", "host_concat expects strings");
+        strncat(buffer, tlang_get_string(args[i]), sizeof(buffer) - strlen(buffer) - 1);
+    }
+    return tlang_string(buffer);
+}
+
+// every run starts with an empty heap, the list built by the previous runs is not visible
+static const char *program =
+    "exception HostError;\n"
+    "let runs = [];\n"
+    "runs->append(__args__[0]);\n"
+    "let raised = 0;\n"
+    "try {\n"
+    "    host_add(\"1\", 2);\n"
+    "} catch(HostError()) {\n"
+    "    raised = 1;\n"
+    "}\n"
+    "let name = host_concat(\"run-\", __args__[0], \"-\", __args__[1]);\n"
+    "if(!(len(runs) == 1) || !raised || !(name == (\"run-\" + __args__[0] + \"-\" + __args__[1]))) {\n"
+    "    return -1;\n"
+    "}\n"
+    "return host_add(num(__args__[0]), len(__args__[1]));\n";
+
+/**
+ * DESCRIPTION:
+ * Runs the program with arguments made from i, returns false if it did not return what was expected
+ */
+static bool run(TLangProgram *compiled, int i)
+{
+    char number[32], word[32];
+    snprintf(number, sizeof(number), "%d", i);
+    snprintf(word, sizeof(word), "%.*s", i % 7, "abcdefg");
+
+    char *args[] = {number, word};
+    int expected = i + i % 7;
+    int returned = tlang_run(compiled, 2, args);
+    if (returned != expected)
+    {
+        printf("Run %d returned %d, expected %d\n", i, returned, expected);
+        return false;
+    }
+    return true;
+}
+
+typedef struct RunThread
+{
+    TLangProgram *compiled;
+    int id;
+    int failed;
+} RunThread;
+
+static void *run_thread(void *arg)
+{
+    RunThread *thread = arg;
+    for (int i = thread->id; i < RUNS; i += RUN_THREADS)
+        thread->failed += !run(thread->compiled, i);
+    return NULL;
+}
+
+int main()
+{
+    if (!tlang_register_builtin("host_add", host_add, 2) ||
+        !tlang_register_builtin("host_concat", host_concat, TLANG_ANY_ARGCOUNT))
+    {
+        printf("Failed to register native functions\n");
+        return 1;
+    }
+
+    if (tlang_register_builtin("print", host_add, 2))
+    {
+        printf("Built in functions must not be replaced\n");
+        return 1;
+    }
+
+    if (tlang_compile("let x = 1 +;", "invalid.tl"))
+    {
+        printf("Invalid program was compiled\n");
+        return 1;
+    }
+
+    TLangProgram *compiled = tlang_compile(program, "embedded.tl");
+    if (!compiled)
+    {
+        printf("Failed to compile program\n");
+        return 1;
+    }
+
+    int failed = 0;
+    for (int i = 0; i < RUNS; i++)
+        failed += !run(compiled, i);
+
+    // the same program run by several threads at once
+    pthread_t threads[RUN_THREADS];
+    RunThread run_threads[RUN_THREADS];
+    for (int i = 0; i < RUN_THREADS; i++)
+    {
+        run_threads[i] = (RunThread){compiled, i, 0};
+        pthread_create(&threads[i], NULL, run_thread, &run_threads[i]);
+    }
+    for (int i = 0; i < RUN_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        failed += run_threads[i].failed;
+    }
+
+    if (host_calls != 2 * RUNS * 2)
+    {
+        printf("host_add was called %d times, expected %d\n", (int)host_calls, 2 * RUNS * 2);
+        failed++;
+    }
+
+    tlang_free(compiled);
+    tlang_shutdown();
+    return failed ? 1 : 0;
+}
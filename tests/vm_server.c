@@ -0,0 +1,337 @@
+// nanosleep is POSIX
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "../compiler/bytecodecache.h"
+#include "../runtime/vm.h"
+#include "../runtime/vmserver.h"
+
+/**
+ * DESCRIPTION:
+ * Runs a server (see runtime/vmserver.h) and sends it scripts by path and as bytecode, sequentially then from several threads
+ * while another client sits idle in the middle of its request.
+ * Exits with 0 if every script printed and returned what was expected
+ *
+ * Build and run with: make test_vm_server && ./test_vm_server
+ */
+
+#define CLIENT_THREADS 8
+#define REQUESTS_PER_THREAD 25
+
+static char socket_path[64];
+static char script_path[64];
+
+// every run starts with an empty heap, so counter is 1 whatever the number of runs before it
+static const char *script =
+    "let counter = [];\n"
+    "counter->append(1);\n"
+    "print(\"run \" + __args__[0] + \" \" + str(len(counter)));\n"
+    "return num(__args__[0]) + len(__args__);\n";
+
+typedef struct Output
+{
+    char text[4096];
+    int return_code;
+} Output;
+
+/**
+ * DESCRIPTION:
+ * Sends a request, output is the stdout of the script
+ */
+static void request(char kind, const void *data, size_t size, int argc, char **argv, Output *output)
+{
+    FILE *out = tmpfile();
+    output->return_code = VM_serve_request(socket_path, kind, data, size, argc, argv, fileno(out), fileno(out));
+
+    rewind(out);
+    size_t length = fread(output->text, 1, sizeof(output->text) - 1, out);
+    output->text[length] = '\0';
+    fclose(out);
+}
+
+static void request_path(const char *path, int argc, char **argv, Output *output)
+{
+    request(VM_SERVER_SCRIPT_PATH, path, strlen(path), argc, argv, output);
+}
+
+static void write_script(const char *source)
+{
+    FILE *file = fopen(script_path, "w");
+    fputs(source, file);
+    fclose(file);
+}
+
+static int failed = 0;
+
+static void expect(bool condition, const char *what, const Output *output)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s (returned %d, printed '%s')\n", what, output->return_code, output->text);
+        failed++;
+    }
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * DESCRIPTION:
+ * Connects to the server without sending anything, returns -1 on failure
+ */
+static int connect_raw()
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int conn = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (conn >= 0 && connect(conn, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(conn);
+        return -1;
+    }
+    return conn;
+}
+
+/**
+ * DESCRIPTION:
+ * Reads the frames sent to a raw connection until its exit frame, output is the stdout and stderr of the script
+ */
+static void read_frames(int conn, Output *output)
+{
+    size_t length = 0;
+    output->return_code = -1;
+    while (true)
+    {
+        char type;
+        uint32_t size;
+        if (read(conn, &type, 1) != 1 || read(conn, &size, sizeof(size)) != sizeof(size))
+            break;
+
+        char data[4096];
+        if (size > sizeof(data) - 1 - length || read(conn, data, size) != (ssize_t)size)
+            break;
+
+        if (type == VM_SERVER_EXIT)
+        {
+            memcpy(&output->return_code, data, sizeof(int32_t));
+            break;
+        }
+        memcpy(output->text + length, data, size);
+        length += size;
+    }
+    output->text[length] = '\0';
+}
+
+/**
+ * DESCRIPTION:
+ * Sends a request one byte every 250ms, returns the seconds until the server disconnects
+ */
+static void *run_slow_client(void *arg)
+{
+    double *elapsed = arg;
+    char request[256];
+    uint32_t size = sizeof(request) - 9;
+    memset(request, 'a', sizeof(request));
+    memcpy(request, VM_SERVER_MAGIC, 4);
+    request[4] = VM_SERVER_SCRIPT_PATH;
+    memcpy(request + 5, &size, sizeof(size));
+
+    int conn = connect_raw();
+    double start = now();
+    for (size_t i = 0; conn >= 0 && i < sizeof(request) && write(conn, request + i, 1) == 1; i++)
+        nanosleep(&(struct timespec){0, 250000000}, NULL);
+
+    *elapsed = now() - start;
+    if (conn >= 0)
+        close(conn);
+    return NULL;
+}
+
+static void *run_client_thread(void *arg)
+{
+    int id = (int)(long)arg;
+    for (int i = 0; i < REQUESTS_PER_THREAD; i++)
+    {
+        char number[32], expected[64];
+        snprintf(number, sizeof(number), "%d", id * 10 + i % 10);
+        snprintf(expected, sizeof(expected), "run %s 1.000000", number);
+
+        char *args[] = {number};
+        Output output;
+        request_path(script_path, 1, args, &output);
+        expect(output.return_code == id * 10 + i % 10 + 1 && strcmp(output.text, expected) == 0,
+               "concurrent request", &output);
+    }
+    return NULL;
+}
+
+int main()
+{
+    snprintf(socket_path, sizeof(socket_path), "/tmp/tlang_test_%d.sock", (int)getpid());
+    snprintf(script_path, sizeof(script_path), "/tmp/tlang_test_%d.tl", (int)getpid());
+    write_script(script);
+    // a server closing a connection fails the expectations, not the test
+    signal(SIGPIPE, SIG_IGN);
+
+    pid_t server = fork();
+    if (server == 0)
+    {
+        GCPolicy policy = default_GC_policy();
+        exit(VM_serve(socket_path, &policy, false));
+    }
+
+    // waits for the server to listen
+    Output output = {"", -1};
+    for (int i = 0; i < 500 && output.return_code == -1; i++)
+    {
+        nanosleep(&(struct timespec){0, 10000000}, NULL);
+        char *args[] = {"4", "x"};
+        request_path(script_path, 2, args, &output);
+    }
+    expect(output.return_code == 6 && strcmp(output.text, "run 4 1.000000") == 0, "script by path", &output);
+
+    // compiled script is reused
+    char *args[] = {"7"};
+    request_path(script_path, 1, args, &output);
+    expect(output.return_code == 8 && strcmp(output.text, "run 7 1.000000") == 0, "cached script", &output);
+
+    // a client trickling its request is disconnected once VM_SERVER_IO_TIMEOUT passed since it connected
+    double slow_elapsed = 0;
+    pthread_t slow_client;
+    pthread_create(&slow_client, NULL, run_slow_client, &slow_elapsed);
+
+    // changed script is compiled again
+    write_script("print(\"changed\");\nreturn 3;\n");
+    request_path(script_path, 0, NULL, &output);
+    expect(output.return_code == 3 && strcmp(output.text, "changed") == 0, "changed script", &output);
+
+    // return codes are the ones of a process
+    write_script("return -1;\n");
+    request_path(script_path, 0, NULL, &output);
+    expect(output.return_code == 255, "negative return code", &output);
+
+    write_script("exception Failure;\nraise Failure(\"unhandled\");\n");
+    request_path(script_path, 0, NULL, &output);
+    expect(output.return_code != 0 && strstr(output.text, "Failure"), "unhandled exception", &output);
+
+    write_script("let x = 1 +;\n");
+    request_path(script_path, 0, NULL, &output);
+    expect(output.return_code == 1 && strstr(output.text, "Expected Expression"), "invalid script", &output);
+
+    request_path("/tmp/tlang_missing_script.tl", 0, NULL, &output);
+    expect(output.return_code == 1 && strstr(output.text, "Could not open"), "missing script", &output);
+
+    // bytecode sent by the client
+    VM *vm = init_VM("bytecode.tl");
+    VM_compile(vm, script);
+    size_t size;
+    void *bytecode = encode_bytecode_cache(vm->program, script, &size);
+    request(VM_SERVER_BYTECODE, bytecode, size, 1, args, &output);
+    expect(output.return_code == 8 && strcmp(output.text, "run 7 1.000000") == 0, "bytecode", &output);
+
+    ((char *)bytecode)[0] = '?';
+    request(VM_SERVER_BYTECODE, bytecode, size, 1, args, &output);
+    expect(output.return_code == 1, "invalid bytecode", &output);
+    free(bytecode);
+    free_VM(vm);
+
+    // well formed images with operands the runtime cannot run are rejected before running anything
+    const char *tampered_script = "let x = [1, 2];\nif (len(x) > 1) { print(map {1: 2}); }\nprint(x);\n";
+    const char *tampered_operands[] = {"jump past the end", "jump before the start", "list length", "negative map size", "argument count"};
+    for (size_t i = 0; i < sizeof(tampered_operands) / sizeof(tampered_operands[0]); i++)
+    {
+        vm = init_VM("bytecode.tl");
+        VM_compile(vm, tampered_script);
+        for (int j = 0; j < vm->program->pg_length; j++)
+        {
+            ByteCode *code = vm->program->code[j];
+            if (i == 0 && code->op_code == OFFSET_JUMP_IF_FALSE_POP)
+                code->data.OFFSET_JUMP_IF_FALSE_POP.offset = 100000;
+            else if (i == 1 && code->op_code == OFFSET_JUMP_IF_FALSE_POP)
+                code->data.OFFSET_JUMP_IF_FALSE_POP.offset = -j - 1;
+            else if (i == 2 && code->op_code == CREATE_LIST)
+                code->data.CREATE_LIST.list_length = 100000;
+            else if (i == 3 && code->op_code == CREATE_MAP)
+                code->data.CREATE_MAP.map_size = -1;
+            else if (i == 4 && code->op_code == FUNCTION_CALL)
+                code->data.FUNCTION_CALL.arg_count = j;
+        }
+
+        bytecode = encode_bytecode_cache(vm->program, tampered_script, &size);
+        expect(output.return_code == 1 && strcmp(output.text, "Invalid bytecode\n") == 0, tampered_operands[i], &output);
+        free(bytecode);
+        free_VM(vm);
+    }
+
+    write_script(script);
+
+    // a client stopping in the middle of its request must not hold up the others
+    char idle_request[256];
+    uint8_t kind = VM_SERVER_SCRIPT_PATH;
+    uint32_t path_length = strlen(script_path), argc = 1, arg_length = 2;
+    size_t idle_length = 0;
+    memcpy(idle_request, VM_SERVER_MAGIC, 4);
+    idle_length += 4;
+    memcpy(idle_request + idle_length, &kind, sizeof(kind));
+    idle_length += sizeof(kind);
+    memcpy(idle_request + idle_length, &path_length, sizeof(path_length));
+    idle_length += sizeof(path_length);
+    memcpy(idle_request + idle_length, script_path, path_length);
+    idle_length += path_length;
+    memcpy(idle_request + idle_length, &argc, sizeof(argc));
+    idle_length += sizeof(argc);
+    memcpy(idle_request + idle_length, &arg_length, sizeof(arg_length));
+    idle_length += sizeof(arg_length);
+    memcpy(idle_request + idle_length, "42", arg_length);
+    idle_length += arg_length;
+
+    int idle = connect_raw();
+    size_t idle_sent = idle_length / 2;
+    expect(idle >= 0 && write(idle, idle_request, idle_sent) == (ssize_t)idle_sent, "idle client connects", &output);
+
+    double start = now();
+    pthread_t threads[CLIENT_THREADS];
+    for (long i = 0; i < CLIENT_THREADS; i++)
+        pthread_create(&threads[i], NULL, run_client_thread, (void *)i);
+    for (int i = 0; i < CLIENT_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    output.return_code = 0;
+    snprintf(output.text, sizeof(output.text), "%.2fs", now() - start);
+    expect(now() - start < VM_SERVER_IO_TIMEOUT, "requests served while a client is idle", &output);
+
+    // the idle client is still served once it sends the rest of its request
+    expect(write(idle, idle_request + idle_sent, idle_length - idle_sent) == (ssize_t)(idle_length - idle_sent),
+           "idle client finishes its request", &output);
+    read_frames(idle, &output);
+    expect(output.return_code == 43 && strcmp(output.text, "run 42 1.000000") == 0, "idle client", &output);
+    close(idle);
+
+    pthread_join(slow_client, NULL);
+    output.return_code = 0;
+    snprintf(output.text, sizeof(output.text), "%.2fs", slow_elapsed);
+    expect(slow_elapsed < VM_SERVER_IO_TIMEOUT + 1, "slow client disconnected", &output);
+
+    kill(server, SIGTERM);
+    int status;
+    waitpid(server, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0 && access(socket_path, F_OK) != 0, "server shutdown", &output);
+
+    unlink(script_path);
+    cleanup_VM_shared();
+    return failed ? 1 : 0;
+}
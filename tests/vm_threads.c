@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "../runtime/vm.h"
+
+/**
+ * DESCRIPTION:
+ * Runs several VMs at the same time, each on its own thread, every VM compiles and runs its own program.
+ * Exits with 0 if every program returned what was expected
+ *
+ * Build and run with: make test_vm_threads && ./test_vm_threads
+ */
+
+#define VM_THREADS 8
+
+// every VM allocates, collects, raises and catches exceptions while the others do the same,
+// the last one ends with an unhandled exception, which must only end its own run
+static const char *program_format =
+    "exception Mismatch;\n"
+    "let n = %d;\n"
+    "func fib(x) { if(x < 2) { return x; } return fib(x - 1) + fib(x - 2); }\n"
+    "let squares = map(range(2000), func(x) { return x * x + n; });\n"
+    "let names = map {\"zero\": 0, \"n\": n};\n"
+    "let caught = 0;\n"
+    "for (i in range(100)) {\n"
+    "    try {\n"
+    "        raise Mismatch(str(i));\n"
+    "    } catch(Mismatch()) {\n"
+    "        caught = caught + 1;\n"
+    "    }\n"
+    "}\n"
+    "if(!(fib(18) == 2584) || !(sum(squares) == 2664667000 + 2000 * n) || !(names[\"n\"] == n) || !(caught == 100)) {\n"
+    "    return 1;\n"
+    "}\n"
+    "if(n == %d) {\n"
+    "    raise Mismatch(\"unhandled\");\n"
+    "}\n"
+    "return len(__args__) + 10 * n;\n";
+
+typedef struct VMThread
+{
+    int id;
+    pthread_t thread;
+    int return_code;
+} VMThread;
+
+static void *run_vm_thread(void *arg)
+{
+    VMThread *vmthread = arg;
+    char source[2048];
+    snprintf(source, sizeof(source), program_format, vmthread->id, VM_THREADS - 1);
+
+    char *args[] = {"first", "second"};
+    VM *vm = init_VM(NULL);
+    vmthread->return_code = VM_compile(vm, source) ? VM_run(vm, 2, args) : -1;
+    free_VM(vm);
+    return NULL;
+}
+
+int main()
+{
+    init_VM_shared();
+
+    VMThread threads[VM_THREADS];
+    for (int i = 0; i < VM_THREADS; i++)
+    {
+        threads[i].id = i;
+        if (pthread_create(&threads[i].thread, NULL, run_vm_thread, &threads[i]) != 0)
+        {
+            printf("Failed to start thread %d\n", i);
+            return 1;
+        }
+    }
+
+    int failed = 0;
+    for (int i = 0; i < VM_THREADS; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+
+        int expected = i == VM_THREADS - 1 ? 1 : 2 + 10 * i;
+        if (threads[i].return_code != expected)
+        {
+            printf("VM %d returned %d, expected %d\n", i, threads[i].return_code, expected);
+            failed++;
+        }
+    }
+
+    cleanup_VM_shared();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include "tlang.h"
+#include "generics/utilities.h"
+#include "parser/lexer.h"
+#include "rtlib/builtinfuncs.h"
+#include "runtime/vm.h"
+#include "runtime/rtobjects.h"
+#include "runtime/rtexchandler.h"
+
+/**
+ * DESCRIPTION:
+ * This file contains the implementation of the C API of libtlang (see tlang.h), programs are VMs (see runtime/vm.h)
+ */
+
+/**
+ * DESCRIPTION:
+ * Compiles a program, returns NULL if it is invalid, errors are then printed
+ *
+ * PARAMS:
+ * source: raw text of the program
+ * filename: file shown by error messages, can be NULL
+ */
+TLangProgram *tlang_compile(const char *source, const char *filename)
+{
+    VM *vm = init_VM(filename);
+    vm->concurrent_runs = true;
+    if (!VM_compile(vm, source))
+    {
+        free_VM(vm);
+        return NULL;
+    }
+    return vm;
+}
+
+/**
+ * DESCRIPTION:
+ * Compiles the program of a file, returns NULL if it cannot be read or is invalid
+ *
+ * NOTE:
+ * Like the interpreter, the bytecode cache of the file is used (see compiler/bytecodecache.h)
+ */
+TLangProgram *tlang_compile_file(const char *path)
+{
+    char *source = get_file_contents(path);
+    if (!source)
+        return NULL;
+
+    VM *vm = init_VM(path);
+    vm->bytecode_cache = true;
+    vm->concurrent_runs = true;
+    bool valid = VM_compile(vm, source);
+    free(source);
+
+    if (!valid)
+    {
+        free_VM(vm);
+        return NULL;
+    }
+    return vm;
+}
+
+/**
+ * DESCRIPTION:
+ * Runs a compiled program on the calling thread, and returns its return code
+ * Several threads can run the same program at once, runs only read the program (see concurrent_runs in runtime/vm.h)
+ *
+ * PARAMS:
+ * argc, argv: arguments of the run, available to the program as __args__
+ */
+int tlang_run(TLangProgram *program, int argc, char **argv)
+{
+    return VM_run(program, argc, argv);
+}
+
+void tlang_free(TLangProgram *program)
+{
+    free_VM(program);
+}
+
+/**
+ * DESCRIPTION:
+ * Adds a native function called name, returns false if name is already a built in function
+ *
+ * PARAMS:
+ * argcount: expected number of arguments, or TLANG_ANY_ARGCOUNT
+ *
+ * NOTE:
+ * Functions must be added before the programs calling them are compiled, and never while a program is running
+ */
+bool tlang_register_builtin(const char *name, TLangNativeFunc func, int argcount)
+{
+    init_VM_shared();
+    return register_BuiltinFunc(name, func, argcount == TLANG_ANY_ARGCOUNT ? INT_FAST64_MAX : (size_t)argcount) == 1;
+}
+
+/**
+ * DESCRIPTION:
+ * Frees the state shared by every program, once no program runs anymore. The API cannot be used afterwards
+ */
+void tlang_shutdown()
+{
+    cleanup_VM_shared();
+}
+
+TLangValue *tlang_null()
+{
+    return init_RtObject(NULL_TYPE);
+}
+
+TLangValue *tlang_number(double number)
+{
+    RtObject *obj = init_RtObject(NUMBER_TYPE);
+    obj->data.Number = init_RtNumber(number);
+    if (!obj->data.Number)
+        MallocError();
+    return obj;
+}
+
+TLangValue *tlang_string(const char *string)
+{
+    RtObject *obj = init_RtObject(STRING_TYPE);
+    obj->data.String = init_RtString(string);
+    if (!obj->data.String)
+        MallocError();
+    return obj;
+}
+
+bool tlang_is_number(const TLangValue *value)
+{
+    return value->type == NUMBER_TYPE;
+}
+
+bool tlang_is_string(const TLangValue *value)
+{
+    return value->type == STRING_TYPE;
+}
+
+double tlang_get_number(const TLangValue *value)
+{
+    assert(value->type == NUMBER_TYPE);
+    return (double)value->data.Number->number;
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the characters of a string, valid for the duration of the native call
+ */
+const char *tlang_get_string(const TLangValue *value)
+{
+    assert(value->type == STRING_TYPE);
+    return rtstr_chars(value->data.String);
+}
+
+/**
+ * DESCRIPTION:
+ * Returns the representation of any value, as printed by print, the string is malloced
+ */
+char *tlang_to_string(const TLangValue *value)
+{
+    return rtobj_toString(value);
+}
+
+/**
+ * DESCRIPTION:
+ * Raises an exception from a native function, which must then return the NULL returned by this function
+ *
+ * PARAMS:
+ * exception: name of the exception, it can be caught by programs declaring it
+ * message: message of the exception, can be NULL
+ */
+TLangValue *tlang_raise(const char *exception, const char *message)
+{
+    setIntermediateException(init_RtException(exception, message ? message : ""));
+    return NULL;
+}
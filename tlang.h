@@ -0,0 +1,43 @@
+#pragma once
+#include <stdbool.h>
+
+/**
+ * C API for embedding the interpreter, built as libtlang.a and libtlang.so (see the Makefile)
+ *
+ * A program is compiled once into a TLangProgram, which can then be run any number of times,
+ * every run starts with an empty heap and gets its own __args__, nothing is left from previous runs.
+ * Programs can be compiled and run by several threads at the same time, including the same program by several threads at once,
+ * a thread runs one program at a time.
+ *
+ * Host programs can add native functions, called by programs like any other built in function (see tlang_register_builtin)
+ */
+
+typedef struct VM TLangProgram;
+typedef struct RtObject TLangValue;
+
+/**
+ * Native function, args are borrowed for the duration of the call.
+ * It returns a new value (see tlang_null, tlang_number and tlang_string), or NULL after calling tlang_raise
+ */
+typedef TLangValue *(*TLangNativeFunc)(TLangValue **args, int argcount);
+
+// argcount of native functions checking their number of arguments themselves
+#define TLANG_ANY_ARGCOUNT -1
+
+TLangProgram *tlang_compile(const char *source, const char *filename);
+TLangProgram *tlang_compile_file(const char *path);
+int tlang_run(TLangProgram *program, int argc, char **argv);
+void tlang_free(TLangProgram *program);
+
+bool tlang_register_builtin(const char *name, TLangNativeFunc func, int argcount);
+void tlang_shutdown();
+
+TLangValue *tlang_null();
+TLangValue *tlang_number(double number);
+TLangValue *tlang_string(const char *string);
+bool tlang_is_number(const TLangValue *value);
+bool tlang_is_string(const TLangValue *value);
+double tlang_get_number(const TLangValue *value);
+const char *tlang_get_string(const TLangValue *value);
+char *tlang_to_string(const TLangValue *value);
+TLangValue *tlang_raise(const char *exception, const char *message);